@@ -0,0 +1,586 @@
+#include "stdafx.h"
+#include "Archive.h"
+#include "BinaryIO.h"
+#include "Checksum.h"
+#include "LZ4.h"
+#include <algorithm>
+#include <tuple>
+#include <zlib.h>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	constexpr uint32_t BSAMagic = 0x00415342;
+	constexpr uint32_t BA2Magic = 0x58445442;
+	constexpr uint32_t BA2General = 0x4C524E47;
+	constexpr uint32_t BA2Textures = 0x30315844;
+
+	// Archive flags of '.bsa' header and the bit of a file's size that inverts the default compression
+	constexpr uint32_t BSAFolderNames = 0x1;
+	constexpr uint32_t BSACompressed = 0x4;
+	constexpr uint32_t BSAEmbeddedNames = 0x100;
+	constexpr uint32_t BSASizeCompressed = 0x40000000;
+	constexpr uint32_t BSASizeMask = 0x3FFFFFFF;
+
+	constexpr size_t BSAHeaderSize = 36;
+	constexpr size_t BSAFileRecordSize = 16;
+	constexpr size_t BA2FileRecordSize = 36;
+	constexpr size_t BA2TextureRecordSize = 24;
+	constexpr size_t BA2ChunkSize = 24;
+
+	// Caps for broken archives. Official ones have a few thousand folders and a few hundred thousand files.
+	constexpr uint32_t MaxFolders = 1024 * 1024;
+	constexpr uint32_t MaxFiles = 16 * 1024 * 1024;
+	constexpr uint32_t MaxExtractSize = 1024 * 1024 * 1024;
+
+	constexpr char ToLower(char c) noexcept
+	{
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+	}
+	uint32_t LoadU32(const std::byte* data) noexcept
+	{
+		uint32_t value = 0;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t HashBSA(std::string_view root, std::string_view extension) noexcept
+	{
+		// First, last and second to last characters with the length, then two multiplicative hashes over the
+		// middle of the name and over the extension. Four common extensions set flag bits.
+		uint32_t hash1 = 0;
+		uint32_t hash2 = 0;
+		uint32_t hash3 = 0;
+
+		const size_t length = root.size();
+		if (length != 0)
+		{
+			hash1 = static_cast<uint8_t>(root[length - 1])|(length > 2 ? static_cast<uint32_t>(static_cast<uint8_t>(root[length - 2])) << 8 : 0)|static_cast<uint32_t>(length) << 16|static_cast<uint32_t>(static_cast<uint8_t>(root[0])) << 24;
+		}
+		if (length > 3)
+		{
+			for (size_t i = 1; i < length - 2; i++)
+			{
+				hash2 = hash2 * 0x1003F + static_cast<uint8_t>(root[i]);
+			}
+		}
+		for (char c: extension)
+		{
+			hash3 = hash3 * 0x1003F + static_cast<uint8_t>(c);
+		}
+
+		if (extension == ".kf")
+		{
+			hash1 |= 0x80;
+		}
+		else if (extension == ".nif")
+		{
+			hash1 |= 0x8000;
+		}
+		else if (extension == ".dds")
+		{
+			hash1 |= 0x8080;
+		}
+		else if (extension == ".wav")
+		{
+			hash1 |= 0x80000000;
+		}
+		return static_cast<uint64_t>(hash2 + hash3) << 32|hash1;
+	}
+
+	// Folder and file name of a normalized path
+	std::pair<std::string_view, std::string_view> SplitPath(std::string_view path) noexcept
+	{
+		const size_t separator = path.rfind('\\');
+		if (separator == std::string_view::npos)
+		{
+			return {{}, path};
+		}
+		return {path.substr(0, separator), path.substr(separator + 1)};
+	}
+
+	ParseStatus Inflate(std::span<const std::byte> data, std::vector<std::byte>& result, uint32_t size)
+	{
+		result.resize(size);
+		uLongf resultSize = size;
+		if (::uncompress(reinterpret_cast<Bytef*>(result.data()), &resultSize, reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size())) != Z_OK || resultSize != size)
+		{
+			return ParseStatus::Malformed;
+		}
+		return ParseStatus::Success;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	uint64_t Archive::HashBSAFolder(std::string_view path) noexcept
+	{
+		return HashBSA(path, {});
+	}
+	uint64_t Archive::HashBSAFile(std::string_view name) noexcept
+	{
+		const size_t dot = name.rfind('.');
+		if (dot == std::string_view::npos)
+		{
+			return HashBSA(name, {});
+		}
+		return HashBSA(name.substr(0, dot), name.substr(dot));
+	}
+	uint32_t Archive::HashBA2(std::string_view value) noexcept
+	{
+		// 'CRC32' inverts before and after, inverting its start value and its result cancels that out
+		return ~CRC32({reinterpret_cast<const std::byte*>(value.data()), value.size()}, 0xFFFFFFFFu);
+	}
+	std::string Archive::NormalizePath(std::string_view path)
+	{
+		std::string result;
+		result.reserve(path.size());
+		for (char c: path)
+		{
+			result += c == '/' ? '\\' : ToLower(c);
+		}
+
+		const size_t start = result.find_first_not_of('\\');
+		result.erase(0, std::min(start, result.size()));
+		return result;
+	}
+
+	size_t Archive::Read(uint64_t offset, void* buffer, size_t size) const noexcept
+	{
+		const size_t read = m_Source.ReadAt(offset, buffer, size);
+		m_BytesRead.fetch_add(read, std::memory_order_relaxed);
+		return read;
+	}
+
+	ParseStatus Archive::OpenBSA()
+	{
+		std::byte header[BSAHeaderSize] = {};
+		if (Read(0, header, sizeof(header)) != sizeof(header))
+		{
+			return ParseStatus::Truncated;
+		}
+
+		BinaryReader reader(header);
+		reader.Skip(sizeof(uint32_t));
+		m_Version = reader.Read<uint32_t>();
+		const uint32_t folderOffset = reader.Read<uint32_t>();
+		m_Flags = reader.Read<uint32_t>();
+		const uint32_t folderCount = reader.Read<uint32_t>();
+		m_FileCount = reader.Read<uint32_t>();
+		reader.Skip(sizeof(uint32_t));
+		m_FileNamesSize = reader.Read<uint32_t>();
+
+		if (m_Version != 103 && m_Version != 104 && m_Version != 105)
+		{
+			return ParseStatus::UnknownFormat;
+		}
+		if (folderCount > MaxFolders || m_FileCount > MaxFiles)
+		{
+			return ParseStatus::LimitExceeded;
+		}
+		m_LZ4 = m_Version == 105;
+
+		// Version 105 widened the offset to 64 bits, with padding in front of it
+		const size_t recordSize = m_Version == 105 ? 24 : 16;
+		if (folderOffset + static_cast<uint64_t>(folderCount) * recordSize > m_Size)
+		{
+			return ParseStatus::Truncated;
+		}
+		std::vector<std::byte> records(folderCount * recordSize);
+		if (Read(folderOffset, records.data(), records.size()) != records.size())
+		{
+			return ParseStatus::Truncated;
+		}
+
+		m_Folders.resize(folderCount);
+		for (size_t i = 0; i < folderCount; i++)
+		{
+			BinaryReader record(std::span<const std::byte>(records).subspan(i * recordSize, recordSize));
+			Folder& folder = m_Folders[i];
+			folder.Hash = record.Read<uint64_t>();
+			folder.FileCount = record.Read<uint32_t>();
+			if (m_Version == 105)
+			{
+				record.Skip(sizeof(uint32_t));
+				folder.Offset = record.Read<uint64_t>();
+			}
+			else
+			{
+				folder.Offset = record.Read<uint32_t>();
+			}
+		}
+
+		// Written sorted by hash, but nothing checks that
+		std::stable_sort(m_Folders.begin(), m_Folders.end(), [](const Folder& left, const Folder& right)
+		{
+			return left.Hash < right.Hash;
+		});
+		m_FolderFiles.resize(folderCount);
+		m_FoldersLoaded.resize(folderCount);
+		return ParseStatus::Success;
+	}
+	ParseStatus Archive::OpenBA2()
+	{
+		std::byte header[24] = {};
+		if (Read(0, header, sizeof(header)) != sizeof(header))
+		{
+			return ParseStatus::Truncated;
+		}
+
+		BinaryReader reader(header);
+		reader.Skip(sizeof(uint32_t));
+		m_Version = reader.Read<uint32_t>();
+		const uint32_t type = reader.Read<uint32_t>();
+		m_FileCount = reader.Read<uint32_t>();
+
+		// Starfield's versions 2 and 3 have 8 more bytes of header, 3 adds the compression method as well
+		uint64_t recordsOffset = sizeof(header);
+		if (m_Version == 2 || m_Version == 3)
+		{
+			recordsOffset += 8;
+			if (m_Version == 3)
+			{
+				uint32_t compression = 0;
+				if (Read(recordsOffset, &compression, sizeof(compression)) != sizeof(compression))
+				{
+					return ParseStatus::Truncated;
+				}
+				m_LZ4 = compression == 3;
+				recordsOffset += sizeof(compression);
+			}
+		}
+		else if (m_Version != 1 && m_Version != 7 && m_Version != 8)
+		{
+			return ParseStatus::UnknownFormat;
+		}
+		if (type != BA2General && type != BA2Textures)
+		{
+			return ParseStatus::UnknownFormat;
+		}
+		if (m_FileCount > MaxFiles)
+		{
+			return ParseStatus::LimitExceeded;
+		}
+		if (recordsOffset + static_cast<uint64_t>(m_FileCount) * (type == BA2General ? BA2FileRecordSize : BA2TextureRecordSize) > m_Size)
+		{
+			return ParseStatus::Truncated;
+		}
+		m_Flags = type;
+
+		m_BA2Files.resize(m_FileCount);
+		if (type == BA2General)
+		{
+			std::vector<std::byte> records(m_FileCount * BA2FileRecordSize);
+			if (Read(recordsOffset, records.data(), records.size()) != records.size())
+			{
+				return ParseStatus::Truncated;
+			}
+			for (size_t i = 0; i < m_FileCount; i++)
+			{
+				BinaryReader record(std::span<const std::byte>(records).subspan(i * BA2FileRecordSize, BA2FileRecordSize));
+				BA2File& file = m_BA2Files[i];
+				file.Name = record.Read<uint32_t>();
+				file.Extension = record.Read<uint32_t>();
+				file.Directory = record.Read<uint32_t>();
+				record.Skip(sizeof(uint32_t));
+				file.Offset = record.Read<uint64_t>();
+				file.PackedSize = record.Read<uint32_t>();
+				file.UnpackedSize = record.Read<uint32_t>();
+			}
+		}
+		else
+		{
+			// Texture records have a variable number of mip chunks, only the hashes and the sizes are kept
+			uint64_t offset = recordsOffset;
+			for (size_t i = 0; i < m_FileCount; i++)
+			{
+				std::byte record[BA2TextureRecordSize] = {};
+				if (Read(offset, record, sizeof(record)) != sizeof(record))
+				{
+					return ParseStatus::Truncated;
+				}
+				BA2File& file = m_BA2Files[i];
+				file.Name = LoadU32(record);
+				file.Extension = LoadU32(record + 4);
+				file.Directory = LoadU32(record + 8);
+
+				const size_t chunkCount = static_cast<uint8_t>(record[13]);
+				std::vector<std::byte> chunks(chunkCount * BA2ChunkSize);
+				if (Read(offset + sizeof(record), chunks.data(), chunks.size()) != chunks.size())
+				{
+					return ParseStatus::Truncated;
+				}
+				for (size_t chunk = 0; chunk < chunkCount; chunk++)
+				{
+					BinaryReader chunkReader(std::span<const std::byte>(chunks).subspan(chunk * BA2ChunkSize, BA2ChunkSize));
+					const uint64_t chunkOffset = chunkReader.Read<uint64_t>();
+					file.Offset = chunk == 0 ? chunkOffset : file.Offset;
+					file.PackedSize += chunkReader.Read<uint32_t>();
+					file.UnpackedSize += chunkReader.Read<uint32_t>();
+				}
+				offset += sizeof(record) + chunks.size();
+			}
+		}
+
+		std::sort(m_BA2Files.begin(), m_BA2Files.end(), [](const BA2File& left, const BA2File& right)
+		{
+			return std::tie(left.Directory, left.Name, left.Extension) < std::tie(right.Directory, right.Name, right.Extension);
+		});
+		return ParseStatus::Success;
+	}
+
+	std::optional<ArchiveEntry> Archive::FindBSA(std::string_view path) const
+	{
+		const auto [folderPath, name] = SplitPath(path);
+		const uint64_t folderHash = HashBSAFolder(folderPath);
+		auto folder = std::lower_bound(m_Folders.begin(), m_Folders.end(), folderHash, [](const Folder& folder, uint64_t hash)
+		{
+			return folder.Hash < hash;
+		});
+		if (folder == m_Folders.end() || folder->Hash != folderHash)
+		{
+			return {};
+		}
+
+		const size_t folderIndex = folder - m_Folders.begin();
+		std::lock_guard lock(m_FoldersMutex);
+		std::vector<BSAFile>& files = m_FolderFiles[folderIndex];
+		if (!m_FoldersLoaded[folderIndex])
+		{
+			// Folder offsets count the file names block that comes after the records, for some reason
+			m_FoldersLoaded[folderIndex] = true;
+			uint64_t offset = folder->Offset >= m_FileNamesSize ? folder->Offset - m_FileNamesSize : 0;
+			if (m_Flags & BSAFolderNames)
+			{
+				uint8_t nameLength = 0;
+				Read(offset, &nameLength, sizeof(nameLength));
+				offset += sizeof(nameLength) + nameLength;
+			}
+
+			const uint64_t recordsSize = static_cast<uint64_t>(std::min(folder->FileCount, m_FileCount)) * BSAFileRecordSize;
+			if (offset + recordsSize > m_Size)
+			{
+				return {};
+			}
+			std::vector<std::byte> records(static_cast<size_t>(recordsSize));
+			if (Read(offset, records.data(), records.size()) != records.size())
+			{
+				return {};
+			}
+			files.resize(records.size() / BSAFileRecordSize);
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				BinaryReader record(std::span<const std::byte>(records).subspan(i * BSAFileRecordSize, BSAFileRecordSize));
+				files[i].Hash = record.Read<uint64_t>();
+				files[i].Size = record.Read<uint32_t>();
+				files[i].Offset = record.Read<uint32_t>();
+			}
+			std::stable_sort(files.begin(), files.end(), [](const BSAFile& left, const BSAFile& right)
+			{
+				return left.Hash < right.Hash;
+			});
+		}
+
+		const uint64_t fileHash = HashBSAFile(name);
+		auto file = std::lower_bound(files.begin(), files.end(), fileHash, [](const BSAFile& file, uint64_t hash)
+		{
+			return file.Hash < hash;
+		});
+		if (file == files.end() || file->Hash != fileHash)
+		{
+			return {};
+		}
+
+		ArchiveEntry entry;
+		entry.Offset = file->Offset;
+		entry.Size = file->Size & BSASizeMask;
+		entry.Compressed = ((m_Flags & BSACompressed) != 0) != ((file->Size & BSASizeCompressed) != 0);
+		entry.UncompressedSize = entry.Compressed ? 0 : entry.Size;
+		return entry;
+	}
+	std::optional<ArchiveEntry> Archive::FindBA2(std::string_view path) const
+	{
+		const auto [directory, name] = SplitPath(path);
+		const size_t dot = name.rfind('.');
+		const std::string_view stem = name.substr(0, dot);
+		const std::string_view extension = dot != std::string_view::npos ? name.substr(dot + 1) : std::string_view();
+
+		// Up to four characters of the extension, without the dot
+		char extensionBytes[4] = {};
+		std::copy_n(extension.begin(), std::min<size_t>(extension.size(), 4), extensionBytes);
+
+		BA2File key;
+		key.Directory = HashBA2(directory);
+		key.Name = HashBA2(stem);
+		key.Extension = LoadU32(reinterpret_cast<const std::byte*>(extensionBytes));
+
+		auto file = std::lower_bound(m_BA2Files.begin(), m_BA2Files.end(), key, [](const BA2File& left, const BA2File& right)
+		{
+			return std::tie(left.Directory, left.Name, left.Extension) < std::tie(right.Directory, right.Name, right.Extension);
+		});
+		if (file == m_BA2Files.end() || file->Directory != key.Directory || file->Name != key.Name || file->Extension != key.Extension)
+		{
+			return {};
+		}
+
+		ArchiveEntry entry;
+		entry.Offset = file->Offset;
+		entry.Compressed = file->PackedSize != 0;
+		entry.Size = entry.Compressed ? file->PackedSize : file->UnpackedSize;
+		entry.UncompressedSize = file->UnpackedSize;
+		return entry;
+	}
+
+	ParseStatus Archive::Open(const std::filesystem::path& path)
+	{
+		Close();
+		if (!m_Source.Open(path))
+		{
+			return ParseStatus::UnknownFormat;
+		}
+		m_Size = m_Source.GetSize().value_or(0);
+
+		uint32_t magic = 0;
+		Read(0, &magic, sizeof(magic));
+
+		ParseStatus status = ParseStatus::UnknownFormat;
+		if (magic == BSAMagic)
+		{
+			m_Format = ArchiveFormat::BSA;
+			status = OpenBSA();
+		}
+		else if (magic == BA2Magic)
+		{
+			m_Format = ArchiveFormat::BA2;
+			status = OpenBA2();
+		}
+
+		if (status != ParseStatus::Success)
+		{
+			Close();
+		}
+		return status;
+	}
+	void Archive::Close() noexcept
+	{
+		m_Source.Close();
+		m_Version = 0;
+		m_Flags = 0;
+		m_FileCount = 0;
+		m_FileNamesSize = 0;
+		m_Size = 0;
+		m_LZ4 = false;
+		m_Folders = {};
+		m_BA2Files = {};
+		m_FolderFiles = {};
+		m_FoldersLoaded = {};
+		m_BytesRead = 0;
+	}
+
+	ArchiveStats Archive::GetStats() const
+	{
+		ArchiveStats stats;
+		stats.Format = m_Format;
+		stats.Version = m_Version;
+		stats.Folders = m_Folders.size();
+		stats.Files = m_FileCount;
+		stats.ArchiveSize = m_Size;
+		stats.BytesRead = m_BytesRead.load(std::memory_order_relaxed);
+		stats.MemoryUsage = m_Folders.capacity() * sizeof(Folder) + m_BA2Files.capacity() * sizeof(BA2File) + m_FolderFiles.capacity() * sizeof(std::vector<BSAFile>);
+
+		std::lock_guard lock(m_FoldersMutex);
+		for (size_t i = 0; i < m_FolderFiles.size(); i++)
+		{
+			stats.FoldersLoaded += m_FoldersLoaded[i] ? 1 : 0;
+			stats.MemoryUsage += m_FolderFiles[i].capacity() * sizeof(BSAFile);
+		}
+		return stats;
+	}
+
+	std::optional<ArchiveEntry> Archive::Find(std::string_view path) const
+	{
+		if (!IsOpen())
+		{
+			return {};
+		}
+
+		const std::string normalized = NormalizePath(path);
+		return m_Format == ArchiveFormat::BSA ? FindBSA(normalized) : FindBA2(normalized);
+	}
+
+	ParseStatus Archive::Extract(const ArchiveEntry& entry, std::vector<std::byte>& result) const
+	{
+		// Texture chunks would need a DDS header built from the record, that's not supported
+		if (m_Format == ArchiveFormat::BA2 && m_Flags == BA2Textures)
+		{
+			return ParseStatus::UnknownFormat;
+		}
+		if (entry.Size > MaxExtractSize || entry.UncompressedSize > MaxExtractSize)
+		{
+			return ParseStatus::LimitExceeded;
+		}
+		if (entry.Offset > m_Size || entry.Size > m_Size - entry.Offset)
+		{
+			// A damaged record must not make us allocate for data that isn't there
+			return ParseStatus::Truncated;
+		}
+
+		std::vector<std::byte> stored;
+		std::vector<std::byte>& buffer = entry.Compressed ? stored : result;
+		buffer.resize(entry.Size);
+		if (Read(entry.Offset, buffer.data(), buffer.size()) != buffer.size())
+		{
+			return ParseStatus::Truncated;
+		}
+
+		BinaryReader reader(buffer);
+		if (m_Format == ArchiveFormat::BSA && m_Version != 103 && (m_Flags & BSAEmbeddedNames))
+		{
+			// Full path of the file in front of its data
+			reader.ReadString<uint8_t>();
+		}
+
+		uint32_t size = entry.UncompressedSize;
+		if (m_Format == ArchiveFormat::BSA && entry.Compressed)
+		{
+			size = reader.Read<uint32_t>();
+			if (size > MaxExtractSize)
+			{
+				return ParseStatus::LimitExceeded;
+			}
+		}
+		if (!reader.IsOk())
+		{
+			return ParseStatus::Truncated;
+		}
+
+		const std::span<const std::byte> data = reader.ReadBytes(reader.GetRemaining());
+		if (!entry.Compressed)
+		{
+			std::memmove(result.data(), data.data(), data.size());
+			result.resize(data.size());
+			return ParseStatus::Success;
+		}
+		if (m_LZ4)
+		{
+			if (m_Format == ArchiveFormat::BSA)
+			{
+				return DecodeLZ4Frame(data, result, size) ? ParseStatus::Success : ParseStatus::Malformed;
+			}
+
+			result.resize(size);
+			auto written = DecodeLZ4Block(data, result);
+			return written && *written == size ? ParseStatus::Success : ParseStatus::Malformed;
+		}
+		return Inflate(data, result, size);
+	}
+	ParseStatus Archive::Extract(std::string_view path, std::vector<std::byte>& result) const
+	{
+		if (auto entry = Find(path))
+		{
+			return Extract(*entry, result);
+		}
+		return ParseStatus::UnknownFormat;
+	}
+}
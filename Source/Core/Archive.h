@@ -0,0 +1,151 @@
+#pragma once
+#include "ByteSource.h"
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// Oblivion, Fallout 3, New Vegas and Skyrim use '.bsa' archives (versions 103, 104 and 105 for Skyrim Special
+	// Edition), Fallout 4 uses '.ba2'. Only general '.ba2' archives can be extracted from, texture ones can only be
+	// looked into.
+	enum class ArchiveFormat
+	{
+		BSA,
+		BA2,
+	};
+
+	struct ArchiveEntry final
+	{
+		uint64_t Offset = 0;
+
+		// Bytes taken in the archive and after extraction. Compressed '.bsa' entries only store the latter with
+		// the data, so it's zero until the entry is extracted.
+		uint32_t Size = 0;
+		uint32_t UncompressedSize = 0;
+		bool Compressed = false;
+	};
+
+	struct ArchiveStats final
+	{
+		ArchiveFormat Format = ArchiveFormat::BSA;
+		uint32_t Version = 0;
+		size_t Folders = 0;
+		size_t Files = 0;
+
+		// Folders whose file records have been read so far, '.ba2' archives read all of them on open
+		size_t FoldersLoaded = 0;
+
+		uint64_t ArchiveSize = 0;
+		uint64_t BytesRead = 0;
+		size_t MemoryUsage = 0;
+	};
+
+	// Index of an archive read on demand with positional reads, so looking a file up in a multi-gigabyte archive
+	// only reads the tables needed to find it.
+	//
+	// Opening a '.bsa' reads the header and the folder records. File records of a folder are read the first time
+	// a file in it is looked up. Names are never read: paths are hashed the way the engine does it and the hash is
+	// searched in the sorted records. '.ba2' archives have a flat table of file records and CRC-32 hashes of
+	// directory and file name, it's read on open and sorted. Lookups are thread-safe.
+	class Archive final
+	{
+		public:
+			// Hashes used by '.bsa' folder and file records. Paths are lowercased and use backslashes.
+			static uint64_t HashBSAFolder(std::string_view path) noexcept;
+			static uint64_t HashBSAFile(std::string_view name) noexcept;
+
+			// CRC-32 without the final inversion, over the lowercase name with backslashes
+			static uint32_t HashBA2(std::string_view value) noexcept;
+
+			// Lowercase with backslashes and without leading ones, what both hashes expect
+			static std::string NormalizePath(std::string_view path);
+
+		private:
+			struct Folder final
+			{
+				uint64_t Hash = 0;
+				uint64_t Offset = 0;
+				uint32_t FileCount = 0;
+			};
+			struct BSAFile final
+			{
+				uint64_t Hash = 0;
+				uint32_t Size = 0;
+				uint32_t Offset = 0;
+			};
+			struct BA2File final
+			{
+				uint32_t Directory = 0;
+				uint32_t Name = 0;
+				uint32_t Extension = 0;
+				uint32_t PackedSize = 0;
+				uint64_t Offset = 0;
+				uint32_t UnpackedSize = 0;
+			};
+
+		private:
+			FileByteSource m_Source;
+			ArchiveFormat m_Format = ArchiveFormat::BSA;
+			uint32_t m_Version = 0;
+			uint32_t m_Flags = 0;
+			uint32_t m_FileCount = 0;
+			uint32_t m_FileNamesSize = 0;
+			uint64_t m_Size = 0;
+			bool m_LZ4 = false;
+
+			std::vector<Folder> m_Folders;
+			std::vector<BA2File> m_BA2Files;
+
+			// Files of each folder, in the order of 'm_Folders'. Empty until the folder is looked into.
+			mutable std::mutex m_FoldersMutex;
+			mutable std::vector<std::vector<BSAFile>> m_FolderFiles;
+			mutable std::vector<bool> m_FoldersLoaded;
+			mutable std::atomic<uint64_t> m_BytesRead = 0;
+
+		private:
+			size_t Read(uint64_t offset, void* buffer, size_t size) const noexcept;
+
+			ParseStatus OpenBSA();
+			ParseStatus OpenBA2();
+			std::optional<ArchiveEntry> FindBSA(std::string_view path) const;
+			std::optional<ArchiveEntry> FindBA2(std::string_view path) const;
+
+		public:
+			Archive() = default;
+			Archive(const Archive&) = delete;
+
+		public:
+			ParseStatus Open(const std::filesystem::path& path);
+			void Close() noexcept;
+			bool IsOpen() const noexcept
+			{
+				return m_Source.IsOpen();
+			}
+
+			ArchiveFormat GetFormat() const noexcept
+			{
+				return m_Format;
+			}
+			ArchiveStats GetStats() const;
+
+			// Paths are relative to the data folder, like 'strings/skyrim_english.strings', in any case and with
+			// either kind of slashes
+			std::optional<ArchiveEntry> Find(std::string_view path) const;
+			bool Contains(std::string_view path) const
+			{
+				return Find(path).has_value();
+			}
+
+			// Reads and decompresses a single entry: zlib for '.bsa' versions 103 and 104 and for '.ba2', LZ4 frames
+			// for version 105 and LZ4 blocks for '.ba2' archives that declare it
+			ParseStatus Extract(const ArchiveEntry& entry, std::vector<std::byte>& result) const;
+			ParseStatus Extract(std::string_view path, std::vector<std::byte>& result) const;
+
+		public:
+			Archive& operator=(const Archive&) = delete;
+	};
+}
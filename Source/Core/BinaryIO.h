@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace BethesdaModule::Core
+{
+	// Appends little-endian values to a byte buffer
+	class BinaryWriter final
+	{
+		private:
+			std::vector<std::byte>& m_Buffer;
+
+		public:
+			BinaryWriter(std::vector<std::byte>& buffer) noexcept
+				:m_Buffer(buffer)
+			{
+			}
+
+		public:
+			size_t GetOffset() const noexcept
+			{
+				return m_Buffer.size();
+			}
+
+			void Write(const void* data, size_t size)
+			{
+				const std::byte* bytes = static_cast<const std::byte*>(data);
+				m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+			}
+			void WriteZeros(size_t count)
+			{
+				m_Buffer.resize(m_Buffer.size() + count);
+			}
+
+			template<class T> requires(std::is_trivially_copyable_v<T>)
+			void Write(T value)
+			{
+				Write(&value, sizeof(value));
+			}
+
+			// Length-prefixed string
+			template<class TLength>
+			void WriteString(std::string_view value)
+			{
+				Write(static_cast<TLength>(value.size()));
+				Write(value.data(), value.size());
+			}
+
+			template<class T>
+			void Patch(size_t offset, T value)
+			{
+				std::memcpy(m_Buffer.data() + offset, &value, sizeof(value));
+			}
+	};
+
+	// Reads little-endian values from a byte span. Any read past the end puts the reader into failed state.
+	class BinaryReader final
+	{
+		private:
+			std::span<const std::byte> m_Data;
+			size_t m_Offset = 0;
+			bool m_Failed = false;
+
+		public:
+			BinaryReader(std::span<const std::byte> data) noexcept
+				:m_Data(data)
+			{
+			}
+
+		public:
+			bool IsOk() const noexcept
+			{
+				return !m_Failed;
+			}
+			bool IsEnd() const noexcept
+			{
+				return m_Offset >= m_Data.size();
+			}
+			size_t GetOffset() const noexcept
+			{
+				return m_Offset;
+			}
+			size_t GetRemaining() const noexcept
+			{
+				return m_Data.size() - m_Offset;
+			}
+
+			std::span<const std::byte> ReadBytes(size_t size) noexcept
+			{
+				if (!m_Failed && size <= GetRemaining())
+				{
+					auto bytes = m_Data.subspan(m_Offset, size);
+					m_Offset += size;
+					return bytes;
+				}
+				m_Failed = true;
+				return {};
+			}
+			void Skip(size_t size) noexcept
+			{
+				ReadBytes(size);
+			}
+
+			template<class T> requires(std::is_trivially_copyable_v<T>)
+			T Read() noexcept
+			{
+				T value = {};
+				if (auto bytes = ReadBytes(sizeof(T)); bytes.size() == sizeof(T))
+				{
+					std::memcpy(&value, bytes.data(), sizeof(T));
+				}
+				return value;
+			}
+
+			template<class TLength>
+			std::string_view ReadString() noexcept
+			{
+				const size_t length = Read<TLength>();
+				auto bytes = ReadBytes(length);
+				return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+			}
+	};
+}
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "ByteSource.h"
+#include <limits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace BethesdaModule::Core
+{
+	#if defined(_WIN32)
+	bool FileByteSource::Open(const std::filesystem::path& path) noexcept
+	{
+		Close();
+
+		HANDLE handle = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle != INVALID_HANDLE_VALUE)
+		{
+			m_Handle = handle;
+			return true;
+		}
+		return false;
+	}
+	void FileByteSource::Close() noexcept
+	{
+		if (m_Handle)
+		{
+			::CloseHandle(m_Handle);
+			m_Handle = nullptr;
+		}
+	}
+	bool FileByteSource::IsOpen() const noexcept
+	{
+		return m_Handle != nullptr;
+	}
+
+	std::optional<uint64_t> FileByteSource::GetSize() const noexcept
+	{
+		LARGE_INTEGER size = {};
+		if (m_Handle && ::GetFileSizeEx(m_Handle, &size))
+		{
+			return static_cast<uint64_t>(size.QuadPart);
+		}
+		return {};
+	}
+	size_t FileByteSource::ReadAt(uint64_t offset, void* buffer, size_t size) const noexcept
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+		DWORD read = 0;
+		if (m_Handle && ::ReadFile(m_Handle, buffer, static_cast<DWORD>(std::min<size_t>(size, MAXDWORD)), &read, &overlapped))
+		{
+			return read;
+		}
+		return 0;
+	}
+
+	bool MappedByteSource::Open(const std::filesystem::path& path) noexcept
+	{
+		Close();
+
+		HANDLE fileHandle = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle != INVALID_HANDLE_VALUE)
+		{
+			// Empty files can't be mapped
+			LARGE_INTEGER size = {};
+			if (::GetFileSizeEx(fileHandle, &size) && size.QuadPart > 0 && static_cast<uint64_t>(size.QuadPart) <= std::numeric_limits<size_t>::max())
+			{
+				m_Mapping = ::CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			}
+			::CloseHandle(fileHandle);
+
+			if (m_Mapping)
+			{
+				if (void* view = ::MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0))
+				{
+					m_Data = {static_cast<const std::byte*>(view), static_cast<size_t>(size.QuadPart)};
+					return true;
+				}
+				Close();
+			}
+		}
+		return false;
+	}
+	void MappedByteSource::Close() noexcept
+	{
+		if (m_Data.data())
+		{
+			::UnmapViewOfFile(m_Data.data());
+			m_Data = {};
+		}
+		if (m_Mapping)
+		{
+			::CloseHandle(m_Mapping);
+			m_Mapping = nullptr;
+		}
+	}
+	#else
+	bool FileByteSource::Open(const std::filesystem::path& path) noexcept
+	{
+		Close();
+
+		m_Handle = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+		return m_Handle >= 0;
+	}
+	void FileByteSource::Close() noexcept
+	{
+		if (m_Handle >= 0)
+		{
+			::close(m_Handle);
+			m_Handle = -1;
+		}
+	}
+	bool FileByteSource::IsOpen() const noexcept
+	{
+		return m_Handle >= 0;
+	}
+
+	std::optional<uint64_t> FileByteSource::GetSize() const noexcept
+	{
+		struct stat info = {};
+		if (m_Handle >= 0 && ::fstat(m_Handle, &info) == 0)
+		{
+			return static_cast<uint64_t>(info.st_size);
+		}
+		return {};
+	}
+	size_t FileByteSource::ReadAt(uint64_t offset, void* buffer, size_t size) const noexcept
+	{
+		size_t total = 0;
+		while (m_Handle >= 0 && total < size)
+		{
+			const ssize_t read = ::pread(m_Handle, static_cast<std::byte*>(buffer) + total, size - total, static_cast<off_t>(offset + total));
+			if (read <= 0)
+			{
+				break;
+			}
+			total += static_cast<size_t>(read);
+		}
+		return total;
+	}
+
+	bool MappedByteSource::Open(const std::filesystem::path& path) noexcept
+	{
+		Close();
+
+		const int handle = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+		if (handle >= 0)
+		{
+			// Empty files can't be mapped
+			struct stat info = {};
+			if (::fstat(handle, &info) == 0 && info.st_size > 0 && static_cast<uint64_t>(info.st_size) <= std::numeric_limits<size_t>::max())
+			{
+				void* view = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, handle, 0);
+				if (view != MAP_FAILED)
+				{
+					m_Data = {static_cast<const std::byte*>(view), static_cast<size_t>(info.st_size)};
+				}
+			}
+			::close(handle);
+		}
+		return IsOpen();
+	}
+	void MappedByteSource::Close() noexcept
+	{
+		if (m_Data.data())
+		{
+			::munmap(const_cast<std::byte*>(m_Data.data()), m_Data.size());
+			m_Data = {};
+		}
+	}
+	#endif
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include "ModuleHeader.h"
+#include <concepts>
+#include <filesystem>
+#include <vector>
+#include <algorithm>
+
+namespace BethesdaModule::Core
+{
+	// Anything module data can be read from. Sources are used through templates so there are
+	// no virtual calls between the parser and the actual read.
+	template<class T>
+	concept ByteSource = requires(T& source, uint64_t offset, void* buffer, size_t size)
+	{
+		{source.ReadAt(offset, buffer, size)} -> std::same_as<size_t>;
+	};
+
+	// Sources that have the whole content available in memory, parsing happens in-place
+	template<class T>
+	concept ContiguousByteSource = ByteSource<T> && requires(const T& source)
+	{
+		{source.GetData()} -> std::same_as<std::span<const std::byte>>;
+	};
+}
+
+namespace BethesdaModule::Core
+{
+	// Plain memory buffer, doesn't own the data
+	class MemoryByteSource final
+	{
+		private:
+			std::span<const std::byte> m_Data;
+
+		public:
+			MemoryByteSource() noexcept = default;
+			MemoryByteSource(std::span<const std::byte> data) noexcept
+				:m_Data(data)
+			{
+			}
+
+		public:
+			bool IsOpen() const noexcept
+			{
+				return m_Data.data() != nullptr;
+			}
+			std::span<const std::byte> GetData() const noexcept
+			{
+				return m_Data;
+			}
+			std::optional<uint64_t> GetSize() const noexcept
+			{
+				return m_Data.size();
+			}
+
+			size_t ReadAt(uint64_t offset, void* buffer, size_t size) const noexcept
+			{
+				if (offset < m_Data.size())
+				{
+					size = std::min<size_t>(size, m_Data.size() - static_cast<size_t>(offset));
+					std::copy_n(m_Data.data() + offset, size, static_cast<std::byte*>(buffer));
+					return size;
+				}
+				return 0;
+			}
+	};
+
+	// Positional reads from a file: 'pread' on POSIX systems and overlapped 'ReadFile' on Windows
+	class FileByteSource final
+	{
+		private:
+			#if defined(_WIN32)
+			void* m_Handle = nullptr;
+			#else
+			int m_Handle = -1;
+			#endif
+
+		public:
+			FileByteSource() noexcept = default;
+			FileByteSource(const std::filesystem::path& path) noexcept
+			{
+				Open(path);
+			}
+			FileByteSource(FileByteSource&& other) noexcept
+			{
+				*this = std::move(other);
+			}
+			FileByteSource(const FileByteSource&) = delete;
+			~FileByteSource() noexcept
+			{
+				Close();
+			}
+
+		public:
+			bool Open(const std::filesystem::path& path) noexcept;
+			void Close() noexcept;
+			bool IsOpen() const noexcept;
+
+			std::optional<uint64_t> GetSize() const noexcept;
+			size_t ReadAt(uint64_t offset, void* buffer, size_t size) const noexcept;
+
+		public:
+			FileByteSource& operator=(FileByteSource&& other) noexcept
+			{
+				Close();
+				std::swap(m_Handle, other.m_Handle);
+				return *this;
+			}
+			FileByteSource& operator=(const FileByteSource&) = delete;
+	};
+
+	// Read-only memory map of a whole file
+	class MappedByteSource final
+	{
+		private:
+			std::span<const std::byte> m_Data;
+
+			#if defined(_WIN32)
+			void* m_Mapping = nullptr;
+			#endif
+
+		public:
+			MappedByteSource() noexcept = default;
+			MappedByteSource(const std::filesystem::path& path) noexcept
+			{
+				Open(path);
+			}
+			MappedByteSource(MappedByteSource&& other) noexcept
+			{
+				*this = std::move(other);
+			}
+			MappedByteSource(const MappedByteSource&) = delete;
+			~MappedByteSource() noexcept
+			{
+				Close();
+			}
+
+		public:
+			bool Open(const std::filesystem::path& path) noexcept;
+			void Close() noexcept;
+			bool IsOpen() const noexcept
+			{
+				return m_Data.data() != nullptr;
+			}
+
+			std::span<const std::byte> GetData() const noexcept
+			{
+				return m_Data;
+			}
+			std::optional<uint64_t> GetSize() const noexcept
+			{
+				return m_Data.size();
+			}
+			size_t ReadAt(uint64_t offset, void* buffer, size_t size) const noexcept
+			{
+				return MemoryByteSource(m_Data).ReadAt(offset, buffer, size);
+			}
+
+		public:
+			MappedByteSource& operator=(MappedByteSource&& other) noexcept
+			{
+				Close();
+				std::swap(m_Data, other.m_Data);
+
+				#if defined(_WIN32)
+				std::swap(m_Mapping, other.m_Mapping);
+				#endif
+				return *this;
+			}
+			MappedByteSource& operator=(const MappedByteSource&) = delete;
+	};
+}
+
+namespace BethesdaModule::Core
+{
+	// Size of the first read of a non-contiguous source. Covers the whole header of nearly every module, the rest is read separately.
+	constexpr size_t HeaderFirstBlockSize = 16 * 1024;
+
+	// Returns the bytes the header should be parsed from. For contiguous sources it's the source's own data,
+	// for others the header record is read into the provided buffer. Never reads more than the read budget allows.
+	template<ByteSource TSource>
+	std::span<const std::byte> ReadModuleHeaderData(TSource& source, std::vector<std::byte>& buffer, uint64_t* bytesRead = nullptr, const ParseLimits& limits = {})
+	{
+		if constexpr (ContiguousByteSource<TSource>)
+		{
+			std::span<const std::byte> data = source.GetData();
+			if (auto headerSize = GetModuleHeaderSize(data))
+			{
+				data = data.first(std::min({data.size(), *headerSize, limits.ReadBudget}));
+			}
+			else
+			{
+				data = data.first(std::min(data.size(), ModuleHeader::PrefixSize));
+			}
+			if (bytesRead)
+			{
+				*bytesRead += data.size();
+			}
+			return data;
+		}
+		else
+		{
+			const size_t firstBlockSize = std::min(HeaderFirstBlockSize, limits.ReadBudget);
+			buffer.resize(firstBlockSize);
+			buffer.resize(source.ReadAt(0, buffer.data(), buffer.size()));
+
+			// Read whatever remains of the header record if it's larger than the first block
+			if (auto headerSize = GetModuleHeaderSize(buffer); headerSize && *headerSize > buffer.size() && buffer.size() == firstBlockSize)
+			{
+				const size_t offset = buffer.size();
+				buffer.resize(std::min(*headerSize, limits.ReadBudget));
+				buffer.resize(offset + source.ReadAt(offset, buffer.data() + offset, buffer.size() - offset));
+			}
+
+			if (bytesRead)
+			{
+				*bytesRead += buffer.size();
+			}
+			return buffer;
+		}
+	}
+}
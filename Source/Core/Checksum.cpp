@@ -0,0 +1,35 @@
+#include "stdafx.h"
+#include "Checksum.h"
+#include <array>
+
+namespace
+{
+	constexpr std::array<uint32_t, 256> MakeCRC32Table() noexcept
+	{
+		std::array<uint32_t, 256> table = {};
+		for (uint32_t i = 0; i < table.size(); i++)
+		{
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+			}
+			table[i] = value;
+		}
+		return table;
+	}
+	constexpr auto g_CRC32Table = MakeCRC32Table();
+}
+
+namespace BethesdaModule::Core
+{
+	uint32_t CRC32(std::span<const std::byte> data, uint32_t crc) noexcept
+	{
+		crc = ~crc;
+		for (std::byte value: data)
+		{
+			crc = g_CRC32Table[(crc ^ static_cast<uint8_t>(value)) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+namespace BethesdaModule::Core
+{
+	// Standard CRC-32 (IEEE 802.3, the one zlib uses)
+	uint32_t CRC32(std::span<const std::byte> data, uint32_t crc = 0) noexcept;
+}
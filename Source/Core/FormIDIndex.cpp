@@ -0,0 +1,259 @@
+#include "stdafx.h"
+#include "FormIDIndex.h"
+#include "MetadataCache.h"
+#include "ModuleInfo.h"
+#include "Parallel.h"
+#include "RecordWalker.h"
+#include <bit>
+#include <unordered_map>
+
+namespace
+{
+	// Finalizer of MurmurHash3, object IDs are mostly sequential so they need proper mixing before masking
+	size_t HashFormID(uint64_t value) noexcept
+	{
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ull;
+		value ^= value >> 33;
+		return static_cast<size_t>(value);
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	size_t FormIDIndex::FindSlot(GlobalFormID formID) const noexcept
+	{
+		const size_t mask = m_Keys.size() - 1;
+		size_t slot = HashFormID(formID) & mask;
+		while (m_Keys[slot] != EmptyKey && m_Keys[slot] != formID)
+		{
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+	void FormIDIndex::Rehash(size_t capacity)
+	{
+		std::vector<GlobalFormID> keys(capacity, EmptyKey);
+		std::vector<uint32_t> heads(capacity, NoDefinition);
+		keys.swap(m_Keys);
+		heads.swap(m_Heads);
+
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			if (keys[i] != EmptyKey)
+			{
+				const size_t slot = FindSlot(keys[i]);
+				m_Keys[slot] = keys[i];
+				m_Heads[slot] = heads[i];
+			}
+		}
+	}
+	void FormIDIndex::Insert(GlobalFormID formID, uint32_t plugin)
+	{
+		// Keep the load factor under 3/4
+		if ((m_Forms + 1) * 4 > m_Keys.size() * 3)
+		{
+			Rehash(std::max<size_t>(m_Keys.size() * 2, 1024));
+		}
+
+		const size_t slot = FindSlot(formID);
+		if (m_Keys[slot] == EmptyKey)
+		{
+			m_Keys[slot] = formID;
+			m_Forms++;
+		}
+		else if (m_Definitions[m_Heads[slot]].Plugin == plugin)
+		{
+			// Same form twice in one plugin, only the first one counts
+			return;
+		}
+
+		m_Definitions.push_back({plugin, m_Heads[slot]});
+		m_Heads[slot] = static_cast<uint32_t>(m_Definitions.size() - 1);
+	}
+
+	void FormIDIndex::Reserve(size_t forms)
+	{
+		const size_t capacity = std::bit_ceil(std::max<size_t>(forms * 4 / 3 + 1, 1024));
+		if (capacity > m_Keys.size())
+		{
+			Rehash(capacity);
+		}
+	}
+	void FormIDIndex::Clear()
+	{
+		m_Keys.clear();
+		m_Heads.clear();
+		m_Definitions.clear();
+		m_Plugins.clear();
+		m_Forms = 0;
+		m_Orphans = 0;
+	}
+
+	void FormIDIndex::Build(const std::vector<std::filesystem::path>& files, size_t threadCount)
+	{
+		Clear();
+		m_Plugins.resize(files.size());
+
+		// Walk plugins in parallel collecting FormIDs as they're stored in each file
+		std::vector<std::vector<uint32_t>> formIDs(files.size());
+		std::vector<std::vector<std::string>> masterNames(files.size());
+		ParallelFor(files.size(), threadCount, [&](size_t index)
+		{
+			thread_local std::vector<std::byte> buffer;
+
+			FormIDIndexPlugin& plugin = m_Plugins[index];
+			const std::u8string name = files[index].filename().u8string();
+			plugin.Name.assign(reinterpret_cast<const char*>(name.data()), name.size());
+
+			MappedByteSource source(files[index]);
+			if (!source.IsOpen())
+			{
+				return;
+			}
+
+			const std::span<const std::byte> data = ReadModuleHeaderData(source, buffer);
+			ModuleHeader header;
+			if (ParseModuleHeader(data, header) == ParseStatus::UnknownFormat || header.FormatLevel == FormatLevel::Morrowind)
+			{
+				// TES3 records are identified by editor IDs, not FormIDs
+				return;
+			}
+			masterNames[index] = ModuleInfo::FromHeader(data, header).Masters;
+
+			std::vector<uint32_t>& items = formIDs[index];
+			const RecordStats stats = WalkRecords(source, header, {}, [&](const RecordEntry& record)
+			{
+				items.push_back(record.FormID);
+			});
+			plugin.Status = stats.Status;
+			plugin.Records = stats.Records;
+		});
+
+		// Link masters to load order positions
+		std::unordered_map<std::string, uint32_t> positions;
+		for (size_t i = 0; i < m_Plugins.size(); i++)
+		{
+			positions.emplace(MetadataCache::NormalizeName(m_Plugins[i].Name), static_cast<uint32_t>(i));
+		}
+
+		// Only records with the plugin's own mod index introduce new forms, which bounds the table size
+		uint64_t totalRecords = 0;
+		uint64_t newForms = 0;
+		for (size_t i = 0; i < m_Plugins.size(); i++)
+		{
+			for (const std::string& master: masterNames[i])
+			{
+				auto it = positions.find(MetadataCache::NormalizeName(master));
+				m_Plugins[i].Masters.push_back(it != positions.end() ? it->second : MissingMaster);
+			}
+
+			totalRecords += formIDs[i].size();
+			newForms += std::count_if(formIDs[i].begin(), formIDs[i].end(), [&](uint32_t formID)
+			{
+				return (formID >> 24) >= masterNames[i].size();
+			});
+		}
+
+		// Insert in load order so every chain ends up ordered by it, the winner being the last plugin
+		Reserve(newForms);
+		m_Definitions.reserve(totalRecords);
+		for (uint32_t i = 0; i < m_Plugins.size(); i++)
+		{
+			FormIDIndexPlugin& plugin = m_Plugins[i];
+			for (uint32_t localFormID: formIDs[i])
+			{
+				const std::optional<GlobalFormID> formID = ToGlobalFormID(i, localFormID);
+				if (!formID)
+				{
+					m_Orphans++;
+					continue;
+				}
+
+				if (GetFormIDPlugin(*formID) != i)
+				{
+					plugin.Overrides.push_back(*formID);
+				}
+				Insert(*formID, i);
+			}
+			std::vector<uint32_t>().swap(formIDs[i]);
+
+			std::sort(plugin.Overrides.begin(), plugin.Overrides.end());
+			plugin.Overrides.erase(std::unique(plugin.Overrides.begin(), plugin.Overrides.end()), plugin.Overrides.end());
+			plugin.Overrides.shrink_to_fit();
+		}
+	}
+
+	std::optional<uint32_t> FormIDIndex::FindPlugin(std::string_view name) const
+	{
+		const std::string key = MetadataCache::NormalizeName(name);
+		for (size_t i = 0; i < m_Plugins.size(); i++)
+		{
+			if (MetadataCache::NormalizeName(m_Plugins[i].Name) == key)
+			{
+				return static_cast<uint32_t>(i);
+			}
+		}
+		return {};
+	}
+	std::optional<GlobalFormID> FormIDIndex::ToGlobalFormID(uint32_t plugin, uint32_t localFormID) const noexcept
+	{
+		// Mod index past the master list means the plugin itself
+		const std::vector<uint32_t>& masters = m_Plugins[plugin].Masters;
+		const uint32_t modIndex = localFormID >> 24;
+		if (modIndex < masters.size())
+		{
+			if (masters[modIndex] == MissingMaster)
+			{
+				return {};
+			}
+			return MakeGlobalFormID(masters[modIndex], localFormID);
+		}
+		return MakeGlobalFormID(plugin, localFormID);
+	}
+
+	std::vector<uint32_t> FormIDIndex::FindDefinitions(GlobalFormID formID) const
+	{
+		std::vector<uint32_t> plugins;
+		if (!m_Keys.empty())
+		{
+			const size_t slot = FindSlot(formID);
+			for (uint32_t i = m_Keys[slot] == formID ? m_Heads[slot] : NoDefinition; i != NoDefinition; i = m_Definitions[i].Previous)
+			{
+				plugins.push_back(m_Definitions[i].Plugin);
+			}
+			std::reverse(plugins.begin(), plugins.end());
+		}
+		return plugins;
+	}
+	std::optional<uint32_t> FormIDIndex::FindWinner(GlobalFormID formID) const noexcept
+	{
+		if (!m_Keys.empty())
+		{
+			const size_t slot = FindSlot(formID);
+			if (m_Keys[slot] == formID)
+			{
+				return m_Definitions[m_Heads[slot]].Plugin;
+			}
+		}
+		return {};
+	}
+
+	FormIDIndexStats FormIDIndex::GetStats() const noexcept
+	{
+		FormIDIndexStats stats;
+		stats.Plugins = m_Plugins.size();
+		stats.Forms = m_Forms;
+		stats.Orphans = m_Orphans;
+		stats.MemoryUsage = m_Keys.capacity() * sizeof(GlobalFormID) + m_Heads.capacity() * sizeof(uint32_t) + m_Definitions.capacity() * sizeof(Definition);
+		for (const FormIDIndexPlugin& plugin: m_Plugins)
+		{
+			stats.Records += plugin.Records;
+			stats.Overrides += plugin.Overrides.size();
+			stats.MemoryUsage += sizeof(plugin) + plugin.Name.capacity() + plugin.Masters.capacity() * sizeof(uint32_t) + plugin.Overrides.capacity() * sizeof(GlobalFormID);
+		}
+		return stats;
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "ModuleHeader.h"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// FormID independent of any master list: load order position of the plugin that introduced the form in the high
+	// half and its object ID in the low one. Local FormIDs store the index into the plugin's own master list instead.
+	using GlobalFormID = uint64_t;
+
+	constexpr GlobalFormID MakeGlobalFormID(uint32_t plugin, uint32_t objectID) noexcept
+	{
+		return static_cast<uint64_t>(plugin) << 32|(objectID & 0x00FFFFFFu);
+	}
+	constexpr uint32_t GetFormIDPlugin(GlobalFormID formID) noexcept
+	{
+		return static_cast<uint32_t>(formID >> 32);
+	}
+	constexpr uint32_t GetFormIDObject(GlobalFormID formID) noexcept
+	{
+		return static_cast<uint32_t>(formID & 0x00FFFFFFu);
+	}
+
+	struct FormIDIndexPlugin final
+	{
+		std::string Name;
+		ParseStatus Status = ParseStatus::UnknownFormat;
+		uint64_t Records = 0;
+
+		// Load order positions of the masters, missing ones are 'MissingMaster'
+		std::vector<uint32_t> Masters;
+
+		// Forms of other plugins this one overrides, sorted
+		std::vector<GlobalFormID> Overrides;
+	};
+
+	struct FormIDIndexStats final
+	{
+		size_t Plugins = 0;
+		uint64_t Records = 0;
+		uint64_t Forms = 0;
+		uint64_t Overrides = 0;
+
+		// Records referring to a master that isn't in the load order
+		uint64_t Orphans = 0;
+
+		size_t MemoryUsage = 0;
+	};
+
+	// Who defines and overrides every form of a load order.
+	//
+	// Forms are keyed by global FormID in an open addressing table with linear probing. Each slot points to the
+	// latest definition of its form and definitions of the same form are chained from the winning one back to the
+	// plugin that introduced it, so the table itself stays at 12 bytes per slot however many overrides there are.
+	class FormIDIndex final
+	{
+		public:
+			static constexpr uint32_t MissingMaster = std::numeric_limits<uint32_t>::max();
+
+		private:
+			static constexpr GlobalFormID EmptyKey = std::numeric_limits<uint64_t>::max();
+			static constexpr uint32_t NoDefinition = std::numeric_limits<uint32_t>::max();
+
+			struct Definition final
+			{
+				uint32_t Plugin = 0;
+				uint32_t Previous = NoDefinition;
+			};
+
+		private:
+			std::vector<GlobalFormID> m_Keys;
+			std::vector<uint32_t> m_Heads;
+			std::vector<Definition> m_Definitions;
+			std::vector<FormIDIndexPlugin> m_Plugins;
+			size_t m_Forms = 0;
+			uint64_t m_Orphans = 0;
+
+		private:
+			size_t FindSlot(GlobalFormID formID) const noexcept;
+			void Rehash(size_t capacity);
+			void Insert(GlobalFormID formID, uint32_t plugin);
+
+		public:
+			// Prepares the table for this many distinct forms without rehashing
+			void Reserve(size_t forms);
+			void Clear();
+
+			// Walks plugins given in load order on up to 'threadCount' threads and indexes all of their records.
+			// Replaces whatever was indexed before.
+			void Build(const std::vector<std::filesystem::path>& files, size_t threadCount);
+
+		public:
+			const std::vector<FormIDIndexPlugin>& GetPlugins() const noexcept
+			{
+				return m_Plugins;
+			}
+			std::optional<uint32_t> FindPlugin(std::string_view name) const;
+
+			// Converts a FormID as stored in the given plugin
+			std::optional<GlobalFormID> ToGlobalFormID(uint32_t plugin, uint32_t localFormID) const noexcept;
+
+			// Every plugin defining the form in load order: the one introducing it first and the winning one last
+			std::vector<uint32_t> FindDefinitions(GlobalFormID formID) const;
+			std::optional<uint32_t> FindWinner(GlobalFormID formID) const noexcept;
+
+			// Forms of other plugins the plugin overrides
+			const std::vector<GlobalFormID>& GetOverrides(uint32_t plugin) const noexcept
+			{
+				return m_Plugins[plugin].Overrides;
+			}
+
+			FormIDIndexStats GetStats() const noexcept;
+	};
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace BethesdaModule::Core
+{
+	struct FreeListStats final
+	{
+		size_t Reused = 0;
+		size_t Stored = 0;
+		size_t Overflows = 0;
+	};
+
+	// Lock-free, bounded store of objects kept for reuse. Every slot is a single atomic pointer that is either
+	// claimed with a compare-exchange or emptied with an exchange, so no thread ever waits for another and there's
+	// no ABA problem to guard against. Objects that don't fit are handed back to be freed by the caller.
+	template<class T, size_t Capacity = 32>
+	class BoundedFreeList final
+	{
+		private:
+			std::array<std::atomic<T*>, Capacity> m_Slots = {};
+
+			// Where the last object was put, the next search starts there
+			std::atomic<size_t> m_Hint = 0;
+
+			std::atomic<size_t> m_Reused = 0;
+			std::atomic<size_t> m_Stored = 0;
+			std::atomic<size_t> m_Overflows = 0;
+
+		public:
+			BoundedFreeList() noexcept = default;
+			BoundedFreeList(const BoundedFreeList&) = delete;
+			~BoundedFreeList()
+			{
+				Clear();
+			}
+
+		public:
+			// Returns a stored object or null if there's none
+			std::unique_ptr<T> Pop() noexcept
+			{
+				const size_t start = m_Hint.load(std::memory_order_relaxed);
+				for (size_t i = 0; i < Capacity; i++)
+				{
+					std::atomic<T*>& slot = m_Slots[(start + Capacity - i) % Capacity];
+					if (slot.load(std::memory_order_relaxed))
+					{
+						if (T* object = slot.exchange(nullptr, std::memory_order_acquire))
+						{
+							m_Reused.fetch_add(1, std::memory_order_relaxed);
+							return std::unique_ptr<T>(object);
+						}
+					}
+				}
+				return nullptr;
+			}
+
+			// Returns the object back if every slot is taken
+			std::unique_ptr<T> Push(std::unique_ptr<T> object) noexcept
+			{
+				const size_t start = m_Hint.load(std::memory_order_relaxed);
+				for (size_t i = 0; i < Capacity; i++)
+				{
+					const size_t index = (start + i) % Capacity;
+					T* expected = nullptr;
+					if (m_Slots[index].load(std::memory_order_relaxed) == nullptr && m_Slots[index].compare_exchange_strong(expected, object.get(), std::memory_order_release, std::memory_order_relaxed))
+					{
+						object.release();
+						m_Hint.store(index, std::memory_order_relaxed);
+						m_Stored.fetch_add(1, std::memory_order_relaxed);
+						return nullptr;
+					}
+				}
+				m_Overflows.fetch_add(1, std::memory_order_relaxed);
+				return object;
+			}
+
+			// Frees every stored object
+			void Clear() noexcept
+			{
+				for (std::atomic<T*>& slot: m_Slots)
+				{
+					delete slot.exchange(nullptr, std::memory_order_acquire);
+				}
+			}
+
+			FreeListStats GetStats() const noexcept
+			{
+				FreeListStats stats;
+				stats.Reused = m_Reused.load(std::memory_order_relaxed);
+				stats.Stored = m_Stored.load(std::memory_order_relaxed);
+				stats.Overflows = m_Overflows.load(std::memory_order_relaxed);
+				return stats;
+			}
+
+		public:
+			BoundedFreeList& operator=(const BoundedFreeList&) = delete;
+	};
+}
@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "LZ4.h"
+#include "BinaryIO.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	constexpr uint32_t FrameMagic = 0x184D2204;
+	constexpr size_t MinMatch = 4;
+
+	// The format requires the last match to start this far from the end and the last 5 bytes to be literals
+	constexpr size_t MatchStartMargin = 12;
+	constexpr size_t LastLiterals = 5;
+
+	uint32_t LoadU32(const std::byte* data) noexcept
+	{
+		uint32_t value = 0;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Token nibbles of 15 continue with bytes of 255 until a smaller one
+	bool ReadLength(const std::byte*& input, const std::byte* inputEnd, size_t& length) noexcept
+	{
+		if (length == 15)
+		{
+			uint8_t value = 0;
+			do
+			{
+				if (input == inputEnd)
+				{
+					return false;
+				}
+				value = static_cast<uint8_t>(*input++);
+				length += value;
+			}
+			while (value == 255);
+		}
+		return true;
+	}
+	void WriteLength(std::vector<std::byte>& output, size_t length)
+	{
+		for (length -= 15; length >= 255; length -= 255)
+		{
+			output.push_back(std::byte(255));
+		}
+		output.push_back(static_cast<std::byte>(length));
+	}
+	void WriteSequence(std::vector<std::byte>& output, std::span<const std::byte> literals, size_t offset, size_t matchLength)
+	{
+		const size_t matchCode = matchLength != 0 ? matchLength - MinMatch : 0;
+		output.push_back(static_cast<std::byte>(std::min<size_t>(literals.size(), 15) << 4|std::min<size_t>(matchCode, 15)));
+		if (literals.size() >= 15)
+		{
+			WriteLength(output, literals.size());
+		}
+		output.insert(output.end(), literals.begin(), literals.end());
+
+		if (matchLength != 0)
+		{
+			output.push_back(static_cast<std::byte>(offset & 0xFF));
+			output.push_back(static_cast<std::byte>(offset >> 8));
+			if (matchCode >= 15)
+			{
+				WriteLength(output, matchCode);
+			}
+		}
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::optional<size_t> DecodeLZ4Block(std::span<const std::byte> block, std::span<std::byte> output, size_t outputOffset) noexcept
+	{
+		const std::byte* input = block.data();
+		const std::byte* inputEnd = input + block.size();
+		std::byte* const outputStart = output.data();
+		std::byte* const outputEnd = outputStart + output.size();
+		std::byte* out = outputStart + std::min(outputOffset, output.size());
+		std::byte* const blockStart = out;
+
+		while (input < inputEnd)
+		{
+			const uint8_t token = static_cast<uint8_t>(*input++);
+
+			size_t literalLength = token >> 4;
+			if (!ReadLength(input, inputEnd, literalLength) || literalLength > static_cast<size_t>(inputEnd - input) || literalLength > static_cast<size_t>(outputEnd - out))
+			{
+				return {};
+			}
+			std::memcpy(out, input, literalLength);
+			input += literalLength;
+			out += literalLength;
+
+			// The last sequence has literals only
+			if (input == inputEnd)
+			{
+				break;
+			}
+			if (inputEnd - input < 2)
+			{
+				return {};
+			}
+
+			const size_t offset = static_cast<uint8_t>(input[0])|static_cast<size_t>(static_cast<uint8_t>(input[1])) << 8;
+			input += 2;
+
+			size_t matchLength = token & 0x0F;
+			if (offset == 0 || offset > static_cast<size_t>(out - outputStart) || !ReadLength(input, inputEnd, matchLength))
+			{
+				return {};
+			}
+			matchLength += MinMatch;
+			if (matchLength > static_cast<size_t>(outputEnd - out))
+			{
+				return {};
+			}
+
+			// Overlapping matches repeat the last 'offset' bytes, they have to be copied forward one at a time
+			const std::byte* match = out - offset;
+			if (offset >= matchLength)
+			{
+				std::memcpy(out, match, matchLength);
+				out += matchLength;
+			}
+			else
+			{
+				for (size_t i = 0; i < matchLength; i++)
+				{
+					*out++ = *match++;
+				}
+			}
+		}
+		return static_cast<size_t>(out - blockStart);
+	}
+
+	bool DecodeLZ4Frame(std::span<const std::byte> frame, std::vector<std::byte>& output, size_t expectedSize)
+	{
+		BinaryReader reader(frame);
+		if (reader.Read<uint32_t>() != FrameMagic)
+		{
+			return false;
+		}
+
+		// Version has to be 01, dictionaries aren't supported
+		const uint8_t flags = reader.Read<uint8_t>();
+		reader.Skip(1);
+		if ((flags >> 6) != 1 || (flags & 0x01))
+		{
+			return false;
+		}
+		const bool blockChecksum = flags & 0x10;
+		const bool contentSize = flags & 0x08;
+		const bool contentChecksum = flags & 0x04;
+
+		size_t size = expectedSize;
+		if (contentSize)
+		{
+			const uint64_t declaredSize = reader.Read<uint64_t>();
+			if (declaredSize > expectedSize)
+			{
+				return false;
+			}
+			size = static_cast<size_t>(declaredSize);
+		}
+		reader.Skip(1);
+		output.resize(size);
+
+		size_t offset = 0;
+		while (reader.IsOk())
+		{
+			const uint32_t blockSize = reader.Read<uint32_t>();
+			if (blockSize == 0)
+			{
+				break;
+			}
+
+			// High bit marks blocks stored as is
+			const std::span<const std::byte> block = reader.ReadBytes(blockSize & 0x7FFFFFFFu);
+			if (!reader.IsOk())
+			{
+				return false;
+			}
+			if (blockSize & 0x80000000u)
+			{
+				if (block.size() > size - offset)
+				{
+					return false;
+				}
+				std::memcpy(output.data() + offset, block.data(), block.size());
+				offset += block.size();
+			}
+			else if (auto written = DecodeLZ4Block(block, output, offset))
+			{
+				offset += *written;
+			}
+			else
+			{
+				return false;
+			}
+
+			if (blockChecksum)
+			{
+				reader.Skip(sizeof(uint32_t));
+			}
+		}
+		if (contentChecksum)
+		{
+			reader.Skip(sizeof(uint32_t));
+		}
+		return reader.IsOk() && offset == size;
+	}
+
+	std::vector<std::byte> EncodeLZ4Block(std::span<const std::byte> data)
+	{
+		std::vector<std::byte> output;
+		output.reserve(data.size() + data.size() / 255 + 16);
+
+		// Last position of every hashed 4-byte sequence, one-based so zero is empty
+		constexpr size_t hashBits = 12;
+		std::vector<uint32_t> table(size_t(1) << hashBits);
+		auto Hash = [](uint32_t value)
+		{
+			return (value * 2654435761u) >> (32 - hashBits);
+		};
+
+		size_t anchor = 0;
+		size_t position = 0;
+		while (data.size() >= MatchStartMargin && position <= data.size() - MatchStartMargin)
+		{
+			const uint32_t value = LoadU32(data.data() + position);
+			uint32_t& slot = table[Hash(value)];
+			const size_t candidate = slot;
+			slot = static_cast<uint32_t>(position + 1);
+
+			if (candidate != 0 && position - (candidate - 1) <= 0xFFFF && LoadU32(data.data() + candidate - 1) == value)
+			{
+				const size_t matchStart = candidate - 1;
+				size_t length = MinMatch;
+				while (position + length < data.size() - LastLiterals && data[matchStart + length] == data[position + length])
+				{
+					length++;
+				}
+
+				WriteSequence(output, data.subspan(anchor, position - anchor), position - matchStart, length);
+				position += length;
+				anchor = position;
+			}
+			else
+			{
+				position++;
+			}
+		}
+		WriteSequence(output, data.subspan(anchor), 0, 0);
+		return output;
+	}
+	std::vector<std::byte> EncodeLZ4Frame(std::span<const std::byte> data)
+	{
+		// Version 01, independent blocks, content size present, 4 MiB blocks. The header checksum isn't verified
+		// when decoding and is left zero.
+		std::vector<std::byte> output(15);
+		BinaryWriter writer(output);
+		writer.Patch(0, FrameMagic);
+		writer.Patch<uint8_t>(4, 0x68);
+		writer.Patch<uint8_t>(5, 0x70);
+		writer.Patch(6, static_cast<uint64_t>(data.size()));
+
+		constexpr size_t blockSize = 4 * 1024 * 1024;
+		for (size_t offset = 0; offset < data.size(); offset += blockSize)
+		{
+			const std::span<const std::byte> block = data.subspan(offset, std::min(blockSize, data.size() - offset));
+			const std::vector<std::byte> encoded = EncodeLZ4Block(block);
+			if (encoded.size() < block.size())
+			{
+				writer.Write(static_cast<uint32_t>(encoded.size()));
+				writer.Write(encoded.data(), encoded.size());
+			}
+			else
+			{
+				writer.Write(static_cast<uint32_t>(block.size())|0x80000000u);
+				writer.Write(block.data(), block.size());
+			}
+		}
+		writer.Write<uint32_t>(0);
+		return output;
+	}
+}
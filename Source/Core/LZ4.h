@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// Decodes a raw LZ4 block into 'output', which has to have room for the whole decoded data. Matches may refer
+	// to anything in 'output' before the block, so blocks of a linked frame can be decoded one after another into
+	// a single buffer by passing where the block starts. Returns the number of bytes written or nothing if the block
+	// is malformed or doesn't fit.
+	std::optional<size_t> DecodeLZ4Block(std::span<const std::byte> block, std::span<std::byte> output, size_t outputOffset = 0) noexcept;
+
+	// Decodes an LZ4 frame, what Skyrim Special Edition stores compressed archive entries as. 'output' is resized
+	// to the content size if the frame declares one and to 'expectedSize' otherwise. Checksums are skipped.
+	bool DecodeLZ4Frame(std::span<const std::byte> frame, std::vector<std::byte>& output, size_t expectedSize);
+
+	// Greedy single-pass encoder, fast rather than small. Only used to generate test archives.
+	std::vector<std::byte> EncodeLZ4Block(std::span<const std::byte> data);
+	std::vector<std::byte> EncodeLZ4Frame(std::span<const std::byte> data);
+}
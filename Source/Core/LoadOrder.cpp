@@ -0,0 +1,381 @@
+#include "stdafx.h"
+#include "LoadOrder.h"
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <tuple>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	constexpr size_t g_NotRequested = std::numeric_limits<size_t>::max();
+
+	bool HasExtension(std::string_view name, std::string_view extension) noexcept
+	{
+		if (name.size() < extension.size())
+		{
+			return false;
+		}
+
+		const std::string_view tail = name.substr(name.size() - extension.size());
+		return std::equal(tail.begin(), tail.end(), extension.begin(), [](char left, char right)
+		{
+			return (left >= 'A' && left <= 'Z' ? left + ('a' - 'A') : left) == right;
+		});
+	}
+	std::string_view TrimLine(std::string_view line) noexcept
+	{
+		while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+		{
+			line.remove_suffix(1);
+		}
+		while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+		{
+			line.remove_prefix(1);
+		}
+		return line;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::string_view GetLoadOrderIssueName(LoadOrderIssueType type) noexcept
+	{
+		switch (type)
+		{
+			case LoadOrderIssueType::MissingMaster:
+			{
+				return "missing-master";
+			}
+			case LoadOrderIssueType::MissingPlugin:
+			{
+				return "missing-plugin";
+			}
+			case LoadOrderIssueType::Cycle:
+			{
+				return "cycle";
+			}
+			case LoadOrderIssueType::MasterAfterDependent:
+			{
+				return "master-after-dependent";
+			}
+			case LoadOrderIssueType::FullSlotsExceeded:
+			{
+				return "full-slots-exceeded";
+			}
+			case LoadOrderIssueType::LightSlotsExceeded:
+			{
+				return "light-slots-exceeded";
+			}
+		};
+		return "unknown";
+	}
+
+	bool LoadOrderGraph::IsLightPlugin(std::string_view name, const ModuleInfo& info) noexcept
+	{
+		// The flag is only honored since Skyrim SE
+		if (HasExtension(name, ".esl"))
+		{
+			return true;
+		}
+		return TestFlag(info.Flags, HeaderFlags::Light) && info.FormatLevel == FormatLevel::Skyrim && info.FormVersion >= 44;
+	}
+	bool LoadOrderGraph::IsMasterPlugin(std::string_view name, const ModuleInfo& info) noexcept
+	{
+		return TestFlag(info.Flags, HeaderFlags::Master) || HasExtension(name, ".esm") || HasExtension(name, ".esl");
+	}
+
+	bool LoadOrderGraph::Contains(std::string_view name) const
+	{
+		auto handle = m_Names.Find(name);
+		return handle && m_Nodes.find(*handle) != m_Nodes.end();
+	}
+	void LoadOrderGraph::Update(std::string name, const ModuleInfo& info)
+	{
+		Node node;
+		node.IsMaster = IsMasterPlugin(name, info);
+		node.IsLight = IsLightPlugin(name, info);
+		node.Masters.reserve(info.Masters.size());
+		for (const std::string& master: info.Masters)
+		{
+			node.Masters.push_back(m_Names.Intern(master));
+		}
+
+		const StringPool::THandle handle = m_Names.Intern(name);
+		node.Name = std::move(name);
+		m_Nodes.insert_or_assign(handle, std::move(node));
+	}
+	bool LoadOrderGraph::Remove(std::string_view name)
+	{
+		auto handle = m_Names.Find(name);
+		return handle && m_Nodes.erase(*handle) != 0;
+	}
+	void LoadOrderGraph::Clear()
+	{
+		// Names stay interned, the same plugins are usually added back
+		m_Nodes.clear();
+		m_RequestedOrder.clear();
+	}
+
+	LoadOrderResult LoadOrderGraph::Resolve() const
+	{
+		LoadOrderResult result;
+
+		// Pick the plugins to resolve and remember where the user wants them
+		std::vector<const Node*> nodes;
+		std::vector<size_t> positions;
+		std::unordered_map<StringPool::THandle, uint32_t> indices;
+		auto AddNode = [&](StringPool::THandle key, const Node& node, size_t position)
+		{
+			if (indices.emplace(key, static_cast<uint32_t>(nodes.size())).second)
+			{
+				nodes.push_back(&node);
+				positions.push_back(position);
+			}
+		};
+
+		if (m_RequestedOrder.empty())
+		{
+			nodes.reserve(m_Nodes.size());
+			for (const auto& [key, node]: m_Nodes)
+			{
+				AddNode(key, node, g_NotRequested);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < m_RequestedOrder.size(); i++)
+			{
+				const auto handle = m_Names.Find(m_RequestedOrder[i]);
+				if (auto it = handle ? m_Nodes.find(*handle) : m_Nodes.end(); it != m_Nodes.end())
+				{
+					AddNode(it->first, it->second, i);
+				}
+				else
+				{
+					result.Issues.push_back({LoadOrderIssueType::MissingPlugin, m_RequestedOrder[i], {}});
+				}
+			}
+
+			// Masters of active plugins are loaded even if they aren't listed, the base game files never are
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				for (StringPool::THandle master: nodes[i]->Masters)
+				{
+					if (auto it = m_Nodes.find(master); it != m_Nodes.end())
+					{
+						AddNode(it->first, it->second, g_NotRequested);
+					}
+				}
+			}
+		}
+
+		// Link masters
+		const size_t count = nodes.size();
+		std::vector<std::vector<uint32_t>> masters(count);
+		std::vector<std::vector<uint32_t>> dependents(count);
+		std::vector<uint32_t> inDegree(count, 0);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Node& node = *nodes[i];
+			for (StringPool::THandle master: node.Masters)
+			{
+				if (auto it = indices.find(master); it != indices.end())
+				{
+					masters[i].push_back(it->second);
+					dependents[it->second].push_back(i);
+					inDegree[i]++;
+				}
+				else
+				{
+					result.Issues.push_back({LoadOrderIssueType::MissingMaster, node.Name, {std::string(m_Names.Get(master))}});
+				}
+			}
+		}
+
+		// Kahn's algorithm, the queue yields the plugin that should load first among those whose masters are all loaded
+		auto GetPriority = [&](uint32_t index)
+		{
+			return std::make_tuple(!nodes[index]->IsMaster, positions[index], std::string_view(nodes[index]->Name));
+		};
+		auto Compare = [&](uint32_t left, uint32_t right)
+		{
+			return GetPriority(left) > GetPriority(right);
+		};
+		std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(Compare)> ready(Compare);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (inDegree[i] == 0)
+			{
+				ready.push(i);
+			}
+		}
+
+		std::vector<uint32_t> order;
+		order.reserve(count);
+		while (!ready.empty())
+		{
+			const uint32_t index = ready.top();
+			ready.pop();
+			order.push_back(index);
+
+			for (uint32_t dependent: dependents[index])
+			{
+				if (--inDegree[dependent] == 0)
+				{
+					ready.push(dependent);
+				}
+			}
+		}
+
+		// Whatever is left is either part of a cycle or depends on one. Every such plugin has at least one master
+		// that is left too, so following them from any of these plugins ends up going around a cycle.
+		if (order.size() != count)
+		{
+			enum class Mark: uint8_t
+			{
+				None,
+				OnPath,
+				Done
+			};
+			std::vector<Mark> marks(count, Mark::None);
+			std::vector<uint32_t> remaining;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (inDegree[i] != 0)
+				{
+					remaining.push_back(i);
+				}
+			}
+
+			std::vector<uint32_t> path;
+			for (uint32_t start: remaining)
+			{
+				uint32_t index = start;
+				while (marks[index] == Mark::None)
+				{
+					marks[index] = Mark::OnPath;
+					path.push_back(index);
+
+					auto it = std::find_if(masters[index].begin(), masters[index].end(), [&](uint32_t master)
+					{
+						return inDegree[master] != 0;
+					});
+					index = *it;
+				}
+
+				if (marks[index] == Mark::OnPath)
+				{
+					LoadOrderIssue issue;
+					issue.Type = LoadOrderIssueType::Cycle;
+					issue.Plugin = nodes[index]->Name;
+					for (auto it = std::find(path.begin(), path.end(), index) + 1; it != path.end(); ++it)
+					{
+						issue.Related.push_back(nodes[*it]->Name);
+					}
+					result.Issues.push_back(std::move(issue));
+				}
+				for (uint32_t item: path)
+				{
+					marks[item] = Mark::Done;
+				}
+				path.clear();
+			}
+
+			std::sort(remaining.begin(), remaining.end(), [&](uint32_t left, uint32_t right)
+			{
+				return GetPriority(left) < GetPriority(right);
+			});
+			order.insert(order.end(), remaining.begin(), remaining.end());
+		}
+
+		// Check the requested order itself
+		if (!m_RequestedOrder.empty())
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				for (uint32_t master: masters[i])
+				{
+					if (positions[i] != g_NotRequested && positions[master] != g_NotRequested && positions[master] > positions[i])
+					{
+						result.Issues.push_back({LoadOrderIssueType::MasterAfterDependent, nodes[i]->Name, {nodes[master]->Name}});
+					}
+				}
+			}
+		}
+
+		// Assign mod indices
+		result.Order.reserve(count);
+		for (uint32_t index: order)
+		{
+			const Node& node = *nodes[index];
+
+			LoadOrderEntry& entry = result.Order.emplace_back();
+			entry.Name = node.Name;
+			entry.IsLight = node.IsLight;
+
+			size_t& slots = node.IsLight ? result.LightSlots : result.FullSlots;
+			if (slots < (node.IsLight ? MaxLightPlugins : MaxFullPlugins))
+			{
+				entry.Slot = static_cast<uint32_t>(slots);
+			}
+			else
+			{
+				result.Issues.push_back({node.IsLight ? LoadOrderIssueType::LightSlotsExceeded : LoadOrderIssueType::FullSlotsExceeded, node.Name, {}});
+			}
+			slots++;
+		}
+		return result;
+	}
+
+	std::optional<std::vector<std::string>> ReadPluginList(const std::filesystem::path& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream)
+		{
+			return {};
+		}
+
+		std::vector<std::string> names;
+		std::vector<bool> active;
+		bool hasActiveMarks = false;
+
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			std::string_view name = TrimLine(line);
+			if (names.empty() && name.starts_with("\xEF\xBB\xBF"))
+			{
+				name.remove_prefix(3);
+			}
+			if (name.empty() || name.front() == '#')
+			{
+				continue;
+			}
+
+			const bool isActive = name.front() == '*';
+			if (isActive)
+			{
+				name.remove_prefix(1);
+				hasActiveMarks = true;
+			}
+			names.emplace_back(name);
+			active.push_back(isActive);
+		}
+
+		if (hasActiveMarks)
+		{
+			std::vector<std::string> activeNames;
+			for (size_t i = 0; i < names.size(); i++)
+			{
+				if (active[i])
+				{
+					activeNames.push_back(std::move(names[i]));
+				}
+			}
+			return activeNames;
+		}
+		return names;
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "ModuleInfo.h"
+#include "StringPool.h"
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+
+namespace BethesdaModule::Core
+{
+	enum class LoadOrderIssueType
+	{
+		// A plugin requires a master that isn't known
+		MissingMaster,
+
+		// A plugin listed in the requested order isn't known
+		MissingPlugin,
+
+		// Plugins require each other, directly or through other plugins. They're appended in requested order.
+		Cycle,
+
+		// The requested order places a plugin before one of its masters
+		MasterAfterDependent,
+
+		// More plugins than the game can address
+		FullSlotsExceeded,
+		LightSlotsExceeded,
+	};
+	std::string_view GetLoadOrderIssueName(LoadOrderIssueType type) noexcept;
+
+	struct LoadOrderIssue final
+	{
+		LoadOrderIssueType Type = LoadOrderIssueType::MissingMaster;
+
+		// Name of the plugin the issue is about, 'Related' is the master for master issues and every other
+		// member of the cycle for cycles.
+		std::string Plugin;
+		std::vector<std::string> Related;
+	};
+
+	struct LoadOrderEntry final
+	{
+		std::string Name;
+		bool IsLight = false;
+
+		// Index of the plugin in its slot range: 0-253 for full plugins and 0-4095 for light ones ('FE:xxx').
+		// Plugins over the limit get no slot.
+		std::optional<uint32_t> Slot;
+	};
+
+	struct LoadOrderResult final
+	{
+		std::vector<LoadOrderEntry> Order;
+		std::vector<LoadOrderIssue> Issues;
+		size_t FullSlots = 0;
+		size_t LightSlots = 0;
+	};
+
+	// Master dependencies between plugins of one game.
+	//
+	// Plugins are identified by file name ignoring ASCII case, the same way master names are matched by the games.
+	// Names are interned, so plugins and masters are linked by comparing handles. Linking happens when the order is
+	// resolved, so adding, replacing or removing a single plugin after a file has changed doesn't touch anything else
+	// and the next 'Resolve' call picks the change up.
+	class LoadOrderGraph final
+	{
+		public:
+			// Mod index 0xFE is taken by light plugins, 0xFF by runtime forms
+			static constexpr size_t MaxFullPlugins = 254;
+			static constexpr size_t MaxLightPlugins = 4096;
+
+			static bool IsLightPlugin(std::string_view name, const ModuleInfo& info) noexcept;
+			static bool IsMasterPlugin(std::string_view name, const ModuleInfo& info) noexcept;
+
+		private:
+			struct Node final
+			{
+				std::string Name;
+				std::vector<StringPool::THandle> Masters;
+				bool IsMaster = false;
+				bool IsLight = false;
+			};
+
+		private:
+			StringPool m_Names;
+			std::unordered_map<StringPool::THandle, Node> m_Nodes;
+			std::vector<std::string> m_RequestedOrder;
+
+		public:
+			size_t GetCount() const noexcept
+			{
+				return m_Nodes.size();
+			}
+			bool Contains(std::string_view name) const;
+
+			// Adds a plugin or replaces whatever was known about it before
+			void Update(std::string name, const ModuleInfo& info);
+			bool Remove(std::string_view name);
+			void Clear();
+
+			// Active plugins in the order the user wants them, as read from 'plugins.txt' or 'loadorder.txt'. When it's
+			// set only these plugins and the masters they require are resolved, otherwise every known plugin is.
+			void SetRequestedOrder(std::vector<std::string> names)
+			{
+				m_RequestedOrder = std::move(names);
+			}
+			const std::vector<std::string>& GetRequestedOrder() const noexcept
+			{
+				return m_RequestedOrder;
+			}
+
+			// Produces an order where every plugin comes after its masters. Among plugins free to load, master-flagged
+			// ones go first (as the games force them to), then ones earlier in the requested order, then by name.
+			LoadOrderResult Resolve() const;
+	};
+
+	// Reads active plugins from 'plugins.txt' or all plugins from 'loadorder.txt'. Lines starting with '#' are comments,
+	// when any line starts with '*' (the Skyrim SE and Fallout 4 format) only those plugins are active.
+	std::optional<std::vector<std::string>> ReadPluginList(const std::filesystem::path& path);
+}
@@ -0,0 +1,513 @@
+#include "stdafx.h"
+#include "MetadataCache.h"
+#include "ModuleScanner.h"
+#include "BinaryIO.h"
+#include "Checksum.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	// Don't bother compacting small logs
+	constexpr size_t g_MinDeadRecordsToCompact = 64;
+
+	// Exclusive lock on '<log>.lock', held while the log is read or written. The log itself isn't locked, so
+	// processes that only have it open for appending don't keep anyone from reading it.
+	class FileLock final
+	{
+		private:
+			#if defined(_WIN32)
+			HANDLE m_Handle = INVALID_HANDLE_VALUE;
+			#else
+			int m_Handle = -1;
+			#endif
+
+		public:
+			FileLock(std::filesystem::path path) noexcept
+			{
+				path += ".lock";
+
+				#if defined(_WIN32)
+				m_Handle = ::CreateFileW(path.c_str(), GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+				OVERLAPPED overlapped = {};
+				if (m_Handle != INVALID_HANDLE_VALUE && !::LockFileEx(m_Handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped))
+				{
+					::CloseHandle(m_Handle);
+					m_Handle = INVALID_HANDLE_VALUE;
+				}
+				#else
+				m_Handle = ::open(path.c_str(), O_RDWR|O_CREAT|O_CLOEXEC, 0644);
+				if (m_Handle >= 0)
+				{
+					int result = 0;
+					while ((result = ::flock(m_Handle, LOCK_EX)) != 0 && errno == EINTR)
+					{
+					}
+					if (result != 0)
+					{
+						::close(m_Handle);
+						m_Handle = -1;
+					}
+				}
+				#endif
+			}
+			FileLock(const FileLock&) = delete;
+			~FileLock() noexcept
+			{
+				// Closing the handle releases the lock
+				#if defined(_WIN32)
+				if (m_Handle != INVALID_HANDLE_VALUE)
+				{
+					::CloseHandle(m_Handle);
+				}
+				#else
+				if (m_Handle >= 0)
+				{
+					::close(m_Handle);
+				}
+				#endif
+			}
+
+		public:
+			bool IsLocked() const noexcept
+			{
+				#if defined(_WIN32)
+				return m_Handle != INVALID_HANDLE_VALUE;
+				#else
+				return m_Handle >= 0;
+				#endif
+			}
+
+		public:
+			FileLock& operator=(const FileLock&) = delete;
+	};
+
+	// Makes sure what was written to the file is on the disk, not only in the system's cache
+	bool FlushFileToDisk(const std::filesystem::path& path) noexcept
+	{
+		#if defined(_WIN32)
+		HANDLE handle = ::CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle != INVALID_HANDLE_VALUE)
+		{
+			const bool isFlushed = ::FlushFileBuffers(handle);
+			::CloseHandle(handle);
+			return isFlushed;
+		}
+		#else
+		const int handle = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+		if (handle >= 0)
+		{
+			const bool isFlushed = ::fsync(handle) == 0;
+			::close(handle);
+			return isFlushed;
+		}
+		#endif
+		return false;
+	}
+
+	// Atomically puts 'source' in place of 'target', whoever opens 'target' sees either the old or the new file
+	bool ReplaceFile(const std::filesystem::path& source, const std::filesystem::path& target) noexcept
+	{
+		#if defined(_WIN32)
+		return ::MoveFileExW(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH);
+		#else
+		return ::rename(source.c_str(), target.c_str()) == 0;
+		#endif
+	}
+
+	void WriteFileHeader(std::vector<std::byte>& buffer)
+	{
+		BinaryWriter writer(buffer);
+		writer.Write(MetadataCache::FileMagic);
+		writer.Write(MetadataCache::FormatVersion);
+	}
+	void WriteRecord(std::vector<std::byte>& buffer, std::string_view name, uint64_t fileSize, int64_t lastWriteTime, const ModuleInfo& info)
+	{
+		// Reserve space for size and checksum, patch them after the payload is written
+		BinaryWriter writer(buffer);
+		const size_t recordOffset = writer.GetOffset();
+		writer.Write<uint32_t>(0);
+		writer.Write<uint32_t>(0);
+
+		const size_t payloadOffset = writer.GetOffset();
+		writer.WriteString<uint16_t>(name);
+		writer.Write(fileSize);
+		writer.Write(lastWriteTime);
+		writer.Write(info.Signature);
+		writer.Write(static_cast<uint32_t>(info.Flags));
+		writer.Write(info.FormVersion);
+		writer.Write(static_cast<uint8_t>(info.FormatLevel));
+		writer.WriteString<uint32_t>(info.Author);
+		writer.WriteString<uint32_t>(info.Description);
+		writer.Write(static_cast<uint16_t>(info.Masters.size()));
+		for (const std::string& master: info.Masters)
+		{
+			writer.WriteString<uint16_t>(master);
+		}
+
+		const auto payload = std::span<const std::byte>(buffer).subspan(payloadOffset);
+		writer.Patch(recordOffset, static_cast<uint32_t>(payload.size()));
+		writer.Patch(recordOffset + sizeof(uint32_t), CRC32(payload));
+	}
+	bool ReadRecordPayload(std::span<const std::byte> payload, std::string& name, uint64_t& fileSize, int64_t& lastWriteTime, ModuleInfo& info)
+	{
+		BinaryReader reader(payload);
+		name = reader.ReadString<uint16_t>();
+		fileSize = reader.Read<uint64_t>();
+		lastWriteTime = reader.Read<int64_t>();
+		info.Signature = reader.Read<uint32_t>();
+		info.Flags = static_cast<HeaderFlags>(reader.Read<uint32_t>());
+		info.FormVersion = reader.Read<uint32_t>();
+		info.FormatLevel = static_cast<FormatLevel>(reader.Read<uint8_t>());
+		info.Author = reader.ReadString<uint32_t>();
+		info.Description = reader.ReadString<uint32_t>();
+
+		const size_t masterCount = reader.Read<uint16_t>();
+		info.Masters.clear();
+		for (size_t i = 0; i < masterCount && reader.IsOk(); i++)
+		{
+			info.Masters.emplace_back(reader.ReadString<uint16_t>());
+		}
+		return reader.IsOk() && reader.IsEnd();
+	}
+
+	std::string ToUTF8(const std::filesystem::path& path)
+	{
+		const std::u8string value = path.u8string();
+		return {reinterpret_cast<const char*>(value.data()), value.size()};
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	CacheKey CacheKey::FromFile(const std::filesystem::path& path)
+	{
+		std::error_code error;
+
+		CacheKey key;
+		const std::filesystem::path fullPath = std::filesystem::absolute(path, error);
+		key.Name = MetadataCache::MakeKeyName(error ? path : fullPath);
+		key.FileSize = std::filesystem::file_size(path, error);
+		key.LastWriteTime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+		return key;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::string MetadataCache::NormalizeName(std::string_view name)
+	{
+		std::string result(name);
+		for (char& c: result)
+		{
+			if (c >= 'A' && c <= 'Z')
+			{
+				c += 'a' - 'A';
+			}
+		}
+		return result;
+	}
+	std::string MetadataCache::MakeKeyName(const std::filesystem::path& path)
+	{
+		if (path.has_parent_path())
+		{
+			const std::u8string value = path.lexically_normal().generic_u8string();
+			return NormalizeName({reinterpret_cast<const char*>(value.data()), value.size()});
+		}
+		return NormalizeName(ToUTF8(path.filename()));
+	}
+
+	bool MetadataCache::Load()
+	{
+		FileLock lock(m_FilePath);
+		if (!lock.IsLocked())
+		{
+			return false;
+		}
+
+		// Damaged records would be read past again every time, so the log is rewritten right away
+		if (!ReadLog() || (m_DeadRecords >= g_MinDeadRecordsToCompact && m_DeadRecords > m_Entries.size()))
+		{
+			return WriteLog();
+		}
+		return true;
+	}
+	void MetadataCache::TrimUnlocked()
+	{
+		if (m_Entries.size() <= m_MaxEntries)
+		{
+			return;
+		}
+
+		// Down to three quarters of the limit, so that the next few additions don't trim again
+		const size_t keepCount = m_MaxEntries - m_MaxEntries / 4;
+		const size_t removeCount = m_Entries.size() - keepCount;
+
+		std::vector<uint64_t> sequences;
+		sequences.reserve(m_Entries.size());
+		for (const auto& [name, entry]: m_Entries)
+		{
+			sequences.push_back(entry.Sequence);
+		}
+		std::nth_element(sequences.begin(), sequences.begin() + removeCount, sequences.end());
+
+		// Sequences are unique, so exactly 'removeCount' entries are older than this one
+		const uint64_t oldestKept = sequences[removeCount];
+		std::erase_if(m_Entries, [&](const auto& item)
+		{
+			return item.second.Sequence < oldestKept;
+		});
+		m_DeadRecords += removeCount;
+	}
+	bool MetadataCache::ReadLog()
+	{
+		m_Entries.clear();
+		m_DeadRecords = 0;
+
+		std::vector<std::byte> data;
+		if (std::ifstream stream(m_FilePath, std::ios::binary); stream)
+		{
+			std::error_code error;
+			data.resize(std::filesystem::file_size(m_FilePath, error));
+			stream.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			data.resize(static_cast<size_t>(stream.gcount()));
+		}
+
+		BinaryReader headerReader(data);
+		if (headerReader.Read<uint32_t>() != FileMagic || headerReader.Read<uint32_t>() != FormatVersion || !headerReader.IsOk())
+		{
+			// Missing, foreign or outdated file, start over
+			return false;
+		}
+
+		bool isIntact = true;
+		size_t offset = headerReader.GetOffset();
+		while (offset < data.size())
+		{
+			BinaryReader reader(std::span<const std::byte>(data).subspan(offset));
+			const uint32_t size = reader.Read<uint32_t>();
+			const uint32_t checksum = reader.Read<uint32_t>();
+			const auto payload = reader.ReadBytes(size);
+
+			std::string name;
+			Entry entry;
+			if (!reader.IsOk() || CRC32(payload) != checksum || !ReadRecordPayload(payload, name, entry.FileSize, entry.LastWriteTime, entry.Info))
+			{
+				// Torn or damaged record, look for the next intact one a byte further
+				isIntact = false;
+				offset++;
+				continue;
+			}
+			offset += reader.GetOffset();
+
+			entry.Sequence = m_NextSequence++;
+			auto [it, inserted] = m_Entries.insert_or_assign(std::move(name), std::move(entry));
+			if (!inserted)
+			{
+				m_DeadRecords++;
+			}
+		}
+		TrimUnlocked();
+		return isIntact;
+	}
+	bool MetadataCache::WriteLog()
+	{
+		std::vector<std::byte> buffer;
+		WriteFileHeader(buffer);
+		for (const auto& [name, entry]: m_Entries)
+		{
+			WriteRecord(buffer, name, entry.FileSize, entry.LastWriteTime, entry.Info);
+		}
+
+		// Written next to the log and renamed over it once it's on the disk, a crash at any point leaves either
+		// the old log or the new one. A temporary file left by such a crash is simply overwritten next time.
+		std::filesystem::path tempPath = m_FilePath;
+		tempPath += ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+			stream.flush();
+			if (!stream)
+			{
+				return false;
+			}
+		}
+		if (!FlushFileToDisk(tempPath) || !ReplaceFile(tempPath, m_FilePath))
+		{
+			std::error_code error;
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		m_DeadRecords = 0;
+		return true;
+	}
+
+	bool MetadataCache::Open(const std::filesystem::path& filePath)
+	{
+		std::unique_lock lock(m_Mutex);
+
+		m_Entries.clear();
+		m_DeadRecords = 0;
+		m_FilePath = filePath;
+
+		std::error_code error;
+		if (filePath.has_parent_path())
+		{
+			std::filesystem::create_directories(filePath.parent_path(), error);
+		}
+
+		if (!Load())
+		{
+			m_FilePath.clear();
+			m_Entries.clear();
+			return false;
+		}
+		return true;
+	}
+	void MetadataCache::Close()
+	{
+		std::unique_lock lock(m_Mutex);
+
+		m_Entries.clear();
+		m_DeadRecords = 0;
+		m_FilePath.clear();
+	}
+
+	void MetadataCache::SetMaxEntries(size_t maxEntries)
+	{
+		std::unique_lock lock(m_Mutex);
+
+		m_MaxEntries = std::max<size_t>(maxEntries, 1);
+		TrimUnlocked();
+	}
+
+	bool MetadataCache::Find(const CacheKey& key, ModuleInfo& info) const
+	{
+		std::shared_lock lock(m_Mutex);
+
+		if (auto it = m_Entries.find(key.Name); it != m_Entries.end() && it->second.FileSize == key.FileSize && it->second.LastWriteTime == key.LastWriteTime)
+		{
+			m_Hits++;
+			info = it->second.Info;
+			return true;
+		}
+		m_Misses++;
+		return false;
+	}
+	bool MetadataCache::Put(const CacheKey& key, const ModuleInfo& info)
+	{
+		std::unique_lock lock(m_Mutex);
+		if (!IsOpen())
+		{
+			return false;
+		}
+
+		auto [it, inserted] = m_Entries.try_emplace(key.Name);
+		if (!inserted)
+		{
+			m_DeadRecords++;
+		}
+
+		Entry& entry = it->second;
+		entry.FileSize = key.FileSize;
+		entry.LastWriteTime = key.LastWriteTime;
+		entry.Info = info;
+		entry.Sequence = m_NextSequence++;
+		TrimUnlocked();
+
+		FileLock fileLock(m_FilePath);
+		if (!fileLock.IsLocked())
+		{
+			return false;
+		}
+
+		// Each record goes out in a single write under the file lock, so appends of other processes can't interleave.
+		// The log is opened for every append: compaction replaces the file and a handle kept open would still point
+		// to the old one. Someone may also have deleted it, then it starts over with a new header.
+		std::vector<std::byte> buffer;
+		std::error_code error;
+		if (std::filesystem::file_size(m_FilePath, error) == 0 || error)
+		{
+			WriteFileHeader(buffer);
+		}
+		WriteRecord(buffer, key.Name, key.FileSize, key.LastWriteTime, info);
+
+		std::ofstream stream(m_FilePath, std::ios::binary|std::ios::app);
+		stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		stream.flush();
+		return stream.good();
+	}
+	bool MetadataCache::Compact()
+	{
+		std::unique_lock lock(m_Mutex);
+		if (!IsOpen())
+		{
+			return false;
+		}
+
+		// The log is read again first, so entries other processes appended since it was loaded are kept
+		FileLock fileLock(m_FilePath);
+		if (!fileLock.IsLocked())
+		{
+			return false;
+		}
+		ReadLog();
+		return WriteLog();
+	}
+
+	size_t MetadataCache::Warm(const std::filesystem::path& directory, size_t threadCount, bool recursive)
+	{
+		// Keys are taken before parsing, so a file modified in the meantime is simply parsed again next time
+		std::vector<std::filesystem::path> files;
+		std::unordered_map<std::string, CacheKey> keys;
+		for (auto& path: FindModuleFiles(directory, recursive))
+		{
+			CacheKey key = CacheKey::FromFile(path);
+
+			ModuleInfo info;
+			if (!Find(key, info))
+			{
+				keys.emplace(ToUTF8(path), std::move(key));
+				files.emplace_back(std::move(path));
+			}
+		}
+
+		size_t added = 0;
+		ModuleScanner scanner(threadCount, recursive);
+		scanner.Scan(files, [&](const ScanResult& result)
+		{
+			if (auto it = keys.find(ToUTF8(result.Path)); it != keys.end() && result.Error.empty() && Put(it->second, result.Info))
+			{
+				added++;
+			}
+		});
+		return added;
+	}
+
+	CacheStats MetadataCache::GetStats() const
+	{
+		std::shared_lock lock(m_Mutex);
+
+		CacheStats stats;
+		stats.Entries = m_Entries.size();
+		stats.DeadRecords = m_DeadRecords;
+		stats.Hits = m_Hits;
+		stats.Misses = m_Misses;
+
+		std::error_code error;
+		stats.FileSize = IsOpen() ? std::filesystem::file_size(m_FilePath, error) : 0;
+		return stats;
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "ModuleInfo.h"
+#include <atomic>
+#include <filesystem>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace BethesdaModule::Core
+{
+	// Identity of a file on disk. The header is re-parsed whenever size or last write time changes.
+	//
+	// 'Name' is the normalized full path whenever it's known, see 'MetadataCache::MakeKeyName'. The shell usually
+	// gives a property handler only the file name though, and then that's all the key has: two different files
+	// with the same name, size and last write time, like 'Update.esm' of two separate installs, share an entry and
+	// one of them shows the other's header. Keys made from a name never match keys made from a path.
+	struct CacheKey final
+	{
+		std::string Name;
+		uint64_t FileSize = 0;
+		int64_t LastWriteTime = 0;
+
+		static CacheKey FromFile(const std::filesystem::path& path);
+	};
+
+	struct CacheStats final
+	{
+		size_t Entries = 0;
+		size_t DeadRecords = 0;
+		size_t Hits = 0;
+		size_t Misses = 0;
+		uint64_t FileSize = 0;
+	};
+
+	// Persistent cache of parsed module headers.
+	//
+	// The file is an append-only log: a fixed header (magic + format version) followed by records,
+	// each one prefixed by its size and CRC-32. Later records replace earlier ones for the same name.
+	// Explorer, the search indexer and the preview host share the log, so appends, loading and compaction
+	// take a lock on '<log>.lock' that other processes respect. A record torn by a crash fails its checksum
+	// and is skipped, loading goes on with the next intact one, so the cache can lose entries but never
+	// returns garbage. Compaction reads the log again, keeping other processes' appends, writes the result to
+	// '<log>.tmp' and renames it over the log. The log is only kept open while the lock is held.
+	class MetadataCache final
+	{
+		public:
+			static constexpr uint32_t FileMagic = MakeFourCC("BMMC");
+			static constexpr uint32_t FormatVersion = 2;
+
+			// Enough for every plugin of several large installs, a few MiB in memory
+			static constexpr size_t DefaultMaxEntries = 20000;
+
+			// Names are compared case-insensitively
+			static std::string NormalizeName(std::string_view name);
+
+			// Normalized full path if the path has a folder, normalized file name otherwise. Paths are compared
+			// case-insensitively as well, the way Windows does.
+			static std::string MakeKeyName(const std::filesystem::path& path);
+
+		private:
+			struct Entry final
+			{
+				uint64_t FileSize = 0;
+				int64_t LastWriteTime = 0;
+				ModuleInfo Info;
+
+				// Order entries were loaded or added in, the oldest go first when there are too many
+				uint64_t Sequence = 0;
+			};
+
+		private:
+			std::filesystem::path m_FilePath;
+
+			mutable std::shared_mutex m_Mutex;
+			std::unordered_map<std::string, Entry> m_Entries;
+			size_t m_DeadRecords = 0;
+			std::atomic<size_t> m_MaxEntries = DefaultMaxEntries;
+			uint64_t m_NextSequence = 0;
+
+			mutable std::atomic<size_t> m_Hits = 0;
+			mutable std::atomic<size_t> m_Misses = 0;
+
+		private:
+			bool Load();
+			void TrimUnlocked();
+
+			// The file lock has to be held for these
+			bool ReadLog();
+			bool WriteLog();
+
+		public:
+			MetadataCache() = default;
+			MetadataCache(const MetadataCache&) = delete;
+
+		public:
+			// Loads the cache file or creates a new one. Files of a different format version are discarded.
+			bool Open(const std::filesystem::path& filePath);
+			void Close();
+			bool IsOpen() const noexcept
+			{
+				return !m_FilePath.empty();
+			}
+
+			// Entries beyond the limit are dropped from memory, oldest first, and from the file on the next compaction
+			size_t GetMaxEntries() const noexcept
+			{
+				return m_MaxEntries;
+			}
+			void SetMaxEntries(size_t maxEntries);
+
+			bool Find(const CacheKey& key, ModuleInfo& info) const;
+			bool Put(const CacheKey& key, const ModuleInfo& info);
+			bool Compact();
+
+			// Parses every module in the directory that isn't already cached
+			size_t Warm(const std::filesystem::path& directory, size_t threadCount = 0, bool recursive = true);
+
+			CacheStats GetStats() const;
+
+		public:
+			MetadataCache& operator=(const MetadataCache&) = delete;
+	};
+}
@@ -0,0 +1,323 @@
+#include "stdafx.h"
+#include "ModuleHeader.h"
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	// Record header sizes
+	constexpr size_t g_TES3RecordHeaderSize = 16;
+	constexpr size_t g_OblivionRecordHeaderSize = 20;
+	constexpr size_t g_SkyrimRecordHeaderSize = 24;
+
+	// Offsets of the fixed length strings inside Morrowind HEDR
+	constexpr size_t g_TES3AuthorOffset = 8;
+	constexpr size_t g_TES3AuthorLength = 32;
+	constexpr size_t g_TES3DescriptionOffset = g_TES3AuthorOffset + g_TES3AuthorLength;
+	constexpr size_t g_TES3DescriptionLength = 256;
+
+	// All supported formats are little-endian, as are all the platforms we run on
+	template<class T>
+	T ReadValue(std::span<const std::byte> buffer, size_t offset) noexcept
+	{
+		T value = {};
+		std::memcpy(&value, buffer.data() + offset, sizeof(T));
+		return value;
+	}
+
+	TextView MakeView(size_t offset, size_t length) noexcept
+	{
+		return {static_cast<uint32_t>(offset), static_cast<uint32_t>(length)};
+	}
+	void ExtendView(TextView& view, size_t offset, size_t end) noexcept
+	{
+		if (view.IsEmpty())
+		{
+			view = MakeView(offset, end - offset);
+		}
+		else
+		{
+			view.Length = static_cast<uint32_t>(end - view.Offset);
+		}
+	}
+
+	// Keeps track of structural limits while walking subrecords
+	class LimitChecker final
+	{
+		private:
+			const ParseLimits& m_Limits;
+			uint32_t m_Subrecords = 0;
+
+		public:
+			LimitChecker(const ParseLimits& limits) noexcept
+				:m_Limits(limits)
+			{
+			}
+
+		public:
+			bool Accept(const Subrecord& subrecord, const ModuleHeader& header) noexcept
+			{
+				if (++m_Subrecords > m_Limits.MaxSubrecords || subrecord.Data.Length > m_Limits.MaxSubrecordSize)
+				{
+					return false;
+				}
+				return subrecord.Type != FourCC::MAST || header.MasterCount < m_Limits.MaxMasters;
+			}
+	};
+
+	ParseStatus GetFinalStatus(std::span<const std::byte> buffer, const ModuleHeader& header, const SubrecordReader& reader, const ParseLimits& limits) noexcept
+	{
+		if (reader.GetOffset() >= header.HeaderSize)
+		{
+			return ParseStatus::Success;
+		}
+		if (header.HeaderSize > limits.ReadBudget && buffer.size() >= limits.ReadBudget)
+		{
+			// Everything the budget allows has been parsed
+			return ParseStatus::LimitExceeded;
+		}
+		return buffer.size() >= header.HeaderSize ? ParseStatus::Malformed : ParseStatus::Truncated;
+	}
+
+	bool IsOblivionHeader(std::span<const std::byte> buffer) noexcept
+	{
+		// Oblivion record header is four bytes shorter, so HEDR is located where Skyrim stores form version
+		return buffer.size() >= g_SkyrimRecordHeaderSize && ReadValue<uint32_t>(buffer, g_OblivionRecordHeaderSize) == FourCC::HEDR;
+	}
+
+	ParseStatus ParseMorrowind(std::span<const std::byte> buffer, ModuleHeader& header, const ParseLimits& limits) noexcept
+	{
+		header.FormatLevel = FormatLevel::Morrowind;
+
+		LimitChecker checker(limits);
+		SubrecordReader reader(buffer, g_TES3RecordHeaderSize, std::min<size_t>(header.HeaderSize, limits.ReadBudget), true);
+		while (auto subrecord = reader.Next())
+		{
+			if (!checker.Accept(*subrecord, header))
+			{
+				return ParseStatus::LimitExceeded;
+			}
+
+			const size_t offset = subrecord->Data.Offset;
+			const size_t length = subrecord->Data.Length;
+
+			switch (subrecord->Type)
+			{
+				case FourCC::HEDR:
+				{
+					// These are fixed length
+					if (length >= g_TES3DescriptionOffset + g_TES3DescriptionLength)
+					{
+						header.Author = MakeView(offset + g_TES3AuthorOffset, g_TES3AuthorLength);
+						header.Description = MakeView(offset + g_TES3DescriptionOffset, g_TES3DescriptionLength);
+					}
+					break;
+				}
+				case FourCC::MAST:
+				{
+					header.MasterCount++;
+					ExtendView(header.MasterList, offset - 8, offset + length);
+					break;
+				}
+				case FourCC::DATA:
+				{
+					// Master file size, follows each MAST
+					if (!header.MasterList.IsEmpty())
+					{
+						ExtendView(header.MasterList, offset - 8, offset + length);
+					}
+					break;
+				}
+			};
+		}
+		return GetFinalStatus(buffer, header, reader, limits);
+	}
+	ParseStatus ParseOblivionSkyrim(std::span<const std::byte> buffer, ModuleHeader& header, const ParseLimits& limits) noexcept
+	{
+		header.Flags = static_cast<HeaderFlags>(ReadValue<uint32_t>(buffer, 8));
+
+		size_t recordHeaderSize = g_SkyrimRecordHeaderSize;
+		if (IsOblivionHeader(buffer))
+		{
+			header.FormatLevel = FormatLevel::Oblivion;
+			recordHeaderSize = g_OblivionRecordHeaderSize;
+		}
+		else
+		{
+			header.FormatLevel = FormatLevel::Skyrim;
+			header.FormVersion = ReadValue<uint16_t>(buffer, g_OblivionRecordHeaderSize);
+		}
+
+		LimitChecker checker(limits);
+		SubrecordReader reader(buffer, recordHeaderSize, std::min<size_t>(header.HeaderSize, limits.ReadBudget), false);
+		while (auto subrecord = reader.Next())
+		{
+			if (!checker.Accept(*subrecord, header))
+			{
+				return ParseStatus::LimitExceeded;
+			}
+
+			const size_t offset = subrecord->Data.Offset;
+			const size_t length = subrecord->Data.Length;
+
+			switch (subrecord->Type)
+			{
+				case FourCC::CNAM:
+				{
+					header.Author = subrecord->Data;
+					break;
+				}
+				case FourCC::SNAM:
+				{
+					header.Description = subrecord->Data;
+					break;
+				}
+				case FourCC::MAST:
+				{
+					header.MasterCount++;
+					ExtendView(header.MasterList, offset - 6, offset + length);
+					break;
+				}
+				case FourCC::DATA:
+				{
+					if (!header.MasterList.IsEmpty())
+					{
+						ExtendView(header.MasterList, offset - 6, offset + length);
+					}
+					break;
+				}
+			};
+		}
+		return GetFinalStatus(buffer, header, reader, limits);
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::optional<Subrecord> SubrecordReader::Next() noexcept
+	{
+		const size_t headerSize = m_WideSize ? 8 : 6;
+		if (m_Offset + headerSize > m_End)
+		{
+			return {};
+		}
+
+		Subrecord subrecord;
+		subrecord.Type = ReadValue<uint32_t>(m_Buffer, m_Offset);
+
+		size_t size = 0;
+		if (m_WideSize)
+		{
+			size = ReadValue<uint32_t>(m_Buffer, m_Offset + 4);
+		}
+		else
+		{
+			size = ReadValue<uint16_t>(m_Buffer, m_Offset + 4);
+
+			// 'XXXX' holds 32-bit size of the next subrecord whose own size field is then ignored
+			if (subrecord.Type == FourCC::XXXX && size == sizeof(uint32_t))
+			{
+				if (m_Offset + headerSize + 4 + headerSize > m_End)
+				{
+					return {};
+				}
+				size = ReadValue<uint32_t>(m_Buffer, m_Offset + headerSize);
+
+				m_Offset += headerSize + 4;
+				subrecord.Type = ReadValue<uint32_t>(m_Buffer, m_Offset);
+			}
+		}
+
+		const size_t dataOffset = m_Offset + headerSize;
+		if (size > m_End - dataOffset)
+		{
+			return {};
+		}
+
+		subrecord.Data = MakeView(dataOffset, size);
+		m_Offset = dataOffset + size;
+		return subrecord;
+	}
+
+	std::optional<size_t> GetModuleHeaderSize(std::span<const std::byte> prefix) noexcept
+	{
+		if (prefix.size() >= ModuleHeader::PrefixSize)
+		{
+			const uint32_t dataSize = ReadValue<uint32_t>(prefix, 4);
+			switch (ReadValue<uint32_t>(prefix, 0))
+			{
+				case FourCC::TES3:
+				{
+					return g_TES3RecordHeaderSize + dataSize;
+				}
+				case FourCC::TES4:
+				{
+					return (IsOblivionHeader(prefix) ? g_OblivionRecordHeaderSize : g_SkyrimRecordHeaderSize) + dataSize;
+				}
+			};
+		}
+		return {};
+	}
+
+	ParseStatus ParseModuleHeader(std::span<const std::byte> buffer, ModuleHeader& header, const ParseLimits& limits) noexcept
+	{
+		header = {};
+
+		if (auto headerSize = GetModuleHeaderSize(buffer))
+		{
+			header.Signature = ReadValue<uint32_t>(buffer, 0);
+			header.HeaderSize = static_cast<uint32_t>(std::min<size_t>(*headerSize, std::numeric_limits<uint32_t>::max()));
+
+			if (header.Signature == FourCC::TES3)
+			{
+				return ParseMorrowind(buffer, header, limits);
+			}
+			else
+			{
+				return ParseOblivionSkyrim(buffer, header, limits);
+			}
+		}
+		else if (buffer.size() >= sizeof(uint32_t))
+		{
+			// Still tell the signature for TES3/TES4 files shorter than the prefix
+			const uint32_t signature = ReadValue<uint32_t>(buffer, 0);
+			if (signature == FourCC::TES3 || signature == FourCC::TES4)
+			{
+				header.Signature = signature;
+				return ParseStatus::Truncated;
+			}
+		}
+		return ParseStatus::UnknownFormat;
+	}
+
+	std::string_view GetParseStatusName(ParseStatus status) noexcept
+	{
+		switch (status)
+		{
+			case ParseStatus::Success:
+			{
+				return "ok";
+			}
+			case ParseStatus::Truncated:
+			{
+				return "truncated";
+			}
+			case ParseStatus::Malformed:
+			{
+				return "malformed";
+			}
+			case ParseStatus::LimitExceeded:
+			{
+				return "limit-exceeded";
+			}
+			default:
+			{
+				break;
+			}
+		};
+		return "unknown format";
+	}
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <optional>
+#include <string_view>
+
+namespace BethesdaModule::Core
+{
+	enum class FormatLevel
+	{
+		Unknown = 0,
+
+		Morrowind,
+		Oblivion,
+		Skyrim
+	};
+	enum class HeaderFlags: uint32_t
+	{
+		None = 0,
+		Master = 1 << 0,
+		Localized = 1 << 7,
+		Light = 1 << 9,
+		Ignored = 1 << 12,
+	};
+	constexpr bool TestFlag(HeaderFlags flags, HeaderFlags flag) noexcept
+	{
+		return (static_cast<uint32_t>(flags) & static_cast<uint32_t>(flag)) != 0;
+	}
+
+	// Record and subrecord tags as they're stored in the file
+	constexpr uint32_t MakeFourCC(const char (&name)[5]) noexcept
+	{
+		return static_cast<uint32_t>(static_cast<uint8_t>(name[0]))|
+			static_cast<uint32_t>(static_cast<uint8_t>(name[1])) << 8|
+			static_cast<uint32_t>(static_cast<uint8_t>(name[2])) << 16|
+			static_cast<uint32_t>(static_cast<uint8_t>(name[3])) << 24;
+	}
+	namespace FourCC
+	{
+		constexpr uint32_t TES3 = MakeFourCC("TES3");
+		constexpr uint32_t TES4 = MakeFourCC("TES4");
+		constexpr uint32_t HEDR = MakeFourCC("HEDR");
+		constexpr uint32_t CNAM = MakeFourCC("CNAM");
+		constexpr uint32_t SNAM = MakeFourCC("SNAM");
+		constexpr uint32_t MAST = MakeFourCC("MAST");
+		constexpr uint32_t DATA = MakeFourCC("DATA");
+		constexpr uint32_t XXXX = MakeFourCC("XXXX");
+		constexpr uint32_t GRUP = MakeFourCC("GRUP");
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	// Offset and length of a piece of text inside the buffer the header was parsed from
+	struct TextView final
+	{
+		uint32_t Offset = 0;
+		uint32_t Length = 0;
+
+		bool IsEmpty() const noexcept
+		{
+			return Length == 0;
+		}
+
+		// Returns the raw, not decoded, text up to the first null character
+		std::string_view GetText(std::span<const std::byte> buffer) const noexcept
+		{
+			if (Length != 0 && static_cast<size_t>(Offset) + Length <= buffer.size())
+			{
+				std::string_view text(reinterpret_cast<const char*>(buffer.data()) + Offset, Length);
+				return text.substr(0, text.find('\0'));
+			}
+			return {};
+		}
+	};
+
+	struct Subrecord final
+	{
+		uint32_t Type = 0;
+		TextView Data;
+	};
+
+	// Walks subrecords inside the given range of a buffer. TES3 subrecords have 32-bit size field,
+	// TES4 ones have 16-bit size which can be overridden by preceding 'XXXX' subrecord.
+	class SubrecordReader final
+	{
+		private:
+			std::span<const std::byte> m_Buffer;
+			size_t m_Offset = 0;
+			size_t m_End = 0;
+			bool m_WideSize = false;
+
+		public:
+			SubrecordReader(std::span<const std::byte> buffer, size_t offset, size_t end, bool wideSize) noexcept
+				:m_Buffer(buffer), m_Offset(offset), m_End(end < buffer.size() ? end : buffer.size()), m_WideSize(wideSize)
+			{
+			}
+
+		public:
+			size_t GetOffset() const noexcept
+			{
+				return m_Offset;
+			}
+			bool IsEnd() const noexcept
+			{
+				return m_Offset >= m_End;
+			}
+
+			std::optional<Subrecord> Next() noexcept;
+	};
+
+	enum class ParseStatus
+	{
+		// The whole header has been parsed
+		Success,
+
+		// Not a TES3 or TES4 file
+		UnknownFormat,
+
+		// The buffer ended before the header did, what was parsed is still valid
+		Truncated,
+
+		// Subrecords don't fit the declared size of the header record, what was parsed before that is still valid
+		Malformed,
+
+		// One of 'ParseLimits' was hit and parsing stopped there, what was parsed is still valid
+		LimitExceeded,
+	};
+
+	// Caps protecting callers (mainly Explorer's UI thread) from broken or malicious files.
+	// Real modules are far below every one of these.
+	struct ParseLimits final
+	{
+		// Bytes read from the source for one header. Headers declaring a larger size are parsed up to this point.
+		size_t ReadBudget = 1024 * 1024;
+
+		// The games themselves can't load more than 255 (254 for TES4 games) masters
+		uint32_t MaxMasters = 255;
+
+		// Author and description are short, master names are file names. Descriptions over 64 KiB need 'XXXX'.
+		uint32_t MaxSubrecordSize = 64 * 1024;
+
+		// Bounds the loop over subrecords regardless of their sizes
+		uint32_t MaxSubrecords = 4096;
+	};
+
+	// Parsed header of a module file. Doesn't own any data, all text is referenced through views into the buffer it was parsed from.
+	struct ModuleHeader final
+	{
+		// Enough to determine format and the full size of the header record
+		static constexpr size_t PrefixSize = 24;
+
+		uint32_t Signature = 0;
+		HeaderFlags Flags = HeaderFlags::None;
+		uint32_t FormVersion = 0;
+		Core::FormatLevel FormatLevel = Core::FormatLevel::Unknown;
+
+		TextView Author;
+		TextView Description;
+
+		// Range covering all 'MAST' subrecords (and 'DATA' subrecords in between), use 'ForEachMaster' to enumerate them
+		TextView MasterList;
+		uint32_t MasterCount = 0;
+
+		// Size of the whole header record including record header itself
+		uint32_t HeaderSize = 0;
+
+		template<class TFunc>
+		void ForEachMaster(std::span<const std::byte> buffer, TFunc&& func) const
+		{
+			SubrecordReader reader(buffer, MasterList.Offset, static_cast<size_t>(MasterList.Offset) + MasterList.Length, FormatLevel == Core::FormatLevel::Morrowind);
+			while (auto subrecord = reader.Next())
+			{
+				if (subrecord->Type == FourCC::MAST)
+				{
+					func(subrecord->Data.GetText(buffer));
+				}
+			}
+		}
+	};
+
+	// Returns full size of the header record if the buffer contains at least 'ModuleHeader::PrefixSize' bytes of a known module format
+	std::optional<size_t> GetModuleHeaderSize(std::span<const std::byte> prefix) noexcept;
+
+	// Parses TES3 or TES4 header record from the buffer. Never allocates.
+	ParseStatus ParseModuleHeader(std::span<const std::byte> buffer, ModuleHeader& header, const ParseLimits& limits = {}) noexcept;
+	std::string_view GetParseStatusName(ParseStatus status) noexcept;
+}
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "ModuleInfo.h"
+
+namespace BethesdaModule::Core
+{
+	ModuleInfo ModuleInfo::FromHeader(std::span<const std::byte> buffer, const ModuleHeader& header)
+	{
+		ModuleInfo info;
+		info.Signature = header.Signature;
+		info.Flags = header.Flags;
+		info.FormVersion = header.FormVersion;
+		info.FormatLevel = header.FormatLevel;
+		info.Author = header.Author.GetText(buffer);
+		info.Description = header.Description.GetText(buffer);
+
+		info.Masters.reserve(header.MasterCount);
+		header.ForEachMaster(buffer, [&](std::string_view name)
+		{
+			info.Masters.emplace_back(name);
+		});
+		return info;
+	}
+	PooledModuleInfo PooledModuleInfo::FromHeader(std::span<const std::byte> buffer, const ModuleHeader& header, StringPool& pool)
+	{
+		PooledModuleInfo info;
+		info.Signature = header.Signature;
+		info.Flags = header.Flags;
+		info.FormVersion = header.FormVersion;
+		info.FormatLevel = header.FormatLevel;
+		info.Author = pool.Intern(header.Author.GetText(buffer));
+		info.Description = header.Description.GetText(buffer);
+
+		info.Masters.reserve(header.MasterCount);
+		header.ForEachMaster(buffer, [&](std::string_view name)
+		{
+			info.Masters.push_back(pool.Intern(name));
+		});
+		return info;
+	}
+
+	std::string_view GetSignatureName(const uint32_t& signature) noexcept
+	{
+		if (signature == FourCC::TES3 || signature == FourCC::TES4)
+		{
+			return {reinterpret_cast<const char*>(&signature), sizeof(signature)};
+		}
+		return {};
+	}
+	std::string_view GetFormatLevelName(FormatLevel formatLevel) noexcept
+	{
+		switch (formatLevel)
+		{
+			case FormatLevel::Morrowind:
+			{
+				return "Morrowind";
+			}
+			case FormatLevel::Oblivion:
+			{
+				return "Oblivion";
+			}
+			case FormatLevel::Skyrim:
+			{
+				return "Skyrim";
+			}
+			default:
+			{
+				break;
+			}
+		};
+		return {};
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "ModuleHeader.h"
+#include "StringPool.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace BethesdaModule::Core
+{
+	// Owning copy of everything 'ModuleHeader' references. Text is kept as it's stored in the file, not decoded.
+	struct ModuleInfo final
+	{
+		uint32_t Signature = 0;
+		HeaderFlags Flags = HeaderFlags::None;
+		uint32_t FormVersion = 0;
+		Core::FormatLevel FormatLevel = Core::FormatLevel::Unknown;
+
+		std::string Author;
+		std::string Description;
+		std::vector<std::string> Masters;
+
+		static ModuleInfo FromHeader(std::span<const std::byte> buffer, const ModuleHeader& header);
+	};
+
+	// 'ModuleInfo' for bulk scans: author and master names, which repeat across nearly every plugin of a library,
+	// are interned in a shared pool and only referenced by handle.
+	struct PooledModuleInfo final
+	{
+		uint32_t Signature = 0;
+		HeaderFlags Flags = HeaderFlags::None;
+		uint32_t FormVersion = 0;
+		Core::FormatLevel FormatLevel = Core::FormatLevel::Unknown;
+
+		StringPool::THandle Author = StringPool::EmptyHandle;
+		std::string Description;
+		std::vector<StringPool::THandle> Masters;
+
+		static PooledModuleInfo FromHeader(std::span<const std::byte> buffer, const ModuleHeader& header, StringPool& pool);
+	};
+
+	std::string_view GetSignatureName(const uint32_t& signature) noexcept;
+	std::string_view GetFormatLevelName(FormatLevel formatLevel) noexcept;
+
+	template<class TFunc>
+	void ForEachHeaderFlagName(HeaderFlags flags, TFunc&& func)
+	{
+		constexpr std::pair<HeaderFlags, std::string_view> names[] =
+		{
+			{HeaderFlags::Master, "Master"},
+			{HeaderFlags::Localized, "Localized"},
+			{HeaderFlags::Light, "Light"},
+			{HeaderFlags::Ignored, "Ignored"},
+		};
+		for (const auto& [flag, name]: names)
+		{
+			if (TestFlag(flags, flag))
+			{
+				func(name);
+			}
+		}
+	}
+}
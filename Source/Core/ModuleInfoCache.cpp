@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "ModuleInfoCache.h"
+
+namespace BethesdaModule::Core
+{
+	size_t ModuleInfoCache::EstimateMemoryUsage(const std::string& name, const PackedModuleInfo& info) noexcept
+	{
+		// Node, list and hash map bookkeeping plus the packed block
+		return sizeof(Node) + 4 * sizeof(void*) + name.capacity() + info.GetMemoryUsage();
+	}
+
+	ModuleInfoCache::Shard& ModuleInfoCache::GetShard(std::string_view name) const noexcept
+	{
+		return m_Shards[std::hash<std::string_view>()(name) % ShardCount];
+	}
+	size_t ModuleInfoCache::EvictUnlocked(Shard& shard, size_t memoryLimit)
+	{
+		size_t evicted = 0;
+		while (shard.MemoryUsage > memoryLimit && !shard.Order.empty())
+		{
+			Node& node = shard.Order.back();
+			shard.MemoryUsage -= node.MemoryUsage;
+			shard.Index.erase(node.Key.Name);
+			shard.Order.pop_back();
+
+			evicted++;
+		}
+		m_Evictions += evicted;
+		return evicted;
+	}
+
+	ModuleInfoCache::ModuleInfoCache(size_t memoryLimit)
+		:m_Shards(std::make_unique<Shard[]>(ShardCount)), m_MemoryLimit(memoryLimit)
+	{
+	}
+
+	void ModuleInfoCache::SetMemoryLimit(size_t memoryLimit)
+	{
+		m_MemoryLimit = memoryLimit;
+		for (size_t i = 0; i < ShardCount; i++)
+		{
+			std::lock_guard lock(m_Shards[i].Mutex);
+			EvictUnlocked(m_Shards[i], memoryLimit / ShardCount);
+		}
+	}
+
+	auto ModuleInfoCache::Find(const CacheKey& key) -> TValue
+	{
+		Shard& shard = GetShard(key.Name);
+		std::lock_guard lock(shard.Mutex);
+
+		if (auto it = shard.Index.find(key.Name); it != shard.Index.end())
+		{
+			auto nodeIt = it->second;
+			if (nodeIt->Key.FileSize == key.FileSize && nodeIt->Key.LastWriteTime == key.LastWriteTime)
+			{
+				// Move to the front, no allocation involved
+				shard.Order.splice(shard.Order.begin(), shard.Order, nodeIt);
+
+				m_Hits++;
+				return nodeIt->Value;
+			}
+		}
+		m_Misses++;
+		return {};
+	}
+	auto ModuleInfoCache::Put(const CacheKey& key, PackedModuleInfo info) -> TValue
+	{
+		// Build the node outside of the lock
+		std::list<Node> newNode;
+		Node& node = newNode.emplace_back();
+		node.Key = key;
+		node.MemoryUsage = EstimateMemoryUsage(key.Name, info);
+		node.Value = std::move(info);
+		TValue value = node.Value;
+
+		const size_t memoryLimit = m_MemoryLimit / ShardCount;
+		if (node.MemoryUsage > memoryLimit)
+		{
+			return value;
+		}
+
+		Shard& shard = GetShard(key.Name);
+		std::lock_guard lock(shard.Mutex);
+
+		// Replace whatever was cached for an older version of the file. The index key points into the node,
+		// so it has to go before the node does.
+		if (auto it = shard.Index.find(key.Name); it != shard.Index.end())
+		{
+			const auto nodeIt = it->second;
+			shard.MemoryUsage -= nodeIt->MemoryUsage;
+			shard.Index.erase(it);
+			shard.Order.erase(nodeIt);
+		}
+
+		shard.Order.splice(shard.Order.begin(), newNode);
+		shard.Index.emplace(shard.Order.front().Key.Name, shard.Order.begin());
+		shard.MemoryUsage += shard.Order.front().MemoryUsage;
+
+		EvictUnlocked(shard, memoryLimit);
+		return value;
+	}
+	void ModuleInfoCache::Clear()
+	{
+		for (size_t i = 0; i < ShardCount; i++)
+		{
+			Shard& shard = m_Shards[i];
+			std::lock_guard lock(shard.Mutex);
+
+			shard.Index.clear();
+			shard.Order.clear();
+			shard.MemoryUsage = 0;
+		}
+	}
+
+	ModuleInfoCacheStats ModuleInfoCache::GetStats() const
+	{
+		ModuleInfoCacheStats stats;
+		for (size_t i = 0; i < ShardCount; i++)
+		{
+			Shard& shard = m_Shards[i];
+			std::lock_guard lock(shard.Mutex);
+
+			stats.Entries += shard.Order.size();
+			stats.MemoryUsage += shard.MemoryUsage;
+		}
+		stats.Hits = m_Hits;
+		stats.Misses = m_Misses;
+		stats.Evictions = m_Evictions;
+		return stats;
+	}
+}
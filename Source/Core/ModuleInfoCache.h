@@ -0,0 +1,85 @@
+#pragma once
+#include "PackedModuleInfo.h"
+#include "MetadataCache.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace BethesdaModule::Core
+{
+	struct ModuleInfoCacheStats final
+	{
+		size_t Entries = 0;
+		size_t MemoryUsage = 0;
+		size_t Hits = 0;
+		size_t Misses = 0;
+		size_t Evictions = 0;
+	};
+
+	// In-memory LRU of parsed headers shared by everyone in the process.
+	//
+	// Keys are split between independently locked shards, so threads looking up different files rarely contend
+	// and there's no lock covering the whole cache. Each shard evicts its least recently used entries once it
+	// goes over its part of the memory limit. Values are immutable and shared, a lookup never copies them.
+	class ModuleInfoCache final
+	{
+		public:
+			using TValue = PackedModuleInfo;
+
+			static constexpr size_t ShardCount = 16;
+			static constexpr size_t DefaultMemoryLimit = 8 * 1024 * 1024;
+
+			// Approximate heap usage of a cached entry, used to enforce the memory limit
+			static size_t EstimateMemoryUsage(const std::string& name, const PackedModuleInfo& info) noexcept;
+
+		private:
+			struct Node final
+			{
+				CacheKey Key;
+				TValue Value;
+				size_t MemoryUsage = 0;
+			};
+			struct Shard final
+			{
+				std::mutex Mutex;
+				std::list<Node> Order;
+				std::unordered_map<std::string_view, std::list<Node>::iterator> Index;
+				size_t MemoryUsage = 0;
+			};
+
+		private:
+			std::unique_ptr<Shard[]> m_Shards;
+			std::atomic<size_t> m_MemoryLimit = DefaultMemoryLimit;
+
+			std::atomic<size_t> m_Hits = 0;
+			std::atomic<size_t> m_Misses = 0;
+			std::atomic<size_t> m_Evictions = 0;
+
+		private:
+			Shard& GetShard(std::string_view name) const noexcept;
+			size_t EvictUnlocked(Shard& shard, size_t memoryLimit);
+
+		public:
+			ModuleInfoCache(size_t memoryLimit = DefaultMemoryLimit);
+			ModuleInfoCache(const ModuleInfoCache&) = delete;
+
+		public:
+			size_t GetMemoryLimit() const noexcept
+			{
+				return m_MemoryLimit;
+			}
+			void SetMemoryLimit(size_t memoryLimit);
+
+			// Returns nothing if the file isn't cached or has changed since it was
+			TValue Find(const CacheKey& key);
+			TValue Put(const CacheKey& key, PackedModuleInfo info);
+			void Clear();
+
+			ModuleInfoCacheStats GetStats() const;
+
+		public:
+			ModuleInfoCache& operator=(const ModuleInfoCache&) = delete;
+	};
+}
@@ -0,0 +1,592 @@
+#include "stdafx.h"
+#include "ModuleQuery.h"
+#include "StringPool.h"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	// Evaluation recurses as deep as the expression goes
+	constexpr size_t g_MaxDepth = 256;
+	constexpr size_t g_MaxNodes = 4096;
+
+	bool IsSpace(char c) noexcept
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+	bool IsWordChar(char c) noexcept
+	{
+		return !IsSpace(c) && c != '(' && c != ')' && c != '!' && c != '&' && c != '|' && c != '<' && c != '>' && c != '=' && c != ':' && c != '"';
+	}
+
+	std::optional<uint32_t> ParseNumber(std::string_view text) noexcept
+	{
+		uint32_t value = 0;
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc() || end != text.data() + text.size())
+		{
+			return {};
+		}
+		return value;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	ModuleIndex ModuleIndex::Build(const ModuleTable& table)
+	{
+		ModuleIndex index;
+		index.m_Table = &table;
+
+		const size_t count = table.GetCount();
+		const auto flags = table.GetFlags();
+		const auto formatLevels = table.GetFormatLevels();
+		const auto formVersions = table.GetFormVersions();
+		index.m_All = RoaringBitmap::FromRange(0, static_cast<uint32_t>(count));
+
+		// A library has only a handful of distinct form versions, each of them is a bucket
+		index.m_FormVersions.assign(formVersions.begin(), formVersions.end());
+		std::sort(index.m_FormVersions.begin(), index.m_FormVersions.end());
+		index.m_FormVersions.erase(std::unique(index.m_FormVersions.begin(), index.m_FormVersions.end()), index.m_FormVersions.end());
+		index.m_FormVersionRows.resize(index.m_FormVersions.size());
+
+		// Rows are added in ascending order, so every bitmap is only appended to
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint32_t row = static_cast<uint32_t>(i);
+			for (uint32_t value = static_cast<uint32_t>(flags[i]); value != 0; value &= value - 1)
+			{
+				index.m_Flags[std::countr_zero(value)].Add(row);
+			}
+
+			const size_t formatLevel = static_cast<size_t>(formatLevels[i]);
+			if (formatLevel < index.m_FormatLevels.size())
+			{
+				index.m_FormatLevels[formatLevel].Add(row);
+			}
+
+			const auto bucket = std::lower_bound(index.m_FormVersions.begin(), index.m_FormVersions.end(), formVersions[i]);
+			index.m_FormVersionRows[bucket - index.m_FormVersions.begin()].Add(row);
+
+			for (ModuleTable::TNameID master: table.GetMasters(row))
+			{
+				index.m_Masters[master].Add(row);
+			}
+		}
+		return index;
+	}
+
+	size_t ModuleIndex::GetMemoryUsage() const noexcept
+	{
+		size_t size = sizeof(*this) + m_All.GetMemoryUsage() + m_FormVersions.capacity() * sizeof(uint32_t) + m_FormVersionRows.capacity() * sizeof(RoaringBitmap);
+		for (const RoaringBitmap& bitmap: m_Flags)
+		{
+			size += bitmap.GetMemoryUsage();
+		}
+		for (const RoaringBitmap& bitmap: m_FormatLevels)
+		{
+			size += bitmap.GetMemoryUsage();
+		}
+		for (const RoaringBitmap& bitmap: m_FormVersionRows)
+		{
+			size += bitmap.GetMemoryUsage();
+		}
+		for (const auto& [id, bitmap]: m_Masters)
+		{
+			size += sizeof(id) + sizeof(bitmap) + sizeof(void*) * 2 + bitmap.GetMemoryUsage();
+		}
+		return size;
+	}
+
+	const RoaringBitmap& ModuleIndex::GetFormatLevel(FormatLevel formatLevel) const noexcept
+	{
+		const size_t value = static_cast<size_t>(formatLevel);
+		return value < m_FormatLevels.size() ? m_FormatLevels[value] : m_Empty;
+	}
+	const RoaringBitmap& ModuleIndex::GetRequiring(std::string_view master) const noexcept
+	{
+		if (m_Table)
+		{
+			if (auto id = m_Table->FindName(master))
+			{
+				if (auto it = m_Masters.find(*id); it != m_Masters.end())
+				{
+					return it->second;
+				}
+			}
+		}
+		return m_Empty;
+	}
+	RoaringBitmap ModuleIndex::GetFormVersions(uint32_t min, uint32_t max) const
+	{
+		RoaringBitmap result;
+		auto it = std::lower_bound(m_FormVersions.begin(), m_FormVersions.end(), min);
+		for (; it != m_FormVersions.end() && *it <= max; ++it)
+		{
+			const RoaringBitmap& rows = m_FormVersionRows[it - m_FormVersions.begin()];
+			result = result.IsEmpty() ? rows : RoaringBitmap::Or(result, rows);
+		}
+		return result;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	// Recursive descent over the text, one function per precedence level
+	class ModuleQuery::Parser final
+	{
+		private:
+			std::string_view m_Text;
+			size_t m_Position = 0;
+			size_t m_Depth = 0;
+			std::vector<Node>& m_Nodes;
+			std::string m_Error;
+
+		private:
+			// Message with a quoted piece of the expression in the middle of it
+			std::nullopt_t Fail(std::string_view message, std::string_view quoted = {}, std::string_view suffix = {})
+			{
+				if (m_Error.empty())
+				{
+					m_Error = message;
+					if (!quoted.empty())
+					{
+						m_Error += '\'';
+						m_Error += quoted;
+						m_Error += '\'';
+					}
+					m_Error += suffix;
+					m_Error += " at position ";
+					m_Error += std::to_string(m_Position + 1);
+				}
+				return std::nullopt;
+			}
+			uint32_t AddNode(Node node)
+			{
+				m_Nodes.push_back(std::move(node));
+				return static_cast<uint32_t>(m_Nodes.size() - 1);
+			}
+			uint32_t AddNode(NodeType type, uint32_t left, uint32_t right = 0)
+			{
+				Node node;
+				node.Type = type;
+				node.Left = left;
+				node.Right = right;
+				return AddNode(std::move(node));
+			}
+
+			void SkipSpace() noexcept
+			{
+				while (m_Position < m_Text.size() && IsSpace(m_Text[m_Position]))
+				{
+					m_Position++;
+				}
+			}
+			std::string_view PeekWord() noexcept
+			{
+				SkipSpace();
+				size_t end = m_Position;
+				while (end < m_Text.size() && IsWordChar(m_Text[end]))
+				{
+					end++;
+				}
+				return m_Text.substr(m_Position, end - m_Position);
+			}
+			std::string_view ReadWord() noexcept
+			{
+				const std::string_view word = PeekWord();
+				m_Position += word.size();
+				return word;
+			}
+			bool Accept(char c) noexcept
+			{
+				SkipSpace();
+				if (m_Position < m_Text.size() && m_Text[m_Position] == c)
+				{
+					m_Position++;
+					return true;
+				}
+				return false;
+			}
+			bool Accept(char symbol, std::string_view keyword) noexcept
+			{
+				if (Accept(symbol))
+				{
+					return true;
+				}
+
+				const std::string_view word = PeekWord();
+				if (StringPool::Equals(word, keyword))
+				{
+					m_Position += word.size();
+					return true;
+				}
+				return false;
+			}
+			std::string_view ReadComparison() noexcept
+			{
+				SkipSpace();
+				constexpr std::string_view comparisons[] = {"<=", ">=", "!=", "==", "<", ">", "=", ":"};
+				for (std::string_view comparison: comparisons)
+				{
+					if (m_Text.substr(m_Position, comparison.size()) == comparison)
+					{
+						m_Position += comparison.size();
+						return comparison;
+					}
+				}
+				return {};
+			}
+			std::optional<std::string_view> ReadValue()
+			{
+				SkipSpace();
+				if (!Accept('"'))
+				{
+					return ReadWord();
+				}
+
+				const size_t end = m_Text.find('"', m_Position);
+				if (end == std::string_view::npos)
+				{
+					return Fail("unterminated quote");
+				}
+				const std::string_view value = m_Text.substr(m_Position, end - m_Position);
+				m_Position = end + 1;
+				return value;
+			}
+
+			std::optional<uint32_t> ParseTerm()
+			{
+				if (m_Nodes.size() >= g_MaxNodes)
+				{
+					return Fail("expression has too many terms");
+				}
+
+				const size_t start = m_Position;
+				const std::string_view field = ReadWord();
+				if (field.empty())
+				{
+					return m_Position < m_Text.size() ? Fail("unexpected ", m_Text.substr(m_Position, 1)) : Fail("expected a term");
+				}
+
+				const std::string_view comparison = ReadComparison();
+				if (comparison.empty())
+				{
+					Node node;
+					node.Type = NodeType::Flag;
+					if (StringPool::Equals(field, "esm") || StringPool::Equals(field, "master"))
+					{
+						node.Value = std::countr_zero(static_cast<uint32_t>(HeaderFlags::Master));
+					}
+					else if (StringPool::Equals(field, "esl") || StringPool::Equals(field, "light"))
+					{
+						node.Value = std::countr_zero(static_cast<uint32_t>(HeaderFlags::Light));
+					}
+					else if (StringPool::Equals(field, "localized"))
+					{
+						node.Value = std::countr_zero(static_cast<uint32_t>(HeaderFlags::Localized));
+					}
+					else if (StringPool::Equals(field, "ignored"))
+					{
+						node.Value = std::countr_zero(static_cast<uint32_t>(HeaderFlags::Ignored));
+					}
+					else
+					{
+						m_Position = start;
+						return Fail("unknown term ", field);
+					}
+					return AddNode(std::move(node));
+				}
+
+				const bool negate = comparison == "!=";
+				const bool equality = negate || comparison == "=" || comparison == "==" || comparison == ":";
+				const std::optional<std::string_view> value = ReadValue();
+				if (!value)
+				{
+					return std::nullopt;
+				}
+				else if (value->empty())
+				{
+					return Fail("expected a value");
+				}
+
+				Node node;
+				if (StringPool::Equals(field, "version"))
+				{
+					const auto version = ParseNumber(*value);
+					if (!version)
+					{
+						return Fail({}, *value, " isn't a form version");
+					}
+
+					// Comparisons are turned into inclusive ranges, an empty range has its minimum above the maximum
+					constexpr uint32_t max = std::numeric_limits<uint32_t>::max();
+					node.Type = NodeType::FormVersion;
+					node.Value = *version;
+					node.MaxValue = *version;
+					if (comparison == "<")
+					{
+						node.Value = *version == 0 ? 1 : 0;
+						node.MaxValue = *version == 0 ? 0 : *version - 1;
+					}
+					else if (comparison == "<=")
+					{
+						node.Value = 0;
+					}
+					else if (comparison == ">")
+					{
+						node.Value = *version == max ? 1 : *version + 1;
+						node.MaxValue = *version == max ? 0 : max;
+					}
+					else if (comparison == ">=")
+					{
+						node.MaxValue = max;
+					}
+				}
+				else if (!equality)
+				{
+					return Fail({}, field, " can only be compared with '=' or '!='");
+				}
+				else if (StringPool::Equals(field, "format"))
+				{
+					node.Type = NodeType::FormatLevel;
+					for (FormatLevel formatLevel: {FormatLevel::Morrowind, FormatLevel::Oblivion, FormatLevel::Skyrim})
+					{
+						if (StringPool::Equals(*value, GetFormatLevelName(formatLevel)))
+						{
+							node.Value = static_cast<uint32_t>(formatLevel);
+							break;
+						}
+					}
+					if (node.Value == 0 && !StringPool::Equals(*value, GetFormatLevelName(FormatLevel::Unknown)))
+					{
+						return Fail("unknown format ", *value);
+					}
+				}
+				else if (StringPool::Equals(field, "requires"))
+				{
+					node.Type = NodeType::Requires;
+					node.Name = *value;
+				}
+				else if (StringPool::Equals(field, "flag"))
+				{
+					const auto bit = ParseNumber(*value);
+					if (!bit || *bit >= 32)
+					{
+						return Fail("flag bit has to be from 0 to 31");
+					}
+					node.Type = NodeType::Flag;
+					node.Value = *bit;
+				}
+				else
+				{
+					m_Position = start;
+					return Fail("unknown field ", field);
+				}
+
+				const uint32_t term = AddNode(std::move(node));
+				return negate ? AddNode(NodeType::Not, term) : term;
+			}
+			std::optional<uint32_t> ParseUnary()
+			{
+				if (++m_Depth > g_MaxDepth)
+				{
+					return Fail("expression is nested too deep");
+				}
+
+				std::optional<uint32_t> node;
+				if (Accept('!', "not"))
+				{
+					if (node = ParseUnary(); node)
+					{
+						node = AddNode(NodeType::Not, *node);
+					}
+				}
+				else if (Accept('('))
+				{
+					node = ParseOr();
+					if (node && !Accept(')'))
+					{
+						node = Fail("expected ')'");
+					}
+				}
+				else
+				{
+					node = ParseTerm();
+				}
+
+				m_Depth--;
+				return node;
+			}
+			std::optional<uint32_t> ParseAnd()
+			{
+				std::optional<uint32_t> left = ParseUnary();
+				while (left && Accept('&', "and"))
+				{
+					const std::optional<uint32_t> right = ParseUnary();
+					if (!right)
+					{
+						return std::nullopt;
+					}
+					left = AddNode(NodeType::And, *left, *right);
+				}
+				return left;
+			}
+			std::optional<uint32_t> ParseOr()
+			{
+				std::optional<uint32_t> left = ParseAnd();
+				while (left && Accept('|', "or"))
+				{
+					const std::optional<uint32_t> right = ParseAnd();
+					if (!right)
+					{
+						return std::nullopt;
+					}
+					left = AddNode(NodeType::Or, *left, *right);
+				}
+				return left;
+			}
+
+		public:
+			Parser(std::string_view text, std::vector<Node>& nodes) noexcept
+				:m_Text(text), m_Nodes(nodes)
+			{
+			}
+
+		public:
+			// The root is the last node
+			bool Parse()
+			{
+				if (!ParseOr())
+				{
+					return false;
+				}
+
+				SkipSpace();
+				if (m_Position != m_Text.size())
+				{
+					Fail("unexpected ", m_Text.substr(m_Position, 1));
+					return false;
+				}
+				return true;
+			}
+			const std::string& GetError() const noexcept
+			{
+				return m_Error;
+			}
+	};
+
+	std::optional<ModuleQuery> ModuleQuery::Parse(std::string_view text, std::string* error)
+	{
+		ModuleQuery query;
+		Parser parser(text, query.m_Nodes);
+		if (!parser.Parse())
+		{
+			if (error)
+			{
+				*error = parser.GetError();
+			}
+			return {};
+		}
+		return query;
+	}
+
+	RoaringBitmap ModuleQuery::Evaluate(const ModuleIndex& index, uint32_t node) const
+	{
+		const Node& item = m_Nodes[node];
+		switch (item.Type)
+		{
+			case NodeType::Flag:
+			{
+				return index.GetFlag(item.Value);
+			}
+			case NodeType::FormatLevel:
+			{
+				return index.GetFormatLevel(static_cast<FormatLevel>(item.Value));
+			}
+			case NodeType::FormVersion:
+			{
+				return index.GetFormVersions(item.Value, item.MaxValue);
+			}
+			case NodeType::Requires:
+			{
+				return index.GetRequiring(item.Name);
+			}
+			case NodeType::Not:
+			{
+				return RoaringBitmap::AndNot(index.GetAll(), Evaluate(index, item.Left));
+			}
+			case NodeType::And:
+			{
+				// 'a & !b' is a single difference instead of a complement and an intersection
+				const Node& left = m_Nodes[item.Left];
+				const Node& right = m_Nodes[item.Right];
+				if (right.Type == NodeType::Not)
+				{
+					return RoaringBitmap::AndNot(Evaluate(index, item.Left), Evaluate(index, right.Left));
+				}
+				else if (left.Type == NodeType::Not)
+				{
+					return RoaringBitmap::AndNot(Evaluate(index, item.Right), Evaluate(index, left.Left));
+				}
+				return RoaringBitmap::And(Evaluate(index, item.Left), Evaluate(index, item.Right));
+			}
+			case NodeType::Or:
+			{
+				return RoaringBitmap::Or(Evaluate(index, item.Left), Evaluate(index, item.Right));
+			}
+		};
+		return {};
+	}
+	bool ModuleQuery::Matches(const ModuleInfo& info, uint32_t node) const noexcept
+	{
+		const Node& item = m_Nodes[node];
+		switch (item.Type)
+		{
+			case NodeType::Flag:
+			{
+				return (static_cast<uint32_t>(info.Flags) >> item.Value) & 1;
+			}
+			case NodeType::FormatLevel:
+			{
+				return static_cast<uint32_t>(info.FormatLevel) == item.Value;
+			}
+			case NodeType::FormVersion:
+			{
+				return info.FormVersion >= item.Value && info.FormVersion <= item.MaxValue;
+			}
+			case NodeType::Requires:
+			{
+				return std::any_of(info.Masters.begin(), info.Masters.end(), [&](const std::string& master)
+				{
+					return StringPool::Equals(master, item.Name);
+				});
+			}
+			case NodeType::Not:
+			{
+				return !Matches(info, item.Left);
+			}
+			case NodeType::And:
+			{
+				return Matches(info, item.Left) && Matches(info, item.Right);
+			}
+			case NodeType::Or:
+			{
+				return Matches(info, item.Left) || Matches(info, item.Right);
+			}
+		};
+		return false;
+	}
+
+	RoaringBitmap ModuleQuery::Evaluate(const ModuleIndex& index) const
+	{
+		return m_Nodes.empty() ? RoaringBitmap() : Evaluate(index, static_cast<uint32_t>(m_Nodes.size() - 1));
+	}
+	bool ModuleQuery::Matches(const ModuleInfo& info) const noexcept
+	{
+		return !m_Nodes.empty() && Matches(info, static_cast<uint32_t>(m_Nodes.size() - 1));
+	}
+}
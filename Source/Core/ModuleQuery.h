@@ -0,0 +1,119 @@
+#pragma once
+#include "ModuleTable.h"
+#include "RoaringBitmap.h"
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// Bitmaps of the rows of a 'ModuleTable' having each value of its header fields: every flag bit, every format
+	// level, every distinct form version and every master name. A query combines these instead of reading the
+	// columns. The table has to outlive the index, rows added to it later aren't indexed.
+	class ModuleIndex final
+	{
+		private:
+			const ModuleTable* m_Table = nullptr;
+
+			RoaringBitmap m_All;
+			RoaringBitmap m_Empty;
+			std::array<RoaringBitmap, 32> m_Flags;
+			std::array<RoaringBitmap, 4> m_FormatLevels;
+
+			// Distinct form versions in ascending order and their rows
+			std::vector<uint32_t> m_FormVersions;
+			std::vector<RoaringBitmap> m_FormVersionRows;
+
+			std::unordered_map<ModuleTable::TNameID, RoaringBitmap> m_Masters;
+
+		public:
+			static ModuleIndex Build(const ModuleTable& table);
+
+		public:
+			ModuleIndex() = default;
+
+		public:
+			const ModuleTable* GetTable() const noexcept
+			{
+				return m_Table;
+			}
+			size_t GetMemoryUsage() const noexcept;
+
+			const RoaringBitmap& GetAll() const noexcept
+			{
+				return m_All;
+			}
+			const RoaringBitmap& GetFlag(size_t bit) const noexcept
+			{
+				return bit < m_Flags.size() ? m_Flags[bit] : m_Empty;
+			}
+			const RoaringBitmap& GetFormatLevel(FormatLevel formatLevel) const noexcept;
+			const RoaringBitmap& GetRequiring(std::string_view master) const noexcept;
+
+			// Union of the form version buckets in the inclusive range
+			RoaringBitmap GetFormVersions(uint32_t min, uint32_t max) const;
+			size_t GetFormVersionCount() const noexcept
+			{
+				return m_FormVersions.size();
+			}
+	};
+
+	// Boolean expression over the indexed header fields, for example 'esl & !esm' or 'requires:Dawnguard.esm | version<44'.
+	//
+	// Terms are 'esm' (or 'master'), 'esl' (or 'light'), 'localized', 'ignored', 'flag:<bit>', 'format:<level>' with
+	// any name 'GetFormatLevelName' returns, 'version' compared with '<', '<=', '>', '>=', '=' or '!=' to a number,
+	// and 'requires:<master>'. Names with spaces are quoted in double quotes. Terms are combined with '!' ('not'),
+	// '&' ('and') and '|' ('or'), in that order of precedence, and parentheses. Everything ignores case.
+	class ModuleQuery final
+	{
+		private:
+			enum class NodeType
+			{
+				Flag,
+				FormatLevel,
+				FormVersion,
+				Requires,
+				Not,
+				And,
+				Or,
+			};
+			struct Node final
+			{
+				NodeType Type = NodeType::Flag;
+
+				// Flag bit, format level or inclusive form version range
+				uint32_t Value = 0;
+				uint32_t MaxValue = 0;
+				std::string Name;
+
+				// Operand nodes
+				uint32_t Left = 0;
+				uint32_t Right = 0;
+			};
+			class Parser;
+
+		private:
+			std::vector<Node> m_Nodes;
+
+		private:
+			RoaringBitmap Evaluate(const ModuleIndex& index, uint32_t node) const;
+			bool Matches(const ModuleInfo& info, uint32_t node) const noexcept;
+
+		public:
+			// Returns nothing and describes the problem in 'error' if the text isn't a valid expression
+			static std::optional<ModuleQuery> Parse(std::string_view text, std::string* error = nullptr);
+
+		public:
+			ModuleQuery() = default;
+
+		public:
+			// Rows of the indexed table matching the expression
+			RoaringBitmap Evaluate(const ModuleIndex& index) const;
+
+			// Same test for a single header, without an index
+			bool Matches(const ModuleInfo& info) const noexcept;
+	};
+}
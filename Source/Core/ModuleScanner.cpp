@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include "ModuleScanner.h"
+#include <mutex>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	bool IsSameExtension(const std::filesystem::path& path, std::string_view extension)
+	{
+		const auto value = path.extension().native();
+		if (value.size() != extension.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			auto c = value[i];
+			if (c >= 'A' && c <= 'Z')
+			{
+				c += 'a' - 'A';
+			}
+			if (c != static_cast<decltype(c)>(extension[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	bool IsModuleFile(const std::filesystem::path& path)
+	{
+		return IsSameExtension(path, ".esp") || IsSameExtension(path, ".esm") || IsSameExtension(path, ".esl") || IsSameExtension(path, ".esu");
+	}
+	std::vector<std::filesystem::path> FindModuleFiles(const std::filesystem::path& directory, bool recursive)
+	{
+		std::vector<std::filesystem::path> files;
+		auto TestEntry = [&](const std::filesystem::directory_entry& entry)
+		{
+			std::error_code error;
+			if (entry.is_regular_file(error) && IsModuleFile(entry.path()))
+			{
+				files.emplace_back(entry.path());
+			}
+		};
+
+		std::error_code error;
+		constexpr auto options = std::filesystem::directory_options::skip_permission_denied;
+		if (recursive)
+		{
+			for (auto it = std::filesystem::recursive_directory_iterator(directory, options, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+			{
+				TestEntry(*it);
+			}
+		}
+		else
+		{
+			for (auto it = std::filesystem::directory_iterator(directory, options, error); !error && it != std::filesystem::directory_iterator(); it.increment(error))
+			{
+				TestEntry(*it);
+			}
+		}
+		return files;
+	}
+
+	bool ReadModuleFile(const std::filesystem::path& path, std::vector<std::byte>& buffer, ScanResult& result, uint64_t& bytesRead, ByteSourceType sourceType)
+	{
+		result = {};
+		result.Path = path;
+
+		bool isRead = false;
+		if (sourceType == ByteSourceType::Mapped)
+		{
+			MappedByteSource source(path);
+			isRead = ReadModuleSource(source, buffer, result, bytesRead);
+		}
+		else
+		{
+			FileByteSource source(path);
+			isRead = ReadModuleSource(source, buffer, result, bytesRead);
+		}
+
+		// Morrowind doesn't store anything inside file to help distinguish master from ordinary plugin,
+		// so file extension is the only option.
+		if (isRead && result.Info.FormatLevel == FormatLevel::Morrowind && IsSameExtension(path, ".esm"))
+		{
+			result.Info.Flags = HeaderFlags::Master;
+		}
+		return isRead;
+	}
+
+	ScanStats ModuleScanner::Scan(const std::filesystem::path& directory, const TCallback& callback) const
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+
+		ScanStats stats = Scan(FindModuleFiles(directory, m_Recursive), callback);
+		stats.Elapsed = std::chrono::steady_clock::now() - startTime;
+		return stats;
+	}
+	ScanStats ModuleScanner::Scan(const std::vector<std::filesystem::path>& files, const TCallback& callback) const
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+
+		std::mutex callbackMutex;
+		std::atomic<size_t> failed = 0;
+		std::atomic<uint64_t> totalBytesRead = 0;
+
+		ParallelFor(files.size(), m_ThreadCount != 0 ? m_ThreadCount : GetDefaultThreadCount(), [&](size_t index)
+		{
+			// One scratch buffer per worker thread for the whole scan
+			thread_local std::vector<std::byte> buffer;
+
+			ScanResult result;
+			uint64_t bytesRead = 0;
+			if (!ReadModuleFile(files[index], buffer, result, bytesRead, m_SourceType))
+			{
+				failed++;
+			}
+			totalBytesRead += bytesRead;
+
+			std::lock_guard lock(callbackMutex);
+			callback(result);
+		});
+
+		ScanStats stats;
+		stats.Files = files.size();
+		stats.Failed = failed;
+		stats.BytesRead = totalBytesRead;
+		stats.Elapsed = std::chrono::steady_clock::now() - startTime;
+		return stats;
+	}
+
+	ScanStats ModuleScanner::ScanBatch(std::span<const std::filesystem::path> files, std::span<ScanResult> results) const
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		const size_t count = std::min(files.size(), results.size());
+
+		std::atomic<size_t> failed = 0;
+		std::atomic<uint64_t> totalBytesRead = 0;
+		StealingParallelFor(count, m_ThreadCount != 0 ? m_ThreadCount : GetDefaultThreadCount(), [&](size_t index)
+		{
+			thread_local std::vector<std::byte> buffer;
+
+			uint64_t bytesRead = 0;
+			if (!ReadModuleFile(files[index], buffer, results[index], bytesRead, m_SourceType))
+			{
+				failed.fetch_add(1, std::memory_order_relaxed);
+			}
+			totalBytesRead.fetch_add(bytesRead, std::memory_order_relaxed);
+		});
+
+		ScanStats stats;
+		stats.Files = count;
+		stats.Failed = failed;
+		stats.BytesRead = totalBytesRead;
+		stats.Elapsed = std::chrono::steady_clock::now() - startTime;
+		return stats;
+	}
+	std::vector<ScanResult> ModuleScanner::ScanBatch(std::span<const std::filesystem::path> files, ScanStats* stats) const
+	{
+		std::vector<ScanResult> results(files.size());
+		const ScanStats batchStats = ScanBatch(files, std::span<ScanResult>(results));
+		if (stats)
+		{
+			*stats = batchStats;
+		}
+		return results;
+	}
+}
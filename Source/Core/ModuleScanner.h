@@ -0,0 +1,145 @@
+#pragma once
+#include "ModuleInfo.h"
+#include "ByteSource.h"
+#include "Parallel.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+
+namespace BethesdaModule::Core
+{
+	struct ScanResult final
+	{
+		std::filesystem::path Path;
+		uint64_t FileSize = 0;
+		ParseStatus Status = ParseStatus::UnknownFormat;
+		std::string Error;
+		ModuleInfo Info;
+	};
+
+	struct ScanStats final
+	{
+		size_t Files = 0;
+		size_t Failed = 0;
+		uint64_t BytesRead = 0;
+		std::chrono::nanoseconds Elapsed = {};
+
+		double GetFilesPerSecond() const noexcept
+		{
+			const double seconds = std::chrono::duration<double>(Elapsed).count();
+			return seconds > 0 ? Files / seconds : 0;
+		}
+	};
+
+	enum class ByteSourceType
+	{
+		// Positional reads of the header only
+		File,
+
+		// Memory map the whole file and parse in-place
+		Mapped,
+	};
+
+	// Checks for '.esp', '.esm', '.esl' and '.esu' extensions ignoring case
+	bool IsModuleFile(const std::filesystem::path& path);
+	std::vector<std::filesystem::path> FindModuleFiles(const std::filesystem::path& directory, bool recursive = true);
+
+	// Reads and parses the header of a single module file. The buffer is only a scratch space and can be reused between calls.
+	bool ReadModuleFile(const std::filesystem::path& path, std::vector<std::byte>& buffer, ScanResult& result, uint64_t& bytesRead, ByteSourceType sourceType = ByteSourceType::File);
+
+	// Parses module header from any byte source into an owning 'ModuleInfo'
+	template<ByteSource TSource>
+	ParseStatus ReadModuleInfo(TSource& source, std::vector<std::byte>& buffer, ModuleInfo& info, uint64_t* bytesRead = nullptr, const ParseLimits& limits = {})
+	{
+		const std::span<const std::byte> data = ReadModuleHeaderData(source, buffer, bytesRead, limits);
+
+		ModuleHeader header;
+		const ParseStatus status = ParseModuleHeader(data, header, limits);
+		info = ModuleInfo::FromHeader(data, header);
+		return status;
+	}
+
+	// Parses the header from an open byte source into the result, sets its size, status and error but not the path
+	template<ByteSource TSource>
+	bool ReadModuleSource(TSource& source, std::vector<std::byte>& buffer, ScanResult& result, uint64_t& bytesRead)
+	{
+		if (!source.IsOpen())
+		{
+			result.Error = "can't open file";
+			return false;
+		}
+		result.FileSize = source.GetSize().value_or(0);
+
+		result.Status = ReadModuleInfo(source, buffer, result.Info, &bytesRead);
+		if (result.Status == ParseStatus::UnknownFormat)
+		{
+			result.Error = "unknown format";
+			return false;
+		}
+		return true;
+	}
+
+	class ModuleScanner final
+	{
+		public:
+			// Called from worker threads, but never concurrently
+			using TCallback = std::function<void(const ScanResult& result)>;
+
+		private:
+			size_t m_ThreadCount = 0;
+			bool m_Recursive = true;
+			ByteSourceType m_SourceType = ByteSourceType::File;
+
+		public:
+			ModuleScanner(size_t threadCount = 0, bool recursive = true) noexcept
+				:m_ThreadCount(threadCount), m_Recursive(recursive)
+			{
+			}
+
+		public:
+			void SetSourceType(ByteSourceType sourceType) noexcept
+			{
+				m_SourceType = sourceType;
+			}
+
+			ScanStats Scan(const std::filesystem::path& directory, const TCallback& callback) const;
+			ScanStats Scan(const std::vector<std::filesystem::path>& files, const TCallback& callback) const;
+
+			// Parses a batch into the results at the same indices. Each result is written only by the thread that
+			// parsed it, so there are no locks and the order doesn't depend on the thread count. Work is split
+			// with 'StealingParallelFor'. Errors are reported in each result, the results span can't be shorter.
+			ScanStats ScanBatch(std::span<const std::filesystem::path> files, std::span<ScanResult> results) const;
+			std::vector<ScanResult> ScanBatch(std::span<const std::filesystem::path> files, ScanStats* stats = nullptr) const;
+
+			// Same for sources that are already open, results don't have paths then
+			template<ByteSource TSource>
+			ScanStats ScanBatch(std::span<TSource> sources, std::span<ScanResult> results) const
+			{
+				const auto startTime = std::chrono::steady_clock::now();
+
+				std::atomic<size_t> failed = 0;
+				std::atomic<uint64_t> totalBytesRead = 0;
+				StealingParallelFor(std::min(sources.size(), results.size()), m_ThreadCount != 0 ? m_ThreadCount : GetDefaultThreadCount(), [&](size_t index)
+				{
+					thread_local std::vector<std::byte> buffer;
+
+					ScanResult& result = results[index];
+					result = {};
+
+					uint64_t bytesRead = 0;
+					if (!ReadModuleSource(sources[index], buffer, result, bytesRead))
+					{
+						failed.fetch_add(1, std::memory_order_relaxed);
+					}
+					totalBytesRead.fetch_add(bytesRead, std::memory_order_relaxed);
+				});
+
+				ScanStats stats;
+				stats.Files = std::min(sources.size(), results.size());
+				stats.Failed = failed;
+				stats.BytesRead = totalBytesRead;
+				stats.Elapsed = std::chrono::steady_clock::now() - startTime;
+				return stats;
+			}
+	};
+}
@@ -0,0 +1,1190 @@
+#include "stdafx.h"
+#include "ModuleSnapshot.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	// Arrow buffers are little-endian and read in place
+	static_assert(std::endian::native == std::endian::little);
+
+	constexpr size_t g_BufferAlignment = 64;
+	constexpr int16_t g_MetadataVersion = 4; // V5
+	constexpr uint32_t g_Continuation = 0xFFFFFFFFu;
+
+	// Flatbuffer union and enum values of the Arrow schema
+	namespace ArrowType
+	{
+		constexpr uint8_t Int = 2;
+		constexpr uint8_t Utf8 = 5;
+		constexpr uint8_t Timestamp = 10;
+		constexpr uint8_t List = 12;
+		constexpr uint8_t FixedSizeBinary = 15;
+	}
+	namespace MessageType
+	{
+		constexpr uint8_t Schema = 1;
+		constexpr uint8_t DictionaryBatch = 2;
+		constexpr uint8_t RecordBatch = 3;
+	}
+	constexpr int16_t g_Microsecond = 2;
+
+	// Dictionary IDs of the encoded columns
+	constexpr int64_t g_StatusDictionary = 0;
+	constexpr int64_t g_FormatDictionary = 1;
+
+	constexpr ParseStatus g_Statuses[] = {ParseStatus::Success, ParseStatus::UnknownFormat, ParseStatus::Truncated, ParseStatus::Malformed, ParseStatus::LimitExceeded};
+	constexpr FormatLevel g_FormatLevels[] = {FormatLevel::Unknown, FormatLevel::Morrowind, FormatLevel::Oblivion, FormatLevel::Skyrim};
+
+	// Structs of the Arrow metadata as they're laid out in a flatbuffer
+	struct FieldNode final
+	{
+		int64_t Length = 0;
+		int64_t NullCount = 0;
+	};
+	struct BufferRef final
+	{
+		int64_t Offset = 0;
+		int64_t Length = 0;
+	};
+	struct Block final
+	{
+		int64_t Offset = 0;
+		int32_t MetadataLength = 0;
+		int32_t Padding = 0;
+		int64_t BodyLength = 0;
+	};
+	static_assert(sizeof(FieldNode) == 16 && sizeof(BufferRef) == 16 && sizeof(Block) == 24);
+
+	size_t AlignUp(size_t value, size_t alignment) noexcept
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	std::string ToUTF8(const std::filesystem::path& path)
+	{
+		const std::u8string value = path.u8string();
+		return {reinterpret_cast<const char*>(value.data()), value.size()};
+	}
+
+	template<class T>
+	std::optional<T> Load(std::span<const std::byte> data, size_t offset) noexcept
+	{
+		if (offset > data.size() || data.size() - offset < sizeof(T))
+		{
+			return {};
+		}
+
+		T value;
+		std::memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+}
+
+namespace
+{
+	// Writes a flatbuffer front to back. Every table, vector and string is written after whatever refers to it, so all
+	// offsets point forward as the format requires, and the referring field is patched once the target is written.
+	class FlatBufferWriter final
+	{
+		public:
+			using TWrite = std::function<size_t(FlatBufferWriter&)>;
+
+			struct Field final
+			{
+				uint16_t Slot = 0;
+				uint8_t Size = 0;
+				uint64_t Value = 0;
+				TWrite Child;
+			};
+
+			template<class T>
+			static Field Scalar(uint16_t slot, T value) noexcept
+			{
+				Field field;
+				field.Slot = slot;
+				field.Size = sizeof(T);
+				field.Value = static_cast<uint64_t>(value);
+				return field;
+			}
+			static Field Child(uint16_t slot, TWrite write)
+			{
+				Field field;
+				field.Slot = slot;
+				field.Size = sizeof(uint32_t);
+				field.Child = std::move(write);
+				return field;
+			}
+
+		private:
+			std::vector<std::byte> m_Buffer;
+
+		private:
+			void Align(size_t alignment)
+			{
+				m_Buffer.resize(AlignUp(m_Buffer.size(), alignment));
+			}
+			void Put(size_t offset, uint64_t value, size_t size) noexcept
+			{
+				for (size_t i = 0; i < size; i++)
+				{
+					m_Buffer[offset + i] = static_cast<std::byte>(value >> (i * 8));
+				}
+			}
+			size_t Append(uint64_t value, size_t size)
+			{
+				const size_t offset = m_Buffer.size();
+				m_Buffer.resize(offset + size);
+				Put(offset, value, size);
+				return offset;
+			}
+			void PatchOffset(size_t offset, size_t target) noexcept
+			{
+				Put(offset, target - offset, sizeof(uint32_t));
+			}
+
+		public:
+			// Root offset followed by the root table
+			std::vector<std::byte> Finish(const TWrite& root)
+			{
+				m_Buffer.clear();
+				Append(0, sizeof(uint32_t));
+				PatchOffset(0, root(*this));
+				Align(8);
+				return std::move(m_Buffer);
+			}
+
+			size_t WriteTable(std::vector<Field> fields)
+			{
+				size_t slotCount = 0;
+				size_t alignment = sizeof(uint32_t);
+				for (const Field& field: fields)
+				{
+					slotCount = std::max<size_t>(slotCount, field.Slot + 1);
+					alignment = std::max<size_t>(alignment, field.Size);
+				}
+
+				// VTable first, its offset from the table is positive then
+				Align(sizeof(uint16_t));
+				const size_t vtable = m_Buffer.size();
+				m_Buffer.resize(vtable + (2 + slotCount) * sizeof(uint16_t));
+
+				Align(alignment);
+				const size_t table = m_Buffer.size();
+				Append(table - vtable, sizeof(int32_t));
+
+				// Largest fields first keeps the padding down
+				std::stable_sort(fields.begin(), fields.end(), [](const Field& left, const Field& right)
+				{
+					return left.Size > right.Size;
+				});
+				std::vector<size_t> positions(fields.size());
+				for (size_t i = 0; i < fields.size(); i++)
+				{
+					Align(fields[i].Size);
+					positions[i] = Append(fields[i].Value, fields[i].Size);
+					Put(vtable + (2 + fields[i].Slot) * sizeof(uint16_t), positions[i] - table, sizeof(uint16_t));
+				}
+				Put(vtable, (2 + slotCount) * sizeof(uint16_t), sizeof(uint16_t));
+				Put(vtable + sizeof(uint16_t), m_Buffer.size() - table, sizeof(uint16_t));
+
+				for (size_t i = 0; i < fields.size(); i++)
+				{
+					if (fields[i].Child)
+					{
+						PatchOffset(positions[i], fields[i].Child(*this));
+					}
+				}
+				return table;
+			}
+			size_t WriteString(std::string_view value)
+			{
+				Align(sizeof(uint32_t));
+				const size_t offset = Append(value.size(), sizeof(uint32_t));
+				const std::byte* bytes = reinterpret_cast<const std::byte*>(value.data());
+				m_Buffer.insert(m_Buffer.end(), bytes, bytes + value.size());
+				m_Buffer.push_back(std::byte(0));
+				return offset;
+			}
+			size_t WriteTables(const std::vector<TWrite>& tables)
+			{
+				Align(sizeof(uint32_t));
+				const size_t offset = Append(tables.size(), sizeof(uint32_t));
+				m_Buffer.resize(m_Buffer.size() + tables.size() * sizeof(uint32_t));
+				for (size_t i = 0; i < tables.size(); i++)
+				{
+					const size_t slot = offset + (i + 1) * sizeof(uint32_t);
+					PatchOffset(slot, tables[i](*this));
+				}
+				return offset;
+			}
+
+			// Structs of the Arrow metadata all have 8-byte alignment, which applies to the elements after the count
+			template<class T>
+			size_t WriteStructs(std::span<const T> values)
+			{
+				Align(sizeof(uint32_t));
+				if (m_Buffer.size() % 8 == 0)
+				{
+					m_Buffer.resize(m_Buffer.size() + sizeof(uint32_t));
+				}
+				const size_t offset = Append(values.size(), sizeof(uint32_t));
+				const std::byte* bytes = reinterpret_cast<const std::byte*>(values.data());
+				m_Buffer.insert(m_Buffer.end(), bytes, bytes + values.size_bytes());
+				return offset;
+			}
+	};
+	using TWrite = FlatBufferWriter::TWrite;
+
+	// Bounds-checked view of a flatbuffer table, fields that are absent or point outside of the buffer read as missing
+	class FlatTable final
+	{
+		private:
+			std::span<const std::byte> m_Buffer;
+			size_t m_Table = 0;
+			size_t m_VTable = 0;
+			size_t m_VTableSize = 0;
+
+		public:
+			static FlatTable FromRoot(std::span<const std::byte> buffer) noexcept
+			{
+				if (auto offset = Load<uint32_t>(buffer, 0))
+				{
+					return FlatTable(buffer, *offset);
+				}
+				return {};
+			}
+
+		public:
+			FlatTable() noexcept = default;
+			FlatTable(std::span<const std::byte> buffer, size_t table) noexcept
+			{
+				auto offset = Load<int32_t>(buffer, table);
+				if (!offset)
+				{
+					return;
+				}
+
+				const int64_t vtable = static_cast<int64_t>(table) - *offset;
+				if (vtable < 0)
+				{
+					return;
+				}
+				auto vtableSize = Load<uint16_t>(buffer, static_cast<size_t>(vtable));
+				if (!vtableSize || *vtableSize < 4 || static_cast<size_t>(vtable) + *vtableSize > buffer.size())
+				{
+					return;
+				}
+
+				m_Buffer = buffer;
+				m_Table = table;
+				m_VTable = static_cast<size_t>(vtable);
+				m_VTableSize = *vtableSize;
+			}
+
+		public:
+			bool IsValid() const noexcept
+			{
+				return !m_Buffer.empty();
+			}
+			std::optional<size_t> GetFieldOffset(uint16_t slot) const noexcept
+			{
+				const size_t entry = (2 + static_cast<size_t>(slot)) * sizeof(uint16_t);
+				if (!IsValid() || entry + sizeof(uint16_t) > m_VTableSize)
+				{
+					return {};
+				}
+				const uint16_t offset = Load<uint16_t>(m_Buffer, m_VTable + entry).value_or(0);
+				if (offset == 0)
+				{
+					return {};
+				}
+				return m_Table + offset;
+			}
+
+			template<class T>
+			T GetScalar(uint16_t slot, T defaultValue) const noexcept
+			{
+				if (auto offset = GetFieldOffset(slot))
+				{
+					return Load<T>(m_Buffer, *offset).value_or(defaultValue);
+				}
+				return defaultValue;
+			}
+			std::optional<size_t> GetTarget(uint16_t slot) const noexcept
+			{
+				if (auto offset = GetFieldOffset(slot))
+				{
+					if (auto target = Load<uint32_t>(m_Buffer, *offset); target && *target <= m_Buffer.size() - *offset)
+					{
+						return *offset + *target;
+					}
+				}
+				return {};
+			}
+			FlatTable GetTable(uint16_t slot) const noexcept
+			{
+				if (auto target = GetTarget(slot))
+				{
+					return FlatTable(m_Buffer, *target);
+				}
+				return {};
+			}
+			std::optional<std::string_view> GetString(uint16_t slot) const noexcept
+			{
+				if (auto target = GetTarget(slot))
+				{
+					if (auto size = Load<uint32_t>(m_Buffer, *target); size && *size <= m_Buffer.size() - *target - sizeof(uint32_t))
+					{
+						return std::string_view(reinterpret_cast<const char*>(m_Buffer.data() + *target + sizeof(uint32_t)), *size);
+					}
+				}
+				return {};
+			}
+
+			// Elements of a vector of structs, copied out since the buffer doesn't guarantee their alignment
+			template<class T>
+			std::optional<std::vector<T>> GetStructs(uint16_t slot) const
+			{
+				if (auto target = GetTarget(slot))
+				{
+					auto count = Load<uint32_t>(m_Buffer, *target);
+					const size_t data = *target + sizeof(uint32_t);
+					if (count && *count <= (m_Buffer.size() - data) / sizeof(T))
+					{
+						std::vector<T> values(*count);
+						std::memcpy(values.data(), m_Buffer.data() + data, *count * sizeof(T));
+						return values;
+					}
+				}
+				return {};
+			}
+			std::optional<std::vector<FlatTable>> GetTables(uint16_t slot) const
+			{
+				if (auto target = GetTarget(slot))
+				{
+					auto count = Load<uint32_t>(m_Buffer, *target);
+					if (count && *count <= (m_Buffer.size() - *target - sizeof(uint32_t)) / sizeof(uint32_t))
+					{
+						std::vector<FlatTable> tables;
+						tables.reserve(*count);
+						for (size_t i = 0; i < *count; i++)
+						{
+							const size_t slotOffset = *target + (i + 1) * sizeof(uint32_t);
+							const uint32_t offset = Load<uint32_t>(m_Buffer, slotOffset).value_or(0);
+							if (offset > m_Buffer.size() - slotOffset)
+							{
+								return {};
+							}
+							tables.emplace_back(m_Buffer, slotOffset + offset);
+						}
+						return tables;
+					}
+				}
+				return {};
+			}
+	};
+}
+
+namespace
+{
+	// Schema of a snapshot, the same in the schema message and in the footer
+	struct ColumnType final
+	{
+		uint8_t Type = 0;
+		TWrite TypeTable;
+		TWrite Dictionary;
+		std::vector<TWrite> Children;
+
+		ColumnType(uint8_t type, TWrite typeTable)
+			:Type(type), TypeTable(std::move(typeTable))
+		{
+		}
+	};
+	TWrite WriteField(std::string_view name, ColumnType type)
+	{
+		return [name, type = std::move(type)](FlatBufferWriter& writer)
+		{
+			std::vector<FlatBufferWriter::Field> fields =
+			{
+				FlatBufferWriter::Child(0, [name](FlatBufferWriter& writer)
+				{
+					return writer.WriteString(name);
+				}),
+				FlatBufferWriter::Scalar<uint8_t>(1, 0),
+				FlatBufferWriter::Scalar<uint8_t>(2, type.Type),
+				FlatBufferWriter::Child(3, type.TypeTable),
+				FlatBufferWriter::Child(5, [&](FlatBufferWriter& writer)
+				{
+					return writer.WriteTables(type.Children);
+				}),
+			};
+			if (type.Dictionary)
+			{
+				fields.push_back(FlatBufferWriter::Child(4, type.Dictionary));
+			}
+			return writer.WriteTable(std::move(fields));
+		};
+	}
+	TWrite WriteIntType(int32_t bitWidth, bool isSigned)
+	{
+		return [=](FlatBufferWriter& writer)
+		{
+			return writer.WriteTable({FlatBufferWriter::Scalar<int32_t>(0, bitWidth), FlatBufferWriter::Scalar<uint8_t>(1, isSigned)});
+		};
+	}
+	TWrite WriteEmptyType()
+	{
+		return [](FlatBufferWriter& writer)
+		{
+			return writer.WriteTable({});
+		};
+	}
+
+	ColumnType MakeInt(int32_t bitWidth, bool isSigned)
+	{
+		return ColumnType(ArrowType::Int, WriteIntType(bitWidth, isSigned));
+	}
+	ColumnType MakeUTF8()
+	{
+		return ColumnType(ArrowType::Utf8, WriteEmptyType());
+	}
+	ColumnType MakeDictionary(int64_t id)
+	{
+		ColumnType type = MakeUTF8();
+		type.Dictionary = [id](FlatBufferWriter& writer)
+		{
+			return writer.WriteTable({FlatBufferWriter::Scalar<int64_t>(0, id), FlatBufferWriter::Child(1, WriteIntType(8, true))});
+		};
+		return type;
+	}
+
+	size_t WriteSchema(FlatBufferWriter& writer)
+	{
+		ColumnType signature(ArrowType::FixedSizeBinary, [](FlatBufferWriter& writer)
+		{
+			return writer.WriteTable({FlatBufferWriter::Scalar<int32_t>(0, 4)});
+		});
+		ColumnType modified(ArrowType::Timestamp, [](FlatBufferWriter& writer)
+		{
+			return writer.WriteTable({FlatBufferWriter::Scalar<int16_t>(0, g_Microsecond), FlatBufferWriter::Child(1, [](FlatBufferWriter& writer)
+			{
+				return writer.WriteString("UTC");
+			})});
+		});
+		ColumnType masters(ArrowType::List, WriteEmptyType());
+		masters.Children.push_back(WriteField("item", MakeUTF8()));
+
+		const std::vector<TWrite> fields =
+		{
+			WriteField("path", MakeUTF8()),
+			WriteField("status", MakeDictionary(g_StatusDictionary)),
+			WriteField("format", MakeDictionary(g_FormatDictionary)),
+			WriteField("signature", std::move(signature)),
+			WriteField("flags", MakeInt(32, false)),
+			WriteField("form_version", MakeInt(32, false)),
+			WriteField("file_size", MakeInt(64, false)),
+			WriteField("modified", std::move(modified)),
+			WriteField("author", MakeUTF8()),
+			WriteField("description", MakeUTF8()),
+			WriteField("masters", std::move(masters)),
+		};
+		return writer.WriteTable({FlatBufferWriter::Child(1, [&](FlatBufferWriter& writer)
+		{
+			return writer.WriteTables(fields);
+		})});
+	}
+
+	// Body of a record batch: every buffer starts at a multiple of 64 bytes
+	class BodyWriter final
+	{
+		private:
+			std::vector<std::byte> m_Data;
+			std::vector<FieldNode> m_Nodes;
+			std::vector<BufferRef> m_Buffers;
+
+		public:
+			void AddNode(size_t length)
+			{
+				m_Nodes.push_back({static_cast<int64_t>(length), 0});
+			}
+			void AddBuffer(const void* data, size_t size)
+			{
+				m_Buffers.push_back({static_cast<int64_t>(m_Data.size()), static_cast<int64_t>(size)});
+				m_Data.insert(m_Data.end(), static_cast<const std::byte*>(data), static_cast<const std::byte*>(data) + size);
+				m_Data.resize(AlignUp(m_Data.size(), g_BufferAlignment));
+			}
+			template<class T>
+			void AddBuffer(const std::vector<T>& values)
+			{
+				AddBuffer(values.data(), values.size() * sizeof(T));
+			}
+
+			// Columns have no nulls, so their validity bitmaps are empty
+			template<class T>
+			void AddColumn(const std::vector<T>& values)
+			{
+				AddNode(values.size());
+				AddBuffer(nullptr, 0);
+				AddBuffer(values);
+			}
+			template<class TFunc>
+			bool AddTextColumn(size_t count, TFunc&& getText)
+			{
+				std::vector<int32_t> offsets(count + 1);
+				std::string data;
+				for (size_t i = 0; i < count; i++)
+				{
+					const std::string_view text = getText(i);
+					if (text.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()) - data.size())
+					{
+						return false;
+					}
+					data += text;
+					offsets[i + 1] = static_cast<int32_t>(data.size());
+				}
+
+				AddNode(count);
+				AddBuffer(nullptr, 0);
+				AddBuffer(offsets);
+				AddBuffer(data.data(), data.size());
+				return true;
+			}
+
+			std::span<const std::byte> GetData() const noexcept
+			{
+				return m_Data;
+			}
+			TWrite WriteRecordBatch(size_t length) const
+			{
+				return [this, length](FlatBufferWriter& writer)
+				{
+					return writer.WriteTable(
+					{
+						FlatBufferWriter::Scalar<int64_t>(0, static_cast<int64_t>(length)),
+						FlatBufferWriter::Child(1, [this](FlatBufferWriter& writer)
+						{
+							return writer.WriteStructs(std::span<const FieldNode>(m_Nodes));
+						}),
+						FlatBufferWriter::Child(2, [this](FlatBufferWriter& writer)
+						{
+							return writer.WriteStructs(std::span<const BufferRef>(m_Buffers));
+						}),
+					});
+				};
+			}
+	};
+
+	std::vector<std::byte> WriteMessage(uint8_t headerType, const TWrite& header, size_t bodyLength)
+	{
+		return FlatBufferWriter().Finish([&](FlatBufferWriter& writer)
+		{
+			return writer.WriteTable(
+			{
+				FlatBufferWriter::Scalar<int16_t>(0, g_MetadataVersion),
+				FlatBufferWriter::Scalar<uint8_t>(1, headerType),
+				FlatBufferWriter::Child(2, header),
+				FlatBufferWriter::Scalar<int64_t>(3, static_cast<int64_t>(bodyLength)),
+			});
+		});
+	}
+
+	// Continuation marker, metadata size, metadata padded so that the body starts at a multiple of 64 bytes, and the body
+	class FileWriter final
+	{
+		private:
+			std::ofstream m_Stream;
+			uint64_t m_Offset = 0;
+
+		public:
+			FileWriter(const std::filesystem::path& path)
+				:m_Stream(path, std::ios::binary|std::ios::trunc)
+			{
+			}
+
+		public:
+			bool IsOk() const noexcept
+			{
+				return m_Stream.good();
+			}
+			void Write(const void* data, size_t size)
+			{
+				m_Stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+				m_Offset += size;
+			}
+			void WriteZeros(size_t size)
+			{
+				constexpr char zeros[g_BufferAlignment] = {};
+				Write(zeros, size);
+			}
+			template<class T>
+			void Write(T value)
+			{
+				Write(&value, sizeof(value));
+			}
+
+			Block WriteMessage(std::span<const std::byte> metadata, std::span<const std::byte> body = {})
+			{
+				Block block;
+				block.Offset = static_cast<int64_t>(m_Offset);
+
+				const size_t paddedSize = AlignUp(m_Offset + 2 * sizeof(uint32_t) + metadata.size(), g_BufferAlignment) - m_Offset - 2 * sizeof(uint32_t);
+				Write(g_Continuation);
+				Write(static_cast<int32_t>(paddedSize));
+				Write(metadata.data(), metadata.size());
+				WriteZeros(paddedSize - metadata.size());
+				Write(body.data(), body.size());
+
+				block.MetadataLength = static_cast<int32_t>(2 * sizeof(uint32_t) + paddedSize);
+				block.BodyLength = static_cast<int64_t>(body.size());
+				return block;
+			}
+	};
+}
+
+namespace BethesdaModule::Core
+{
+	int64_t ModuleSnapshot::GetLastWriteTime(const std::filesystem::path& path) noexcept
+	{
+		std::error_code error;
+		const auto time = std::filesystem::last_write_time(path, error);
+		if (error)
+		{
+			return 0;
+		}
+
+		#if defined(_WIN32)
+		const auto systemTime = std::chrono::clock_cast<std::chrono::system_clock>(time);
+		#else
+		const auto systemTime = std::chrono::file_clock::to_sys(time);
+		#endif
+		return std::chrono::duration_cast<std::chrono::microseconds>(systemTime.time_since_epoch()).count();
+	}
+
+	bool ModuleSnapshot::Write(const std::filesystem::path& filePath, std::span<const ScanResult> results, std::span<const int64_t> lastWriteTimes)
+	{
+		const size_t count = results.size();
+		if (!lastWriteTimes.empty() && lastWriteTimes.size() != count)
+		{
+			return false;
+		}
+
+		// Dictionaries
+		std::vector<std::string_view> statusNames;
+		for (ParseStatus status: g_Statuses)
+		{
+			statusNames.push_back(GetParseStatusName(status));
+		}
+		std::vector<std::string_view> formatNames;
+		for (FormatLevel formatLevel: g_FormatLevels)
+		{
+			formatNames.push_back(GetFormatLevelName(formatLevel));
+		}
+
+		// Fixed width columns
+		std::vector<int8_t> statuses(count);
+		std::vector<int8_t> formatLevels(count);
+		std::vector<uint32_t> signatures(count);
+		std::vector<uint32_t> flags(count);
+		std::vector<uint32_t> formVersions(count);
+		std::vector<uint64_t> fileSizes(count);
+		std::vector<int64_t> times(count);
+		std::vector<int32_t> masterOffsets(count + 1);
+		std::vector<std::string> paths(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const ScanResult& result = results[i];
+			statuses[i] = static_cast<int8_t>(result.Status);
+			formatLevels[i] = static_cast<int8_t>(result.Info.FormatLevel);
+			signatures[i] = result.Info.Signature;
+			flags[i] = static_cast<uint32_t>(result.Info.Flags);
+			formVersions[i] = result.Info.FormVersion;
+			fileSizes[i] = result.FileSize;
+			times[i] = lastWriteTimes.empty() ? GetLastWriteTime(result.Path) : lastWriteTimes[i];
+			paths[i] = ToUTF8(result.Path);
+
+			if (result.Info.Masters.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max() - masterOffsets[i]))
+			{
+				return false;
+			}
+			masterOffsets[i + 1] = masterOffsets[i] + static_cast<int32_t>(result.Info.Masters.size());
+		}
+
+		// Columns in schema order, lists are followed by their items
+		BodyWriter body;
+		bool isOk = body.AddTextColumn(count, [&](size_t i) -> std::string_view
+		{
+			return paths[i];
+		});
+		body.AddColumn(statuses);
+		body.AddColumn(formatLevels);
+		body.AddColumn(signatures);
+		body.AddColumn(flags);
+		body.AddColumn(formVersions);
+		body.AddColumn(fileSizes);
+		body.AddColumn(times);
+		isOk = isOk && body.AddTextColumn(count, [&](size_t i) -> std::string_view
+		{
+			return results[i].Info.Author;
+		});
+		isOk = isOk && body.AddTextColumn(count, [&](size_t i) -> std::string_view
+		{
+			return results[i].Info.Description;
+		});
+		body.AddNode(count);
+		body.AddBuffer(nullptr, 0);
+		body.AddBuffer(masterOffsets);
+
+		std::vector<std::string_view> masters;
+		masters.reserve(static_cast<size_t>(masterOffsets.back()));
+		for (const ScanResult& result: results)
+		{
+			masters.insert(masters.end(), result.Info.Masters.begin(), result.Info.Masters.end());
+		}
+		isOk = isOk && body.AddTextColumn(masters.size(), [&](size_t i)
+		{
+			return masters[i];
+		});
+		if (!isOk)
+		{
+			return false;
+		}
+
+		std::filesystem::path tempPath = filePath;
+		tempPath += ".tmp";
+
+		std::vector<Block> dictionaryBlocks;
+		std::vector<Block> batchBlocks;
+		{
+			FileWriter file(tempPath);
+			file.Write(FileMagic.data(), FileMagic.size());
+			file.WriteZeros(2);
+			file.WriteMessage(WriteMessage(MessageType::Schema, WriteSchema, 0));
+
+			// A dictionary batch is a record batch with a single string column
+			const std::pair<int64_t, const std::vector<std::string_view>*> dictionaryValues[] = {{g_StatusDictionary, &statusNames}, {g_FormatDictionary, &formatNames}};
+			for (const auto& values: dictionaryValues)
+			{
+				const int64_t id = values.first;
+				const std::vector<std::string_view>& names = *values.second;
+
+				BodyWriter dictionary;
+				dictionary.AddTextColumn(names.size(), [&](size_t i)
+				{
+					return names[i];
+				});
+				const auto metadata = WriteMessage(MessageType::DictionaryBatch, [&](FlatBufferWriter& writer)
+				{
+					return writer.WriteTable({FlatBufferWriter::Scalar<int64_t>(0, id), FlatBufferWriter::Child(1, dictionary.WriteRecordBatch(names.size()))});
+				}, dictionary.GetData().size());
+				dictionaryBlocks.push_back(file.WriteMessage(metadata, dictionary.GetData()));
+			}
+			batchBlocks.push_back(file.WriteMessage(WriteMessage(MessageType::RecordBatch, body.WriteRecordBatch(count), body.GetData().size()), body.GetData()));
+
+			// End of stream, then the footer with the positions of every message
+			file.Write(g_Continuation);
+			file.Write(uint32_t(0));
+			const std::vector<std::byte> footer = FlatBufferWriter().Finish([&](FlatBufferWriter& writer)
+			{
+				return writer.WriteTable(
+				{
+					FlatBufferWriter::Scalar<int16_t>(0, g_MetadataVersion),
+					FlatBufferWriter::Child(1, WriteSchema),
+					FlatBufferWriter::Child(2, [&](FlatBufferWriter& writer)
+					{
+						return writer.WriteStructs(std::span<const Block>(dictionaryBlocks));
+					}),
+					FlatBufferWriter::Child(3, [&](FlatBufferWriter& writer)
+					{
+						return writer.WriteStructs(std::span<const Block>(batchBlocks));
+					}),
+				});
+			});
+			file.Write(footer.data(), footer.size());
+			file.Write(static_cast<int32_t>(footer.size()));
+			file.Write(FileMagic.data(), FileMagic.size());
+
+			if (!file.IsOk())
+			{
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, filePath, error);
+		return !error;
+	}
+}
+
+namespace
+{
+	// Buffers and nodes of a record batch, consumed in schema order
+	class BatchReader final
+	{
+		private:
+			std::span<const std::byte> m_Body;
+			std::vector<FieldNode> m_Nodes;
+			std::vector<BufferRef> m_Buffers;
+			size_t m_Node = 0;
+			size_t m_Buffer = 0;
+			int64_t m_Length = 0;
+
+		public:
+			// Message at the block, its header has to be of the given type
+			static std::optional<std::pair<FlatTable, BatchReader>> Open(std::span<const std::byte> file, const Block& block, uint8_t type)
+			{
+				if (block.Offset < 0 || block.MetadataLength < 8 || block.BodyLength < 0 || static_cast<uint64_t>(block.Offset) > file.size()
+					|| static_cast<uint64_t>(block.MetadataLength) + static_cast<uint64_t>(block.BodyLength) > file.size() - static_cast<uint64_t>(block.Offset))
+				{
+					return {};
+				}
+				const std::span<const std::byte> message = file.subspan(static_cast<size_t>(block.Offset), static_cast<size_t>(block.MetadataLength));
+				if (Load<uint32_t>(message, 0) != g_Continuation)
+				{
+					return {};
+				}
+
+				const FlatTable header = FlatTable::FromRoot(message.subspan(8));
+				if (header.GetScalar<uint8_t>(1, 0) != type || header.GetScalar<int64_t>(3, 0) != block.BodyLength)
+				{
+					return {};
+				}
+
+				// Dictionary batches wrap their record batch
+				const FlatTable headerTable = header.GetTable(2);
+				const FlatTable batch = type == MessageType::DictionaryBatch ? headerTable.GetTable(1) : headerTable;
+				auto nodes = batch.GetStructs<FieldNode>(1);
+				auto buffers = batch.GetStructs<BufferRef>(2);
+				if (!nodes || !buffers || batch.GetFieldOffset(3))
+				{
+					// Compressed bodies aren't read
+					return {};
+				}
+
+				BatchReader reader;
+				reader.m_Body = file.subspan(static_cast<size_t>(block.Offset + block.MetadataLength), static_cast<size_t>(block.BodyLength));
+				reader.m_Nodes = std::move(*nodes);
+				reader.m_Buffers = std::move(*buffers);
+				reader.m_Length = batch.GetScalar<int64_t>(0, 0);
+				return std::pair(headerTable, std::move(reader));
+			}
+
+		public:
+			int64_t GetLength() const noexcept
+			{
+				return m_Length;
+			}
+			bool IsComplete() const noexcept
+			{
+				return m_Node == m_Nodes.size() && m_Buffer == m_Buffers.size();
+			}
+
+			// Node without nulls of the expected length
+			bool ReadNode(int64_t length) noexcept
+			{
+				return m_Node < m_Nodes.size() && m_Nodes[m_Node].NullCount == 0 && m_Nodes[m_Node++].Length == length;
+			}
+			std::optional<std::span<const std::byte>> ReadBuffer() noexcept
+			{
+				if (m_Buffer >= m_Buffers.size())
+				{
+					return {};
+				}
+
+				const BufferRef buffer = m_Buffers[m_Buffer++];
+				if (buffer.Offset < 0 || buffer.Length < 0 || static_cast<uint64_t>(buffer.Offset) > m_Body.size() || static_cast<uint64_t>(buffer.Length) > m_Body.size() - static_cast<uint64_t>(buffer.Offset))
+				{
+					return {};
+				}
+				return m_Body.subspan(static_cast<size_t>(buffer.Offset), static_cast<size_t>(buffer.Length));
+			}
+
+			// Values are read in place, so they have to be aligned
+			template<class T>
+			std::optional<std::span<const T>> ReadColumn(int64_t length) noexcept
+			{
+				auto validity = ReadBuffer();
+				auto values = ReadBuffer();
+				if (!ReadNode(length) || !validity || !values || values->size() / sizeof(T) < static_cast<uint64_t>(length) || reinterpret_cast<uintptr_t>(values->data()) % alignof(T) != 0)
+				{
+					return {};
+				}
+				return std::span(reinterpret_cast<const T*>(values->data()), static_cast<size_t>(length));
+			}
+			std::optional<std::span<const int32_t>> ReadOffsets(int64_t length, size_t limit) noexcept
+			{
+				auto validity = ReadBuffer();
+				auto values = ReadBuffer();
+				if (!ReadNode(length) || !validity || !values || values->size() / sizeof(int32_t) < static_cast<uint64_t>(length) + 1 || reinterpret_cast<uintptr_t>(values->data()) % alignof(int32_t) != 0)
+				{
+					return {};
+				}
+
+				// Offsets have to be ascending and inside the data, then no view can point out of it
+				const std::span offsets(reinterpret_cast<const int32_t*>(values->data()), static_cast<size_t>(length) + 1);
+				int32_t previous = 0;
+				for (int32_t offset: offsets)
+				{
+					if (offset < previous)
+					{
+						return {};
+					}
+					previous = offset;
+				}
+				if (static_cast<uint64_t>(offsets.back()) > limit)
+				{
+					return {};
+				}
+				return offsets;
+			}
+			template<class TColumn>
+			bool ReadText(int64_t length, TColumn& column) noexcept
+			{
+				const size_t buffer = m_Buffer + 2;
+				if (buffer >= m_Buffers.size() || m_Buffers[buffer].Length < 0)
+				{
+					return false;
+				}
+
+				auto offsets = ReadOffsets(length, static_cast<size_t>(m_Buffers[buffer].Length));
+				auto data = ReadBuffer();
+				if (!offsets || !data)
+				{
+					return false;
+				}
+				column.Offsets = *offsets;
+				column.Data = reinterpret_cast<const char*>(data->data());
+				return true;
+			}
+	};
+
+	// Fields have to be named and typed the way the writer does it
+	bool IsField(const FlatTable& field, std::string_view name, uint8_t type, size_t childCount = 0)
+	{
+		const auto children = field.GetTables(5);
+		return field.GetString(0) == name && field.GetScalar<uint8_t>(2, 0) == type && field.GetTable(3).IsValid() && (children ? children->size() : 0) == childCount;
+	}
+	bool IsIntField(const FlatTable& field, std::string_view name, int32_t bitWidth, bool isSigned)
+	{
+		const FlatTable type = field.GetTable(3);
+		return IsField(field, name, ArrowType::Int, 0) && !field.GetFieldOffset(4) && type.GetScalar<int32_t>(0, 0) == bitWidth && type.GetScalar<uint8_t>(1, 0) == isSigned;
+	}
+	std::optional<int64_t> GetDictionaryID(const FlatTable& field, std::string_view name)
+	{
+		const FlatTable dictionary = field.GetTable(4);
+		const FlatTable indexType = dictionary.GetTable(1);
+		if (!IsField(field, name, ArrowType::Utf8) || !dictionary.IsValid() || indexType.GetScalar<int32_t>(0, 0) != 8 || indexType.GetScalar<uint8_t>(1, 0) != 1)
+		{
+			return {};
+		}
+		return dictionary.GetScalar<int64_t>(0, 0);
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	bool ModuleSnapshot::Load(std::span<const std::byte> data)
+	{
+		// Padded magic at the start, the footer, its size and the magic again at the end
+		constexpr size_t headerSize = 8;
+		if (data.size() < headerSize + sizeof(int32_t) + FileMagic.size() || std::memcmp(data.data(), FileMagic.data(), FileMagic.size()) != 0
+			|| std::memcmp(data.data() + data.size() - FileMagic.size(), FileMagic.data(), FileMagic.size()) != 0)
+		{
+			return false;
+		}
+		const size_t footerEnd = data.size() - FileMagic.size() - sizeof(int32_t);
+		const int32_t footerSize = ::Load<int32_t>(data, footerEnd).value_or(-1);
+		if (footerSize <= 0 || static_cast<size_t>(footerSize) > footerEnd - headerSize)
+		{
+			return false;
+		}
+
+		const FlatTable footer = FlatTable::FromRoot(data.subspan(footerEnd - static_cast<size_t>(footerSize), static_cast<size_t>(footerSize)));
+		const auto fields = footer.GetTable(1).GetTables(1);
+		const auto dictionaries = footer.GetStructs<Block>(2);
+		const auto batches = footer.GetStructs<Block>(3);
+		if (!fields || fields->size() != 11 || !dictionaries || !batches || batches->size() != 1)
+		{
+			return false;
+		}
+
+		const FlatTable& masters = (*fields)[10];
+		const auto masterItems = masters.GetTables(5);
+		const FlatTable signatureType = (*fields)[3].GetTable(3);
+		const FlatTable timeType = (*fields)[7].GetTable(3);
+		const auto statusID = GetDictionaryID((*fields)[1], "status");
+		const auto formatID = GetDictionaryID((*fields)[2], "format");
+		if (!IsField((*fields)[0], "path", ArrowType::Utf8) || !statusID || !formatID || *statusID == *formatID
+			|| !IsField((*fields)[3], "signature", ArrowType::FixedSizeBinary) || signatureType.GetScalar<int32_t>(0, 0) != 4
+			|| !IsIntField((*fields)[4], "flags", 32, false) || !IsIntField((*fields)[5], "form_version", 32, false) || !IsIntField((*fields)[6], "file_size", 64, false)
+			|| !IsField((*fields)[7], "modified", ArrowType::Timestamp) || timeType.GetScalar<int16_t>(0, 0) != g_Microsecond
+			|| !IsField((*fields)[8], "author", ArrowType::Utf8) || !IsField((*fields)[9], "description", ArrowType::Utf8)
+			|| !IsField(masters, "masters", ArrowType::List, 1) || !masterItems || !IsField((*masterItems)[0], (*masterItems)[0].GetString(0).value_or(""), ArrowType::Utf8))
+		{
+			return false;
+		}
+
+		// Dictionary values are mapped by name, so their order doesn't matter. Dictionaries may leave out values
+		// that aren't used, so their lengths are kept to check the indices against.
+		bool hasStatuses = false;
+		bool hasFormatLevels = false;
+		int64_t statusCount = 0;
+		int64_t formatCount = 0;
+		for (const Block& block: *dictionaries)
+		{
+			auto message = BatchReader::Open(data, block, MessageType::DictionaryBatch);
+			if (!message)
+			{
+				return false;
+			}
+			auto& [header, reader] = *message;
+
+			TextColumn names;
+			const int64_t id = header.GetScalar<int64_t>(0, 0);
+			if (reader.GetLength() < 0 || reader.GetLength() > 128 || !reader.ReadText(reader.GetLength(), names) || !reader.IsComplete() || header.GetScalar<uint8_t>(2, 0) != 0)
+			{
+				return false;
+			}
+
+			auto Map = [&](auto& table, const auto& values, auto getName)
+			{
+				for (size_t i = 0; i < static_cast<size_t>(reader.GetLength()); i++)
+				{
+					auto it = std::find_if(std::begin(values), std::end(values), [&](auto value)
+					{
+						return getName(value) == names.Get(i);
+					});
+					if (it == std::end(values))
+					{
+						return false;
+					}
+					table[i] = *it;
+				}
+				return true;
+			};
+			if (id == *statusID && Map(m_Statuses, g_Statuses, GetParseStatusName))
+			{
+				hasStatuses = true;
+				statusCount = reader.GetLength();
+			}
+			else if (id == *formatID && Map(m_FormatLevels, g_FormatLevels, GetFormatLevelName))
+			{
+				hasFormatLevels = true;
+				formatCount = reader.GetLength();
+			}
+			else
+			{
+				return false;
+			}
+		}
+		if (!hasStatuses || !hasFormatLevels)
+		{
+			return false;
+		}
+
+		auto message = BatchReader::Open(data, batches->front(), MessageType::RecordBatch);
+		if (!message)
+		{
+			return false;
+		}
+		BatchReader& reader = message->second;
+		const int64_t length = reader.GetLength();
+		if (length < 0 || static_cast<uint64_t>(length) > std::numeric_limits<size_t>::max() / 8)
+		{
+			return false;
+		}
+
+		if (!reader.ReadText(length, m_Paths))
+		{
+			return false;
+		}
+		auto statuses = reader.ReadColumn<int8_t>(length);
+		auto formatLevels = reader.ReadColumn<int8_t>(length);
+		auto signatures = reader.ReadColumn<uint32_t>(length);
+		auto flags = reader.ReadColumn<uint32_t>(length);
+		auto formVersions = reader.ReadColumn<uint32_t>(length);
+		auto fileSizes = reader.ReadColumn<uint64_t>(length);
+		auto times = reader.ReadColumn<int64_t>(length);
+		if (!statuses || !formatLevels || !signatures || !flags || !formVersions || !fileSizes || !times || !reader.ReadText(length, m_Authors) || !reader.ReadText(length, m_Descriptions))
+		{
+			return false;
+		}
+
+		// Master list offsets are checked against the item count once the item node is known
+		auto masterOffsets = reader.ReadOffsets(length, std::numeric_limits<int32_t>::max());
+		if (!masterOffsets || !reader.ReadText(masterOffsets->back(), m_Masters) || !reader.IsComplete())
+		{
+			return false;
+		}
+
+		// Dictionary indices have to be inside the dictionaries read above
+		for (size_t i = 0; i < static_cast<size_t>(length); i++)
+		{
+			if ((*statuses)[i] < 0 || (*statuses)[i] >= statusCount || (*formatLevels)[i] < 0 || (*formatLevels)[i] >= formatCount)
+			{
+				return false;
+			}
+		}
+
+		m_Count = static_cast<size_t>(length);
+		m_StatusIndices = *statuses;
+		m_FormatIndices = *formatLevels;
+		m_Signatures = *signatures;
+		m_Flags = *flags;
+		m_FormVersions = *formVersions;
+		m_FileSizes = *fileSizes;
+		m_LastWriteTimes = *times;
+		m_MasterOffsets = *masterOffsets;
+		return true;
+	}
+
+	bool ModuleSnapshot::Open(const std::filesystem::path& path)
+	{
+		Close();
+		if (!m_Source.Open(path) || !Load(m_Source.GetData()))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+	void ModuleSnapshot::Close() noexcept
+	{
+		m_Source.Close();
+		*this = {};
+	}
+
+	ScanResult ModuleSnapshot::GetResult(size_t row) const
+	{
+		ScanResult result;
+		const std::string_view path = GetPath(row);
+		result.Path = std::filesystem::path(std::u8string_view(reinterpret_cast<const char8_t*>(path.data()), path.size()));
+		result.FileSize = m_FileSizes[row];
+		result.Status = GetStatus(row);
+
+		ModuleInfo& info = result.Info;
+		info.Signature = m_Signatures[row];
+		info.Flags = static_cast<HeaderFlags>(m_Flags[row]);
+		info.FormVersion = m_FormVersions[row];
+		info.FormatLevel = GetFormatLevel(row);
+		info.Author = GetAuthor(row);
+		info.Description = GetDescription(row);
+
+		const size_t masterCount = GetMasterCount(row);
+		info.Masters.reserve(masterCount);
+		for (size_t i = 0; i < masterCount; i++)
+		{
+			info.Masters.emplace_back(GetMaster(row, i));
+		}
+		return result;
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include "ByteSource.h"
+#include "ModuleScanner.h"
+#include <array>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace BethesdaModule::Core
+{
+	// Scan results stored as an Apache Arrow IPC file (Feather V2), for analytics tools that read Arrow directly.
+	//
+	// A single record batch holds the columns 'path', 'status' and 'format' (int8 indices into dictionaries of their
+	// names), 'signature' (fixed size binary of 4 bytes), 'flags', 'form_version' (both uint32), 'file_size' (uint64),
+	// 'modified' (microsecond timestamp in UTC), 'author', 'description' (both UTF-8) and 'masters' (list of UTF-8).
+	// Every buffer starts at a multiple of 64 bytes, so the reader maps the file and points into it: opening only
+	// checks the metadata and the offsets of the text columns and copies nothing. Only files of this layout are read.
+	class ModuleSnapshot final
+	{
+		public:
+			static constexpr std::string_view FileMagic = "ARROW1";
+
+			// Microseconds since the Unix epoch, zero if the file can't be queried
+			static int64_t GetLastWriteTime(const std::filesystem::path& path) noexcept;
+
+			// One row per result. Times are one per result, taken from the files when they aren't given. The file is
+			// written next to the target and renamed over it, so a reader that has the old one mapped keeps it intact.
+			static bool Write(const std::filesystem::path& filePath, std::span<const ScanResult> results, std::span<const int64_t> lastWriteTimes = {});
+
+		private:
+			// Arrow string array: 'Offsets' has one more element than there are values
+			struct TextColumn final
+			{
+				std::span<const int32_t> Offsets;
+				const char* Data = nullptr;
+
+				std::string_view Get(size_t index) const noexcept
+				{
+					return {Data + Offsets[index], static_cast<size_t>(Offsets[index + 1] - Offsets[index])};
+				}
+			};
+
+		private:
+			MappedByteSource m_Source;
+			size_t m_Count = 0;
+
+			std::span<const uint32_t> m_Signatures;
+			std::span<const uint32_t> m_Flags;
+			std::span<const uint32_t> m_FormVersions;
+			std::span<const int8_t> m_StatusIndices;
+			std::span<const int8_t> m_FormatIndices;
+			std::span<const uint64_t> m_FileSizes;
+			std::span<const int64_t> m_LastWriteTimes;
+
+			TextColumn m_Paths;
+			TextColumn m_Authors;
+			TextColumn m_Descriptions;
+			std::span<const int32_t> m_MasterOffsets;
+			TextColumn m_Masters;
+
+			// Dictionary index to value
+			std::array<ParseStatus, 128> m_Statuses = {};
+			std::array<Core::FormatLevel, 128> m_FormatLevels = {};
+
+		private:
+			bool Load(std::span<const std::byte> data);
+
+		public:
+			ModuleSnapshot() noexcept = default;
+			ModuleSnapshot(const ModuleSnapshot&) = delete;
+			ModuleSnapshot(ModuleSnapshot&&) noexcept = default;
+
+		public:
+			// Fails for anything that isn't a complete snapshot of this layout
+			bool Open(const std::filesystem::path& path);
+			void Close() noexcept;
+			bool IsOpen() const noexcept
+			{
+				return m_Source.IsOpen();
+			}
+
+			size_t GetCount() const noexcept
+			{
+				return m_Count;
+			}
+			size_t GetMappedSize() const noexcept
+			{
+				return m_Source.GetData().size();
+			}
+
+			// Columns point into the mapping and stay valid while the snapshot is open
+			std::span<const uint32_t> GetSignatures() const noexcept
+			{
+				return m_Signatures;
+			}
+			std::span<const uint32_t> GetFlags() const noexcept
+			{
+				return m_Flags;
+			}
+			std::span<const uint32_t> GetFormVersions() const noexcept
+			{
+				return m_FormVersions;
+			}
+			std::span<const uint64_t> GetFileSizes() const noexcept
+			{
+				return m_FileSizes;
+			}
+			std::span<const int64_t> GetLastWriteTimes() const noexcept
+			{
+				return m_LastWriteTimes;
+			}
+
+			// Single row
+			std::string_view GetPath(size_t row) const noexcept
+			{
+				return m_Paths.Get(row);
+			}
+			std::string_view GetAuthor(size_t row) const noexcept
+			{
+				return m_Authors.Get(row);
+			}
+			std::string_view GetDescription(size_t row) const noexcept
+			{
+				return m_Descriptions.Get(row);
+			}
+			ParseStatus GetStatus(size_t row) const noexcept
+			{
+				return m_Statuses[static_cast<size_t>(m_StatusIndices[row])];
+			}
+			Core::FormatLevel GetFormatLevel(size_t row) const noexcept
+			{
+				return m_FormatLevels[static_cast<size_t>(m_FormatIndices[row])];
+			}
+			size_t GetMasterCount(size_t row) const noexcept
+			{
+				return static_cast<size_t>(m_MasterOffsets[row + 1] - m_MasterOffsets[row]);
+			}
+			std::string_view GetMaster(size_t row, size_t index) const noexcept
+			{
+				return m_Masters.Get(static_cast<size_t>(m_MasterOffsets[row]) + index);
+			}
+			ScanResult GetResult(size_t row) const;
+
+		public:
+			ModuleSnapshot& operator=(const ModuleSnapshot&) = delete;
+			ModuleSnapshot& operator=(ModuleSnapshot&&) noexcept = default;
+	};
+}
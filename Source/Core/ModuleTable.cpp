@@ -0,0 +1,432 @@
+#include "stdafx.h"
+#include "ModuleTable.h"
+#include "StringPool.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	std::string_view GetFileName(std::string_view path) noexcept
+	{
+		const size_t separator = path.find_last_of("/\\");
+		return separator != std::string_view::npos ? path.substr(separator + 1) : path;
+	}
+	std::string ToUTF8(const std::filesystem::path& path)
+	{
+		const std::u8string value = path.u8string();
+		return {reinterpret_cast<const char*>(value.data()), value.size()};
+	}
+
+	// Stable LSD radix sort of rows by their keys, a byte per pass. Passes where every key has the same byte are skipped,
+	// so small values and the unused high bytes of file sizes cost nothing.
+	template<class TKey>
+	void RadixSort(std::vector<ModuleTable::TRow>& rows, std::vector<TKey>& keys)
+	{
+		std::vector<ModuleTable::TRow> rowBuffer(rows.size());
+		std::vector<TKey> keyBuffer(keys.size());
+		for (size_t shift = 0; shift < sizeof(TKey) * 8; shift += 8)
+		{
+			size_t offsets[256] = {};
+			for (TKey key: keys)
+			{
+				offsets[(key >> shift) & 0xFF]++;
+			}
+			if (std::find(std::begin(offsets), std::end(offsets), keys.size()) != std::end(offsets))
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for (size_t& value: offsets)
+			{
+				offset += std::exchange(value, offset);
+			}
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				const size_t index = offsets[(keys[i] >> shift) & 0xFF]++;
+				rowBuffer[index] = rows[i];
+				keyBuffer[index] = keys[i];
+			}
+			rows.swap(rowBuffer);
+			keys.swap(keyBuffer);
+		}
+	}
+
+	template<class TGetKey>
+	void SortRows(std::vector<ModuleTable::TRow>& rows, bool descending, TGetKey&& getKey)
+	{
+		using TKey = std::conditional_t<sizeof(decltype(getKey(ModuleTable::TRow()))) <= sizeof(uint32_t), uint32_t, uint64_t>;
+
+		std::vector<TKey> keys(rows.size());
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			const TKey key = static_cast<TKey>(getKey(rows[i]));
+			keys[i] = descending ? ~key : key;
+		}
+		RadixSort(rows, keys);
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	ModuleTable ModuleTable::Build(std::span<const ScanResult> results)
+	{
+		// Sizes first, so columns don't grow while they're filled. Master names are mostly shared and aren't counted.
+		size_t textSize = 0;
+		size_t masterCount = 0;
+		for (const ScanResult& result: results)
+		{
+			textSize += result.Path.native().size() + result.Info.Author.size() + result.Info.Description.size();
+			masterCount += result.Info.Masters.size();
+		}
+
+		ModuleTable table;
+		table.Reserve(results.size(), textSize, masterCount);
+		for (const ScanResult& result: results)
+		{
+			if (!table.Append(result))
+			{
+				break;
+			}
+		}
+		return table;
+	}
+
+	auto ModuleTable::AddText(std::string_view value) -> TextRef
+	{
+		const TextRef ref = {static_cast<uint32_t>(m_Text.size()), static_cast<uint32_t>(value.size())};
+		m_Text.append(value);
+		return ref;
+	}
+	auto ModuleTable::InternName(std::string_view name) -> TNameID
+	{
+		const uint32_t hash = StringPool::Hash(name);
+		if (!m_NameSlots.empty())
+		{
+			if (const uint32_t value = m_NameSlots[FindNameSlot(name, hash)]; value != 0)
+			{
+				return value - 1;
+			}
+		}
+
+		// Table is kept at most half full
+		if ((m_Names.size() + 1) * 2 > m_NameSlots.size())
+		{
+			const size_t capacity = std::max<size_t>(m_NameSlots.size() * 2, 64);
+			m_NameSlots.assign(capacity, 0);
+			for (size_t i = 0; i < m_Names.size(); i++)
+			{
+				size_t slot = m_NameHashes[i] & (capacity - 1);
+				while (m_NameSlots[slot] != 0)
+				{
+					slot = (slot + 1) & (capacity - 1);
+				}
+				m_NameSlots[slot] = static_cast<uint32_t>(i + 1);
+			}
+		}
+
+		const TNameID id = static_cast<TNameID>(m_Names.size());
+		m_Names.push_back(AddText(name));
+		m_NameHashes.push_back(hash);
+		m_NameSlots[FindNameSlot(name, hash)] = id + 1;
+		return id;
+	}
+	size_t ModuleTable::FindNameSlot(std::string_view name, uint32_t hash) const noexcept
+	{
+		const size_t mask = m_NameSlots.size() - 1;
+		size_t slot = hash & mask;
+		for (uint32_t value = m_NameSlots[slot]; value != 0; value = m_NameSlots[slot])
+		{
+			if (m_NameHashes[value - 1] == hash && StringPool::Equals(GetName(value - 1), name))
+			{
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	auto ModuleTable::Append(const ScanResult& result) -> std::optional<TRow>
+	{
+		const std::string path = ToUTF8(result.Path);
+		const ModuleInfo& info = result.Info;
+
+		// Upper bound, masters that are already known don't take any space
+		size_t textSize = path.size() + info.Author.size() + info.Description.size();
+		for (const std::string& master: info.Masters)
+		{
+			textSize += master.size();
+		}
+		if (textSize > std::numeric_limits<uint32_t>::max() - m_Text.size() || m_Signatures.size() >= std::numeric_limits<TRow>::max())
+		{
+			return {};
+		}
+
+		const TRow row = static_cast<TRow>(m_Signatures.size());
+		m_Signatures.push_back(info.Signature);
+		m_Flags.push_back(info.Flags);
+		m_FormVersions.push_back(info.FormVersion);
+		m_FormatLevels.push_back(info.FormatLevel);
+		m_Statuses.push_back(result.Status);
+		m_FileSizes.push_back(result.FileSize);
+
+		m_Paths.push_back(AddText(path));
+		m_Authors.push_back(AddText(info.Author));
+		m_Descriptions.push_back(AddText(info.Description));
+		m_NameIDs.push_back(InternName(::GetFileName(path)));
+
+		for (const std::string& master: info.Masters)
+		{
+			m_Masters.push_back(InternName(master));
+		}
+		m_MasterOffsets.push_back(static_cast<uint32_t>(m_Masters.size()));
+		return row;
+	}
+	void ModuleTable::Reserve(size_t rows, size_t textSize, size_t masterCount)
+	{
+		rows += GetCount();
+		m_Signatures.reserve(rows);
+		m_Flags.reserve(rows);
+		m_FormVersions.reserve(rows);
+		m_FormatLevels.reserve(rows);
+		m_Statuses.reserve(rows);
+		m_FileSizes.reserve(rows);
+		m_Paths.reserve(rows);
+		m_Authors.reserve(rows);
+		m_Descriptions.reserve(rows);
+		m_NameIDs.reserve(rows);
+		m_MasterOffsets.reserve(rows + 1);
+
+		m_Text.reserve(m_Text.size() + textSize);
+		m_Masters.reserve(m_Masters.size() + masterCount);
+	}
+	void ModuleTable::Clear() noexcept
+	{
+		m_Signatures.clear();
+		m_Flags.clear();
+		m_FormVersions.clear();
+		m_FormatLevels.clear();
+		m_Statuses.clear();
+		m_FileSizes.clear();
+
+		m_Text.clear();
+		m_Paths.clear();
+		m_Authors.clear();
+		m_Descriptions.clear();
+
+		// Shrinking back to the leading zero keeps the capacity and doesn't allocate
+		m_NameIDs.clear();
+		m_MasterOffsets.resize(1);
+		m_Masters.clear();
+
+		m_Names.clear();
+		m_NameHashes.clear();
+		m_NameSlots.clear();
+	}
+	size_t ModuleTable::GetMemoryUsage() const noexcept
+	{
+		auto GetSize = [](const auto& items)
+		{
+			return items.capacity() * sizeof(items[0]);
+		};
+		return GetSize(m_Signatures) + GetSize(m_Flags) + GetSize(m_FormVersions) + GetSize(m_FormatLevels) + GetSize(m_Statuses) + GetSize(m_FileSizes)
+			+ m_Text.capacity() + GetSize(m_Paths) + GetSize(m_Authors) + GetSize(m_Descriptions)
+			+ GetSize(m_NameIDs) + GetSize(m_MasterOffsets) + GetSize(m_Masters)
+			+ GetSize(m_Names) + GetSize(m_NameHashes) + GetSize(m_NameSlots);
+	}
+
+	std::string_view ModuleTable::GetPath(TRow row) const noexcept
+	{
+		return std::string_view(m_Text).substr(m_Paths[row].Offset, m_Paths[row].Size);
+	}
+	std::string_view ModuleTable::GetAuthor(TRow row) const noexcept
+	{
+		return std::string_view(m_Text).substr(m_Authors[row].Offset, m_Authors[row].Size);
+	}
+	std::string_view ModuleTable::GetDescription(TRow row) const noexcept
+	{
+		return std::string_view(m_Text).substr(m_Descriptions[row].Offset, m_Descriptions[row].Size);
+	}
+	ScanResult ModuleTable::GetResult(TRow row) const
+	{
+		const std::string_view path = GetPath(row);
+
+		ScanResult result;
+		result.Path = std::u8string_view(reinterpret_cast<const char8_t*>(path.data()), path.size());
+		result.FileSize = m_FileSizes[row];
+		result.Status = m_Statuses[row];
+		result.Info.Signature = m_Signatures[row];
+		result.Info.Flags = m_Flags[row];
+		result.Info.FormVersion = m_FormVersions[row];
+		result.Info.FormatLevel = m_FormatLevels[row];
+		result.Info.Author = GetAuthor(row);
+		result.Info.Description = GetDescription(row);
+		for (TNameID master: GetMasters(row))
+		{
+			result.Info.Masters.emplace_back(GetName(master));
+		}
+		return result;
+	}
+
+	std::string_view ModuleTable::GetName(TNameID id) const noexcept
+	{
+		return std::string_view(m_Text).substr(m_Names[id].Offset, m_Names[id].Size);
+	}
+	auto ModuleTable::FindName(std::string_view name) const noexcept -> std::optional<TNameID>
+	{
+		if (!m_NameSlots.empty())
+		{
+			if (const uint32_t value = m_NameSlots[FindNameSlot(name, StringPool::Hash(name))]; value != 0)
+			{
+				return value - 1;
+			}
+		}
+		return {};
+	}
+
+	auto ModuleTable::Select(const ModuleFilter& filter) const -> std::vector<TRow>
+	{
+		const uint32_t required = static_cast<uint32_t>(filter.RequiredFlags);
+		const uint32_t excluded = static_cast<uint32_t>(filter.ExcludedFlags);
+		const uint32_t minFormVersion = filter.MinFormVersion;
+		const uint32_t maxFormVersion = filter.MaxFormVersion;
+		const bool anyFormatLevel = !filter.FormatLevel;
+		const Core::FormatLevel formatLevel = filter.FormatLevel.value_or(Core::FormatLevel::Unknown);
+		const bool anySignature = !filter.Signature;
+		const uint32_t signature = filter.Signature.value_or(0);
+
+		// Columns are read through local pointers, writing the output can't alias them then
+		const HeaderFlags* const flagsColumn = m_Flags.data();
+		const uint32_t* const formVersions = m_FormVersions.data();
+		const Core::FormatLevel* const formatLevels = m_FormatLevels.data();
+		const uint32_t* const signatures = m_Signatures.data();
+		auto IsMatch = [&](size_t row) -> bool
+		{
+			const uint32_t flags = static_cast<uint32_t>(flagsColumn[row]);
+			const uint32_t formVersion = formVersions[row];
+
+			return ((flags & required) == required) & ((flags & excluded) == 0)
+				& (formVersion >= minFormVersion) & (formVersion <= maxFormVersion)
+				& (anyFormatLevel | (formatLevels[row] == formatLevel)) & (anySignature | (signatures[row] == signature));
+		};
+
+		std::vector<TRow> rows;
+		if (filter.Master)
+		{
+			// Rows requiring the master are found by going through the whole adjacency array once, then the
+			// other conditions are checked just for them
+			size_t row = 0;
+			for (size_t i = 0; i < m_Masters.size(); i++)
+			{
+				if (m_Masters[i] == *filter.Master)
+				{
+					while (m_MasterOffsets[row + 1] <= i)
+					{
+						row++;
+					}
+					if (rows.empty() || rows.back() != row)
+					{
+						rows.push_back(static_cast<TRow>(row));
+					}
+				}
+			}
+			std::erase_if(rows, [&](TRow row)
+			{
+				return !IsMatch(row);
+			});
+			return rows;
+		}
+
+		// Conditions are evaluated for a block of rows without branches, which the compiler turns into SIMD compares,
+		// then matching rows are collected skipping eight non-matching ones at a time
+		const size_t rowCount = GetCount();
+		for (size_t blockStart = 0; blockStart < rowCount; blockStart += 1024)
+		{
+			const size_t blockSize = std::min<size_t>(1024, rowCount - blockStart);
+			alignas(8) uint8_t matches[1024] = {};
+			for (size_t i = 0; i < blockSize; i++)
+			{
+				matches[i] = IsMatch(blockStart + i);
+			}
+
+			for (size_t i = 0; i < blockSize; i += 8)
+			{
+				uint64_t word = 0;
+				std::memcpy(&word, matches + i, sizeof(word));
+				for (; word != 0; word &= word - 1)
+				{
+					rows.push_back(static_cast<TRow>(blockStart + i + std::countr_zero(word) / 8));
+				}
+			}
+		}
+		return rows;
+	}
+
+	auto ModuleTable::Sort(ModuleColumn column, bool descending) const -> std::vector<TRow>
+	{
+		std::vector<TRow> rows(GetCount());
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			rows[i] = static_cast<TRow>(i);
+		}
+		Sort(rows, column, descending);
+		return rows;
+	}
+	void ModuleTable::Sort(std::vector<TRow>& rows, ModuleColumn column, bool descending) const
+	{
+		switch (column)
+		{
+			case ModuleColumn::Signature:
+			{
+				SortRows(rows, descending, [&](TRow row)
+				{
+					return m_Signatures[row];
+				});
+				break;
+			}
+			case ModuleColumn::Flags:
+			{
+				SortRows(rows, descending, [&](TRow row)
+				{
+					return static_cast<uint32_t>(m_Flags[row]);
+				});
+				break;
+			}
+			case ModuleColumn::FormVersion:
+			{
+				SortRows(rows, descending, [&](TRow row)
+				{
+					return m_FormVersions[row];
+				});
+				break;
+			}
+			case ModuleColumn::FormatLevel:
+			{
+				SortRows(rows, descending, [&](TRow row)
+				{
+					return static_cast<uint32_t>(m_FormatLevels[row]);
+				});
+				break;
+			}
+			case ModuleColumn::FileSize:
+			{
+				SortRows(rows, descending, [&](TRow row)
+				{
+					return m_FileSizes[row];
+				});
+				break;
+			}
+			case ModuleColumn::MasterCount:
+			{
+				SortRows(rows, descending, [&](TRow row)
+				{
+					return m_MasterOffsets[row + 1] - m_MasterOffsets[row];
+				});
+				break;
+			}
+		};
+	}
+}
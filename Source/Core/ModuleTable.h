@@ -0,0 +1,175 @@
+#pragma once
+#include "ModuleScanner.h"
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// Numeric columns rows can be sorted by
+	enum class ModuleColumn
+	{
+		Signature,
+		Flags,
+		FormVersion,
+		FormatLevel,
+		FileSize,
+		MasterCount,
+	};
+
+	// Rows matching all of the set conditions
+	struct ModuleFilter final
+	{
+		HeaderFlags RequiredFlags = HeaderFlags::None;
+		HeaderFlags ExcludedFlags = HeaderFlags::None;
+		std::optional<Core::FormatLevel> FormatLevel;
+		std::optional<uint32_t> Signature;
+
+		// Inclusive range
+		uint32_t MinFormVersion = 0;
+		uint32_t MaxFormVersion = std::numeric_limits<uint32_t>::max();
+
+		// Name ID of a master every row has to require, see 'ModuleTable::FindName'
+		std::optional<uint32_t> Master;
+	};
+
+	// Parsed headers of a whole library stored column by column.
+	//
+	// Each header field is a dense array indexed by row, so filters and sorts only read the columns they need and
+	// never touch text. Paths, authors and descriptions are stored one after another in a single blob and referenced
+	// by offset and size. File names of the modules and their masters are interned, ignoring ASCII case, into one
+	// dictionary of name IDs. Master lists are a compressed sparse row adjacency: the masters of row 'i' are
+	// name IDs from 'MasterOffsets[i]' up to 'MasterOffsets[i + 1]'. A row's master can be joined with the row
+	// defining it through the name IDs. Rows are only ever appended.
+	class ModuleTable final
+	{
+		public:
+			using TRow = uint32_t;
+			using TNameID = uint32_t;
+
+			struct TextRef final
+			{
+				uint32_t Offset = 0;
+				uint32_t Size = 0;
+			};
+
+		private:
+			// Header fields
+			std::vector<uint32_t> m_Signatures;
+			std::vector<HeaderFlags> m_Flags;
+			std::vector<uint32_t> m_FormVersions;
+			std::vector<Core::FormatLevel> m_FormatLevels;
+			std::vector<ParseStatus> m_Statuses;
+			std::vector<uint64_t> m_FileSizes;
+
+			// Text in the blob
+			std::string m_Text;
+			std::vector<TextRef> m_Paths;
+			std::vector<TextRef> m_Authors;
+			std::vector<TextRef> m_Descriptions;
+
+			// Names and master lists
+			std::vector<TNameID> m_NameIDs;
+			std::vector<uint32_t> m_MasterOffsets = {0};
+			std::vector<TNameID> m_Masters;
+
+			// Name dictionary: text and hash of every name and an open addressing table of 'ID + 1'
+			std::vector<TextRef> m_Names;
+			std::vector<uint32_t> m_NameHashes;
+			std::vector<uint32_t> m_NameSlots;
+
+		private:
+			TextRef AddText(std::string_view value);
+			TNameID InternName(std::string_view name);
+			size_t FindNameSlot(std::string_view name, uint32_t hash) const noexcept;
+
+		public:
+			// Built in one go with every column allocated once
+			static ModuleTable Build(std::span<const ScanResult> results);
+
+		public:
+			ModuleTable() = default;
+
+		public:
+			// Returns the new row. Text past 4 GiB in total doesn't fit, nothing is added then.
+			std::optional<TRow> Append(const ScanResult& result);
+			void Reserve(size_t rows, size_t textSize = 0, size_t masterCount = 0);
+			void Clear() noexcept;
+
+			size_t GetCount() const noexcept
+			{
+				return m_Signatures.size();
+			}
+			size_t GetMemoryUsage() const noexcept;
+
+			// Columns
+			std::span<const uint32_t> GetSignatures() const noexcept
+			{
+				return m_Signatures;
+			}
+			std::span<const HeaderFlags> GetFlags() const noexcept
+			{
+				return m_Flags;
+			}
+			std::span<const uint32_t> GetFormVersions() const noexcept
+			{
+				return m_FormVersions;
+			}
+			std::span<const Core::FormatLevel> GetFormatLevels() const noexcept
+			{
+				return m_FormatLevels;
+			}
+			std::span<const ParseStatus> GetStatuses() const noexcept
+			{
+				return m_Statuses;
+			}
+			std::span<const uint64_t> GetFileSizes() const noexcept
+			{
+				return m_FileSizes;
+			}
+			std::span<const TNameID> GetNameIDs() const noexcept
+			{
+				return m_NameIDs;
+			}
+			std::span<const uint32_t> GetMasterOffsets() const noexcept
+			{
+				return m_MasterOffsets;
+			}
+			std::span<const TNameID> GetMasterIDs() const noexcept
+			{
+				return m_Masters;
+			}
+
+			// Single row
+			std::string_view GetPath(TRow row) const noexcept;
+			std::string_view GetAuthor(TRow row) const noexcept;
+			std::string_view GetDescription(TRow row) const noexcept;
+			std::string_view GetFileName(TRow row) const noexcept
+			{
+				return GetName(m_NameIDs[row]);
+			}
+			std::span<const TNameID> GetMasters(TRow row) const noexcept
+			{
+				return std::span(m_Masters).subspan(m_MasterOffsets[row], m_MasterOffsets[row + 1] - m_MasterOffsets[row]);
+			}
+			ScanResult GetResult(TRow row) const;
+
+			// Names
+			size_t GetNameCount() const noexcept
+			{
+				return m_Names.size();
+			}
+			std::string_view GetName(TNameID id) const noexcept;
+			std::optional<TNameID> FindName(std::string_view name) const noexcept;
+
+			// Rows in ascending order
+			std::vector<TRow> Select(const ModuleFilter& filter) const;
+
+			// Sorts all rows or the given ones by a column, equal values keep the order of rows
+			std::vector<TRow> Sort(ModuleColumn column, bool descending = false) const;
+			void Sort(std::vector<TRow>& rows, ModuleColumn column, bool descending = false) const;
+	};
+}
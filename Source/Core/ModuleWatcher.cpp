@@ -0,0 +1,512 @@
+#include "stdafx.h"
+#include "ModuleWatcher.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	#if defined(__linux__)
+	// Files are picked up once they're closed after writing, created (hard links don't produce anything else),
+	// moved or deleted. Directory creation and removal is needed to follow subfolders.
+	constexpr uint32_t WatchMask = IN_CLOSE_WRITE|IN_CREATE|IN_MOVED_FROM|IN_MOVED_TO|IN_DELETE|IN_ONLYDIR;
+	#endif
+
+	bool IsWithin(const ModuleWatcher::TKey& path, const ModuleWatcher::TKey& directory) noexcept
+	{
+		return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 && std::filesystem::path::preferred_separator == path[directory.size()];
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::string_view GetModuleChangeName(ModuleChange change) noexcept
+	{
+		switch (change)
+		{
+			case ModuleChange::Added:
+			{
+				return "added";
+			}
+			case ModuleChange::Modified:
+			{
+				return "modified";
+			}
+			case ModuleChange::Renamed:
+			{
+				return "renamed";
+			}
+			case ModuleChange::Removed:
+			{
+				return "removed";
+			}
+		};
+		return "unknown";
+	}
+
+	#if defined(__linux__)
+	bool ModuleWatcher::IsSupported() noexcept
+	{
+		return true;
+	}
+
+	void ModuleWatcher::AddWatches(const std::filesystem::path& directory, TPending* pending)
+	{
+		auto AddWatch = [&](const std::filesystem::path& path)
+		{
+			const int watch = ::inotify_add_watch(m_Handle, path.c_str(), WatchMask);
+			if (watch >= 0)
+			{
+				m_Watches.insert_or_assign(watch, path);
+			}
+		};
+		auto TestEntry = [&](const std::filesystem::directory_entry& entry)
+		{
+			std::error_code error;
+			if (entry.is_directory(error))
+			{
+				AddWatch(entry.path());
+			}
+			else if (pending && entry.is_regular_file(error) && IsModuleFile(entry.path()))
+			{
+				pending->insert_or_assign(entry.path().native(), PendingChange());
+			}
+		};
+
+		// Watches go first, so files created while the folder is being listed are either listed or reported
+		AddWatch(directory);
+
+		std::error_code error;
+		constexpr auto options = std::filesystem::directory_options::skip_permission_denied;
+		if (m_Options.Recursive)
+		{
+			for (auto it = std::filesystem::recursive_directory_iterator(directory, options, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+			{
+				TestEntry(*it);
+			}
+		}
+		else if (pending)
+		{
+			for (auto it = std::filesystem::directory_iterator(directory, options, error); !error && it != std::filesystem::directory_iterator(); it.increment(error))
+			{
+				TestEntry(*it);
+			}
+		}
+	}
+	void ModuleWatcher::RemoveWatches(const std::filesystem::path& directory)
+	{
+		for (auto it = m_Watches.begin(); it != m_Watches.end();)
+		{
+			if (it->second == directory || IsWithin(it->second.native(), directory.native()))
+			{
+				::inotify_rm_watch(m_Handle, it->first);
+				it = m_Watches.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	bool ModuleWatcher::Wait(std::optional<std::chrono::milliseconds> timeout)
+	{
+		pollfd handles[2] = {};
+		handles[0].fd = m_Handle;
+		handles[0].events = POLLIN;
+		handles[1].fd = m_StopEvent;
+		handles[1].events = POLLIN;
+
+		const int timeoutValue = timeout ? static_cast<int>(std::max<int64_t>(timeout->count(), 0)) : -1;
+		if (::poll(handles, std::size(handles), timeoutValue) <= 0)
+		{
+			return false;
+		}
+
+		std::lock_guard lock(m_StatsMutex);
+		m_Stats.Wakeups++;
+
+		// The stop event is never reset, every wait after 'Stop' returns immediately
+		return !(handles[1].revents & POLLIN) && (handles[0].revents & POLLIN);
+	}
+	void ModuleWatcher::ReadEvents(TPending& pending)
+	{
+		alignas(inotify_event) char buffer[64 * 1024];
+		for (;;)
+		{
+			const ssize_t size = ::read(m_Handle, buffer, sizeof(buffer));
+			if (size <= 0)
+			{
+				break;
+			}
+
+			size_t events = 0;
+			size_t overflows = 0;
+			for (const char* item = buffer; item < buffer + size;)
+			{
+				const inotify_event& event = *reinterpret_cast<const inotify_event*>(item);
+				item += sizeof(inotify_event) + event.len;
+				events++;
+
+				if (event.mask & IN_Q_OVERFLOW)
+				{
+					overflows++;
+					QueueRescan(pending);
+					continue;
+				}
+				if (event.mask & IN_IGNORED)
+				{
+					m_Watches.erase(event.wd);
+					continue;
+				}
+
+				auto it = m_Watches.find(event.wd);
+				if (it == m_Watches.end() || event.len == 0)
+				{
+					continue;
+				}
+				std::filesystem::path path = it->second / event.name;
+
+				if (event.mask & IN_ISDIR)
+				{
+					if (m_Options.Recursive && event.mask & (IN_CREATE|IN_MOVED_TO))
+					{
+						AddWatches(path, &pending);
+					}
+					else if (m_Options.Recursive && event.mask & (IN_DELETE|IN_MOVED_FROM))
+					{
+						// Everything that was inside is gone, modules moved along with the folder come back as new ones
+						RemoveWatches(path);
+
+						std::shared_lock lock(m_IndexMutex);
+						for (const auto& [key, result]: m_Index)
+						{
+							if (IsWithin(key, path.native()))
+							{
+								pending.insert_or_assign(key, PendingChange());
+							}
+						}
+					}
+					continue;
+				}
+				if (!IsModuleFile(path))
+				{
+					continue;
+				}
+
+				PendingChange change;
+				if (event.mask & IN_MOVED_FROM)
+				{
+					m_MovedFrom.insert_or_assign(event.cookie, path);
+				}
+				else if (event.mask & IN_MOVED_TO)
+				{
+					if (auto from = m_MovedFrom.find(event.cookie); from != m_MovedFrom.end())
+					{
+						change.MovedFrom = std::move(from->second);
+						m_MovedFrom.erase(from);
+					}
+				}
+
+				// A write after the rename replaces it with a full parse
+				pending.insert_or_assign(path.native(), std::move(change));
+			}
+
+			std::lock_guard lock(m_StatsMutex);
+			m_Stats.Events += events;
+			m_Stats.Overflows += overflows;
+		}
+	}
+
+	bool ModuleWatcher::Open(const std::filesystem::path& directory, const ModuleWatcherOptions& options)
+	{
+		Close();
+
+		m_Directory = directory;
+		m_Options = options;
+		m_Handle = ::inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+		m_StopEvent = ::eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+		if (m_Handle < 0 || m_StopEvent < 0)
+		{
+			Close();
+			return false;
+		}
+
+		AddWatches(directory, nullptr);
+		if (m_Watches.empty())
+		{
+			Close();
+			return false;
+		}
+
+		// Initial index, anything written since the watches were added is reported and parsed again later
+		ModuleScanner scanner(options.ThreadCount, options.Recursive);
+		scanner.SetSourceType(options.SourceType);
+		const ScanStats stats = scanner.Scan(directory, [&](const ScanResult& result)
+		{
+			m_Index.insert_or_assign(result.Path.native(), std::make_shared<const ScanResult>(result));
+		});
+		m_Stats.BytesRead = stats.BytesRead;
+		m_Stats.Directories = m_Watches.size();
+		return true;
+	}
+	void ModuleWatcher::Close() noexcept
+	{
+		if (m_Handle >= 0)
+		{
+			::close(m_Handle);
+			m_Handle = -1;
+		}
+		if (m_StopEvent >= 0)
+		{
+			::close(m_StopEvent);
+			m_StopEvent = -1;
+		}
+		m_Stopped = false;
+		m_Watches.clear();
+		m_MovedFrom.clear();
+		{
+			std::unique_lock lock(m_IndexMutex);
+			m_Index.clear();
+		}
+
+		std::lock_guard lock(m_StatsMutex);
+		m_Stats = {};
+	}
+
+	void ModuleWatcher::Stop() noexcept
+	{
+		m_Stopped = true;
+		if (m_StopEvent >= 0)
+		{
+			const uint64_t value = 1;
+			[[maybe_unused]] const ssize_t written = ::write(m_StopEvent, &value, sizeof(value));
+		}
+	}
+	#else
+	bool ModuleWatcher::IsSupported() noexcept
+	{
+		return false;
+	}
+
+	void ModuleWatcher::AddWatches(const std::filesystem::path& directory, TPending* pending)
+	{
+	}
+	void ModuleWatcher::RemoveWatches(const std::filesystem::path& directory)
+	{
+	}
+
+	bool ModuleWatcher::Wait(std::optional<std::chrono::milliseconds> timeout)
+	{
+		return false;
+	}
+	void ModuleWatcher::ReadEvents(TPending& pending)
+	{
+	}
+
+	bool ModuleWatcher::Open(const std::filesystem::path& directory, const ModuleWatcherOptions& options)
+	{
+		return false;
+	}
+	void ModuleWatcher::Close() noexcept
+	{
+	}
+
+	void ModuleWatcher::Stop() noexcept
+	{
+		m_Stopped = true;
+	}
+	#endif
+
+	void ModuleWatcher::QueueRescan(TPending& pending)
+	{
+		// Missed events can be anything, including new folders. Known modules are checked again and
+		// the folder is listed to find new ones.
+		{
+			std::shared_lock lock(m_IndexMutex);
+			for (const auto& [key, result]: m_Index)
+			{
+				pending.insert_or_assign(key, PendingChange());
+			}
+		}
+		AddWatches(m_Directory, &pending);
+		m_MovedFrom.clear();
+	}
+	size_t ModuleWatcher::Apply(TPending& pending, std::chrono::steady_clock::time_point firstEvent, const TCallback& callback)
+	{
+		std::vector<ModuleUpdate> updates;
+		std::vector<std::filesystem::path> parse;
+		{
+			std::shared_lock lock(m_IndexMutex);
+
+			// Renames first: the entry is reused if the file is still where it was moved to and the source was indexed
+			for (auto& [key, change]: pending)
+			{
+				std::error_code error;
+				if (!change.MovedFrom.empty() && std::filesystem::is_regular_file(key, error))
+				{
+					if (auto it = m_Index.find(change.MovedFrom.native()); it != m_Index.end())
+					{
+						auto result = std::make_shared<ScanResult>(*it->second);
+						result->Path = key;
+						updates.push_back({ModuleChange::Renamed, std::move(result), change.MovedFrom});
+						continue;
+					}
+				}
+				change.MovedFrom.clear();
+			}
+
+			for (const auto& [key, change]: pending)
+			{
+				std::error_code error;
+				if (std::filesystem::is_regular_file(key, error))
+				{
+					if (change.MovedFrom.empty())
+					{
+						parse.emplace_back(key);
+					}
+				}
+				else if (auto it = m_Index.find(key); it != m_Index.end())
+				{
+					const bool isRenamed = std::any_of(updates.begin(), updates.end(), [&](const ModuleUpdate& update)
+					{
+						return update.PreviousPath.native() == key;
+					});
+					if (!isRenamed)
+					{
+						updates.push_back({ModuleChange::Removed, it->second, {}});
+					}
+				}
+			}
+		}
+
+		// Everything else is parsed again, in parallel for large batches
+		ModuleScanner scanner(m_Options.ThreadCount, false);
+		scanner.SetSourceType(m_Options.SourceType);
+
+		ScanStats scanStats;
+		std::vector<ScanResult> results = scanner.ScanBatch(parse, &scanStats);
+
+		size_t parsed = 0;
+		size_t renamed = 0;
+		size_t removed = 0;
+		{
+			std::unique_lock lock(m_IndexMutex);
+			for (ModuleUpdate& update: updates)
+			{
+				if (update.Change == ModuleChange::Removed)
+				{
+					m_Index.erase(update.Result->Path.native());
+					removed++;
+				}
+				else
+				{
+					m_Index.erase(update.PreviousPath.native());
+					m_Index.insert_or_assign(update.Result->Path.native(), update.Result);
+					renamed++;
+				}
+			}
+			for (ScanResult& result: results)
+			{
+				auto value = std::make_shared<const ScanResult>(std::move(result));
+				auto [it, inserted] = m_Index.insert_or_assign(value->Path.native(), value);
+				updates.push_back({inserted ? ModuleChange::Added : ModuleChange::Modified, std::move(value), {}});
+				parsed++;
+			}
+		}
+
+		if (!updates.empty())
+		{
+			const auto latency = std::chrono::steady_clock::now() - firstEvent;
+
+			std::lock_guard lock(m_StatsMutex);
+			m_Stats.Batches++;
+			m_Stats.Parsed += parsed;
+			m_Stats.Renamed += renamed;
+			m_Stats.Removed += removed;
+			m_Stats.BytesRead += scanStats.BytesRead;
+			m_Stats.LastLatency = latency;
+			m_Stats.MaxLatency = std::max(m_Stats.MaxLatency, m_Stats.LastLatency);
+			m_Stats.Directories = m_Watches.size();
+		}
+
+		if (callback)
+		{
+			for (const ModuleUpdate& update: updates)
+			{
+				callback(update);
+			}
+		}
+		return updates.size();
+	}
+
+	size_t ModuleWatcher::Update(std::optional<std::chrono::milliseconds> timeout, const TCallback& callback)
+	{
+		if (!IsOpen() || m_Stopped || !Wait(timeout))
+		{
+			return 0;
+		}
+
+		// Keep reading until the burst is over
+		const auto firstEvent = std::chrono::steady_clock::now();
+		TPending pending;
+		ReadEvents(pending);
+		for (;;)
+		{
+			const auto elapsed = std::chrono::steady_clock::now() - firstEvent;
+			if (elapsed >= m_Options.MaxDelay)
+			{
+				break;
+			}
+
+			const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(m_Options.MaxDelay - elapsed);
+			if (!Wait(std::min(m_Options.QuietPeriod, remaining)))
+			{
+				break;
+			}
+			ReadEvents(pending);
+		}
+
+		// Sources of renames that didn't complete in this batch are plain removals and are already queued
+		m_MovedFrom.clear();
+		return Apply(pending, firstEvent, callback);
+	}
+	void ModuleWatcher::Run(const TCallback& callback)
+	{
+		while (IsOpen() && !m_Stopped)
+		{
+			Update({}, callback);
+		}
+	}
+
+	std::shared_ptr<const ScanResult> ModuleWatcher::Find(const std::filesystem::path& path) const
+	{
+		std::shared_lock lock(m_IndexMutex);
+		if (auto it = m_Index.find(path.native()); it != m_Index.end())
+		{
+			return it->second;
+		}
+		return nullptr;
+	}
+	size_t ModuleWatcher::GetCount() const
+	{
+		std::shared_lock lock(m_IndexMutex);
+		return m_Index.size();
+	}
+	ModuleWatcherStats ModuleWatcher::GetStats() const
+	{
+		ModuleWatcherStats stats;
+		{
+			std::lock_guard lock(m_StatsMutex);
+			stats = m_Stats;
+		}
+		stats.Modules = GetCount();
+		return stats;
+	}
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include "ModuleScanner.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace BethesdaModule::Core
+{
+	enum class ModuleChange
+	{
+		Added,
+		Modified,
+		Renamed,
+		Removed,
+	};
+	std::string_view GetModuleChangeName(ModuleChange change) noexcept;
+
+	struct ModuleUpdate final
+	{
+		ModuleChange Change = ModuleChange::Added;
+
+		// Current state of the module, the last known one for removed modules
+		std::shared_ptr<const ScanResult> Result;
+
+		// Path before the rename, empty for other changes
+		std::filesystem::path PreviousPath;
+	};
+
+	struct ModuleWatcherOptions final
+	{
+		bool Recursive = true;
+		size_t ThreadCount = 0;
+		ByteSourceType SourceType = ByteSourceType::File;
+
+		// Events are collected until none arrive for 'QuietPeriod', but no longer than 'MaxDelay' after the first one
+		std::chrono::milliseconds QuietPeriod = std::chrono::milliseconds(20);
+		std::chrono::milliseconds MaxDelay = std::chrono::milliseconds(250);
+	};
+
+	struct ModuleWatcherStats final
+	{
+		size_t Modules = 0;
+		size_t Directories = 0;
+
+		// Raw events read from the kernel and the batches they were coalesced into
+		size_t Events = 0;
+		size_t Batches = 0;
+		size_t Wakeups = 0;
+
+		size_t Parsed = 0;
+		size_t Renamed = 0;
+		size_t Removed = 0;
+		size_t Overflows = 0;
+		uint64_t BytesRead = 0;
+
+		// From the first event of a batch until the index reflects it
+		std::chrono::nanoseconds LastLatency = {};
+		std::chrono::nanoseconds MaxLatency = {};
+	};
+
+	// In-memory index of every module header in a folder that's kept current with inotify.
+	//
+	// The folder is scanned once on open, after that only the files that were written, created, moved in or removed
+	// are looked at again. Events are coalesced, so a mod manager writing hundreds of files costs one batch and every
+	// file is parsed once no matter how many events it produced. Renames within the folder move the entry without
+	// parsing the file again. When the kernel queue overflows the whole folder is rescanned.
+	//
+	// Waiting for events blocks in 'poll' without a timeout, an idle watcher doesn't wake up at all. Lookups are
+	// thread-safe and can be done while another thread runs the update loop. Only Linux is supported for now.
+	class ModuleWatcher final
+	{
+		public:
+			// Called from the thread running 'Update' or 'Run' once the index reflects the change
+			using TCallback = std::function<void(const ModuleUpdate& update)>;
+			using TKey = std::filesystem::path::string_type;
+
+			static bool IsSupported() noexcept;
+
+		private:
+			// Paths are checked again when the batch is applied, only the source of a rename has to be remembered
+			struct PendingChange final
+			{
+				std::filesystem::path MovedFrom;
+			};
+			using TPending = std::unordered_map<TKey, PendingChange>;
+
+		private:
+			std::filesystem::path m_Directory;
+			ModuleWatcherOptions m_Options;
+
+			int m_Handle = -1;
+			int m_StopEvent = -1;
+			std::atomic<bool> m_Stopped = false;
+			std::unordered_map<int, std::filesystem::path> m_Watches;
+
+			// Source side of renames seen in the current batch by their cookie
+			std::unordered_map<uint32_t, std::filesystem::path> m_MovedFrom;
+
+			mutable std::shared_mutex m_IndexMutex;
+			std::unordered_map<TKey, std::shared_ptr<const ScanResult>> m_Index;
+
+			mutable std::mutex m_StatsMutex;
+			ModuleWatcherStats m_Stats;
+
+		private:
+			void AddWatches(const std::filesystem::path& directory, TPending* pending);
+			void RemoveWatches(const std::filesystem::path& directory);
+			void QueueRescan(TPending& pending);
+
+			bool Wait(std::optional<std::chrono::milliseconds> timeout);
+			void ReadEvents(TPending& pending);
+			size_t Apply(TPending& pending, std::chrono::steady_clock::time_point firstEvent, const TCallback& callback);
+
+		public:
+			ModuleWatcher() = default;
+			ModuleWatcher(const ModuleWatcher&) = delete;
+			~ModuleWatcher() noexcept
+			{
+				Close();
+			}
+
+		public:
+			// Starts watching and fills the index, returns false if the folder can't be watched
+			bool Open(const std::filesystem::path& directory, const ModuleWatcherOptions& options = {});
+			void Close() noexcept;
+			bool IsOpen() const noexcept
+			{
+				return m_Handle >= 0;
+			}
+
+			// Waits for the next batch of events and applies it. Returns the number of changed modules,
+			// zero when the timeout expired or the watcher was stopped.
+			size_t Update(std::optional<std::chrono::milliseconds> timeout, const TCallback& callback);
+
+			// Applies batches until 'Stop' is called
+			void Run(const TCallback& callback);
+
+			// Makes 'Run' return and 'Update' stop waiting, can be called from any thread
+			void Stop() noexcept;
+
+			std::shared_ptr<const ScanResult> Find(const std::filesystem::path& path) const;
+			size_t GetCount() const;
+			ModuleWatcherStats GetStats() const;
+
+			template<class TFunc>
+			void ForEach(TFunc&& func) const
+			{
+				std::shared_lock lock(m_IndexMutex);
+				for (const auto& [key, result]: m_Index)
+				{
+					func(*result);
+				}
+			}
+
+		public:
+			ModuleWatcher& operator=(const ModuleWatcher&) = delete;
+	};
+}
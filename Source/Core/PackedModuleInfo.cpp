@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include "PackedModuleInfo.h"
+#include <cstring>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	uint32_t ReadUInt32(const std::byte* data) noexcept
+	{
+		uint32_t value = 0;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	void WriteUInt32(std::byte* data, uint32_t value) noexcept
+	{
+		std::memcpy(data, &value, sizeof(value));
+	}
+
+	// Measures every string first, so the block can be allocated at its final size
+	template<class TLayout, class TForEachMaster>
+	std::shared_ptr<const std::byte[]> Pack(TLayout layout, std::string_view author, std::string_view description, TForEachMaster&& forEachMaster)
+	{
+		size_t textSize = 2 * sizeof(uint32_t) + author.size() + description.size();
+		layout.MasterCount = 0;
+		forEachMaster([&](std::string_view name)
+		{
+			textSize += sizeof(uint32_t) + name.size();
+			layout.MasterCount++;
+		});
+
+		const size_t tableOffset = sizeof(TLayout);
+		const size_t textOffset = tableOffset + (2 + layout.MasterCount) * sizeof(uint32_t);
+		layout.Size = static_cast<uint32_t>(textOffset + textSize);
+
+		auto block = std::make_shared_for_overwrite<std::byte[]>(layout.Size);
+		std::memcpy(block.get(), &layout, sizeof(layout));
+
+		size_t index = 0;
+		size_t offset = textOffset;
+		auto AddString = [&](std::string_view value)
+		{
+			WriteUInt32(block.get() + tableOffset + index * sizeof(uint32_t), static_cast<uint32_t>(offset));
+			WriteUInt32(block.get() + offset, static_cast<uint32_t>(value.size()));
+			std::memcpy(block.get() + offset + sizeof(uint32_t), value.data(), value.size());
+
+			offset += sizeof(uint32_t) + value.size();
+			index++;
+		};
+		AddString(author);
+		AddString(description);
+		forEachMaster(AddString);
+		return block;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	PackedModuleInfo PackedModuleInfo::FromHeader(std::span<const std::byte> buffer, const ModuleHeader& header)
+	{
+		Layout layout;
+		layout.Signature = header.Signature;
+		layout.Flags = header.Flags;
+		layout.FormVersion = header.FormVersion;
+		layout.FormatLevel = header.FormatLevel;
+
+		PackedModuleInfo info;
+		info.m_Block = Pack(layout, header.Author.GetText(buffer), header.Description.GetText(buffer), [&](auto&& func)
+		{
+			header.ForEachMaster(buffer, func);
+		});
+		return info;
+	}
+	PackedModuleInfo PackedModuleInfo::FromModuleInfo(const ModuleInfo& moduleInfo)
+	{
+		Layout layout;
+		layout.Signature = moduleInfo.Signature;
+		layout.Flags = moduleInfo.Flags;
+		layout.FormVersion = moduleInfo.FormVersion;
+		layout.FormatLevel = moduleInfo.FormatLevel;
+
+		PackedModuleInfo info;
+		info.m_Block = Pack(layout, moduleInfo.Author, moduleInfo.Description, [&](auto&& func)
+		{
+			for (const std::string& name: moduleInfo.Masters)
+			{
+				func(name);
+			}
+		});
+		return info;
+	}
+
+	auto PackedModuleInfo::GetLayout() const noexcept -> Layout
+	{
+		Layout layout;
+		if (m_Block)
+		{
+			std::memcpy(&layout, m_Block.get(), sizeof(layout));
+		}
+		return layout;
+	}
+	std::string_view PackedModuleInfo::GetString(size_t index) const noexcept
+	{
+		if (!m_Block || index >= 2 + GetMasterCount())
+		{
+			return {};
+		}
+
+		const std::byte* entry = m_Block.get() + ReadUInt32(m_Block.get() + sizeof(Layout) + index * sizeof(uint32_t));
+		return {reinterpret_cast<const char*>(entry + sizeof(uint32_t)), ReadUInt32(entry)};
+	}
+
+	uint32_t PackedModuleInfo::GetSignature() const noexcept
+	{
+		return GetLayout().Signature;
+	}
+	HeaderFlags PackedModuleInfo::GetFlags() const noexcept
+	{
+		return GetLayout().Flags;
+	}
+	uint32_t PackedModuleInfo::GetFormVersion() const noexcept
+	{
+		return GetLayout().FormVersion;
+	}
+	FormatLevel PackedModuleInfo::GetFormatLevel() const noexcept
+	{
+		return GetLayout().FormatLevel;
+	}
+	size_t PackedModuleInfo::GetMasterCount() const noexcept
+	{
+		return GetLayout().MasterCount;
+	}
+
+	size_t PackedModuleInfo::GetMemoryUsage() const noexcept
+	{
+		// The reference count block sits in front of the data
+		return m_Block ? GetLayout().Size + 2 * sizeof(void*) : 0;
+	}
+	ModuleInfo PackedModuleInfo::ToModuleInfo() const
+	{
+		ModuleInfo info;
+		info.Signature = GetSignature();
+		info.Flags = GetFlags();
+		info.FormVersion = GetFormVersion();
+		info.FormatLevel = GetFormatLevel();
+		info.Author = GetAuthor();
+		info.Description = GetDescription();
+
+		info.Masters.reserve(GetMasterCount());
+		ForEachMaster([&](std::string_view name)
+		{
+			info.Masters.emplace_back(name);
+		});
+		return info;
+	}
+}
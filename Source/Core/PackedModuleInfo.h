@@ -0,0 +1,87 @@
+#pragma once
+#include "ModuleInfo.h"
+#include <memory>
+
+namespace BethesdaModule::Core
+{
+	// Immutable 'ModuleInfo' laid out in a single heap block: a fixed part with the header fields, a table of string
+	// offsets (author, description, then masters) and length-prefixed strings. The block is allocated once, together
+	// with its reference count, and freed in one go when the last copy goes away. Copies only share the block.
+	class PackedModuleInfo final
+	{
+		private:
+			struct Layout final
+			{
+				uint32_t Signature = 0;
+				HeaderFlags Flags = HeaderFlags::None;
+				uint32_t FormVersion = 0;
+				Core::FormatLevel FormatLevel = Core::FormatLevel::Unknown;
+				uint32_t MasterCount = 0;
+				uint32_t Size = 0;
+			};
+
+		public:
+			static PackedModuleInfo FromHeader(std::span<const std::byte> buffer, const ModuleHeader& header);
+			static PackedModuleInfo FromModuleInfo(const ModuleInfo& info);
+
+		private:
+			std::shared_ptr<const std::byte[]> m_Block;
+
+		private:
+			Layout GetLayout() const noexcept;
+			std::string_view GetString(size_t index) const noexcept;
+
+		public:
+			PackedModuleInfo() noexcept = default;
+
+		public:
+			bool IsEmpty() const noexcept
+			{
+				return m_Block == nullptr;
+			}
+
+			// An empty object returns defaults for all fields
+			uint32_t GetSignature() const noexcept;
+			HeaderFlags GetFlags() const noexcept;
+			uint32_t GetFormVersion() const noexcept;
+			Core::FormatLevel GetFormatLevel() const noexcept;
+
+			std::string_view GetAuthor() const noexcept
+			{
+				return GetString(0);
+			}
+			std::string_view GetDescription() const noexcept
+			{
+				return GetString(1);
+			}
+			size_t GetMasterCount() const noexcept;
+			std::string_view GetMaster(size_t index) const noexcept
+			{
+				return GetString(2 + index);
+			}
+
+			template<class TFunc>
+			void ForEachMaster(TFunc&& func) const
+			{
+				const size_t count = GetMasterCount();
+				for (size_t i = 0; i < count; i++)
+				{
+					func(GetMaster(i));
+				}
+			}
+
+			// Size of the block including the reference count
+			size_t GetMemoryUsage() const noexcept;
+			ModuleInfo ToModuleInfo() const;
+
+		public:
+			explicit operator bool() const noexcept
+			{
+				return !IsEmpty();
+			}
+			bool operator!() const noexcept
+			{
+				return IsEmpty();
+			}
+	};
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace BethesdaModule::Core
+{
+	inline size_t GetDefaultThreadCount() noexcept
+	{
+		return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	// Calls 'func(index)' for every index in [0, count) on up to 'threadCount' threads including the calling one.
+	// Indices are handed out one at a time, so uneven item costs are balanced automatically.
+	template<class TFunc>
+	void ParallelFor(size_t count, size_t threadCount, TFunc&& func)
+	{
+		std::atomic<size_t> next = 0;
+		auto Worker = [&]()
+		{
+			for (size_t i = next++; i < count; i = next++)
+			{
+				func(i);
+			}
+		};
+
+		threadCount = std::clamp<size_t>(threadCount, 1, std::max<size_t>(count, 1));
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (size_t i = 1; i < threadCount; i++)
+		{
+			threads.emplace_back(Worker);
+		}
+		Worker();
+
+		for (std::thread& thread: threads)
+		{
+			thread.join();
+		}
+	}
+
+	// Same as 'ParallelFor', but every thread starts with its own contiguous part of the indices and only takes work
+	// from others once it runs out: it steals the upper half of the largest remaining part. Neighboring items are
+	// mostly processed by the same thread and there's no counter shared by all threads.
+	template<class TFunc>
+	void StealingParallelFor(size_t count, size_t threadCount, TFunc&& func)
+	{
+		// Both ends of a part are packed into one word, so taking from either side is a single compare-exchange
+		if (count > std::numeric_limits<uint32_t>::max())
+		{
+			ParallelFor(count, threadCount, std::forward<TFunc>(func));
+			return;
+		}
+		auto Pack = [](uint64_t begin, uint64_t end)
+		{
+			return begin << 32|end;
+		};
+		auto GetSize = [](uint64_t range)
+		{
+			return (range & 0xFFFFFFFFu) - (range >> 32);
+		};
+
+		struct alignas(64) Part final
+		{
+			std::atomic<uint64_t> Range = 0;
+		};
+		threadCount = std::clamp<size_t>(threadCount, 1, std::max<size_t>(count, 1));
+		std::vector<Part> parts(threadCount);
+		for (size_t i = 0; i < threadCount; i++)
+		{
+			parts[i].Range = Pack(count * i / threadCount, count * (i + 1) / threadCount);
+		}
+
+		auto Steal = [&](size_t self)
+		{
+			for (;;)
+			{
+				Part* victim = nullptr;
+				uint64_t range = 0;
+				for (Part& part: parts)
+				{
+					const uint64_t value = part.Range.load();
+					if (GetSize(value) > GetSize(range))
+					{
+						victim = &part;
+						range = value;
+					}
+				}
+				if (!victim)
+				{
+					return false;
+				}
+
+				const uint64_t begin = range >> 32;
+				const uint64_t end = range & 0xFFFFFFFFu;
+				const uint64_t middle = end - (end - begin + 1) / 2;
+				if (victim->Range.compare_exchange_strong(range, Pack(begin, middle)))
+				{
+					parts[self].Range = Pack(middle, end);
+					return true;
+				}
+			}
+		};
+		auto Worker = [&](size_t self)
+		{
+			do
+			{
+				Part& part = parts[self];
+				for (uint64_t range = part.Range.load(); GetSize(range) != 0;)
+				{
+					if (part.Range.compare_exchange_weak(range, range + (uint64_t(1) << 32)))
+					{
+						func(static_cast<size_t>(range >> 32));
+						range = part.Range.load();
+					}
+				}
+			}
+			while (Steal(self));
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (size_t i = 1; i < threadCount; i++)
+		{
+			threads.emplace_back(Worker, i);
+		}
+		Worker(0);
+
+		for (std::thread& thread: threads)
+		{
+			thread.join();
+		}
+	}
+}
@@ -0,0 +1,253 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <optional>
+#include <algorithm>
+
+namespace BethesdaModule::Core
+{
+	enum class SeekOrigin
+	{
+		Start,
+		Current,
+		End
+	};
+
+	struct ReadAheadStats final
+	{
+		size_t ReadCalls = 0;
+		size_t SeekCalls = 0;
+		size_t WriteCalls = 0;
+		uint64_t BytesRead = 0;
+
+		size_t GetStreamCalls() const noexcept
+		{
+			return ReadCalls + SeekCalls + WriteCalls;
+		}
+	};
+
+	// Serves small sequential reads and relative seeks from a single block fetched from the underlying stream.
+	// The stream itself is passed to every call and is only required to provide these members:
+	// 'size_t Read(void* buffer, size_t size)', 'std::optional<uint64_t> Seek(int64_t offset, SeekOrigin origin)'
+	// and 'size_t Write(const void* buffer, size_t size)' if writing is used.
+	class ReadAheadBuffer final
+	{
+		public:
+			// Enough to cover TES4 + HEDR + CNAM + SNAM + a typical MAST list in one read
+			static constexpr size_t DefaultCapacity = 16 * 1024;
+
+		private:
+			std::vector<uint8_t> m_Data;
+			size_t m_Capacity = DefaultCapacity;
+			size_t m_DataSize = 0;
+			uint64_t m_DataOffset = 0;
+
+			// Logical position seen by the user and the actual position of the underlying stream, if known
+			uint64_t m_Position = 0;
+			std::optional<uint64_t> m_StreamPosition;
+			bool m_IsPositionKnown = false;
+
+			ReadAheadStats m_Stats;
+
+		private:
+			bool IsBuffered(uint64_t position) const noexcept
+			{
+				return m_DataSize != 0 && position >= m_DataOffset && position < m_DataOffset + m_DataSize;
+			}
+
+			template<class TStream>
+			bool EnsurePosition(TStream& stream)
+			{
+				if (!m_IsPositionKnown)
+				{
+					m_Stats.SeekCalls++;
+					m_StreamPosition = stream.Seek(0, SeekOrigin::Current);
+					if (!m_StreamPosition)
+					{
+						return false;
+					}
+					m_Position = *m_StreamPosition;
+					m_IsPositionKnown = true;
+				}
+				return true;
+			}
+
+			template<class TStream>
+			bool SyncStreamPosition(TStream& stream)
+			{
+				if (m_StreamPosition != m_Position)
+				{
+					m_Stats.SeekCalls++;
+					m_StreamPosition = stream.Seek(static_cast<int64_t>(m_Position), SeekOrigin::Start);
+					return m_StreamPosition.has_value();
+				}
+				return true;
+			}
+
+			template<class TStream>
+			size_t ReadStream(TStream& stream, void* buffer, size_t size)
+			{
+				if (SyncStreamPosition(stream))
+				{
+					m_Stats.ReadCalls++;
+					const size_t read = stream.Read(buffer, size);
+
+					m_Stats.BytesRead += read;
+					*m_StreamPosition += read;
+					return read;
+				}
+				return 0;
+			}
+
+		public:
+			ReadAheadBuffer(size_t capacity = DefaultCapacity) noexcept
+				:m_Capacity(std::max<size_t>(capacity, 1))
+			{
+			}
+
+		public:
+			size_t GetCapacity() const noexcept
+			{
+				return m_Capacity;
+			}
+			const ReadAheadStats& GetStats() const noexcept
+			{
+				return m_Stats;
+			}
+
+			// Forgets everything about the underlying stream, call it when the stream is replaced
+			void Reset() noexcept
+			{
+				Discard();
+				m_Position = 0;
+				m_StreamPosition.reset();
+				m_IsPositionKnown = false;
+				m_Stats = {};
+			}
+
+			// Drops buffered data but keeps the logical position
+			void Discard() noexcept
+			{
+				m_DataSize = 0;
+				m_DataOffset = 0;
+			}
+
+			template<class TStream>
+			size_t Read(TStream& stream, void* buffer, size_t size)
+			{
+				if (!EnsurePosition(stream))
+				{
+					return 0;
+				}
+
+				uint8_t* out = static_cast<uint8_t*>(buffer);
+				size_t total = 0;
+				while (total < size)
+				{
+					if (IsBuffered(m_Position))
+					{
+						const size_t offset = static_cast<size_t>(m_Position - m_DataOffset);
+						const size_t count = std::min(size - total, m_DataSize - offset);
+						std::memcpy(out + total, m_Data.data() + offset, count);
+
+						total += count;
+						m_Position += count;
+					}
+					else if (size - total >= m_Capacity)
+					{
+						// Large requests gain nothing from going through the buffer
+						const size_t read = ReadStream(stream, out + total, size - total);
+						total += read;
+						m_Position += read;
+						break;
+					}
+					else
+					{
+						m_Data.resize(m_Capacity);
+
+						m_DataOffset = m_Position;
+						m_DataSize = ReadStream(stream, m_Data.data(), m_Capacity);
+						if (m_DataSize == 0)
+						{
+							break;
+						}
+					}
+				}
+				return total;
+			}
+
+			template<class TStream>
+			size_t Write(TStream& stream, const void* buffer, size_t size)
+			{
+				if (EnsurePosition(stream) && SyncStreamPosition(stream))
+				{
+					// Whatever we have buffered can be stale now
+					Discard();
+
+					m_Stats.WriteCalls++;
+					const size_t written = stream.Write(buffer, size);
+
+					m_Position += written;
+					*m_StreamPosition += written;
+					return written;
+				}
+				return 0;
+			}
+
+			template<class TStream>
+			std::optional<uint64_t> Seek(TStream& stream, int64_t offset, SeekOrigin origin)
+			{
+				switch (origin)
+				{
+					case SeekOrigin::Start:
+					{
+						// Absolute seek doesn't need to know where the stream currently is
+						if (offset < 0)
+						{
+							return {};
+						}
+						m_Position = static_cast<uint64_t>(offset);
+						m_IsPositionKnown = true;
+						return m_Position;
+					}
+					case SeekOrigin::Current:
+					{
+						if (!EnsurePosition(stream))
+						{
+							return {};
+						}
+						if (offset < 0 && static_cast<uint64_t>(-offset) > m_Position)
+						{
+							return {};
+						}
+						m_Position += offset;
+						return m_Position;
+					}
+					case SeekOrigin::End:
+					{
+						// We don't know the stream size, so this one has to go to the stream
+						m_Stats.SeekCalls++;
+						m_StreamPosition = stream.Seek(offset, SeekOrigin::End);
+						if (m_StreamPosition)
+						{
+							m_Position = *m_StreamPosition;
+							m_IsPositionKnown = true;
+						}
+						return m_StreamPosition;
+					}
+				};
+				return {};
+			}
+
+			template<class TStream>
+			std::optional<uint64_t> Tell(TStream& stream)
+			{
+				if (EnsurePosition(stream))
+				{
+					return m_Position;
+				}
+				return {};
+			}
+	};
+}
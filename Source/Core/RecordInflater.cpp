@@ -0,0 +1,145 @@
+#include "stdafx.h"
+#include "RecordInflater.h"
+#include <zlib.h>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	bool ReadUncompressedSize(std::span<const std::byte> recordData, uint32_t& size) noexcept
+	{
+		if (recordData.size() < sizeof(size))
+		{
+			return false;
+		}
+		std::memcpy(&size, recordData.data(), sizeof(size));
+		return true;
+	}
+
+	// Inflates the whole stream at once, the output is expected to be exactly 'output.size()' bytes
+	ParseStatus InflateInto(z_stream& stream, std::span<const std::byte> input, std::span<std::byte> output) noexcept
+	{
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(input.data()));
+		stream.avail_in = static_cast<uInt>(input.size());
+		stream.next_out = reinterpret_cast<Bytef*>(output.data());
+		stream.avail_out = static_cast<uInt>(output.size());
+
+		const int result = ::inflate(&stream, Z_FINISH);
+		if (result == Z_STREAM_END && stream.total_out == output.size())
+		{
+			return ParseStatus::Success;
+		}
+		return result == Z_BUF_ERROR && stream.avail_in == 0 ? ParseStatus::Truncated : ParseStatus::Malformed;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	RecordInflater::RecordInflater()
+		:m_Stream(std::make_unique<z_stream>())
+	{
+	}
+	RecordInflater::~RecordInflater()
+	{
+		if (m_Initialized)
+		{
+			::inflateEnd(m_Stream.get());
+		}
+	}
+
+	ParseStatus RecordInflater::Inflate(std::span<const std::byte> recordData, std::span<const std::byte>& result)
+	{
+		uint32_t size = 0;
+		if (!ReadUncompressedSize(recordData, size))
+		{
+			return ParseStatus::Truncated;
+		}
+		if (size > MaxUncompressedSize)
+		{
+			return ParseStatus::LimitExceeded;
+		}
+
+		// Resetting keeps the window and internal state allocated
+		if (!m_Initialized)
+		{
+			if (::inflateInit(m_Stream.get()) != Z_OK)
+			{
+				return ParseStatus::Malformed;
+			}
+			m_Initialized = true;
+		}
+		else if (::inflateReset(m_Stream.get()) != Z_OK)
+		{
+			return ParseStatus::Malformed;
+		}
+
+		// The buffer only grows, so it ends up the size of the largest record seen
+		if (m_Buffer.size() < size)
+		{
+			m_Buffer.resize(size);
+		}
+
+		const std::span<std::byte> output(m_Buffer.data(), size);
+		const ParseStatus status = InflateInto(*m_Stream, recordData.subspan(sizeof(size)), output);
+		if (status == ParseStatus::Success)
+		{
+			result = output;
+		}
+		return status;
+	}
+
+	RecordInflater& GetThreadInflater()
+	{
+		thread_local RecordInflater inflater;
+		return inflater;
+	}
+
+	ParseStatus InflateRecordUnpooled(std::span<const std::byte> recordData, std::vector<std::byte>& result)
+	{
+		uint32_t size = 0;
+		if (!ReadUncompressedSize(recordData, size))
+		{
+			return ParseStatus::Truncated;
+		}
+		if (size > RecordInflater::MaxUncompressedSize)
+		{
+			return ParseStatus::LimitExceeded;
+		}
+
+		z_stream stream = {};
+		if (::inflateInit(&stream) != Z_OK)
+		{
+			return ParseStatus::Malformed;
+		}
+
+		std::vector<std::byte> buffer(size);
+		const ParseStatus status = InflateInto(stream, recordData.subspan(sizeof(size)), buffer);
+		::inflateEnd(&stream);
+
+		if (status == ParseStatus::Success)
+		{
+			result = std::move(buffer);
+		}
+		return status;
+	}
+
+	std::vector<RecordEntry> FindCompressedRecords(std::span<const std::byte> fileData, const ModuleHeader& header)
+	{
+		// TES3 has no record compression
+		std::vector<RecordEntry> records;
+		if (header.FormatLevel == FormatLevel::Morrowind)
+		{
+			return records;
+		}
+
+		MemoryByteSource source(fileData);
+		WalkRecords(source, header, {}, [&](const RecordEntry& record)
+		{
+			if (record.IsCompressed() && record.DataOffset + record.DataSize <= fileData.size())
+			{
+				records.push_back(record);
+			}
+		});
+		return records;
+	}
+}
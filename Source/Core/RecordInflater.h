@@ -0,0 +1,111 @@
+#pragma once
+#include "RecordWalker.h"
+#include "Parallel.h"
+#include <memory>
+#include <mutex>
+
+struct z_stream_s;
+
+namespace BethesdaModule::Core
+{
+	struct InflateStats final
+	{
+		uint64_t Records = 0;
+		uint64_t Failed = 0;
+		uint64_t CompressedBytes = 0;
+		uint64_t UncompressedBytes = 0;
+
+		double GetRatio() const noexcept
+		{
+			return CompressedBytes != 0 ? static_cast<double>(UncompressedBytes) / CompressedBytes : 0.0;
+		}
+
+		InflateStats& operator+=(const InflateStats& other) noexcept
+		{
+			Records += other.Records;
+			Failed += other.Failed;
+			CompressedBytes += other.CompressedBytes;
+			UncompressedBytes += other.UncompressedBytes;
+			return *this;
+		}
+	};
+
+	// Inflates compressed record data: the uncompressed size followed by a zlib stream.
+	//
+	// The zlib state and the output buffer are kept between calls and only reset, so after the first few records
+	// inflating doesn't allocate at all. Not thread-safe, each thread should use its own (see 'GetThreadInflater').
+	class RecordInflater final
+	{
+		public:
+			// Declared sizes above this are rejected, real records are well under a megabyte
+			static constexpr uint32_t MaxUncompressedSize = 64 * 1024 * 1024;
+
+		private:
+			std::unique_ptr<z_stream_s> m_Stream;
+			std::vector<std::byte> m_Buffer;
+			bool m_Initialized = false;
+
+		public:
+			RecordInflater();
+			RecordInflater(const RecordInflater&) = delete;
+			~RecordInflater();
+
+		public:
+			// On success 'result' refers to the internal buffer and stays valid until the next call
+			ParseStatus Inflate(std::span<const std::byte> recordData, std::span<const std::byte>& result);
+
+		public:
+			RecordInflater& operator=(const RecordInflater&) = delete;
+	};
+
+	// Inflater owned by the calling thread
+	RecordInflater& GetThreadInflater();
+
+	// Inflates a record with a zlib stream of its own and a new buffer, what code without pooling does.
+	// Only kept as a baseline for benchmarks.
+	ParseStatus InflateRecordUnpooled(std::span<const std::byte> recordData, std::vector<std::byte>& result);
+
+	// Compressed records of a whole file in file order. Records running past the end of the data are left out.
+	std::vector<RecordEntry> FindCompressedRecords(std::span<const std::byte> fileData, const ModuleHeader& header);
+}
+
+namespace BethesdaModule::Core
+{
+	// Inflates 'records' of 'fileData' on up to 'threadCount' threads and calls 'onRecord(index, data)' for every
+	// record that inflated successfully. Records are handed out in batches to keep contention on the shared counter
+	// low, the callback is called concurrently from different threads.
+	template<class TFunc>
+	InflateStats InflateRecords(std::span<const std::byte> fileData, std::span<const RecordEntry> records, size_t threadCount, TFunc&& onRecord)
+	{
+		constexpr size_t batchSize = 64;
+
+		std::mutex statsMutex;
+		InflateStats stats;
+		ParallelFor((records.size() + batchSize - 1) / batchSize, threadCount, [&](size_t batch)
+		{
+			RecordInflater& inflater = GetThreadInflater();
+
+			InflateStats batchStats;
+			for (size_t i = batch * batchSize; i < std::min(records.size(), (batch + 1) * batchSize); i++)
+			{
+				const RecordEntry& record = records[i];
+				std::span<const std::byte> data;
+				if (record.DataOffset + record.DataSize <= fileData.size() && inflater.Inflate(fileData.subspan(record.DataOffset, record.DataSize), data) == ParseStatus::Success)
+				{
+					batchStats.CompressedBytes += record.DataSize;
+					batchStats.UncompressedBytes += data.size();
+					onRecord(i, data);
+				}
+				else
+				{
+					batchStats.Failed++;
+				}
+				batchStats.Records++;
+			}
+
+			std::lock_guard lock(statsMutex);
+			stats += batchStats;
+		});
+		return stats;
+	}
+}
@@ -0,0 +1,36 @@
+#include "stdafx.h"
+#include "RecordWalker.h"
+
+namespace BethesdaModule::Core
+{
+	uint64_t RecordStats::GetRecordCount(uint32_t type) const noexcept
+	{
+		auto it = std::lower_bound(RecordTypes.begin(), RecordTypes.end(), type, [](const RecordTypeCount& item, uint32_t type)
+		{
+			return item.Type < type;
+		});
+		return it != RecordTypes.end() && it->Type == type ? it->Count : 0;
+	}
+
+	void RecordStats::AddRecord(uint32_t type, uint32_t flags)
+	{
+		Records++;
+		if (flags & CompressedRecordFlag)
+		{
+			CompressedRecords++;
+		}
+
+		auto it = std::lower_bound(RecordTypes.begin(), RecordTypes.end(), type, [](const RecordTypeCount& item, uint32_t type)
+		{
+			return item.Type < type;
+		});
+		if (it != RecordTypes.end() && it->Type == type)
+		{
+			it->Count++;
+		}
+		else if (RecordTypes.size() < MaxRecordTypes)
+		{
+			RecordTypes.insert(it, {type, 1});
+		}
+	}
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include "ByteSource.h"
+#include <vector>
+#include <limits>
+#include <cstring>
+
+namespace BethesdaModule::Core
+{
+	// Record flag telling that record data is zlib-compressed and prefixed with its uncompressed size
+	constexpr uint32_t CompressedRecordFlag = 0x00040000;
+
+	struct RecordTypeCount final
+	{
+		uint32_t Type = 0;
+		uint64_t Count = 0;
+	};
+
+	// Totals over the whole body of a module, the header record excluded
+	struct RecordStats final
+	{
+		// Types beyond this many are only counted in totals, real files have less than 150
+		static constexpr size_t MaxRecordTypes = 512;
+
+		ParseStatus Status = ParseStatus::Success;
+		uint64_t Records = 0;
+		uint64_t Groups = 0;
+		uint64_t CompressedRecords = 0;
+		uint64_t BytesWalked = 0;
+
+		// Sorted by type
+		std::vector<RecordTypeCount> RecordTypes;
+
+		uint64_t GetUncompressedRecords() const noexcept
+		{
+			return Records - CompressedRecords;
+		}
+		uint64_t GetRecordCount(uint32_t type) const noexcept;
+
+		void AddRecord(uint32_t type, uint32_t flags);
+	};
+
+	// Location of a record found while walking, 'DataOffset' points past the record header. TES3 records have no FormID.
+	struct RecordEntry final
+	{
+		uint32_t Type = 0;
+		uint32_t Flags = 0;
+		uint32_t FormID = 0;
+		uint64_t DataOffset = 0;
+		uint32_t DataSize = 0;
+
+		bool IsCompressed() const noexcept
+		{
+			return Flags & CompressedRecordFlag;
+		}
+	};
+
+	struct RecordWalkLimits final
+	{
+		// Stop after walking this many bytes of the body, the stats are partial then
+		uint64_t MaxBytes = std::numeric_limits<uint64_t>::max();
+
+		// Size of the block non-contiguous sources are read in. Small records are skipped without touching the source again.
+		size_t BlockSize = 64 * 1024;
+	};
+}
+
+namespace BethesdaModule::Core
+{
+	namespace Private
+	{
+		// Serves small reads at increasing offsets from one reusable block
+		template<ByteSource TSource>
+		class BlockReader final
+		{
+			private:
+				TSource& m_Source;
+				std::vector<std::byte> m_Block;
+				uint64_t m_BlockOffset = 0;
+				size_t m_BlockSize = 0;
+
+			public:
+				BlockReader(TSource& source, size_t blockSize)
+					:m_Source(source), m_Block(blockSize)
+				{
+				}
+
+			public:
+				// Returns a pointer to 'size' bytes at the offset or null if the source ends before that
+				const std::byte* Read(uint64_t offset, size_t size)
+				{
+					if constexpr (ContiguousByteSource<TSource>)
+					{
+						const std::span<const std::byte> data = m_Source.GetData();
+						return offset + size <= data.size() ? data.data() + offset : nullptr;
+					}
+					else
+					{
+						if (offset < m_BlockOffset || offset + size > m_BlockOffset + m_BlockSize)
+						{
+							m_BlockOffset = offset;
+							m_BlockSize = m_Source.ReadAt(offset, m_Block.data(), m_Block.size());
+							if (size > m_BlockSize)
+							{
+								return nullptr;
+							}
+						}
+						return m_Block.data() + (offset - m_BlockOffset);
+					}
+				}
+		};
+	}
+
+	// Walks records and groups following the header record in a single pass. Only record and group headers are read,
+	// record data is skipped using declared sizes, so memory use doesn't depend on file size. Groups are entered rather
+	// than skipped, which covers nested groups of any depth without keeping a stack.
+	//
+	// 'onRecord(const RecordEntry&)' is called for every record in file order, groups aren't reported.
+	template<ByteSource TSource, class TFunc>
+	RecordStats WalkRecords(TSource& source, const ModuleHeader& header, const RecordWalkLimits& limits, TFunc&& onRecord)
+	{
+		RecordStats stats;
+		if (header.FormatLevel == FormatLevel::Unknown || header.HeaderSize == 0)
+		{
+			stats.Status = ParseStatus::UnknownFormat;
+			return stats;
+		}
+
+		// TES3 has no groups and a shorter record header, Oblivion headers are 4 bytes shorter than Skyrim ones
+		const bool isMorrowind = header.FormatLevel == FormatLevel::Morrowind;
+		const size_t recordHeaderSize = isMorrowind ? 16 : (header.FormatLevel == FormatLevel::Oblivion ? 20 : 24);
+		const size_t flagsOffset = isMorrowind ? 12 : 8;
+
+		// Some sources (COM streams) don't know their size
+		std::optional<uint64_t> fileSize;
+		if constexpr (requires { source.GetSize(); })
+		{
+			fileSize = source.GetSize();
+		}
+		const uint64_t startOffset = header.HeaderSize;
+		uint64_t offset = startOffset;
+
+		Private::BlockReader reader(source, std::max(limits.BlockSize, recordHeaderSize));
+		while (!fileSize || offset < *fileSize)
+		{
+			if (offset - startOffset >= limits.MaxBytes)
+			{
+				stats.Status = ParseStatus::LimitExceeded;
+				break;
+			}
+
+			const std::byte* data = reader.Read(offset, recordHeaderSize);
+			if (!data)
+			{
+				// Without a known size the end of the source is only found by reading past it
+				stats.Status = fileSize ? ParseStatus::Truncated : ParseStatus::Success;
+				break;
+			}
+
+			uint32_t type = 0;
+			uint32_t size = 0;
+			uint32_t flags = 0;
+			uint32_t formID = 0;
+			std::memcpy(&type, data, sizeof(type));
+			std::memcpy(&size, data + 4, sizeof(size));
+			std::memcpy(&flags, data + flagsOffset, sizeof(flags));
+			if (!isMorrowind)
+			{
+				std::memcpy(&formID, data + 12, sizeof(formID));
+			}
+
+			if (!isMorrowind && type == FourCC::GRUP)
+			{
+				// Group size includes the group header itself
+				if (size < recordHeaderSize)
+				{
+					stats.Status = ParseStatus::Malformed;
+					break;
+				}
+				stats.Groups++;
+				offset += recordHeaderSize;
+			}
+			else
+			{
+				stats.AddRecord(type, flags);
+				onRecord(RecordEntry{type, flags, formID, offset + recordHeaderSize, size});
+				offset += recordHeaderSize + static_cast<uint64_t>(size);
+			}
+		}
+
+		if (fileSize && offset > *fileSize && stats.Status == ParseStatus::Success)
+		{
+			stats.Status = ParseStatus::Truncated;
+		}
+		stats.BytesWalked = std::min(offset, fileSize.value_or(offset)) - startOffset;
+		return stats;
+	}
+
+	template<ByteSource TSource>
+	RecordStats WalkRecords(TSource& source, const ModuleHeader& header, const RecordWalkLimits& limits = {})
+	{
+		return WalkRecords(source, header, limits, [](const RecordEntry&)
+		{
+		});
+	}
+}
@@ -0,0 +1,441 @@
+#include "stdafx.h"
+#include "RoaringBitmap.h"
+#include <algorithm>
+#include <iterator>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BETHESDAMODULE_BITMAP_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BETHESDAMODULE_BITMAP_SSE2 1
+#endif
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	// Word operations for every register width
+	struct AndWords final
+	{
+		static uint64_t Apply(uint64_t left, uint64_t right) noexcept
+		{
+			return left & right;
+		}
+		#if BETHESDAMODULE_BITMAP_AVX2
+		static __m256i Apply(__m256i left, __m256i right) noexcept
+		{
+			return _mm256_and_si256(left, right);
+		}
+		#endif
+		#if BETHESDAMODULE_BITMAP_SSE2
+		static __m128i Apply(__m128i left, __m128i right) noexcept
+		{
+			return _mm_and_si128(left, right);
+		}
+		#endif
+	};
+	struct OrWords final
+	{
+		static uint64_t Apply(uint64_t left, uint64_t right) noexcept
+		{
+			return left|right;
+		}
+		#if BETHESDAMODULE_BITMAP_AVX2
+		static __m256i Apply(__m256i left, __m256i right) noexcept
+		{
+			return _mm256_or_si256(left, right);
+		}
+		#endif
+		#if BETHESDAMODULE_BITMAP_SSE2
+		static __m128i Apply(__m128i left, __m128i right) noexcept
+		{
+			return _mm_or_si128(left, right);
+		}
+		#endif
+	};
+	struct AndNotWords final
+	{
+		static uint64_t Apply(uint64_t left, uint64_t right) noexcept
+		{
+			return left & ~right;
+		}
+		#if BETHESDAMODULE_BITMAP_AVX2
+		static __m256i Apply(__m256i left, __m256i right) noexcept
+		{
+			return _mm256_andnot_si256(right, left);
+		}
+		#endif
+		#if BETHESDAMODULE_BITMAP_SSE2
+		static __m128i Apply(__m128i left, __m128i right) noexcept
+		{
+			return _mm_andnot_si128(right, left);
+		}
+		#endif
+	};
+
+	// Combines two full bitmap containers and returns the number of set bits
+	template<class TWords>
+	uint32_t CombineBits(const uint64_t* left, const uint64_t* right, uint64_t* output) noexcept
+	{
+		constexpr size_t count = RoaringBitmap::BitmapWords;
+
+		size_t i = 0;
+		#if BETHESDAMODULE_BITMAP_AVX2
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256i value = TWords::Apply(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), value);
+		}
+		#endif
+		#if BETHESDAMODULE_BITMAP_SSE2
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m128i value = TWords::Apply(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), value);
+		}
+		#endif
+		for (; i < count; i++)
+		{
+			output[i] = TWords::Apply(left[i], right[i]);
+		}
+
+		uint32_t cardinality = 0;
+		for (i = 0; i < count; i++)
+		{
+			cardinality += static_cast<uint32_t>(std::popcount(output[i]));
+		}
+		return cardinality;
+	}
+
+	bool TestBit(const std::vector<uint64_t>& bits, uint16_t value) noexcept
+	{
+		return (bits[value >> 6] >> (value & 63)) & 1;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	void RoaringBitmap::Container::ToBitmap()
+	{
+		Bits.assign(BitmapWords, 0);
+		for (uint16_t value: Array)
+		{
+			Bits[value >> 6] |= uint64_t(1) << (value & 63);
+		}
+		Array = {};
+	}
+	void RoaringBitmap::Container::ToArray()
+	{
+		Array.clear();
+		Array.reserve(Cardinality);
+		for (size_t i = 0; i < BitmapWords; i++)
+		{
+			for (uint64_t word = Bits[i]; word != 0; word &= word - 1)
+			{
+				Array.push_back(static_cast<uint16_t>(i * 64 + std::countr_zero(word)));
+			}
+		}
+		Bits = {};
+	}
+
+	auto RoaringBitmap::Combine(const Container& left, const Container& right, Operation operation) -> Container
+	{
+		Container result;
+		result.Key = left.Key;
+
+		if (!left.IsBitmap() && !right.IsBitmap())
+		{
+			// Sorted array merges
+			switch (operation)
+			{
+				case Operation::And:
+				{
+					result.Array.reserve(std::min(left.Array.size(), right.Array.size()));
+					std::set_intersection(left.Array.begin(), left.Array.end(), right.Array.begin(), right.Array.end(), std::back_inserter(result.Array));
+					break;
+				}
+				case Operation::Or:
+				{
+					result.Array.reserve(left.Array.size() + right.Array.size());
+					std::set_union(left.Array.begin(), left.Array.end(), right.Array.begin(), right.Array.end(), std::back_inserter(result.Array));
+					break;
+				}
+				case Operation::AndNot:
+				{
+					result.Array.reserve(left.Array.size());
+					std::set_difference(left.Array.begin(), left.Array.end(), right.Array.begin(), right.Array.end(), std::back_inserter(result.Array));
+					break;
+				}
+			}
+			result.Cardinality = static_cast<uint32_t>(result.Array.size());
+			if (result.Cardinality > ArrayLimit)
+			{
+				result.ToBitmap();
+			}
+			return result;
+		}
+		else if (left.IsBitmap() && right.IsBitmap())
+		{
+			result.Bits.resize(BitmapWords);
+			switch (operation)
+			{
+				case Operation::And:
+				{
+					result.Cardinality = CombineBits<AndWords>(left.Bits.data(), right.Bits.data(), result.Bits.data());
+					break;
+				}
+				case Operation::Or:
+				{
+					result.Cardinality = CombineBits<OrWords>(left.Bits.data(), right.Bits.data(), result.Bits.data());
+					break;
+				}
+				case Operation::AndNot:
+				{
+					result.Cardinality = CombineBits<AndNotWords>(left.Bits.data(), right.Bits.data(), result.Bits.data());
+					break;
+				}
+			}
+		}
+		else
+		{
+			// One array and one bitmap, the array is tested against or applied to the bitmap
+			const Container& array = left.IsBitmap() ? right : left;
+			const Container& bitmap = left.IsBitmap() ? left : right;
+
+			if (operation == Operation::And || (operation == Operation::AndNot && !left.IsBitmap()))
+			{
+				const bool keepSet = operation == Operation::And;
+				result.Array.reserve(array.Array.size());
+				for (uint16_t value: array.Array)
+				{
+					if (TestBit(bitmap.Bits, value) == keepSet)
+					{
+						result.Array.push_back(value);
+					}
+				}
+				result.Cardinality = static_cast<uint32_t>(result.Array.size());
+				return result;
+			}
+			else
+			{
+				// Or, or a bitmap minus an array
+				const bool set = operation == Operation::Or;
+				result.Bits = bitmap.Bits;
+				result.Cardinality = bitmap.Cardinality;
+				for (uint16_t value: array.Array)
+				{
+					uint64_t& word = result.Bits[value >> 6];
+					const uint64_t mask = uint64_t(1) << (value & 63);
+					if (((word & mask) != 0) != set)
+					{
+						word ^= mask;
+						if (set)
+						{
+							result.Cardinality++;
+						}
+						else
+						{
+							result.Cardinality--;
+						}
+					}
+				}
+			}
+		}
+
+		if (result.Cardinality <= ArrayLimit)
+		{
+			result.ToArray();
+		}
+		return result;
+	}
+	RoaringBitmap RoaringBitmap::Combine(const RoaringBitmap& left, const RoaringBitmap& right, Operation operation)
+	{
+		RoaringBitmap result;
+		result.m_Containers.reserve(operation == Operation::Or ? left.m_Containers.size() + right.m_Containers.size() : left.m_Containers.size());
+
+		// Containers of either side that have no counterpart are copied as they are, or skipped
+		const bool keepLeft = operation != Operation::And;
+		const bool keepRight = operation == Operation::Or;
+
+		auto leftIt = left.m_Containers.begin();
+		auto rightIt = right.m_Containers.begin();
+		while (leftIt != left.m_Containers.end() && rightIt != right.m_Containers.end())
+		{
+			if (leftIt->Key == rightIt->Key)
+			{
+				Container container = Combine(*leftIt, *rightIt, operation);
+				if (container.Cardinality != 0)
+				{
+					result.m_Containers.push_back(std::move(container));
+				}
+				++leftIt;
+				++rightIt;
+			}
+			else if (leftIt->Key < rightIt->Key)
+			{
+				if (keepLeft)
+				{
+					result.m_Containers.push_back(*leftIt);
+				}
+				++leftIt;
+			}
+			else
+			{
+				if (keepRight)
+				{
+					result.m_Containers.push_back(*rightIt);
+				}
+				++rightIt;
+			}
+		}
+		if (keepLeft)
+		{
+			result.m_Containers.insert(result.m_Containers.end(), leftIt, left.m_Containers.end());
+		}
+		if (keepRight)
+		{
+			result.m_Containers.insert(result.m_Containers.end(), rightIt, right.m_Containers.end());
+		}
+		return result;
+	}
+
+	auto RoaringBitmap::GetContainer(uint16_t key) -> Container&
+	{
+		if (m_Containers.empty() || m_Containers.back().Key < key)
+		{
+			m_Containers.emplace_back().Key = key;
+			return m_Containers.back();
+		}
+		else if (m_Containers.back().Key == key)
+		{
+			return m_Containers.back();
+		}
+
+		auto it = std::lower_bound(m_Containers.begin(), m_Containers.end(), key, [](const Container& container, uint16_t key)
+		{
+			return container.Key < key;
+		});
+		if (it == m_Containers.end() || it->Key != key)
+		{
+			it = m_Containers.emplace(it);
+			it->Key = key;
+		}
+		return *it;
+	}
+
+	RoaringBitmap RoaringBitmap::FromRange(uint32_t begin, uint32_t end)
+	{
+		RoaringBitmap result;
+		for (uint64_t value = begin; value < end;)
+		{
+			const uint64_t containerEnd = std::min<uint64_t>((value|0xFFFF) + 1, end);
+
+			Container& container = result.m_Containers.emplace_back();
+			container.Key = static_cast<uint16_t>(value >> 16);
+			container.Cardinality = static_cast<uint32_t>(containerEnd - value);
+			if (container.Cardinality > ArrayLimit)
+			{
+				container.Bits.assign(BitmapWords, 0);
+				for (uint64_t i = value; i < containerEnd; i++)
+				{
+					container.Bits[(i & 0xFFFF) >> 6] |= uint64_t(1) << (i & 63);
+				}
+			}
+			else
+			{
+				container.Array.reserve(container.Cardinality);
+				for (uint64_t i = value; i < containerEnd; i++)
+				{
+					container.Array.push_back(static_cast<uint16_t>(i));
+				}
+			}
+			value = containerEnd;
+		}
+		return result;
+	}
+
+	void RoaringBitmap::Add(uint32_t value)
+	{
+		Container& container = GetContainer(static_cast<uint16_t>(value >> 16));
+		const uint16_t low = static_cast<uint16_t>(value);
+
+		if (container.IsBitmap())
+		{
+			uint64_t& word = container.Bits[low >> 6];
+			const uint64_t mask = uint64_t(1) << (low & 63);
+			if ((word & mask) == 0)
+			{
+				word |= mask;
+				container.Cardinality++;
+			}
+			return;
+		}
+
+		if (container.Array.empty() || container.Array.back() < low)
+		{
+			container.Array.push_back(low);
+		}
+		else
+		{
+			auto it = std::lower_bound(container.Array.begin(), container.Array.end(), low);
+			if (*it == low)
+			{
+				return;
+			}
+			container.Array.insert(it, low);
+		}
+
+		container.Cardinality++;
+		if (container.Cardinality > ArrayLimit)
+		{
+			container.ToBitmap();
+		}
+	}
+	bool RoaringBitmap::Contains(uint32_t value) const noexcept
+	{
+		const uint16_t key = static_cast<uint16_t>(value >> 16);
+		auto it = std::lower_bound(m_Containers.begin(), m_Containers.end(), key, [](const Container& container, uint16_t key)
+		{
+			return container.Key < key;
+		});
+		if (it == m_Containers.end() || it->Key != key)
+		{
+			return false;
+		}
+
+		const uint16_t low = static_cast<uint16_t>(value);
+		return it->IsBitmap() ? TestBit(it->Bits, low) : std::binary_search(it->Array.begin(), it->Array.end(), low);
+	}
+
+	size_t RoaringBitmap::GetCardinality() const noexcept
+	{
+		size_t cardinality = 0;
+		for (const Container& container: m_Containers)
+		{
+			cardinality += container.Cardinality;
+		}
+		return cardinality;
+	}
+	size_t RoaringBitmap::GetMemoryUsage() const noexcept
+	{
+		size_t size = m_Containers.capacity() * sizeof(Container);
+		for (const Container& container: m_Containers)
+		{
+			size += container.Array.capacity() * sizeof(uint16_t) + container.Bits.capacity() * sizeof(uint64_t);
+		}
+		return size;
+	}
+
+	std::vector<uint32_t> RoaringBitmap::ToVector() const
+	{
+		std::vector<uint32_t> values;
+		values.reserve(GetCardinality());
+		ForEach([&](uint32_t value)
+		{
+			values.push_back(value);
+		});
+		return values;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// Compressed set of 32-bit integers in the roaring bitmap layout.
+	//
+	// Values are split by their upper 16 bits into containers. A container with up to 4096 values is a sorted array
+	// of the lower 16 bits, a fuller one is a plain 8 KiB bitmap. Sparse sets stay small and dense ones are combined
+	// a machine word (or a SIMD register) at a time. Set operations produce new bitmaps.
+	class RoaringBitmap final
+	{
+		public:
+			static constexpr size_t ArrayLimit = 4096;
+			static constexpr size_t BitmapWords = 65536 / 64;
+
+		private:
+			struct Container final
+			{
+				uint16_t Key = 0;
+				uint32_t Cardinality = 0;
+
+				// Only one of them is used
+				std::vector<uint16_t> Array;
+				std::vector<uint64_t> Bits;
+
+				bool IsBitmap() const noexcept
+				{
+					return !Bits.empty();
+				}
+				void ToBitmap();
+				void ToArray();
+			};
+			enum class Operation
+			{
+				And,
+				Or,
+				AndNot,
+			};
+
+		private:
+			std::vector<Container> m_Containers;
+
+		private:
+			static Container Combine(const Container& left, const Container& right, Operation operation);
+			static RoaringBitmap Combine(const RoaringBitmap& left, const RoaringBitmap& right, Operation operation);
+
+			Container& GetContainer(uint16_t key);
+
+		public:
+			// Every value in [begin, end)
+			static RoaringBitmap FromRange(uint32_t begin, uint32_t end);
+
+			static RoaringBitmap And(const RoaringBitmap& left, const RoaringBitmap& right)
+			{
+				return Combine(left, right, Operation::And);
+			}
+			static RoaringBitmap Or(const RoaringBitmap& left, const RoaringBitmap& right)
+			{
+				return Combine(left, right, Operation::Or);
+			}
+			static RoaringBitmap AndNot(const RoaringBitmap& left, const RoaringBitmap& right)
+			{
+				return Combine(left, right, Operation::AndNot);
+			}
+
+		public:
+			// Values added in ascending order are appended without any search
+			void Add(uint32_t value);
+			bool Contains(uint32_t value) const noexcept;
+
+			bool IsEmpty() const noexcept
+			{
+				return m_Containers.empty();
+			}
+			size_t GetCardinality() const noexcept;
+			size_t GetMemoryUsage() const noexcept;
+
+			std::vector<uint32_t> ToVector() const;
+
+			// Calls 'func(value)' in ascending order
+			template<class TFunc>
+			void ForEach(TFunc&& func) const
+			{
+				for (const Container& container: m_Containers)
+				{
+					const uint32_t high = static_cast<uint32_t>(container.Key) << 16;
+					if (container.IsBitmap())
+					{
+						for (size_t i = 0; i < BitmapWords; i++)
+						{
+							for (uint64_t word = container.Bits[i]; word != 0; word &= word - 1)
+							{
+								func(high|static_cast<uint32_t>(i * 64 + std::countr_zero(word)));
+							}
+						}
+					}
+					else
+					{
+						for (uint16_t low: container.Array)
+						{
+							func(high|low);
+						}
+					}
+				}
+			}
+	};
+}
@@ -0,0 +1,193 @@
+#include "stdafx.h"
+#include "StringPool.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	constexpr char ToLower(char c) noexcept
+	{
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+	}
+	constexpr size_t AlignUp(size_t value) noexcept
+	{
+		return (value + 3) & ~size_t(3);
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	bool StringPool::Equals(std::string_view left, std::string_view right) noexcept
+	{
+		return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(), [](char a, char b)
+		{
+			return ToLower(a) == ToLower(b);
+		});
+	}
+	uint32_t StringPool::Hash(std::string_view value) noexcept
+	{
+		// FNV-1a over lowercase bytes
+		uint32_t hash = 2166136261u;
+		for (char c: value)
+		{
+			hash ^= static_cast<uint8_t>(ToLower(c));
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	size_t StringPool::FindSlot(const Shard& shard, std::string_view value, uint32_t hash) const noexcept
+	{
+		const size_t mask = shard.Handles.size() - 1;
+		size_t slot = hash & mask;
+		while (shard.Handles[slot] != EmptyHandle && (shard.Hashes[slot] != hash || !Equals(Get(shard.Handles[slot]), value)))
+		{
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+	void StringPool::Rehash(Shard& shard, size_t capacity) const
+	{
+		std::vector<THandle> handles(capacity, EmptyHandle);
+		std::vector<uint32_t> hashes(capacity, 0);
+		handles.swap(shard.Handles);
+		hashes.swap(shard.Hashes);
+
+		for (size_t i = 0; i < handles.size(); i++)
+		{
+			if (handles[i] != EmptyHandle)
+			{
+				// Stored strings are unique, so the first free slot is the right one
+				size_t slot = hashes[i] & (capacity - 1);
+				while (shard.Handles[slot] != EmptyHandle)
+				{
+					slot = (slot + 1) & (capacity - 1);
+				}
+				shard.Handles[slot] = handles[i];
+				shard.Hashes[slot] = hashes[i];
+			}
+		}
+	}
+	auto StringPool::Store(Shard& shard, size_t shardIndex, std::string_view value) -> THandle
+	{
+		// Length-prefixed, 4-byte aligned. Blocks start at offset 4, so no string gets the empty handle.
+		const size_t entrySize = AlignUp(sizeof(uint32_t) + value.size());
+		if (shard.BlockSize - shard.BlockOffset < entrySize)
+		{
+			if (shard.OwnedBlocks.size() == MaxBlocks)
+			{
+				throw std::length_error("StringPool: arena is full");
+			}
+
+			// Blocks grow from 4 KiB to 1 MiB, so small pools stay small
+			const size_t regularSize = std::min(MinBlockSize << std::min<size_t>(shard.OwnedBlocks.size(), 8), MaxBlockSize);
+			shard.BlockSize = std::max(regularSize, entrySize + sizeof(uint32_t));
+			shard.BlockOffset = sizeof(uint32_t);
+			shard.BlockMemory += shard.BlockSize;
+			shard.OwnedBlocks.push_back(std::make_unique_for_overwrite<std::byte[]>(shard.BlockSize));
+			shard.Blocks[shard.OwnedBlocks.size() - 1].store(shard.OwnedBlocks.back().get(), std::memory_order_release);
+		}
+
+		const size_t blockIndex = shard.OwnedBlocks.size() - 1;
+		std::byte* entry = shard.OwnedBlocks.back().get() + shard.BlockOffset;
+		const uint32_t length = static_cast<uint32_t>(value.size());
+		std::memcpy(entry, &length, sizeof(length));
+		std::memcpy(entry + sizeof(length), value.data(), value.size());
+
+		const THandle handle = static_cast<THandle>(shardIndex << 28|blockIndex << 18|shard.BlockOffset / 4);
+
+		// Offsets past 1 MiB can't be encoded, a block made for a single big string is full right away
+		shard.BlockOffset = shard.BlockSize > MaxBlockSize ? shard.BlockSize : shard.BlockOffset + entrySize;
+		shard.BytesStored += value.size();
+		return handle;
+	}
+
+	StringPool::StringPool()
+		:m_Shards(std::make_unique<Shard[]>(ShardCount))
+	{
+	}
+	StringPool::~StringPool() = default;
+
+	auto StringPool::Intern(std::string_view value) -> THandle
+	{
+		if (value.empty())
+		{
+			return EmptyHandle;
+		}
+		m_Lookups++;
+
+		const uint32_t hash = Hash(value);
+		const size_t shardIndex = hash >> 28;
+		Shard& shard = m_Shards[shardIndex];
+		std::lock_guard lock(shard.Mutex);
+
+		// Keep the load factor under 3/4
+		if ((shard.Count + 1) * 4 > shard.Handles.size() * 3)
+		{
+			Rehash(shard, std::max<size_t>(shard.Handles.size() * 2, 64));
+		}
+
+		const size_t slot = FindSlot(shard, value, hash);
+		if (shard.Handles[slot] == EmptyHandle)
+		{
+			shard.Handles[slot] = Store(shard, shardIndex, value);
+			shard.Hashes[slot] = hash;
+			shard.Count++;
+		}
+		return shard.Handles[slot];
+	}
+	auto StringPool::Find(std::string_view value) const -> std::optional<THandle>
+	{
+		if (value.empty())
+		{
+			return EmptyHandle;
+		}
+		m_Lookups++;
+
+		const uint32_t hash = Hash(value);
+		Shard& shard = m_Shards[hash >> 28];
+		std::lock_guard lock(shard.Mutex);
+
+		if (shard.Count != 0)
+		{
+			const size_t slot = FindSlot(shard, value, hash);
+			if (shard.Handles[slot] != EmptyHandle)
+			{
+				return shard.Handles[slot];
+			}
+		}
+		return {};
+	}
+	std::string_view StringPool::Get(THandle handle) const noexcept
+	{
+		if (handle == EmptyHandle)
+		{
+			return {};
+		}
+
+		const Shard& shard = m_Shards[handle >> 28];
+		const std::byte* entry = shard.Blocks[(handle >> 18) & (MaxBlocks - 1)].load(std::memory_order_acquire) + (handle & 0x3FFFF) * 4;
+
+		uint32_t length = 0;
+		std::memcpy(&length, entry, sizeof(length));
+		return {reinterpret_cast<const char*>(entry + sizeof(length)), length};
+	}
+
+	StringPoolStats StringPool::GetStats() const
+	{
+		StringPoolStats stats;
+		for (size_t i = 0; i < ShardCount; i++)
+		{
+			Shard& shard = m_Shards[i];
+			std::lock_guard lock(shard.Mutex);
+
+			stats.Strings += shard.Count;
+			stats.BytesStored += shard.BytesStored;
+			stats.MemoryUsage += shard.Handles.capacity() * sizeof(THandle) + shard.Hashes.capacity() * sizeof(uint32_t);
+			stats.MemoryUsage += shard.OwnedBlocks.capacity() * sizeof(void*) + shard.BlockMemory;
+		}
+		stats.MemoryUsage += sizeof(Shard) * ShardCount;
+		stats.Lookups = m_Lookups;
+		return stats;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	struct StringPoolStats final
+	{
+		size_t Strings = 0;
+		size_t Lookups = 0;
+		size_t BytesStored = 0;
+		size_t MemoryUsage = 0;
+	};
+
+	// Stores each distinct string once and hands out 32-bit handles for them. Strings that differ only in ASCII case
+	// are the same string, the first spelling seen is kept.
+	//
+	// Like 'ModuleInfoCache' it's split into independently locked shards. Strings are copied into arena blocks that are
+	// never moved or freed before the pool itself, and a handle encodes the shard, block and offset of its string, so
+	// 'Get' is lock-free and equal strings can be compared by handle alone.
+	class StringPool final
+	{
+		public:
+			using THandle = uint32_t;
+
+			// Handle of the empty string
+			static constexpr THandle EmptyHandle = 0;
+
+			// Compares ignoring ASCII case, what the games do for file names
+			static bool Equals(std::string_view left, std::string_view right) noexcept;
+			static uint32_t Hash(std::string_view value) noexcept;
+
+		private:
+			// Handle layout: 4 bits of shard, 10 bits of block and 18 bits of offset in 4-byte units. Strings too long
+			// for a regular block get a block of their own.
+			static constexpr size_t ShardCount = 16;
+			static constexpr size_t MaxBlocks = 1024;
+			static constexpr size_t MaxBlockSize = 1024 * 1024;
+			static constexpr size_t MinBlockSize = 4 * 1024;
+
+			struct Shard final
+			{
+				std::mutex Mutex;
+
+				// Arena blocks, published for lock-free reads
+				std::array<std::atomic<const std::byte*>, MaxBlocks> Blocks = {};
+				std::vector<std::unique_ptr<std::byte[]>> OwnedBlocks;
+				size_t BlockSize = 0;
+				size_t BlockOffset = 0;
+				size_t BlockMemory = 0;
+
+				// Open addressing table of handles with their hashes, so probing rarely touches the strings
+				std::vector<THandle> Handles;
+				std::vector<uint32_t> Hashes;
+				size_t Count = 0;
+				size_t BytesStored = 0;
+			};
+
+		private:
+			std::unique_ptr<Shard[]> m_Shards;
+			mutable std::atomic<size_t> m_Lookups = 0;
+
+		private:
+			size_t FindSlot(const Shard& shard, std::string_view value, uint32_t hash) const noexcept;
+			void Rehash(Shard& shard, size_t capacity) const;
+			THandle Store(Shard& shard, size_t shardIndex, std::string_view value);
+
+		public:
+			StringPool();
+			StringPool(const StringPool&) = delete;
+			~StringPool();
+
+		public:
+			// Returns the handle of an equal string, storing the string first if it's new
+			THandle Intern(std::string_view value);
+			std::optional<THandle> Find(std::string_view value) const;
+
+			// The handle must come from this pool
+			std::string_view Get(THandle handle) const noexcept;
+
+			StringPoolStats GetStats() const;
+
+		public:
+			StringPool& operator=(const StringPool&) = delete;
+	};
+}
@@ -0,0 +1,406 @@
+#include "stdafx.h"
+#include "StringTable.h"
+#include "StringPool.h"
+#include <algorithm>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+
+	constexpr size_t HeaderSize = 2 * sizeof(uint32_t);
+	constexpr size_t EntrySize = 2 * sizeof(uint32_t);
+
+	uint32_t LoadU32(const std::byte* data) noexcept
+	{
+		uint32_t value = 0;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Existing entry of the directory named like 'name' ignoring case, or the name itself
+	std::filesystem::path FindFile(const std::filesystem::path& directory, const std::filesystem::path& name)
+	{
+		std::error_code error;
+		std::filesystem::path path = directory / name;
+		if (std::filesystem::exists(path, error))
+		{
+			return path;
+		}
+
+		const std::u8string expected = name.u8string();
+		for (const auto& entry: std::filesystem::directory_iterator(directory, error))
+		{
+			const std::u8string actual = entry.path().filename().u8string();
+			if (StringPool::Equals({reinterpret_cast<const char*>(actual.data()), actual.size()}, {reinterpret_cast<const char*>(expected.data()), expected.size()}))
+			{
+				return entry.path();
+			}
+		}
+		return path;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::string_view GetStringTableExtension(StringTableType type) noexcept
+	{
+		switch (type)
+		{
+			case StringTableType::Strings:
+			{
+				return "STRINGS";
+			}
+			case StringTableType::DLStrings:
+			{
+				return "DLSTRINGS";
+			}
+			case StringTableType::ILStrings:
+			{
+				return "ILSTRINGS";
+			}
+		}
+		return {};
+	}
+	std::optional<StringTableType> GetStringTableType(const std::filesystem::path& path) noexcept
+	{
+		try
+		{
+			const std::u8string extension = path.extension().u8string();
+			const std::string_view value = {reinterpret_cast<const char*>(extension.data()), extension.size()};
+			for (StringTableType type: StringTableTypes)
+			{
+				if (value.size() == GetStringTableExtension(type).size() + 1 && StringPool::Equals(value.substr(1), GetStringTableExtension(type)))
+				{
+					return type;
+				}
+			}
+		}
+		catch (...)
+		{
+		}
+		return {};
+	}
+
+	template<class TFunc>
+	std::optional<size_t> StringTable::FindEntry(uint32_t id, TFunc&& getID) const noexcept
+	{
+		// The sample narrows the search to one block, which is then searched with 'getID'
+		const size_t block = std::upper_bound(m_Samples.begin(), m_Samples.end(), id) - m_Samples.begin();
+		if (block == 0)
+		{
+			return {};
+		}
+
+		size_t first = (block - 1) * SampleInterval;
+		size_t count = std::min<size_t>(SampleInterval, m_Count - first);
+		while (count != 0)
+		{
+			const size_t half = count / 2;
+			if (getID(first + half) < id)
+			{
+				first += half + 1;
+				count -= half + 1;
+			}
+			else
+			{
+				count = half;
+			}
+		}
+		if (first < m_Count && getID(first) == id)
+		{
+			return first;
+		}
+		return {};
+	}
+	std::optional<uint32_t> StringTable::FindOffset(uint32_t id) const noexcept
+	{
+		if (!m_SortedIndex.empty())
+		{
+			if (auto index = FindEntry(id, [&](size_t i)
+			{
+				return static_cast<uint32_t>(m_SortedIndex[i] >> 32);
+			}))
+			{
+				return static_cast<uint32_t>(m_SortedIndex[*index]);
+			}
+			return {};
+		}
+
+		// Searched in the mapping itself
+		const std::byte* directory = m_Directory.data();
+		if (auto index = FindEntry(id, [&](size_t i)
+		{
+			return LoadU32(directory + i * EntrySize);
+		}))
+		{
+			return LoadU32(directory + *index * EntrySize + sizeof(uint32_t));
+		}
+		return {};
+	}
+
+	bool StringTable::Open(const std::filesystem::path& path)
+	{
+		if (auto type = GetStringTableType(path))
+		{
+			return Open(path, *type);
+		}
+		Close();
+		return false;
+	}
+	bool StringTable::Open(const std::filesystem::path& path, StringTableType type)
+	{
+		Close();
+		if (!m_Source.Open(path) || !Index(m_Source.GetData(), type))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+	bool StringTable::Load(std::vector<std::byte> data, StringTableType type)
+	{
+		Close();
+		m_Buffer = std::move(data);
+		if (!Index(m_Buffer, type))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+	bool StringTable::Index(std::span<const std::byte> data, StringTableType type)
+	{
+		if (data.size() < HeaderSize)
+		{
+			return false;
+		}
+
+		// Directory and data have to fit, trailing bytes are tolerated
+		const uint64_t count = LoadU32(data.data());
+		const uint64_t dataSize = LoadU32(data.data() + sizeof(uint32_t));
+		if (HeaderSize + count * EntrySize + dataSize > data.size())
+		{
+			return false;
+		}
+
+		m_Type = type;
+		m_Count = static_cast<uint32_t>(count);
+		m_Directory = data.subspan(HeaderSize, count * EntrySize);
+		m_Data = data.subspan(HeaderSize + count * EntrySize, dataSize);
+
+		// Tables written by the games and the CK are sorted, other tools don't always bother
+		bool sorted = true;
+		for (size_t i = 1; i < m_Count && sorted; i++)
+		{
+			sorted = LoadU32(m_Directory.data() + (i - 1) * EntrySize) <= LoadU32(m_Directory.data() + i * EntrySize);
+		}
+		if (!sorted)
+		{
+			m_SortedIndex.resize(m_Count);
+			for (size_t i = 0; i < m_Count; i++)
+			{
+				m_SortedIndex[i] = static_cast<uint64_t>(LoadU32(m_Directory.data() + i * EntrySize)) << 32|LoadU32(m_Directory.data() + i * EntrySize + sizeof(uint32_t));
+			}
+			std::stable_sort(m_SortedIndex.begin(), m_SortedIndex.end(), [](uint64_t left, uint64_t right)
+			{
+				return (left >> 32) < (right >> 32);
+			});
+		}
+
+		m_Samples.reserve((m_Count + SampleInterval - 1) / SampleInterval);
+		for (size_t i = 0; i < m_Count; i += SampleInterval)
+		{
+			m_Samples.push_back(sorted ? LoadU32(m_Directory.data() + i * EntrySize) : static_cast<uint32_t>(m_SortedIndex[i] >> 32));
+		}
+		return true;
+	}
+	void StringTable::Close() noexcept
+	{
+		m_Source.Close();
+		m_Buffer = {};
+		m_Directory = {};
+		m_Data = {};
+		m_Count = 0;
+		m_SortedIndex = {};
+		m_Samples = {};
+	}
+
+	StringTableStats StringTable::GetStats() const noexcept
+	{
+		StringTableStats stats;
+		stats.Count = m_Count;
+		stats.MappedSize = m_Source.GetData().size();
+		stats.ExtractedSize = m_Buffer.size();
+		stats.IndexMemory = m_SortedIndex.capacity() * sizeof(uint64_t) + m_Samples.capacity() * sizeof(uint32_t);
+		stats.Sorted = m_SortedIndex.empty();
+		return stats;
+	}
+
+	std::optional<std::string_view> StringTable::Find(uint32_t id) const noexcept
+	{
+		if (auto offset = FindOffset(id))
+		{
+			return GetText(*offset);
+		}
+		return {};
+	}
+	std::optional<std::string_view> StringTable::GetText(uint32_t offset) const noexcept
+	{
+		const char* data = reinterpret_cast<const char*>(m_Data.data());
+		if (m_Type == StringTableType::Strings)
+		{
+			if (offset < m_Data.size())
+			{
+				if (const void* end = std::memchr(data + offset, 0, m_Data.size() - offset))
+				{
+					return std::string_view(data + offset, static_cast<const char*>(end));
+				}
+			}
+		}
+		else if (static_cast<uint64_t>(offset) + sizeof(uint32_t) <= m_Data.size())
+		{
+			// The length counts the terminating null
+			const uint64_t length = LoadU32(m_Data.data() + offset);
+			if (offset + sizeof(uint32_t) + length <= m_Data.size())
+			{
+				std::string_view text(data + offset + sizeof(uint32_t), static_cast<size_t>(length));
+				if (!text.empty() && text.back() == '\0')
+				{
+					text.remove_suffix(1);
+				}
+				return text;
+			}
+		}
+		return {};
+	}
+
+	std::filesystem::path StringTableCache::GetTablePath(const std::filesystem::path& pluginPath, std::string_view language, StringTableType type)
+	{
+		std::u8string name = pluginPath.stem().u8string();
+		name += u8'_';
+		name.append(language.begin(), language.end());
+		name += u8'.';
+		name.append(GetStringTableExtension(type).begin(), GetStringTableExtension(type).end());
+
+		return FindFile(FindFile(pluginPath.parent_path(), "Strings"), name);
+	}
+
+	std::shared_ptr<const StringTable> StringTableCache::Get(const std::filesystem::path& pluginPath, std::string_view language, StringTableType type)
+	{
+		// Paths and languages are case-insensitive, so are the keys
+		const std::u8string path = pluginPath.u8string();
+		std::string key(path.begin(), path.end());
+		key += '|';
+		key += language;
+		key += '|';
+		key += GetStringTableExtension(type);
+		std::transform(key.begin(), key.end(), key.begin(), [](char c)
+		{
+			return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+		});
+
+		{
+			std::lock_guard lock(m_Mutex);
+			if (auto it = m_Tables.find(key); it != m_Tables.end())
+			{
+				m_Hits++;
+				return it->second;
+			}
+		}
+
+		// Mapped outside of the lock, if two threads race for the same table the first one stored wins
+		std::shared_ptr<StringTable> table = std::make_shared<StringTable>();
+		if (!table->Open(GetTablePath(pluginPath, language, type), type))
+		{
+			table = nullptr;
+
+			std::vector<std::shared_ptr<const Archive>> archives;
+			{
+				std::lock_guard lock(m_Mutex);
+				archives = m_Archives;
+			}
+
+			const std::u8string stem = pluginPath.stem().u8string();
+			std::string archivePath = "strings\\";
+			archivePath.append(stem.begin(), stem.end());
+			archivePath += '_';
+			archivePath += language;
+			archivePath += '.';
+			archivePath += GetStringTableExtension(type);
+			for (const auto& archive: archives)
+			{
+				std::vector<std::byte> data;
+				if (archive->Extract(archivePath, data) == ParseStatus::Success)
+				{
+					table = std::make_shared<StringTable>();
+					if (!table->Load(std::move(data), type))
+					{
+						table = nullptr;
+					}
+					break;
+				}
+			}
+		}
+
+		std::lock_guard lock(m_Mutex);
+		m_Loads++;
+		return m_Tables.emplace(std::move(key), std::move(table)).first->second;
+	}
+	std::optional<std::string_view> StringTableCache::Find(const std::filesystem::path& pluginPath, std::string_view language, StringTableType type, uint32_t id)
+	{
+		if (auto table = Get(pluginPath, language, type))
+		{
+			return table->Find(id);
+		}
+		return {};
+	}
+	std::optional<std::string_view> StringTableCache::Find(const std::filesystem::path& pluginPath, std::string_view language, uint32_t id)
+	{
+		for (StringTableType type: StringTableTypes)
+		{
+			if (auto text = Find(pluginPath, language, type, id))
+			{
+				return text;
+			}
+		}
+		return {};
+	}
+
+	void StringTableCache::AddArchive(std::shared_ptr<const Archive> archive)
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Archives.emplace_back(std::move(archive));
+	}
+
+	void StringTableCache::Clear()
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Tables.clear();
+		m_Hits = 0;
+		m_Loads = 0;
+	}
+	StringTableCacheStats StringTableCache::GetStats() const
+	{
+		std::lock_guard lock(m_Mutex);
+
+		StringTableCacheStats stats;
+		stats.Hits = m_Hits;
+		stats.Loads = m_Loads;
+		for (const auto& [key, table]: m_Tables)
+		{
+			if (table)
+			{
+				const StringTableStats tableStats = table->GetStats();
+				stats.Tables++;
+				stats.MappedSize += tableStats.MappedSize;
+				stats.ExtractedSize += tableStats.ExtractedSize;
+				stats.IndexMemory += tableStats.IndexMemory;
+			}
+			else
+			{
+				stats.Missing++;
+			}
+		}
+		return stats;
+	}
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include "Archive.h"
+#include "ByteSource.h"
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace BethesdaModule::Core
+{
+	// Localized plugins store string IDs instead of text, the text is in three tables next to the plugin:
+	// 'Strings/<plugin>_<language>.STRINGS' for names, '.DLSTRINGS' for descriptions and '.ILSTRINGS' for dialogue.
+	enum class StringTableType
+	{
+		Strings,
+		DLStrings,
+		ILStrings,
+	};
+	inline constexpr StringTableType StringTableTypes[] = {StringTableType::Strings, StringTableType::DLStrings, StringTableType::ILStrings};
+
+	std::string_view GetStringTableExtension(StringTableType type) noexcept;
+	std::optional<StringTableType> GetStringTableType(const std::filesystem::path& path) noexcept;
+
+	struct StringTableStats final
+	{
+		size_t Count = 0;
+		size_t MappedSize = 0;
+
+		// Size of the table if it was extracted from an archive rather than mapped
+		size_t ExtractedSize = 0;
+
+		// Heap memory of the sampled IDs and of the sorted copy of the directory if the file isn't sorted itself
+		size_t IndexMemory = 0;
+		bool Sorted = false;
+	};
+
+	// Read-only view of a memory-mapped string table.
+	//
+	// The file is a count and a data size, a directory of ID and offset pairs and then the string data. Strings are
+	// null-terminated in '.STRINGS' and additionally length-prefixed in the other two. Lookups binary-search the
+	// directory in place and return views into the mapping, so nothing is copied. Directories that aren't sorted by
+	// ID are copied and sorted once on open.
+	class StringTable final
+	{
+		private:
+			// Every 64th ID is copied to the heap, a small array that stays in cache and leaves only the last few
+			// steps of a search to the mapped directory
+			static constexpr size_t SampleInterval = 64;
+
+		private:
+			MappedByteSource m_Source;
+			std::vector<std::byte> m_Buffer;
+			StringTableType m_Type = StringTableType::Strings;
+			std::span<const std::byte> m_Directory;
+			std::span<const std::byte> m_Data;
+			uint32_t m_Count = 0;
+
+			// ID in the high half and offset in the low one
+			std::vector<uint64_t> m_SortedIndex;
+			std::vector<uint32_t> m_Samples;
+
+		private:
+			template<class TFunc>
+			std::optional<size_t> FindEntry(uint32_t id, TFunc&& getID) const noexcept;
+			std::optional<uint32_t> FindOffset(uint32_t id) const noexcept;
+			bool Index(std::span<const std::byte> data, StringTableType type);
+
+		public:
+			StringTable() noexcept = default;
+			StringTable(const StringTable&) = delete;
+			StringTable(StringTable&&) noexcept = default;
+
+		public:
+			// Type is taken from the extension when it's not given. Fails for malformed tables.
+			bool Open(const std::filesystem::path& path);
+			bool Open(const std::filesystem::path& path, StringTableType type);
+
+			// Takes a table extracted from an archive
+			bool Load(std::vector<std::byte> data, StringTableType type);
+
+			void Close() noexcept;
+			bool IsOpen() const noexcept
+			{
+				return m_Directory.data() != nullptr || m_Data.data() != nullptr;
+			}
+
+			StringTableType GetType() const noexcept
+			{
+				return m_Type;
+			}
+			size_t GetCount() const noexcept
+			{
+				return m_Count;
+			}
+			StringTableStats GetStats() const noexcept;
+
+			// Views stay valid while the table is open. Text is in the encoding of the game's language.
+			std::optional<std::string_view> Find(uint32_t id) const noexcept;
+
+			// Calls 'func(id, text)' for every entry in directory order, entries that point out of the data are skipped
+			template<class TFunc>
+			void ForEach(TFunc&& func) const
+			{
+				for (uint32_t i = 0; i < m_Count; i++)
+				{
+					uint32_t entry[2] = {};
+					std::memcpy(entry, m_Directory.data() + i * sizeof(entry), sizeof(entry));
+					if (auto text = GetText(entry[1]))
+					{
+						func(entry[0], *text);
+					}
+				}
+			}
+			std::optional<std::string_view> GetText(uint32_t offset) const noexcept;
+
+		public:
+			StringTable& operator=(const StringTable&) = delete;
+			StringTable& operator=(StringTable&&) noexcept = default;
+	};
+
+	struct StringTableCacheStats final
+	{
+		size_t Tables = 0;
+		size_t Missing = 0;
+		size_t Hits = 0;
+		size_t Loads = 0;
+		size_t MappedSize = 0;
+		size_t ExtractedSize = 0;
+		size_t IndexMemory = 0;
+	};
+
+	// Tables of every plugin and language asked for, mapped on first use and kept until 'Clear'. Missing tables are
+	// remembered too, so plugins without them aren't probed again on every lookup. Tables that aren't in the
+	// 'Strings' folder are looked up in the added archives, in the order they were added, and extracted from there.
+	class StringTableCache final
+	{
+		private:
+			mutable std::mutex m_Mutex;
+			std::unordered_map<std::string, std::shared_ptr<const StringTable>> m_Tables;
+			std::vector<std::shared_ptr<const Archive>> m_Archives;
+			size_t m_Hits = 0;
+			size_t m_Loads = 0;
+
+		public:
+			// 'Strings/<plugin name without extension>_<language>.<type>' in the plugin's directory. File names are
+			// matched ignoring case when the exact one doesn't exist.
+			static std::filesystem::path GetTablePath(const std::filesystem::path& pluginPath, std::string_view language, StringTableType type);
+
+		public:
+			StringTableCache() = default;
+			StringTableCache(const StringTableCache&) = delete;
+
+		public:
+			void AddArchive(std::shared_ptr<const Archive> archive);
+
+			// Null if the table doesn't exist or can't be read
+			std::shared_ptr<const StringTable> Get(const std::filesystem::path& pluginPath, std::string_view language, StringTableType type);
+
+			// Looks the ID up in the table of the given type. Views stay valid until the cache is cleared.
+			std::optional<std::string_view> Find(const std::filesystem::path& pluginPath, std::string_view language, StringTableType type, uint32_t id);
+
+			// Looks the ID up in all three tables, for callers that don't know which field it came from
+			std::optional<std::string_view> Find(const std::filesystem::path& pluginPath, std::string_view language, uint32_t id);
+
+			// Drops the tables, added archives are kept
+			void Clear();
+			StringTableCacheStats GetStats() const;
+
+		public:
+			StringTableCache& operator=(const StringTableCache&) = delete;
+	};
+}
@@ -0,0 +1,580 @@
+#include "stdafx.h"
+#include "TextDecoder.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BETHESDAMODULE_TEXT_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BETHESDAMODULE_TEXT_SSE2 1
+#endif
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+	using TCodePage = std::array<char16_t, 256>;
+
+	// Lower half of every supported code page is ASCII
+	constexpr TCodePage MakeCodePage(const char16_t (&upperHalf)[128]) noexcept
+	{
+		TCodePage table = {};
+		for (size_t i = 0; i < 128; i++)
+		{
+			table[i] = static_cast<char16_t>(i);
+			table[128 + i] = upperHalf[i];
+		}
+		return table;
+	}
+
+	// Windows-1252 differs from Latin-1 only in 0x80-0x9F range. Undefined positions of every code page
+	// are mapped to the corresponding C1 control characters as 'MultiByteToWideChar' does.
+	constexpr char16_t g_Windows1252Extra[32] =
+	{
+		0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+		0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+	};
+	constexpr TCodePage MakeWindows1252() noexcept
+	{
+		char16_t upperHalf[128] = {};
+		for (size_t i = 0; i < 128; i++)
+		{
+			upperHalf[i] = i < 32 ? g_Windows1252Extra[i] : static_cast<char16_t>(0x80 + i);
+		}
+		return MakeCodePage(upperHalf);
+	}
+
+	// Central European: Polish, Czech and Hungarian translations
+	constexpr char16_t g_Windows1250Upper[128] =
+	{
+		0x20AC, 0x0081, 0x201A, 0x0083, 0x201E, 0x2026, 0x2020, 0x2021, 0x0088, 0x2030, 0x0160, 0x2039, 0x015A, 0x0164, 0x017D, 0x0179,
+		0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x0098, 0x2122, 0x0161, 0x203A, 0x015B, 0x0165, 0x017E, 0x017A,
+		0x00A0, 0x02C7, 0x02D8, 0x0141, 0x00A4, 0x0104, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x015E, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x017B,
+		0x00B0, 0x00B1, 0x02DB, 0x0142, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x0105, 0x015F, 0x00BB, 0x013D, 0x02DD, 0x013E, 0x017C,
+		0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7, 0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+		0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7, 0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+		0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7, 0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+		0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7, 0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9,
+	};
+
+	// Cyrillic: Russian and Ukrainian translations
+	constexpr char16_t g_Windows1251Upper[128] =
+	{
+		0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021, 0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+		0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x0098, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+		0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7, 0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+		0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7, 0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+		0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+		0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427, 0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+		0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+		0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447, 0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+	};
+
+	constexpr TCodePage g_Windows1250 = MakeCodePage(g_Windows1250Upper);
+	constexpr TCodePage g_Windows1251 = MakeCodePage(g_Windows1251Upper);
+	constexpr TCodePage g_Windows1252 = MakeWindows1252();
+	static_assert(g_Windows1252['a'] == u'a' && g_Windows1252[0x80] == 0x20AC && g_Windows1252[0xE0] == 0x00E0);
+	static_assert(g_Windows1251[0xC0] == 0x0410 && g_Windows1251[0xFF] == 0x044F);
+	static_assert(g_Windows1250[0xA3] == 0x0141);
+
+	// Every code page character as UTF-8: up to three bytes in the low bits and their count in the high byte,
+	// so the bytes are written with a single store and no branches
+	using TUTF8Table = std::array<uint32_t, 256>;
+	static_assert(std::endian::native == std::endian::little);
+
+	constexpr TUTF8Table MakeUTF8Table(const TCodePage& codePage) noexcept
+	{
+		TUTF8Table table = {};
+		for (size_t i = 0; i < table.size(); i++)
+		{
+			const uint32_t c = codePage[i];
+			if (c < 0x80)
+			{
+				table[i] = c|1u << 24;
+			}
+			else if (c < 0x800)
+			{
+				table[i] = (0xC0|(c >> 6))|(0x80|(c & 0x3F)) << 8|2u << 24;
+			}
+			else
+			{
+				table[i] = (0xE0|(c >> 12))|(0x80|((c >> 6) & 0x3F)) << 8|(0x80|(c & 0x3F)) << 16|3u << 24;
+			}
+		}
+		return table;
+	}
+	constexpr TUTF8Table g_Windows1250UTF8 = MakeUTF8Table(g_Windows1250);
+	constexpr TUTF8Table g_Windows1251UTF8 = MakeUTF8Table(g_Windows1251);
+	constexpr TUTF8Table g_Windows1252UTF8 = MakeUTF8Table(g_Windows1252);
+	static_assert(g_Windows1252UTF8[0x80] == (0xE2|0x82 << 8|0xAC << 16|3u << 24));
+
+	const TUTF8Table& GetUTF8Table(TextEncoding encoding) noexcept
+	{
+		switch (encoding)
+		{
+			case TextEncoding::Windows1250:
+			{
+				return g_Windows1250UTF8;
+			}
+			case TextEncoding::Windows1251:
+			{
+				return g_Windows1251UTF8;
+			}
+			default:
+			{
+				return g_Windows1252UTF8;
+			}
+		};
+	}
+	const TCodePage& GetCodePage(TextEncoding encoding) noexcept
+	{
+		switch (encoding)
+		{
+			case TextEncoding::Windows1250:
+			{
+				return g_Windows1250;
+			}
+			case TextEncoding::Windows1251:
+			{
+				return g_Windows1251;
+			}
+			default:
+			{
+				return g_Windows1252;
+			}
+		};
+	}
+
+	// Length of the leading ASCII run
+	template<bool vectorized>
+	size_t CountASCII(const uint8_t* data, size_t size) noexcept
+	{
+		size_t i = 0;
+		if constexpr (vectorized)
+		{
+			#if BETHESDAMODULE_TEXT_AVX2
+			for (; i + 32 <= size; i += 32)
+			{
+				const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+				if (mask != 0)
+				{
+					return i + std::countr_zero(mask);
+				}
+			}
+			#endif
+			#if BETHESDAMODULE_TEXT_SSE2
+			for (; i + 16 <= size; i += 16)
+			{
+				const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))));
+				if (mask != 0)
+				{
+					return i + std::countr_zero(mask);
+				}
+			}
+			#endif
+		}
+		while (i < size && data[i] < 0x80)
+		{
+			i++;
+		}
+		return i;
+	}
+
+	// Same as 'CountASCII' but also widens the run. Whole blocks are stored even if only a part of them is ASCII,
+	// the rest is overwritten later. That never goes past the end since every byte gives at least one unit.
+	template<bool vectorized>
+	size_t WidenASCII(const uint8_t* data, size_t size, char16_t* buffer) noexcept
+	{
+		size_t i = 0;
+		if constexpr (vectorized)
+		{
+			#if BETHESDAMODULE_TEXT_AVX2
+			for (; i + 32 <= size; i += 32)
+			{
+				const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+
+				const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+				if (mask != 0)
+				{
+					return i + std::countr_zero(mask);
+				}
+			}
+			#endif
+			#if BETHESDAMODULE_TEXT_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), _mm_unpacklo_epi8(bytes, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i + 8), _mm_unpackhi_epi8(bytes, zero));
+
+				const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+				if (mask != 0)
+				{
+					return i + std::countr_zero(mask);
+				}
+			}
+			#endif
+		}
+		for (; i < size && data[i] < 0x80; i++)
+		{
+			buffer[i] = data[i];
+		}
+		return i;
+	}
+
+	// Decodes one well-formed sequence: no overlong forms, surrogates or code points past U+10FFFF
+	bool DecodeUTF8Sequence(const uint8_t* data, size_t size, size_t& offset, char32_t& codePoint) noexcept
+	{
+		const uint8_t lead = data[offset];
+		size_t length = 0;
+		char32_t minValue = 0;
+		if (lead < 0x80)
+		{
+			codePoint = lead;
+			offset++;
+			return true;
+		}
+		else if ((lead & 0xE0) == 0xC0)
+		{
+			length = 2;
+			codePoint = lead & 0x1F;
+			minValue = 0x80;
+		}
+		else if ((lead & 0xF0) == 0xE0)
+		{
+			length = 3;
+			codePoint = lead & 0x0F;
+			minValue = 0x800;
+		}
+		else if ((lead & 0xF8) == 0xF0)
+		{
+			length = 4;
+			codePoint = lead & 0x07;
+			minValue = 0x10000;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (size - offset < length)
+		{
+			return false;
+		}
+		for (size_t i = 1; i < length; i++)
+		{
+			const uint8_t c = data[offset + i];
+			if ((c & 0xC0) != 0x80)
+			{
+				return false;
+			}
+			codePoint = (codePoint << 6)|(c & 0x3F);
+		}
+		if (codePoint < minValue || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+		{
+			return false;
+		}
+		offset += length;
+		return true;
+	}
+
+	template<bool vectorized>
+	bool IsUTF8Impl(const uint8_t* data, size_t size) noexcept
+	{
+		size_t i = 0;
+		while (i < size)
+		{
+			// The vector path is only tried at the start of an ASCII run
+			char32_t codePoint = 0;
+			if (data[i] < 0x80)
+			{
+				i += CountASCII<vectorized>(data + i, size - i);
+			}
+			else if (!DecodeUTF8Sequence(data, size, i, codePoint))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<bool vectorized>
+	TextEncoding ResolveEncoding(const uint8_t* data, size_t size, const TextDecodeOptions& options) noexcept
+	{
+		if (options.DetectUTF8 && options.Encoding != TextEncoding::UTF8 && CountASCII<vectorized>(data, size) != size && IsUTF8Impl<vectorized>(data, size))
+		{
+			return TextEncoding::UTF8;
+		}
+		return options.Encoding;
+	}
+
+	// Decodes UTF-8 starting at 'offset' to 'buffer'. Malformed sequences are replaced with U+FFFD, or end decoding
+	// with null returned if 'strict' is set.
+	template<bool vectorized>
+	char16_t* DecodeUTF8ToUTF16(const uint8_t* data, size_t size, size_t offset, char16_t* buffer, bool strict) noexcept
+	{
+		char16_t* out = buffer;
+		size_t i = offset;
+		while (i < size)
+		{
+			if (data[i] < 0x80)
+			{
+				const size_t count = WidenASCII<vectorized>(data + i, size - i, out);
+				i += count;
+				out += count;
+				continue;
+			}
+
+			char32_t codePoint = 0;
+			if (!DecodeUTF8Sequence(data, size, i, codePoint))
+			{
+				if (strict)
+				{
+					return nullptr;
+				}
+				codePoint = 0xFFFD;
+				i++;
+			}
+
+			if (codePoint >= 0x10000)
+			{
+				codePoint -= 0x10000;
+				*out++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+				*out++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+			}
+			else
+			{
+				*out++ = static_cast<char16_t>(codePoint);
+			}
+		}
+		return out;
+	}
+
+	template<bool vectorized>
+	size_t DecodeToUTF16Impl(std::string_view text, char16_t* buffer, const TextDecodeOptions& options) noexcept
+	{
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+		const size_t size = text.size();
+
+		if constexpr (!vectorized)
+		{
+			// Detection as a separate pass, then one byte or sequence at a time
+			const TextEncoding encoding = ResolveEncoding<false>(data, size, options);
+			if (encoding == TextEncoding::UTF8)
+			{
+				return static_cast<size_t>(DecodeUTF8ToUTF16<false>(data, size, 0, buffer, false) - buffer);
+			}
+
+			const TCodePage& codePage = GetCodePage(encoding);
+			for (size_t i = 0; i < size; i++)
+			{
+				buffer[i] = codePage[data[i]];
+			}
+			return size;
+		}
+		else
+		{
+			if (options.Encoding == TextEncoding::UTF8)
+			{
+				return static_cast<size_t>(DecodeUTF8ToUTF16<true>(data, size, 0, buffer, false) - buffer);
+			}
+
+			// Leading ASCII goes through the vector path. What follows is decoded as UTF-8 if it all turns out
+			// to be well-formed, otherwise it's looked up byte by byte: mixed text switches between ASCII and
+			// the upper half too often for anything else to pay off.
+			const size_t asciiSize = WidenASCII<true>(data, size, buffer);
+			if (options.DetectUTF8 && asciiSize != size)
+			{
+				if (char16_t* end = DecodeUTF8ToUTF16<true>(data, size, asciiSize, buffer + asciiSize, true))
+				{
+					return static_cast<size_t>(end - buffer);
+				}
+			}
+
+			const TCodePage& codePage = GetCodePage(options.Encoding);
+			for (size_t i = asciiSize; i < size; i++)
+			{
+				buffer[i] = codePage[data[i]];
+			}
+			return size;
+		}
+	}
+
+	char* AppendUTF8(char* out, char16_t c) noexcept
+	{
+		if (c < 0x80)
+		{
+			*out++ = static_cast<char>(c);
+		}
+		else if (c < 0x800)
+		{
+			*out++ = static_cast<char>(0xC0 | (c >> 6));
+			*out++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			*out++ = static_cast<char>(0xE0 | (c >> 12));
+			*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		return out;
+	}
+}
+
+namespace BethesdaModule::Core
+{
+	std::string_view GetTextEncodingName(TextEncoding encoding) noexcept
+	{
+		switch (encoding)
+		{
+			case TextEncoding::Windows1250:
+			{
+				return "1250";
+			}
+			case TextEncoding::Windows1251:
+			{
+				return "1251";
+			}
+			case TextEncoding::Windows1252:
+			{
+				return "1252";
+			}
+			case TextEncoding::UTF8:
+			{
+				return "utf8";
+			}
+		};
+		return {};
+	}
+	std::optional<TextEncoding> ParseTextEncoding(std::string_view name) noexcept
+	{
+		for (TextEncoding encoding: {TextEncoding::Windows1250, TextEncoding::Windows1251, TextEncoding::Windows1252, TextEncoding::UTF8})
+		{
+			if (GetTextEncodingName(encoding) == name)
+			{
+				return encoding;
+			}
+		}
+		return {};
+	}
+	std::optional<TextEncoding> GetTextEncodingFromCodePage(uint32_t codePage) noexcept
+	{
+		switch (codePage)
+		{
+			case 1250:
+			{
+				return TextEncoding::Windows1250;
+			}
+			case 1251:
+			{
+				return TextEncoding::Windows1251;
+			}
+			case 1252:
+			{
+				return TextEncoding::Windows1252;
+			}
+			case 65001:
+			{
+				return TextEncoding::UTF8;
+			}
+		};
+		return {};
+	}
+
+	bool IsASCII(std::string_view text) noexcept
+	{
+		return CountASCII<true>(reinterpret_cast<const uint8_t*>(text.data()), text.size()) == text.size();
+	}
+	bool IsUTF8(std::string_view text) noexcept
+	{
+		return IsUTF8Impl<true>(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+	}
+	TextEncoding DetectTextEncoding(std::string_view text, const TextDecodeOptions& options) noexcept
+	{
+		return ResolveEncoding<true>(reinterpret_cast<const uint8_t*>(text.data()), text.size(), options);
+	}
+
+	size_t DecodeToUTF16(std::string_view text, char16_t* buffer, const TextDecodeOptions& options) noexcept
+	{
+		return DecodeToUTF16Impl<true>(text, buffer, options);
+	}
+	std::u16string DecodeToUTF16(std::string_view text, const TextDecodeOptions& options)
+	{
+		std::u16string result(text.size(), u'\0');
+		result.resize(DecodeToUTF16Impl<true>(text, result.data(), options));
+		return result;
+	}
+	size_t DecodeToUTF16Scalar(std::string_view text, char16_t* buffer, const TextDecodeOptions& options) noexcept
+	{
+		return DecodeToUTF16Impl<false>(text, buffer, options);
+	}
+
+	std::string DecodeToUTF8(std::string_view text, const TextDecodeOptions& options)
+	{
+		std::string result;
+		DecodeToUTF8(text, result, options);
+		return result;
+	}
+	void DecodeToUTF8(std::string_view text, std::string& result, const TextDecodeOptions& options)
+	{
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+		const size_t size = text.size();
+		const TextEncoding encoding = ResolveEncoding<true>(data, size, options);
+		if (encoding == TextEncoding::UTF8 && (options.Encoding != TextEncoding::UTF8 || IsUTF8Impl<true>(data, size)))
+		{
+			// Detected or checked to be well-formed, nothing to convert
+			result.assign(text);
+			return;
+		}
+
+		// At most three bytes for every byte plus one, table entries are always stored whole.
+		// The size is fixed once decoding is done.
+		result.resize(size * 3 + 1);
+
+		// ASCII runs are copied as they are
+		char* out = result.data();
+		size_t i = CountASCII<true>(data, size);
+		out = std::copy_n(text.data(), i, out);
+
+		if (encoding != TextEncoding::UTF8)
+		{
+			const TUTF8Table& table = GetUTF8Table(encoding);
+			for (; i < size; i++)
+			{
+				const uint32_t value = table[data[i]];
+				std::memcpy(out, &value, sizeof(value));
+				out += value >> 24;
+			}
+		}
+		else
+		{
+			while (i < size)
+			{
+				const size_t start = i;
+				char32_t codePoint = 0;
+				if (data[i] < 0x80)
+				{
+					i += CountASCII<true>(data + i, size - i);
+					out = std::copy(text.data() + start, text.data() + i, out);
+				}
+				else if (DecodeUTF8Sequence(data, size, i, codePoint))
+				{
+					out = std::copy(text.data() + start, text.data() + i, out);
+				}
+				else
+				{
+					out = AppendUTF8(out, 0xFFFD);
+					i++;
+				}
+			}
+		}
+		result.resize(static_cast<size_t>(out - result.data()));
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace BethesdaModule::Core
+{
+	// Code pages text in modules is found in. Official games use Windows-1252, translations use whatever the
+	// translator's system had, newer tools write UTF-8.
+	enum class TextEncoding
+	{
+		Windows1250,
+		Windows1251,
+		Windows1252,
+		UTF8,
+	};
+	std::string_view GetTextEncodingName(TextEncoding encoding) noexcept;
+	std::optional<TextEncoding> ParseTextEncoding(std::string_view name) noexcept;
+	std::optional<TextEncoding> GetTextEncodingFromCodePage(uint32_t codePage) noexcept;
+
+	struct TextDecodeOptions final
+	{
+		TextEncoding Encoding = TextEncoding::Windows1252;
+
+		// Non-ASCII text that is entirely well-formed UTF-8 is decoded as UTF-8. Single-byte text almost never is.
+		bool DetectUTF8 = false;
+	};
+
+	// ASCII runs are checked and widened 16 bytes at a time with SSE2 or 32 with AVX2, when the build targets them
+	bool IsASCII(std::string_view text) noexcept;
+	bool IsUTF8(std::string_view text) noexcept;
+	TextEncoding DetectTextEncoding(std::string_view text, const TextDecodeOptions& options = {}) noexcept;
+
+	// Every byte gives at most one UTF-16 unit, so 'buffer' has to have room for 'text.size()' of them.
+	// Returns the number of units written. Malformed UTF-8 is replaced with U+FFFD.
+	size_t DecodeToUTF16(std::string_view text, char16_t* buffer, const TextDecodeOptions& options = {}) noexcept;
+	std::u16string DecodeToUTF16(std::string_view text, const TextDecodeOptions& options = {});
+
+	// Byte at a time, without the vector fast path. Reference for the benchmark.
+	size_t DecodeToUTF16Scalar(std::string_view text, char16_t* buffer, const TextDecodeOptions& options = {}) noexcept;
+
+	// Converts text stored in a module to UTF-8
+	std::string DecodeToUTF8(std::string_view text, const TextDecodeOptions& options = {});
+	void DecodeToUTF8(std::string_view text, std::string& result, const TextDecodeOptions& options = {});
+}
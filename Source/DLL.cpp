@@ -87,7 +87,7 @@ namespace BethesdaModule::ShellView
 
 namespace BethesdaModule::ShellView
 {
-	HRESULT DLLClassFactory::CreateInstance(REFCLSID clsid, const ClassObjectInitializer* classObjectInitializers, size_t initializersCount, REFIID riid, void** result)
+	HRESULT DLLClassFactory::GetClassObject(REFCLSID clsid, const ClassObjectInitializer* classObjectInitializers, size_t initializersCount, REFIID riid, void** result)
 	{
 		if (!classObjectInitializers || initializersCount == 0)
 		{
@@ -104,12 +104,7 @@ namespace BethesdaModule::ShellView
 		{
 			if (clsid == *classObjectInitializers[i].m_CLSID)
 			{
-				COMPtr<IClassFactory> classFactory = new(std::nothrow) DLLClassFactory(classObjectInitializers[i].m_CreateFunc);
-				hr = classFactory ? S_OK : E_OUTOFMEMORY;
-				if (hr)
-				{
-					hr = classFactory->QueryInterface(riid, result);
-				}
+				hr = classObjectInitializers[i].m_ClassFactory->QueryInterface(riid, result);
 				break;
 			}
 		}
@@ -133,11 +128,12 @@ extern "C"
 	{
 		using namespace BethesdaModule::ShellView;
 
-		constexpr ClassObjectInitializer classObjectInitializers[] =
+		static DLLClassFactory metadataHandlerFactory(MetadataHandler::CreateInstance);
+		const ClassObjectInitializer classObjectInitializers[] =
 		{
-			{&__uuidof(MetadataHandler), MetadataHandler::CreateInstance}
+			{&__uuidof(MetadataHandler), &metadataHandlerFactory}
 		};
-		return DLLClassFactory::CreateInstance(clsid, classObjectInitializers, std::size(classObjectInitializers), riid, result);
+		return DLLClassFactory::GetClassObject(clsid, classObjectInitializers, std::size(classObjectInitializers), riid, result);
 	}
 	HRESULT STDAPICALLTYPE DllRegisterServer()
 	{
@@ -153,7 +149,8 @@ extern "C"
 	}
 	HRESULT STDAPICALLTYPE DllCanUnloadNow()
 	{
-		// Only allow the DLL to be unloaded after all outstanding references have been released
+		// Only allow the DLL to be unloaded after all outstanding references have been released.
+		// Process-wide header caches and recycled handlers don't count, they're plain memory released with the DLL itself.
 		return g_RefCount == 0 ? S_OK : S_FALSE;
 	}
 
@@ -45,38 +45,37 @@ namespace BethesdaModule::ShellView
 		using CreateFunc = HRESULT(*)(REFIID riid, void** ppvObject);
 
 		const CLSID* m_CLSID = nullptr;
-		CreateFunc m_CreateFunc = nullptr;
+		DLLClassFactory* m_ClassFactory = nullptr;
 	};
 
+	// Factories are static objects created once per class, Explorer asks for one for nearly every file it looks at.
+	// Their references only keep the DLL loaded.
 	class DLLClassFactory: public IClassFactory
 	{
 		public:
-			static HRESULT CreateInstance(REFCLSID clsid, const ClassObjectInitializer* classObjectInitializers, size_t initializersCount, REFIID riid, void** result);
+			static HRESULT GetClassObject(REFCLSID clsid, const ClassObjectInitializer* classObjectInitializers, size_t initializersCount, REFIID riid, void** result);
 
 		private:
-			COMRefCount<DLLClassFactory, ULONG, 1> m_RefCount;
 			ClassObjectInitializer::CreateFunc m_CreateFunc = nullptr;
 
 		public:
-			DLLClassFactory(ClassObjectInitializer::CreateFunc func)
-				:m_RefCount(this), m_CreateFunc(func)
+			DLLClassFactory(ClassObjectInitializer::CreateFunc func) noexcept
+				:m_CreateFunc(func)
 			{
-				DllAddRef();
-			}
-			~DLLClassFactory()
-			{
-				DllRelease();
 			}
+			DLLClassFactory(const DLLClassFactory&) = delete;
 
 		public:
 			// IUnknown
 			ULONG STDMETHODCALLTYPE AddRef() override
 			{
-				return m_RefCount.AddRef();
+				DllAddRef();
+				return 2;
 			}
 			ULONG STDMETHODCALLTYPE Release() override
 			{
-				return m_RefCount.Release();
+				DllRelease();
+				return 1;
 			}
 			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override;
 
@@ -97,6 +96,9 @@ namespace BethesdaModule::ShellView
 				}
 				return S_OK;
 			}
+
+		public:
+			DLLClassFactory& operator=(const DLLClassFactory&) = delete;
 	};
 }
 
@@ -5,6 +5,9 @@
 #include "Resources/resource.h"
 #include "Utility/PropertyStore.h"
 #include "Utility/VariantProperty.h"
+#include "Core/MetadataCache.h"
+#include "Core/TextDecoder.h"
+#include <mutex>
 
 namespace
 {
@@ -30,166 +33,258 @@ namespace
 		}
 		return result;
 	}
-	KxFramework::String StringOrNone(const KxFramework::String& value)
+	std::wstring DecodeText(std::string_view text)
 	{
-		return !value.IsEmpty() ? value : wxS("<None>");
-	}
-	KxFramework::String ConcatWithSeparator(const std::vector<KxFramework::String>& items, const KxFramework::String& separator)
-	{
-		using namespace KxFramework;
+		// Mods are written in the code page of the author's system, which is normally the one of the user's system too.
+		// Newer tools write UTF-8, that is recognized by itself.
+		static const std::optional<BethesdaModule::Core::TextEncoding> encoding = BethesdaModule::Core::GetTextEncodingFromCodePage(::GetACP());
 
-		String result;
-		for (const auto& item: items)
+		std::wstring result;
+		if (!text.empty())
 		{
-			if (!result.IsEmpty())
+			if (encoding)
 			{
-				result += separator;
+				BethesdaModule::Core::TextDecodeOptions options;
+				options.Encoding = *encoding;
+				options.DetectUTF8 = true;
+
+				static_assert(sizeof(wchar_t) == sizeof(char16_t));
+				result.resize(text.size());
+				result.resize(BethesdaModule::Core::DecodeToUTF16(text, reinterpret_cast<char16_t*>(result.data()), options));
+				return result;
+			}
+
+			// Code pages the decoder has no table for
+			const int length = ::MultiByteToWideChar(CP_ACP, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+			if (length > 0)
+			{
+				result.resize(static_cast<size_t>(length));
+				::MultiByteToWideChar(CP_ACP, 0, text.data(), static_cast<int>(text.size()), result.data(), length);
 			}
-			result += item;
 		}
 		return result;
 	}
+	std::wstring_view StringOrNone(const std::wstring& value)
+	{
+		return !value.empty() ? std::wstring_view(value) : L"<None>";
+	}
+	// Every property the handler provides, in 'MetadataHandler::PropertyIndex' order
+	constexpr const PROPERTYKEY* g_PropertyKeys[] =
+	{
+		&PKEY_Author,
+		&PKEY_Comment,
+		&PKEY_FileVersion,
+		&PKEY_ContentType,
+		&PKEY_DataObjectFormat,
+		&PKEY_Keywords,
+	};
+
+	// Shared by all handler instances in the process, lives in '%LOCALAPPDATA%\BethesdaModuleShellView'.
+	// If it can't be opened every lookup is simply a miss.
+	BethesdaModule::Core::MetadataCache& GetMetadataCache()
+	{
+		static BethesdaModule::Core::MetadataCache cache;
+		static std::once_flag once;
+
+		std::call_once(once, []()
+		{
+			PWSTR folder = nullptr;
+			if (SUCCEEDED(::SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &folder)))
+			{
+				cache.Open(std::filesystem::path(folder) / L"BethesdaModuleShellView" / L"MetadataCache.bin");
+			}
+			::CoTaskMemFree(folder);
+		});
+		return cache;
+	}
+	// In-memory LRU in front of the persistent cache for files Explorer asks about repeatedly. It holds neither
+	// COM objects nor DLL references, so it doesn't keep 'DllCanUnloadNow' from succeeding.
+	BethesdaModule::Core::ModuleInfoCache& GetModuleInfoCache()
+	{
+		static BethesdaModule::Core::ModuleInfoCache cache;
+		return cache;
+	}
+	// Handlers released by Explorer, waiting to be reused for the next file
+	BethesdaModule::Core::BoundedFreeList<BethesdaModule::ShellView::MetadataHandler> g_HandlerPool;
+
+	// Recycled handlers don't keep header buffers grown by unusually big headers
+	constexpr size_t g_MaxRecycledHeaderData = 64 * 1024;
+
+	// The stream's name is the full path when whoever opened it knows one, otherwise the key has the file name
+	// only and can collide with a file of the same name, size and time elsewhere (see 'Core::CacheKey')
+	BethesdaModule::Core::CacheKey MakeCacheKey(const BethesdaModule::ShellView::IStreamFileInfo& fileInfo)
+	{
+		BethesdaModule::Core::CacheKey key;
+		key.Name = BethesdaModule::Core::MetadataCache::MakeKeyName(std::filesystem::path(fileInfo.Name));
+		key.FileSize = fileInfo.Size;
+		key.LastWriteTime = fileInfo.LastWriteTime;
+		return key;
+	}
 }
 
 namespace BethesdaModule::ShellView
 {
 	HRESULT MetadataHandler::CreateInstance(REFIID riid, void** ppv)
 	{
-		return *MakeObjectInstance<MetadataHandler>(riid, ppv);
+		std::unique_ptr<MetadataHandler> handler = g_HandlerPool.Pop();
+		if (!handler)
+		{
+			handler.reset(new(std::nothrow) MetadataHandler());
+			if (!handler)
+			{
+				return E_OUTOFMEMORY;
+			}
+		}
+		DllAddRef();
+
+		COMPtr<MetadataHandler> object;
+		object = handler.release();
+		return object->QueryInterface(riid, ppv);
 	}
 
-	HResult MetadataHandler::ReadMorrowind()
+	HResult MetadataHandler::ReadHeader(const IStreamFileInfo* fileInfo, Core::PackedModuleInfo& info)
 	{
-		// Seek after to HEDR and skip its record name and following three 32-bit fields
-		m_Stream.Seek(16 + 12);
-
-		// These are fixed length
-		m_FileInfo.Author = m_Stream.ReadStringACP(32);
-		m_FileInfo.Description = m_Stream.ReadStringACP(256);
-
-		// Skip unknown 32-bit value
-		m_Stream.Skip<uint32_t>();
-
-		// Read master-files if any
-		String recordName = m_Stream.ReadStringASCII(4);
-		while (recordName == wxS("MAST"))
+		// Normally served by a single read of the underlying stream
+		const std::span<const std::byte> data = Core::ReadModuleHeaderData(m_Source, m_HeaderData);
+		if (data.empty())
 		{
-			m_FileInfo.RequiredFiles.emplace_back(m_Stream.ReadStringACP(m_Stream.ReadObject<uint32_t>()));
+			return m_Source.GetLastError();
+		}
 
-			// Skip DATA 
-			m_Stream.Seek(16);
-			recordName = m_Stream.ReadStringASCII(4);
+		Core::ModuleHeader header;
+		if (Core::ParseModuleHeader(data, header) == Core::ParseStatus::UnknownFormat)
+		{
+			return S_FALSE;
 		}
 
 		// Morrowind doesn't store anything inside file to help distinguish master from ordinary plugin,
 		// so file extension is the only option.
-		if (m_Stream.GetFilePath().GetExtension().IsSameAs(wxS("esm"), StringOpFlag::IgnoreCase))
+		if (header.FormatLevel == FormatLevel::Morrowind && fileInfo && FSPath(fileInfo->Name.c_str()).GetExtension().IsSameAs(wxS("esm"), StringOpFlag::IgnoreCase))
 		{
-			m_FileInfo.Flags = HeaderFlags::Master;
+			header.Flags = HeaderFlags::Master;
 		}
 
-		m_FileInfo.FormatLevel = FormatLevel::Morrowind;
+		// The only allocation made for the parsed header
+		info = Core::PackedModuleInfo::FromHeader(data, header);
 		return S_OK;
 	}
-	HResult MetadataHandler::ReadOblivionSkyrim()
+	void MetadataHandler::Reset() noexcept
 	{
-		// Skip size
-		m_Stream.Skip<uint32_t>();
-
-		// Read flags and seek to CNAM
-		m_FileInfo.Flags = FromInt<HeaderFlags>(m_Stream.ReadObject<uint32_t>());
-
-		// Skip (FormID + Version control info)
-		m_Stream.Seek(8);
-
-		// See if next 4 bytes are "HEDR". If so it's Oblivion file, if not it's Skyrim.
-		const uint32_t temp = m_Stream.ReadObject<uint32_t>();
-		if (std::string_view(reinterpret_cast<const char*>(&temp), sizeof(temp)) == "HEDR")
+		// The stream and the header go right away, only the buffers stay
+		m_Source.Close();
+		m_Info = {};
+		m_HeaderData.clear();
+		if (m_HeaderData.capacity() > g_MaxRecycledHeaderData)
 		{
-			return ReadOblivion();
+			std::vector<std::byte>().swap(m_HeaderData);
 		}
-		else
+
+		for (size_t i = 0; i < PropertyCount; i++)
 		{
-			return ReadSkyrim(temp);
+			m_Values[i].Clear();
+			m_ValuesReady[i].store(false, std::memory_order_relaxed);
 		}
+		m_RefCount.Reset();
 	}
-	HResult MetadataHandler::ReadOblivion()
-	{
-		// Skip rest of the HEDR struct
-		m_Stream.Seek(14);
 
-		String recordName = m_Stream.ReadStringASCII(4);
-		if (recordName == wxS("CNAM"))
-		{
-			m_FileInfo.Author = m_Stream.ReadStringACP(m_Stream.ReadObject<uint16_t>());
-			recordName = m_Stream.ReadStringASCII(4);
-		}
-		if (recordName == wxS("SNAM"))
-		{
-			m_FileInfo.Description = m_Stream.ReadStringACP(m_Stream.ReadObject<uint16_t>());
-			recordName = m_Stream.ReadStringASCII(4);
-		}
-		if (recordName == wxS("MAST"))
+	auto MetadataHandler::FindProperty(REFPROPERTYKEY key) noexcept -> std::optional<PropertyIndex>
+	{
+		// Comparing property IDs first rejects most keys without comparing format IDs. Author and FileVersion share
+		// property ID 4, so the format ID still decides between them.
+		for (size_t i = 0; i < std::size(g_PropertyKeys); i++)
 		{
-			do
+			if (g_PropertyKeys[i]->pid == key.pid && g_PropertyKeys[i]->fmtid == key.fmtid)
 			{
-				m_FileInfo.RequiredFiles.emplace_back(m_Stream.ReadStringACP(m_Stream.ReadObject<uint16_t>()));
-
-				// Skip DATA 
-				m_Stream.Seek(14);
-				recordName = m_Stream.ReadStringASCII(4);
+				return static_cast<PropertyIndex>(i);
 			}
-			while (recordName == wxS("MAST"));
 		}
-
-		m_FileInfo.FormatLevel = FormatLevel::Oblivion;
-		return S_OK;
+		return {};
 	}
-	HResult MetadataHandler::ReadSkyrim(uint32_t formVersion)
+	VariantProperty MetadataHandler::CreateValue(PropertyIndex index) const
 	{
-		// It was the form version
-		m_FileInfo.FormVersion = formVersion;
-
-		// Skip HEDR struct
-		m_Stream.Seek(18);
+		const Core::PackedModuleInfo& info = m_Info;
 
-		String recordName = m_Stream.ReadStringASCII(4);
-		if (recordName == wxS("CNAM"))
+		VariantProperty property;
+		switch (index)
 		{
-			m_FileInfo.Author = m_Stream.ReadStringACP(m_Stream.ReadObject<uint16_t>());
-			recordName = m_Stream.ReadStringASCII(4);
-		}
-		if (recordName == wxS("SNAM"))
-		{
-			m_FileInfo.Description = m_Stream.ReadStringACP(m_Stream.ReadObject<uint16_t>());
-			recordName = m_Stream.ReadStringASCII(4);
-		}
-
-		// Read masters
-		if (recordName == wxS("MAST"))
+			case PropertyIndex::Author:
+			{
+				property = StringOrNone(DecodeText(info.GetAuthor()));
+				break;
+			}
+			case PropertyIndex::Comment:
+			{
+				property = StringOrNone(DecodeText(info.GetDescription()));
+				break;
+			}
+			case PropertyIndex::FileVersion:
+			{
+				if (info.GetFormVersion() != 0)
+				{
+					property = info.GetFormVersion();
+				}
+				else
+				{
+					property = wxS("<Unknown>");
+				}
+				break;
+			}
+			case PropertyIndex::ContentType:
+			{
+				String content = HeaderFlagsDef::ToOrExpression(info.GetFlags());
+				property = !content.IsEmpty() ? content : wxS("Normal");
+				break;
+			}
+			case PropertyIndex::DataObjectFormat:
+			{
+				property = FormatLevelDef::TryToString(info.GetFormatLevel()).value_or(StringView(wxS("<Unknown>")));
+				break;
+			}
+			case PropertyIndex::Keywords:
+			{
+				// Required files
+				std::wstring requiredFiles;
+				info.ForEachMaster([&](std::string_view name)
+				{
+					if (!requiredFiles.empty())
+					{
+						requiredFiles += L"; ";
+					}
+					requiredFiles += DecodeText(name);
+				});
+				property = StringOrNone(requiredFiles);
+				break;
+			}
+		};
+		return property;
+	}
+	const VariantProperty& MetadataHandler::GetPropertyValue(PropertyIndex index)
+	{
+		const size_t i = static_cast<size_t>(index);
+		if (!m_ValuesReady[i].load(std::memory_order_acquire))
 		{
-			do
+			std::lock_guard lock(m_ValuesMutex);
+			if (!m_ValuesReady[i].load(std::memory_order_relaxed))
 			{
-				m_FileInfo.RequiredFiles.emplace_back(m_Stream.ReadStringACP(m_Stream.ReadObject<uint16_t>()));
-
-				// Skip DATA 
-				m_Stream.Seek(14);
-				recordName = m_Stream.ReadStringASCII(4);
+				m_Values[i] = CreateValue(index);
+				m_ValuesReady[i].store(true, std::memory_order_release);
 			}
-			while (recordName == wxS("MAST"));
 		}
-
-		m_FileInfo.FormatLevel = FormatLevel::Skyrim;
-		return S_OK;
+		return m_Values[i];
 	}
 
 	MetadataHandler::MetadataHandler()
 		:m_RefCount(this)
 	{
-		DllAddRef();
 	}
-	MetadataHandler::~MetadataHandler()
+	MetadataHandler::~MetadataHandler() = default;
+
+	void MetadataHandler::OnFinalRelease() noexcept
 	{
+		// Pooled handlers don't hold a reference to the DLL, so they don't keep it from unloading.
+		// Whatever doesn't fit into the pool is deleted right away.
+		Reset();
+		g_HandlerPool.Push(std::unique_ptr<MetadataHandler>(this));
 		DllRelease();
 	}
 
@@ -207,61 +302,37 @@ namespace BethesdaModule::ShellView
 
 	HRESULT MetadataHandler::GetCount(DWORD* pcProps)
 	{
-		*pcProps = 0;
+		static_assert(std::size(g_PropertyKeys) == PropertyCount);
+
+		if (!pcProps)
+		{
+			return E_POINTER;
+		}
+
+		*pcProps = static_cast<DWORD>(PropertyCount);
 		return S_OK;
 	}
 	HRESULT MetadataHandler::GetAt(DWORD iProp, PROPERTYKEY* pkey)
 	{
-		*pkey = PKEY_Null;
-		return E_UNEXPECTED;
-	}
-	HRESULT MetadataHandler::GetValue(REFPROPERTYKEY key, PROPVARIANT* pPropVar)
-	{
-		if (key == PKEY_Author)
+		if (!pkey)
 		{
-			VariantProperty property;
-			property = StringOrNone(m_FileInfo.Author);
-			return property.Detach(*pPropVar);
+			return E_POINTER;
 		}
-		if (key == PKEY_Comment)
+		if (iProp >= PropertyCount)
 		{
-			VariantProperty property;
-			property = StringOrNone(m_FileInfo.Description);
-			return property.Detach(*pPropVar);
+			*pkey = PKEY_Null;
+			return E_INVALIDARG;
 		}
-		if (key == PKEY_FileVersion)
-		{
-			VariantProperty property;
-			if (m_FileInfo.FormVersion != 0)
-			{
-				property = m_FileInfo.FormVersion;
-			}
-			else
-			{
-				property = wxS("<Unknown>");
-			}
-			return property.Detach(*pPropVar);
-		}
-		if (key == PKEY_ContentType)
-		{
-			String content = HeaderFlagsDef::ToOrExpression(m_FileInfo.Flags);
 
-			VariantProperty property;
-			property = !content.IsEmpty() ? content : wxS("Normal");
-			return property.Detach(*pPropVar);
-		}
-		if (key == PKEY_DataObjectFormat)
-		{
-			VariantProperty property;
-			property = FormatLevelDef::TryToString(m_FileInfo.FormatLevel).value_or(StringView(wxS("<Unknown>")));
-			return property.Detach(*pPropVar);
-		}
-		if (key == PKEY_Keywords)
+		*pkey = *g_PropertyKeys[iProp];
+		return S_OK;
+	}
+	HRESULT MetadataHandler::GetValue(REFPROPERTYKEY key, PROPVARIANT* pPropVar)
+	{
+		if (auto index = FindProperty(key))
 		{
-			// Required files
-			VariantProperty property;
-			property = StringOrNone(ConcatWithSeparator(m_FileInfo.RequiredFiles, wxS("; ")));
-			return property.Detach(*pPropVar);
+			// One 'PropVariantCopy' per call, the value itself is built only once per handler
+			return ::PropVariantCopy(pPropVar, &GetPropertyValue(*index));
 		}
 		return S_FALSE;
 	}
@@ -284,19 +355,43 @@ namespace BethesdaModule::ShellView
 
 	HRESULT MetadataHandler::Initialize(IStream* stream, DWORD streamAccess)
 	{
-		if (m_Stream.Open(*stream) && m_Stream.ReadStringASCII(m_FileInfo.Signature, 4))
+		if (!m_Source.Open(*stream))
 		{
-			if (m_FileInfo.Signature == wxS("TES3"))
-			{
-				return *ReadMorrowind();
-			}
-			else if (m_FileInfo.Signature == wxS("TES4"))
+			return *m_Source.GetLastError();
+		}
+
+		const auto fileInfo = m_Source.GetFileInfo();
+		if (!fileInfo)
+		{
+			return *ReadHeader(nullptr, m_Info);
+		}
+
+		// Answer from the caches if the file hasn't changed, this doesn't touch the stream data at all
+		Core::ModuleInfoCache& memoryCache = GetModuleInfoCache();
+		const Core::CacheKey key = MakeCacheKey(*fileInfo);
+		if (m_Info = memoryCache.Find(key))
+		{
+			return S_OK;
+		}
+
+		Core::MetadataCache& diskCache = GetMetadataCache();
+		if (Core::ModuleInfo info; diskCache.Find(key, info))
+		{
+			m_Info = memoryCache.Put(key, Core::PackedModuleInfo::FromModuleInfo(info));
+			return S_OK;
+		}
+
+		Core::PackedModuleInfo info;
+		HResult hr = ReadHeader(&*fileInfo, info);
+		if (*hr == S_OK)
+		{
+			if (diskCache.IsOpen())
 			{
-				return *ReadOblivionSkyrim();
+				diskCache.Put(key, info.ToModuleInfo());
 			}
-			return S_FALSE;
+			m_Info = memoryCache.Put(key, std::move(info));
 		}
-		return *m_Stream.GetLastError();
+		return *hr;
 	}
 }
 
@@ -1,10 +1,15 @@
 #pragma once
 #include "BethesdaModule.hpp"
 #include "Utility/COMRefCount.h"
-#include "Utility/COMIStream.h"
+#include "Utility/IStreamByteSource.h"
+#include "Utility/VariantProperty.h"
+#include "Core/FreeList.h"
+#include "Core/ModuleInfoCache.h"
 #include <shlwapi.h>
 #include <propkey.h>
 #include <propsys.h>
+#include <array>
+#include <mutex>
 
 #include <Kx/System/COM.h>
 #include <Kx/System/ErrorCodeValue.h>
@@ -13,14 +18,7 @@
 
 namespace BethesdaModule::ShellView
 {
-	enum class FormatLevel
-	{
-		Unknown = 0,
-
-		Morrowind,
-		Oblivion,
-		Skyrim
-	};
+	using Core::FormatLevel;
 	struct FormatLevelDef final: public IndexedEnumDefinition<FormatLevelDef, FormatLevel, StringView>
 	{
 		inline static constexpr TItem Items[] =
@@ -31,14 +29,7 @@ namespace BethesdaModule::ShellView
 		};
 	};
 
-	enum class HeaderFlags: uint32_t
-	{
-		None = 0,
-		Master = 1 << 0,
-		Localized = 1 << 7,
-		Light = 1 << 9,
-		Ignored = 1 << 12,
-	};
+	using Core::HeaderFlags;
 	struct HeaderFlagsDef final: public IndexedEnumDefinition<HeaderFlagsDef, HeaderFlags, StringView>
 	{
 		inline static constexpr TItem Items[] =
@@ -52,7 +43,7 @@ namespace BethesdaModule::ShellView
 }
 namespace KxFramework::EnumClass
 {
-	Kx_EnumClass_AllowEverything(BethesdaModule::ShellView::HeaderFlags);
+	Kx_EnumClass_AllowEverything(BethesdaModule::Core::HeaderFlags);
 }
 
 namespace BethesdaModule::ShellView
@@ -62,31 +53,51 @@ namespace BethesdaModule::ShellView
 		public:
 			static HRESULT CreateInstance(REFIID riid, void** ppv);
 
+		private:
+			enum class PropertyIndex: size_t
+			{
+				Author,
+				Comment,
+				FileVersion,
+				ContentType,
+				DataObjectFormat,
+				Keywords,
+
+				Count
+			};
+			static constexpr size_t PropertyCount = static_cast<size_t>(PropertyIndex::Count);
+
 		private:
 			COMRefCount<MetadataHandler, ULONG, 1> m_RefCount;
-			COMIStream m_Stream;
+			IStreamByteSource m_Source;
 
-			struct
-			{
-				String Signature;
-				HeaderFlags Flags = HeaderFlags::None;
-				uint32_t FormVersion = 0;
-				String Author;
-				String Description;
-				std::vector<String> RequiredFiles;
-				FormatLevel FormatLevel = FormatLevel::Unknown;
-			} m_FileInfo;
+			// Scratch space for the header record and the header itself, packed into a single block that's either
+			// parsed here or shared with the caches. Text is kept as it's stored in the file and decoded only when requested.
+			std::vector<std::byte> m_HeaderData;
+			Core::PackedModuleInfo m_Info;
+
+			// Property values are built on the first request and only copied out afterwards
+			std::mutex m_ValuesMutex;
+			std::array<VariantProperty, PropertyCount> m_Values;
+			std::array<std::atomic<bool>, PropertyCount> m_ValuesReady = {};
 
 		private:
-			HResult ReadMorrowind();
-			HResult ReadOblivionSkyrim();
-			HResult ReadOblivion();
-			HResult ReadSkyrim(uint32_t formVersion);
+			HResult ReadHeader(const IStreamFileInfo* fileInfo, Core::PackedModuleInfo& info);
+			void Reset() noexcept;
+
+			static std::optional<PropertyIndex> FindProperty(REFPROPERTYKEY key) noexcept;
+			VariantProperty CreateValue(PropertyIndex index) const;
+			const VariantProperty& GetPropertyValue(PropertyIndex index);
 
 		public:
 			MetadataHandler();
 			~MetadataHandler();
 
+		public:
+			// Called by the reference counter instead of deleting the handler. Released handlers are reset and kept
+			// for reuse, with their buffers, up to a fixed number of them.
+			void OnFinalRelease() noexcept;
+
 		public:
 			// IUnknown
 			ULONG STDMETHODCALLTYPE AddRef() override
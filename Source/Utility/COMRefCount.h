@@ -27,9 +27,23 @@ namespace BethesdaModule::ShellView
 				const T refCount = --m_RefCount;
 				if (refCount == 0)
 				{
-					delete m_Object;
+					// Objects that can be reused decide themselves what happens to them
+					if constexpr (requires(TObject& object) { object.OnFinalRelease(); })
+					{
+						m_Object->OnFinalRelease();
+					}
+					else
+					{
+						delete m_Object;
+					}
 				}
 				return refCount;
 			}
+
+			// Makes a released object usable again
+			void Reset() noexcept
+			{
+				m_RefCount = initialValue;
+			}
 	};
 }
@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "IStreamByteSource.h"
+#include <Kx/Utility/CallAtScopeExit.h>
+
+namespace BethesdaModule::ShellView
+{
+	size_t IStreamAccessor::Read(void* buffer, size_t size)
+	{
+		ULONG read = 0;
+		if (m_LastError = m_Stream.Read(buffer, static_cast<ULONG>(size), &read))
+		{
+			return read;
+		}
+		return 0;
+	}
+	size_t IStreamAccessor::Write(const void* buffer, size_t size)
+	{
+		ULONG written = 0;
+		if (m_LastError = m_Stream.Write(buffer, static_cast<ULONG>(size), &written))
+		{
+			return written;
+		}
+		return 0;
+	}
+	std::optional<uint64_t> IStreamAccessor::Seek(int64_t offset, Core::SeekOrigin origin)
+	{
+		LARGE_INTEGER move = {};
+		move.QuadPart = offset;
+
+		ULARGE_INTEGER newPos = {};
+		switch (origin)
+		{
+			case Core::SeekOrigin::Start:
+			{
+				m_LastError = m_Stream.Seek(move, STREAM_SEEK_SET, &newPos);
+				break;
+			}
+			case Core::SeekOrigin::Current:
+			{
+				m_LastError = m_Stream.Seek(move, STREAM_SEEK_CUR, &newPos);
+				break;
+			}
+			case Core::SeekOrigin::End:
+			{
+				m_LastError = m_Stream.Seek(move, STREAM_SEEK_END, &newPos);
+				break;
+			}
+		};
+
+		if (m_LastError)
+		{
+			return newPos.QuadPart;
+		}
+		return {};
+	}
+}
+
+namespace BethesdaModule::ShellView
+{
+	bool IStreamByteSource::Open(IStream& stream)
+	{
+		m_Stream = nullptr;
+		m_ReadAhead.Reset();
+		m_LastError = stream.QueryInterface(&m_Stream);
+
+		return m_LastError.IsSuccess();
+	}
+	void IStreamByteSource::Close()
+	{
+		m_Stream = nullptr;
+		m_ReadAhead.Reset();
+	}
+
+	std::optional<IStreamFileInfo> IStreamByteSource::GetFileInfo() const
+	{
+		if (m_Stream)
+		{
+			STATSTG stat = {};
+			Utility::CallAtScopeExit atExit = [&]()
+			{
+				if (stat.pwcsName)
+				{
+					COM::FreeMemory(stat.pwcsName);
+				}
+			};
+
+			if (m_Stream->Stat(&stat, STATFLAG_DEFAULT) == S_OK)
+			{
+				IStreamFileInfo info;
+				info.Name = stat.pwcsName ? stat.pwcsName : L"";
+				info.Size = stat.cbSize.QuadPart;
+				info.LastWriteTime = static_cast<int64_t>(static_cast<uint64_t>(stat.mtime.dwHighDateTime) << 32|stat.mtime.dwLowDateTime);
+				return info;
+			}
+		}
+		return {};
+	}
+	size_t IStreamByteSource::ReadAt(uint64_t offset, void* buffer, size_t size)
+	{
+		if (m_Stream)
+		{
+			IStreamAccessor accessor(*m_Stream, m_LastError);
+			if (m_ReadAhead.Seek(accessor, static_cast<int64_t>(offset), Core::SeekOrigin::Start))
+			{
+				return m_ReadAhead.Read(accessor, buffer, size);
+			}
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "BethesdaModule.hpp"
+#include "Core/ByteSource.h"
+#include "Core/ReadAheadBuffer.h"
+#include <Kx/System/ErrorCodeValue.h>
+#include <Kx/FileSystem/FSPath.h>
+#include <objidl.h>
+
+namespace BethesdaModule::ShellView
+{
+	// Adapts 'IStream' to the stream interface 'Core::ReadAheadBuffer' expects
+	class IStreamAccessor final
+	{
+		private:
+			IStream& m_Stream;
+			HResult& m_LastError;
+
+		public:
+			IStreamAccessor(IStream& stream, HResult& lastError) noexcept
+				:m_Stream(stream), m_LastError(lastError)
+			{
+			}
+
+		public:
+			size_t Read(void* buffer, size_t size);
+			size_t Write(const void* buffer, size_t size);
+			std::optional<uint64_t> Seek(int64_t offset, Core::SeekOrigin origin);
+	};
+
+	// What 'IStream::Stat' tells about the file behind the stream
+	struct IStreamFileInfo final
+	{
+		// Usually just the file name, not the full path
+		std::wstring Name;
+		uint64_t Size = 0;
+		int64_t LastWriteTime = 0;
+	};
+
+	// 'Core::ByteSource' over a COM stream. Reads go straight to the stream through the read-ahead buffer.
+	class IStreamByteSource final
+	{
+		private:
+			COMPtr<IStream> m_Stream;
+			Core::ReadAheadBuffer m_ReadAhead;
+			HResult m_LastError = S_OK;
+
+		public:
+			IStreamByteSource() = default;
+			IStreamByteSource(IStream& stream)
+			{
+				Open(stream);
+			}
+
+		public:
+			bool Open(IStream& stream);
+			void Close();
+			bool IsOpen() const
+			{
+				return m_Stream != nullptr;
+			}
+
+			HResult GetLastError() const
+			{
+				return m_LastError;
+			}
+			const Core::ReadAheadStats& GetStreamStats() const
+			{
+				return m_ReadAhead.GetStats();
+			}
+
+			std::optional<IStreamFileInfo> GetFileInfo() const;
+			size_t ReadAt(uint64_t offset, void* buffer, size_t size);
+	};
+}
@@ -0,0 +1,75 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> g_AllocationCount = 0;
+
+	void* Allocate(size_t size)
+	{
+		g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		if (void* ptr = std::malloc(size != 0 ? size : 1))
+		{
+			return ptr;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	size_t GetAllocationCount() noexcept
+	{
+		return g_AllocationCount.load(std::memory_order_relaxed);
+	}
+}
+
+// Aligned forms aren't replaced, nothing in the tool uses over-aligned types
+void* operator new(size_t size)
+{
+	return Allocate(size);
+}
+void* operator new[](size_t size)
+{
+	return Allocate(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return Allocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return Allocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+
+namespace BethesdaModule::Tool
+{
+	// Number of global 'operator new' calls made by the tool so far. The counting operators are replaced for the whole executable.
+	size_t GetAllocationCount() noexcept;
+}
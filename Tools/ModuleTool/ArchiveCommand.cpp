@@ -0,0 +1,94 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/Archive.h"
+#include <iostream>
+#include <fstream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	void AppendStats(std::string& buffer, const Core::ArchiveStats& stats)
+	{
+		buffer += "\"format\":";
+		Tool::AppendJSONString(buffer, stats.Format == Core::ArchiveFormat::BSA ? "bsa" : "ba2");
+		buffer += ",\"version\":" + std::to_string(stats.Version);
+		buffer += ",\"folders\":" + std::to_string(stats.Folders);
+		buffer += ",\"files\":" + std::to_string(stats.Files);
+		buffer += ",\"size\":" + std::to_string(stats.ArchiveSize);
+		buffer += ",\"bytesRead\":" + std::to_string(stats.BytesRead);
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunArchive(const CommandLine& args)
+	{
+		auto pathValue = args.GetPositional(0);
+		if (!pathValue)
+		{
+			std::cerr << "archive: a .bsa or .ba2 file is required\n";
+			return 1;
+		}
+
+		Core::Archive archive;
+		if (const Core::ParseStatus status = archive.Open(std::filesystem::path(*pathValue)); status != Core::ParseStatus::Success)
+		{
+			std::cerr << "archive: can't open '" << *pathValue << "': " << Core::GetParseStatusName(status) << '\n';
+			return 1;
+		}
+
+		std::string buffer = "{";
+		if (auto path = args.GetOption("extract"))
+		{
+			auto output = args.GetOption("output");
+			if (!output)
+			{
+				std::cerr << "archive: --extract needs --output\n";
+				return 1;
+			}
+
+			std::vector<std::byte> data;
+			if (const Core::ParseStatus status = archive.Extract(*path, data); status != Core::ParseStatus::Success)
+			{
+				std::cerr << "archive: can't extract '" << *path << "': " << (archive.Contains(*path) ? Core::GetParseStatusName(status) : "not found") << '\n';
+				return 2;
+			}
+
+			std::ofstream stream(std::filesystem::path(*output), std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (!stream)
+			{
+				std::cerr << "archive: can't write '" << *output << "'\n";
+				return 1;
+			}
+
+			buffer += "\"path\":";
+			AppendJSONString(buffer, *path);
+			buffer += ",\"extracted\":" + std::to_string(data.size()) + ',';
+		}
+		else if (auto path = args.GetOption("find"))
+		{
+			auto entry = archive.Find(*path);
+			buffer += "\"path\":";
+			AppendJSONString(buffer, *path);
+			if (entry)
+			{
+				buffer += ",\"offset\":" + std::to_string(entry->Offset);
+				buffer += ",\"stored\":" + std::to_string(entry->Size);
+				buffer += entry->Compressed ? ",\"compressed\":true," : ",\"compressed\":false,";
+			}
+			else
+			{
+				buffer += ",\"status\":\"missing\",";
+			}
+		}
+
+		// How much of the archive it took
+		AppendStats(buffer, archive.GetStats());
+		buffer += "}\n";
+		std::cout << buffer;
+		std::cout.flush();
+		return 0;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Commands.h"
+#include "Core/ModuleScanner.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+// Suites of 'bench', one file each. Suites that check their results return nonzero on a mismatch and are registered
+// with CTest in CMakeLists.txt.
+namespace BethesdaModule::Tool
+{
+	struct BenchResult final
+	{
+		double Seconds = 0;
+		uint64_t BytesRead = 0;
+		size_t Checksum = 0;
+	};
+
+	template<class TFunc>
+	BenchResult MeasureBest(size_t iterations, TFunc&& func)
+	{
+		// Best of N is the least noisy figure for short runs
+		BenchResult best;
+		for (size_t i = 0; i < std::max<size_t>(iterations, 1); i++)
+		{
+			BenchResult result;
+			const auto startTime = std::chrono::steady_clock::now();
+			func(result);
+			result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			if (i == 0 || result.Seconds < best.Seconds)
+			{
+				best = result;
+			}
+		}
+		return best;
+	}
+
+	// Folder generated files go to, '--dir' or one in the temporary directory
+	std::filesystem::path GetCorpusDirectory(const CommandLine& args);
+
+	// Headers of a synthetic library as a scan would return them: every supported game, some masters and light
+	// plugins, and master lists drawn from the same popular files
+	std::vector<Core::ScanResult> GenerateLibrary(size_t count, size_t threadCount);
+
+	int BenchSources(const CommandLine& args);
+	int BenchFormats(const CommandLine& args);
+	int BenchStream(const CommandLine& args);
+	int BenchFuzz(const CommandLine& args);
+	int BenchLRU(const CommandLine& args);
+	int BenchCache(const CommandLine& args);
+	int BenchRecords(const CommandLine& args);
+	int BenchInflate(const CommandLine& args);
+	int BenchLoadOrder(const CommandLine& args);
+	int BenchFormIDs(const CommandLine& args);
+	int BenchStrings(const CommandLine& args);
+	int BenchPacked(const CommandLine& args);
+	int BenchRecycle(const CommandLine& args);
+	int BenchProperties(const CommandLine& args);
+	int BenchText(const CommandLine& args);
+	int BenchStringTables(const CommandLine& args);
+	int BenchArchives(const CommandLine& args);
+	int BenchWatch(const CommandLine& args);
+	int BenchBatch(const CommandLine& args);
+	int BenchTable(const CommandLine& args);
+	int BenchQuery(const CommandLine& args);
+	int BenchSnapshot(const CommandLine& args);
+}
@@ -0,0 +1,167 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/Archive.h"
+#include "Core/StringTable.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchArchives(const CommandLine& args)
+	{
+		const size_t iterations = args.GetOption("iterations", size_t(3));
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(20000)), 1);
+		const size_t fileSize = args.GetOption("file-size", size_t(4096));
+
+		// Loose files plus the string tables of a localized master, what an official '- Interface' archive holds
+		const size_t tableEntries = args.GetOption("entries", size_t(50000));
+		std::vector<ArchiveFixtureFile> files = GenerateArchiveFiles(count, std::max<size_t>(count / 64, 1), fileSize);
+		for (Core::StringTableType type: Core::StringTableTypes)
+		{
+			StringTableFixtureOptions tableOptions;
+			tableOptions.Type = type;
+			tableOptions.Count = tableEntries;
+
+			ArchiveFixtureFile& file = files.emplace_back();
+			file.Path = "Strings/ArchiveFixture_english." + std::string(Core::GetStringTableExtension(type));
+			file.Data = GenerateStringTable(tableOptions);
+		}
+		const std::string tablePath = files[files.size() - std::size(Core::StringTableTypes)].Path;
+
+		struct Variant final
+		{
+			std::string_view Name;
+			ArchiveFixtureOptions Options;
+		};
+		const Variant variants[] =
+		{
+			{"bsa103", {Core::ArchiveFormat::BSA, 103, true, 5, false}},
+			{"bsa104", {Core::ArchiveFormat::BSA, 104, true, 5, true}},
+			{"bsa105", {Core::ArchiveFormat::BSA, 105, true, 5, false}},
+			{"ba2", {Core::ArchiveFormat::BA2, 1, true, 0, false}},
+			{"ba2-raw", {Core::ArchiveFormat::BA2, 1, false, 0, false}},
+			{"ba2-v3", {Core::ArchiveFormat::BA2, 3, true, 0, false}},
+		};
+
+		const std::filesystem::path directory = GetCorpusDirectory(args);
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+		}
+
+		std::cout << files.size() << " files per archive, string table '" << tablePath << "'\n";
+		std::cout << std::left << std::setw(9) << "archive" << std::right << std::setw(12) << "size" << std::setw(10) << "open ms" << std::setw(12) << "open read"
+			<< std::setw(12) << "table read" << std::setw(12) << "table ms" << std::setw(12) << "ns/lookup" << std::setw(10) << "MB/sec" << '\n';
+
+		size_t mismatches = 0;
+		for (const Variant& variant: variants)
+		{
+			const std::filesystem::path path = directory / (std::string("Fixture - ") + std::string(variant.Name) + (variant.Options.Format == Core::ArchiveFormat::BSA ? ".bsa" : ".ba2"));
+			{
+				const std::vector<std::byte> data = GenerateArchive(variant.Options, files);
+				std::ofstream stream(path, std::ios::binary|std::ios::trunc);
+				stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+				if (!stream)
+				{
+					std::cerr << "bench archives: can't write '" << path.string() << "'\n";
+					return 1;
+				}
+			}
+
+			// Cold: open and pull out a single string table, what resolving one localized plugin costs
+			auto startTime = std::chrono::steady_clock::now();
+			Core::Archive archive;
+			if (archive.Open(path) != Core::ParseStatus::Success)
+			{
+				std::cerr << "bench archives: can't open '" << path.string() << "'\n";
+				return 1;
+			}
+			const double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const uint64_t openRead = archive.GetStats().BytesRead;
+
+			std::vector<std::byte> table;
+			startTime = std::chrono::steady_clock::now();
+			if (archive.Extract(tablePath, table) != Core::ParseStatus::Success || table != files[files.size() - std::size(Core::StringTableTypes)].Data)
+			{
+				mismatches++;
+			}
+			const double tableSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const uint64_t tableRead = archive.GetStats().BytesRead - openRead;
+
+			// Warm lookups of every file, then extraction of everything
+			const BenchResult lookups = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				for (const ArchiveFixtureFile& file: files)
+				{
+					if (auto entry = archive.Find(file.Path))
+					{
+						result.Checksum += entry->Size;
+					}
+				}
+			});
+			std::vector<std::byte> data;
+			const BenchResult extract = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				for (const ArchiveFixtureFile& file: files)
+				{
+					if (archive.Extract(file.Path, data) == Core::ParseStatus::Success)
+					{
+						result.BytesRead += data.size();
+						result.Checksum += data.size();
+					}
+				}
+			});
+
+			// Every file must come back as it was written and made-up ones must not be found. '.ba2' only keeps four
+			// characters of an extension, so the names are changed instead.
+			for (const ArchiveFixtureFile& file: files)
+			{
+				if (archive.Extract(file.Path, data) != Core::ParseStatus::Success || data != file.Data)
+				{
+					mismatches++;
+				}
+				const size_t dot = file.Path.rfind('.');
+				const std::string otherName = file.Path.substr(0, dot) + '_' + file.Path.substr(dot);
+				if (archive.Contains(otherName) || archive.Contains("Missing/" + file.Path))
+				{
+					mismatches++;
+				}
+			}
+
+			// An entry reaching past the end of the archive fails before anything is allocated for it
+			if (auto entry = archive.Find(files.front().Path))
+			{
+				data.clear();
+				data.shrink_to_fit();
+
+				entry->Offset = archive.GetStats().ArchiveSize - entry->Size + 1;
+				if (archive.Extract(*entry, data) != Core::ParseStatus::Truncated || data.capacity() != 0)
+				{
+					mismatches++;
+				}
+			}
+
+			const Core::ArchiveStats stats = archive.GetStats();
+			std::cout << std::left << std::setw(9) << variant.Name << std::right << std::setw(12) << stats.ArchiveSize << std::fixed << std::setprecision(2) << std::setw(10) << openSeconds * 1000.0
+				<< std::setw(12) << openRead << std::setw(12) << tableRead << std::setw(12) << tableSeconds * 1000.0 << std::setprecision(1)
+				<< std::setw(12) << lookups.Seconds * 1e9 / files.size() << std::setw(10) << extract.BytesRead / std::max(extract.Seconds, 1e-9) / (1024.0 * 1024.0) << '\n';
+		}
+
+		// Tables missing from the 'Strings' folder are found in the archives added to the cache
+		Core::StringTableCache cache;
+		auto archive = std::make_shared<Core::Archive>();
+		archive->Open(directory / "Fixture - bsa105.bsa");
+		cache.AddArchive(archive);
+		size_t resolved = 0;
+		for (Core::StringTableType type: Core::StringTableTypes)
+		{
+			if (auto loaded = cache.Get(directory / "ArchiveFixture.esm", "english", type); loaded && loaded->GetStats().ExtractedSize != 0 && loaded->GetCount() == tableEntries)
+			{
+				resolved++;
+			}
+		}
+		std::cout << "string tables resolved through the archive: " << resolved << "\nmismatches: " << mismatches << '\n';
+		return mismatches == 0 && resolved == std::size(Core::StringTableTypes) ? 0 : 1;
+	}
+}
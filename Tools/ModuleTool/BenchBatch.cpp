@@ -0,0 +1,101 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/Parallel.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchBatch(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(10000)), 1);
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+		const size_t maxThreads = std::max<size_t>(args.GetOption("threads", Core::GetDefaultThreadCount()), 1);
+
+		FixtureOptions options;
+		options.MasterCount = args.GetOption("masters", size_t(8));
+		options.BodySize = args.GetOption("body", size_t(4 * 1024));
+
+		const auto files = GenerateModuleCorpus(GetCorpusDirectory(args), count, options);
+		if (files.size() != count)
+		{
+			std::cerr << "bench batch: can't write the corpus\n";
+			return 1;
+		}
+
+		// Preloaded files take the disk and the page cache out, what's left is parsing
+		std::vector<std::vector<std::byte>> contents;
+		for (const auto& path: files)
+		{
+			std::ifstream stream(path, std::ios::binary);
+			contents.emplace_back(std::filesystem::file_size(path));
+			stream.read(reinterpret_cast<char*>(contents.back().data()), static_cast<std::streamsize>(contents.back().size()));
+		}
+		std::vector<Core::MemoryByteSource> sources;
+		for (const auto& content: contents)
+		{
+			sources.emplace_back(content);
+		}
+
+		// Single-threaded results in input order, every other run has to produce exactly the same
+		std::vector<Core::ScanResult> expected = Core::ModuleScanner(1).ScanBatch(files);
+		size_t mismatches = 0;
+		auto Verify = [&](const std::vector<Core::ScanResult>& results, bool hasPaths)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const Core::ScanResult& result = results[i];
+				mismatches += (hasPaths && result.Path != expected[i].Path) || result.Status != expected[i].Status || result.FileSize != expected[i].FileSize
+					|| result.Info.Author != expected[i].Info.Author || result.Info.Masters != expected[i].Info.Masters;
+			}
+		};
+
+		std::cout << "Corpus: " << count << " files, " << options.MasterCount << " masters, " << Core::GetDefaultThreadCount() << " hardware thread(s)\n";
+		std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(16) << "shared files/s" << std::setw(18) << "stealing files/s"
+			<< std::setw(16) << "memory files/s" << std::setw(10) << "speedup" << '\n';
+
+		double baseline = 0;
+		for (size_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreads))
+		{
+			const Core::ModuleScanner scanner(threadCount);
+			std::vector<Core::ScanResult> results(count);
+
+			// Existing API: a shared counter hands out files, results come through a locked callback
+			const BenchResult shared = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				result.BytesRead += scanner.Scan(files, [&](const Core::ScanResult& scanResult)
+				{
+					result.Checksum += scanResult.Info.Masters.size();
+				}).BytesRead;
+			});
+			const BenchResult stealing = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				result.BytesRead += scanner.ScanBatch(files, std::span<Core::ScanResult>(results)).BytesRead;
+			});
+			Verify(results, true);
+
+			const BenchResult memory = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				result.BytesRead += scanner.ScanBatch(std::span<Core::MemoryByteSource>(sources), std::span<Core::ScanResult>(results)).BytesRead;
+			});
+			Verify(results, false);
+
+			if (threadCount == 1)
+			{
+				baseline = stealing.Seconds;
+			}
+			std::cout << std::left << std::setw(10) << threadCount << std::right << std::fixed << std::setprecision(0)
+				<< std::setw(16) << count / shared.Seconds << std::setw(18) << count / stealing.Seconds << std::setw(16) << count / memory.Seconds
+				<< std::setw(9) << std::setprecision(2) << baseline / stealing.Seconds << "x\n";
+
+			if (threadCount == maxThreads)
+			{
+				break;
+			}
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,253 @@
+#include "Bench.h"
+#include "Core/MetadataCache.h"
+#include "Core/Parallel.h"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	Core::CacheKey MakeKey(size_t index, size_t version)
+	{
+		Core::CacheKey key;
+		key.Name = "plugin" + std::to_string(index) + ".esp";
+		key.FileSize = 1000 + index + version;
+		key.LastWriteTime = static_cast<int64_t>(index);
+		return key;
+	}
+	Core::ModuleInfo MakeInfo(size_t index, size_t version)
+	{
+		Core::ModuleInfo info;
+		info.Signature = Core::MakeFourCC("TES4");
+		info.FormVersion = 44;
+		info.FormatLevel = Core::FormatLevel::Skyrim;
+		info.Author = "Author " + std::to_string(index);
+		info.Description = "Version " + std::to_string(version);
+		info.Masters = {"Skyrim.esm", "Update.esm"};
+		return info;
+	}
+
+	// Entries of the given version found with exactly what was put, anything found with different data is a mismatch
+	size_t CountFound(const Core::MetadataCache& cache, size_t count, size_t version, size_t& mismatches)
+	{
+		size_t found = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (Core::ModuleInfo info; cache.Find(MakeKey(i, version), info))
+			{
+				const Core::ModuleInfo expected = MakeInfo(i, version);
+				if (info.Signature == expected.Signature && info.FormVersion == expected.FormVersion && info.FormatLevel == expected.FormatLevel
+					&& info.Author == expected.Author && info.Description == expected.Description && info.Masters == expected.Masters)
+				{
+					found++;
+				}
+				else
+				{
+					mismatches++;
+				}
+			}
+		}
+		return found;
+	}
+
+	std::vector<char> ReadFile(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		std::vector<char> data(std::filesystem::file_size(path, error));
+		std::ifstream(path, std::ios::binary).read(data.data(), static_cast<std::streamsize>(data.size()));
+		return data;
+	}
+	void WriteFile(const std::filesystem::path& path, const std::vector<char>& data)
+	{
+		std::ofstream(path, std::ios::binary|std::ios::trunc).write(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	// The persistent header cache on a real file: appends, replaced entries, compaction, damaged logs and
+	// several instances sharing one log. Separate instances lock the log the same way separate processes do.
+	int BenchCache(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("entries", size_t(10000)), 8);
+		const size_t threadCount = std::max<size_t>(args.GetOption("threads", size_t(4)), 2);
+
+		const std::filesystem::path directory = GetCorpusDirectory(args);
+		const std::filesystem::path logPath = directory / "MetadataCache.bin";
+		std::filesystem::path tempPath = logPath;
+		tempPath += ".tmp";
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		std::filesystem::remove(logPath, error);
+		std::filesystem::remove(tempPath, error);
+
+		size_t mismatches = 0;
+		auto Check = [&](bool condition, std::string_view what)
+		{
+			if (!condition)
+			{
+				std::cout << "failed: " << what << '\n';
+				mismatches++;
+			}
+		};
+
+		// Appends survive reopening
+		{
+			Core::MetadataCache cache;
+			Check(cache.Open(logPath), "create");
+
+			const auto startTime = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < count; i++)
+			{
+				mismatches += !cache.Put(MakeKey(i, 0), MakeInfo(i, 0));
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			std::cout << std::fixed << std::setprecision(2) << "append: " << seconds * 1e6 / count << " us/entry\n";
+		}
+		{
+			Core::MetadataCache cache;
+			const auto startTime = std::chrono::steady_clock::now();
+			Check(cache.Open(logPath), "reopen");
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			std::cout << "load: " << seconds * 1000.0 << " ms for " << cache.GetStats().FileSize << " bytes\n";
+
+			Check(CountFound(cache, count, 0, mismatches) == count && cache.GetStats().DeadRecords == 0, "appended entries");
+
+			// A changed file replaces its entry and leaves a dead record behind
+			for (size_t i = 0; i < count; i += 2)
+			{
+				cache.Put(MakeKey(i, 1), MakeInfo(i, 1));
+			}
+			Check(cache.GetStats().DeadRecords == (count + 1) / 2, "dead records");
+		}
+		{
+			Core::MetadataCache cache;
+			Check(cache.Open(logPath), "reopen after replacing");
+			Check(CountFound(cache, count, 0, mismatches) == count / 2 && CountFound(cache, count, 1, mismatches) == (count + 1) / 2, "replaced entries");
+
+			// Compaction drops the dead records and goes through a temporary file it doesn't leave behind
+			const uint64_t sizeBefore = cache.GetStats().FileSize;
+			Check(cache.Compact(), "compact");
+			const Core::CacheStats stats = cache.GetStats();
+			Check(stats.DeadRecords == 0 && stats.Entries == count && stats.FileSize < sizeBefore && !std::filesystem::exists(tempPath), "compacted log");
+		}
+		{
+			Core::MetadataCache cache;
+			Check(cache.Open(logPath), "reopen after compaction");
+			Check(CountFound(cache, count, 0, mismatches) == count / 2 && CountFound(cache, count, 1, mismatches) == (count + 1) / 2, "compacted entries");
+		}
+
+		// A damaged record in the middle and a torn one at the end only lose these two. Loading rewrites the log,
+		// so the next load finds it intact.
+		{
+			std::vector<char> data = ReadFile(logPath);
+			data[data.size() / 2] ^= 0x5A;
+			data.resize(data.size() - 3);
+			WriteFile(logPath, data);
+
+			Core::MetadataCache cache;
+			Check(cache.Open(logPath), "open damaged");
+			Check(cache.GetStats().Entries == count - 2 && CountFound(cache, count, 0, mismatches) + CountFound(cache, count, 1, mismatches) == count - 2, "entries of damaged log");
+
+			Core::MetadataCache reloaded;
+			Check(reloaded.Open(logPath) && reloaded.GetStats().Entries == count - 2 && reloaded.GetStats().FileSize < data.size(), "repaired log");
+		}
+
+		// A compaction that crashed before its rename leaves a temporary file, which is neither loaded nor in the way
+		{
+			WriteFile(tempPath, std::vector<char>(4096, 'x'));
+
+			Core::MetadataCache cache;
+			Check(cache.Open(logPath) && cache.GetStats().Entries == count - 2, "open with a stale temporary file");
+			Check(cache.Compact() && cache.GetStats().Entries == count - 2 && !std::filesystem::exists(tempPath), "compact over a stale temporary file");
+		}
+
+		// Several instances append to the same log while another one keeps compacting it, nothing gets lost
+		{
+			std::atomic<size_t> writersLeft = threadCount - 1;
+			std::atomic<size_t> compactions = 0;
+			std::atomic<size_t> failures = 0;
+			Core::ParallelFor(threadCount, threadCount, [&](size_t thread)
+			{
+				Core::MetadataCache cache;
+				const bool isOpen = cache.Open(logPath);
+				failures += !isOpen;
+
+				if (thread == 0)
+				{
+					while (isOpen && writersLeft != 0)
+					{
+						failures += !cache.Compact();
+						compactions++;
+					}
+				}
+				else
+				{
+					for (size_t i = thread - 1; isOpen && i < count; i += threadCount - 1)
+					{
+						failures += !cache.Put(MakeKey(i, 2), MakeInfo(i, 2));
+					}
+					writersLeft--;
+				}
+			});
+
+			Core::MetadataCache cache;
+			Check(failures == 0 && cache.Open(logPath), "concurrent appends");
+			Check(CountFound(cache, count, 2, mismatches) == count && cache.GetStats().Entries == count, "entries appended concurrently");
+			std::cout << "concurrent: " << threadCount - 1 << " writer(s), " << compactions << " compaction(s)\n";
+		}
+
+		// Copies of a file in two installs with the same size and time are different entries when their paths are known
+		{
+			Check(Core::MetadataCache::MakeKeyName("Data/./Skyrim.ESM") == Core::MetadataCache::MakeKeyName("data/skyrim.esm")
+				&& Core::MetadataCache::MakeKeyName("Data/Skyrim.esm") != Core::MetadataCache::MakeKeyName("Other/Skyrim.esm")
+				&& Core::MetadataCache::MakeKeyName("Skyrim.ESM") == "skyrim.esm", "key names");
+
+			const std::filesystem::path paths[] = {directory / "First" / "Update.esm", directory / "Second" / "Update.esm"};
+			for (const std::filesystem::path& path: paths)
+			{
+				std::filesystem::create_directories(path.parent_path(), error);
+				WriteFile(path, std::vector<char>(64, 'x'));
+			}
+			std::filesystem::last_write_time(paths[1], std::filesystem::last_write_time(paths[0], error), error);
+
+			const Core::CacheKey keys[] = {Core::CacheKey::FromFile(paths[0]), Core::CacheKey::FromFile(paths[1])};
+			Check(keys[0].Name != keys[1].Name && keys[0].FileSize == keys[1].FileSize && keys[0].LastWriteTime == keys[1].LastWriteTime, "keys of copies");
+
+			Core::MetadataCache cache;
+			Check(cache.Open(logPath), "open for copies");
+			cache.Put(keys[0], MakeInfo(0, 10));
+			cache.Put(keys[1], MakeInfo(1, 11));
+
+			Core::ModuleInfo first;
+			Core::ModuleInfo second;
+			Check(cache.Find(keys[0], first) && cache.Find(keys[1], second) && first.Description == "Version 10" && second.Description == "Version 11", "entries of copies");
+		}
+
+		// Entries are limited, the oldest are dropped first, also from what's loaded
+		{
+			const size_t maxEntries = count / 4;
+			Core::MetadataCache cache;
+			cache.SetMaxEntries(maxEntries);
+			Check(cache.Open(logPath) && cache.GetStats().Entries <= maxEntries, "open with an entry limit");
+
+			size_t overLimit = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				cache.Put(MakeKey(i, 3), MakeInfo(i, 3));
+				overLimit += cache.GetStats().Entries > maxEntries;
+			}
+
+			Core::ModuleInfo info;
+			Check(overLimit == 0 && cache.Find(MakeKey(count - 1, 3), info) && !cache.Find(MakeKey(0, 3), info), "limited entries");
+			Check(cache.Compact() && cache.GetStats().Entries <= maxEntries && cache.Find(MakeKey(count - 1, 3), info), "compacted limited entries");
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,136 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/Parallel.h"
+#include <iostream>
+
+namespace
+{
+	using namespace BethesdaModule::Tool;
+
+	// 'Usage' holds a short description of the suite
+	constexpr Command g_Suites[] =
+	{
+		{"sources", "Header read through each byte source", BenchSources},
+		{"formats", "Header pipeline for every game and master count", BenchFormats},
+		{"stream", "Stream calls of a header read through the read-ahead buffer", BenchStream},
+		{"fuzz", "Broken and hostile headers, worst case parse time", BenchFuzz},
+		{"lru", "In-memory header cache shared by handlers", BenchLRU},
+		{"cache", "Persistent header cache: appends, compaction, damaged logs, shared use", BenchCache},
+		{"records", "Walking records and groups of a large module", BenchRecords},
+		{"inflate", "Decompressing compressed records", BenchInflate},
+		{"loadorder", "Resolving and updating a load order", BenchLoadOrder},
+		{"formids", "FormID index over a load order", BenchFormIDs},
+		{"strings", "Interned author and master names", BenchStrings},
+		{"packed", "Packed single block headers", BenchPacked},
+		{"recycle", "Handler objects, new or taken from the pool", BenchRecycle},
+		{"properties", "Property values, key lookup and store cloning", BenchProperties},
+		{"text", "Reference and SIMD text decoding", BenchText},
+		{"stringtables", "Mapped string table lookups", BenchStringTables},
+		{"archives", "Lazy archive index and extraction", BenchArchives},
+		{"watch", "Watched folder index latency", BenchWatch},
+		{"batch", "Work-stealing batch parsing", BenchBatch},
+		{"table", "Columnar store filters and sorts", BenchTable},
+		{"query", "Bitmap index queries", BenchQuery},
+		{"snapshot", "Arrow snapshot export and reading", BenchSnapshot},
+	};
+}
+
+namespace BethesdaModule::Tool
+{
+	std::filesystem::path GetCorpusDirectory(const CommandLine& args)
+	{
+		if (auto directory = args.GetOption("dir"))
+		{
+			return std::filesystem::path(*directory);
+		}
+		return std::filesystem::temp_directory_path() / "BethesdaModuleBench";
+	}
+
+	// Headers of a synthetic library as a scan would return them: every supported game, some masters and light
+	// plugins, and master lists drawn from the same popular files
+	std::vector<Core::ScanResult> GenerateLibrary(size_t count, size_t threadCount)
+	{
+		constexpr std::string_view masterNames[] =
+		{
+			"Skyrim.esm", "Update.esm", "Dawnguard.esm", "HearthFires.esm", "Dragonborn.esm",
+			"Unofficial Skyrim Special Edition Patch.esp", "SkyUI_SE.esp", "RaceMenu.esp", "SMIM-SE-Merged-All.esp", "Immersive Weapons.esp",
+		};
+
+		std::vector<std::vector<std::byte>> contents(count);
+		std::vector<std::filesystem::path> paths(count);
+		Core::ParallelFor(count, threadCount, [&](size_t i)
+		{
+			uint32_t state = static_cast<uint32_t>(i) * 2654435761u + 1;
+			auto Next = [&]()
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state;
+			};
+
+			const FixtureProfile& profile = FixtureProfiles[Next() % std::size(FixtureProfiles)];
+			FixtureOptions options;
+			options.FormatLevel = profile.FormatLevel;
+			options.FormVersion = profile.FormVersion;
+			options.Seed = static_cast<uint32_t>(i);
+			options.Author = "Author" + std::to_string(Next() % 500);
+			options.DescriptionLength = 16 + Next() % 96;
+
+			const uint32_t flags = Next();
+			options.Flags = static_cast<Core::HeaderFlags>((flags % 5 == 0 ? static_cast<uint32_t>(Core::HeaderFlags::Master) : 0)
+				|(flags % 4 == 1 ? static_cast<uint32_t>(Core::HeaderFlags::Light) : 0)
+				|(flags % 8 == 3 ? static_cast<uint32_t>(Core::HeaderFlags::Localized) : 0));
+
+			// Morrowind headers have no flags and only know about their own masters
+			if (profile.FormatLevel == Core::FormatLevel::Morrowind)
+			{
+				options.Flags = Core::HeaderFlags::None;
+				options.MasterNames = {"Morrowind.esm"};
+			}
+			else
+			{
+				const size_t first = Next() % 3;
+				options.MasterNames.assign(std::begin(masterNames) + first, std::begin(masterNames) + first + 1 + Next() % 7);
+			}
+			contents[i] = GenerateModule(options);
+
+			const std::string_view extension = Core::TestFlag(options.Flags, Core::HeaderFlags::Master) ? ".esm" : Core::TestFlag(options.Flags, Core::HeaderFlags::Light) ? ".esl" : ".esp";
+			paths[i] = "Plugin" + std::to_string(i) + std::string(extension);
+		});
+
+		std::vector<Core::MemoryByteSource> sources;
+		sources.reserve(count);
+		for (const auto& content: contents)
+		{
+			sources.emplace_back(content);
+		}
+
+		std::vector<Core::ScanResult> results(count);
+		Core::ModuleScanner(threadCount).ScanBatch(std::span<Core::MemoryByteSource>(sources), std::span<Core::ScanResult>(results));
+		for (size_t i = 0; i < count; i++)
+		{
+			results[i].Path = std::move(paths[i]);
+		}
+		return results;
+	}
+
+	int RunBench(const CommandLine& args)
+	{
+		const std::string_view name = args.GetPositional(0).value_or("sources");
+		for (const Command& suite: g_Suites)
+		{
+			if (suite.Name == name)
+			{
+				return suite.Run(args);
+			}
+		}
+
+		std::cerr << "bench: unknown suite '" << name << "', use one of:\n";
+		for (const Command& suite: g_Suites)
+		{
+			std::cerr << "  " << suite.Name << " - " << suite.Usage << '\n';
+		}
+		return 1;
+	}
+}
@@ -0,0 +1,97 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/FormIDIndex.h"
+#include "Core/Parallel.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchFormIDs(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(100)), 2);
+		const size_t threadCount = std::max<size_t>(args.GetOption("threads", Core::GetDefaultThreadCount()), 1);
+
+		// One big master and plugins overriding its forms and forms of the plugin before them
+		FixtureOptions options;
+		options.RecordCount = std::max<size_t>(args.GetOption("records", size_t(20000)), 1);
+		options.RecordSize = args.GetOption("record-size", size_t(16));
+		options.OverrideEvery = std::max<size_t>(args.GetOption("override-every", size_t(4)), 1);
+		options.MasterCount = 0;
+
+		const std::filesystem::path directory = GetCorpusDirectory(args) / "FormIDs";
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+		std::filesystem::create_directories(directory, error);
+
+		std::vector<std::filesystem::path> files;
+		for (size_t i = 0; i < count; i++)
+		{
+			const std::string name = i == 0 ? "Base.esm" : "Plugin" + std::to_string(i) + ".esp";
+			options.MasterNames.clear();
+			if (i != 0)
+			{
+				options.MasterNames.push_back("Base.esm");
+			}
+			if (i > 1)
+			{
+				options.MasterNames.push_back(files.back().filename().string());
+			}
+			options.Seed = static_cast<uint32_t>(i);
+
+			const std::vector<std::byte> content = GenerateModule(options);
+			files.push_back(directory / name);
+
+			std::ofstream stream(files.back(), std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+			if (!stream)
+			{
+				std::cerr << "bench: can't write the corpus\n";
+				return 1;
+			}
+		}
+
+		Core::FormIDIndex index;
+		const auto startTime = std::chrono::steady_clock::now();
+		index.Build(files, threadCount);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		const Core::FormIDIndexStats stats = index.GetStats();
+
+		// Random lookups of forms introduced by the master, most of them overridden somewhere
+		constexpr size_t lookups = 1000000;
+		size_t checksum = 0;
+		uint32_t state = 1;
+		const auto lookupStartTime = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; i++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			checksum += index.FindWinner(Core::MakeGlobalFormID(0, 0x800 + state % options.RecordCount)).value_or(0);
+		}
+		const double lookupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lookupStartTime).count();
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Load order: " << stats.Plugins << " plugins, " << stats.Records << " records on " << threadCount << " thread(s)\n";
+		std::cout << "build: " << seconds * 1000.0 << " ms (" << std::setprecision(0) << stats.Records / seconds << " records/sec)\n";
+		std::cout << std::setprecision(1) << "forms: " << stats.Forms << ", overrides: " << stats.Overrides << ", orphans: " << stats.Orphans << '\n';
+		std::cout << "memory: " << stats.MemoryUsage << " bytes (" << static_cast<double>(stats.MemoryUsage) / std::max<uint64_t>(stats.Records, 1) << " bytes/record)\n";
+		std::cout << "winner lookup: " << lookupSeconds * 1e9 / lookups << " ns  (checksum " << checksum << ")\n";
+
+		// Every override must be found among the definitions of its form, after the plugin introducing it
+		for (uint32_t plugin = 0; plugin < stats.Plugins; plugin++)
+		{
+			for (Core::GlobalFormID formID: index.GetOverrides(plugin))
+			{
+				const std::vector<uint32_t> definitions = index.FindDefinitions(formID);
+				if (std::find(definitions.begin(), definitions.end(), plugin) == definitions.end() || !std::is_sorted(definitions.begin(), definitions.end()))
+				{
+					std::cerr << "bench: definitions of a form overridden by plugin " << plugin << " are wrong\n";
+					return 1;
+				}
+			}
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,148 @@
+#include "Bench.h"
+#include "AllocationCounter.h"
+#include "CountingStream.h"
+#include "ModuleFixture.h"
+#include "Core/TextDecoder.h"
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	std::vector<size_t> ParseList(std::string_view value)
+	{
+		std::vector<size_t> items;
+		while (!value.empty())
+		{
+			const size_t end = std::min(value.find(','), value.size());
+			items.push_back(std::strtoull(std::string(value.substr(0, end)).c_str(), nullptr, 10));
+			value.remove_prefix(std::min(end + 1, value.size()));
+		}
+		return items;
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int BenchFormats(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(1000)), 1);
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+		const std::vector<size_t> masterCounts = ParseList(args.GetOption("masters", "0,8,64,254"));
+
+		FixtureOptions options;
+		options.AuthorLength = args.GetOption("author", size_t(16));
+		options.DescriptionLength = args.GetOption("description", size_t(64));
+		if (auto text = ParseFixtureText(args.GetOption("text", "ascii")))
+		{
+			options.Text = *text;
+		}
+		else
+		{
+			std::cerr << "bench: unknown text type, use 'ascii', '1252', '1251' or 'utf8'\n";
+			return 1;
+		}
+
+		std::vector<const FixtureProfile*> profiles;
+		if (auto name = args.GetOption("profile"))
+		{
+			if (const FixtureProfile* profile = FindFixtureProfile(*name))
+			{
+				profiles.push_back(profile);
+			}
+			else
+			{
+				std::cerr << "bench: unknown profile '" << *name << "'\n";
+				return 1;
+			}
+		}
+		else
+		{
+			for (const FixtureProfile& profile: FixtureProfiles)
+			{
+				profiles.push_back(&profile);
+			}
+		}
+
+		std::cout << "Full header pipeline (read, parse, copy, decode) per file, " << count << " files per row\n";
+		std::cout << std::left << std::setw(12) << "profile" << std::right << std::setw(8) << "masters"
+			<< std::setw(12) << "ns/file" << std::setw(12) << "bytes/file" << std::setw(12) << "calls/file" << std::setw(12) << "allocs/file" << '\n';
+
+		size_t mismatches = 0;
+		for (const FixtureProfile* profile: profiles)
+		{
+			for (size_t masterCount: masterCounts)
+			{
+				// Morrowind stores author and description in fixed size fields, but there's no limit on master count
+				options.FormatLevel = profile->FormatLevel;
+				options.FormVersion = profile->FormVersion;
+				options.MasterCount = profile->FormatLevel == Core::FormatLevel::Morrowind ? masterCount : std::min<size_t>(masterCount, 254);
+
+				std::vector<std::vector<std::byte>> contents;
+				for (size_t i = 0; i < count; i++)
+				{
+					options.Seed = static_cast<uint32_t>(i);
+					contents.emplace_back(GenerateModule(options));
+				}
+
+				size_t streamCalls = 0;
+				size_t allocations = 0;
+				const BenchResult result = MeasureBest(iterations, [&](BenchResult& result)
+				{
+					streamCalls = 0;
+					const size_t allocationsBefore = GetAllocationCount();
+
+					std::vector<std::byte> buffer;
+					std::string decoded;
+					for (const auto& content: contents)
+					{
+						CountingStream stream(content);
+						StreamByteSource source(stream);
+
+						Core::ModuleInfo info;
+						Core::ReadModuleInfo(source, buffer, info, &result.BytesRead);
+						streamCalls += source.GetStats().GetStreamCalls();
+
+						// What the shell extension does for every displayed property
+						Core::DecodeToUTF8(info.Author, decoded);
+						result.Checksum += decoded.size();
+						Core::DecodeToUTF8(info.Description, decoded);
+						result.Checksum += decoded.size();
+						for (const std::string& master: info.Masters)
+						{
+							Core::DecodeToUTF8(master, decoded);
+							result.Checksum += decoded.size();
+						}
+					}
+					allocations = GetAllocationCount() - allocationsBefore;
+				});
+
+				std::cout << std::left << std::setw(12) << profile->Name << std::right << std::setw(8) << options.MasterCount << std::fixed
+					<< std::setw(12) << std::setprecision(1) << result.Seconds * 1e9 / count
+					<< std::setw(12) << std::setprecision(0) << static_cast<double>(result.BytesRead) / count
+					<< std::setw(12) << std::setprecision(2) << static_cast<double>(streamCalls) / count
+					<< std::setw(12) << std::setprecision(2) << static_cast<double>(allocations) / count << '\n';
+
+				// Read through the stream every header has to come out as read from memory, with all of its masters
+				std::vector<std::byte> buffer;
+				for (const auto& content: contents)
+				{
+					Core::MemoryByteSource memory(content);
+					Core::ModuleInfo expected;
+					mismatches += Core::ReadModuleInfo(memory, buffer, expected) != Core::ParseStatus::Success || expected.FormatLevel != profile->FormatLevel
+						|| expected.Masters.size() != options.MasterCount;
+
+					CountingStream stream(content);
+					StreamByteSource source(stream);
+					Core::ModuleInfo info;
+					mismatches += Core::ReadModuleInfo(source, buffer, info) != Core::ParseStatus::Success || info.Signature != expected.Signature || info.Flags != expected.Flags
+						|| info.FormVersion != expected.FormVersion || info.Author != expected.Author || info.Description != expected.Description || info.Masters != expected.Masters;
+				}
+			}
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
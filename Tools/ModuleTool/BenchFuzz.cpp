@@ -0,0 +1,88 @@
+#include "Bench.h"
+#include "CountingStream.h"
+#include "ModuleFixture.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchFuzz(const CommandLine& args)
+	{
+		const size_t iterations = std::max<size_t>(args.GetOption("iterations", size_t(3)), 1);
+		const size_t mutants = args.GetOption("mutants", size_t(20000));
+		const double maxMicroseconds = static_cast<double>(args.GetOption("max-us", size_t(5000)));
+
+		Core::ParseLimits limits;
+		limits.ReadBudget = args.GetOption("budget", limits.ReadBudget);
+
+		std::vector<FixtureCase> corpus = GenerateHostileCorpus();
+		for (size_t i = 0; i < mutants; i++)
+		{
+			const FixtureProfile& profile = FixtureProfiles[i % std::size(FixtureProfiles)];
+
+			FixtureOptions options;
+			options.FormatLevel = profile.FormatLevel;
+			options.FormVersion = profile.FormVersion;
+			options.MasterCount = i % 16;
+			options.Seed = static_cast<uint32_t>(i);
+			corpus.push_back({std::string(profile.Name) + "/mutant-" + std::to_string(i), MutateModule(GenerateModule(options), static_cast<uint32_t>(i))});
+		}
+
+		struct CaseResult final
+		{
+			const FixtureCase* Case = nullptr;
+			Core::ParseStatus Status = Core::ParseStatus::Success;
+			double Seconds = 0;
+			uint64_t BytesRead = 0;
+		};
+		std::vector<CaseResult> results;
+		results.reserve(corpus.size());
+
+		std::vector<std::byte> buffer;
+		for (const FixtureCase& item: corpus)
+		{
+			// Least of N, worst case over the corpus is what matters and a single slow run is usually just noise
+			CaseResult result;
+			result.Case = &item;
+			for (size_t i = 0; i < iterations; i++)
+			{
+				CountingStream stream(item.Data);
+				StreamByteSource source(stream);
+
+				Core::ModuleInfo info;
+				uint64_t bytesRead = 0;
+				const auto startTime = std::chrono::steady_clock::now();
+				result.Status = Core::ReadModuleInfo(source, buffer, info, &bytesRead, limits);
+				const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+				result.BytesRead = bytesRead;
+				result.Seconds = i == 0 ? seconds : std::min(result.Seconds, seconds);
+			}
+			results.push_back(result);
+		}
+
+		std::sort(results.begin(), results.end(), [](const CaseResult& left, const CaseResult& right)
+		{
+			return left.Seconds > right.Seconds;
+		});
+
+		std::cout << "Hostile corpus: " << corpus.size() << " files, read budget " << limits.ReadBudget << " bytes\n";
+		std::cout << "Slowest cases:\n";
+		for (size_t i = 0; i < std::min<size_t>(results.size(), args.GetOption("top", size_t(10))); i++)
+		{
+			const CaseResult& result = results[i];
+			std::cout << "  " << std::left << std::setw(36) << result.Case->Name << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << result.Seconds * 1e6 << " us" << std::setw(12) << result.BytesRead << " bytes  "
+				<< Core::GetParseStatusName(result.Status) << '\n';
+		}
+
+		const double worst = !results.empty() ? results.front().Seconds * 1e6 : 0;
+		if (worst > maxMicroseconds)
+		{
+			std::cerr << "bench: worst case " << worst << " us is over the " << maxMicroseconds << " us bound\n";
+			return 1;
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,87 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/Parallel.h"
+#include "Core/RecordInflater.h"
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchInflate(const CommandLine& args)
+	{
+		const size_t iterations = args.GetOption("iterations", size_t(3));
+		const size_t threadCount = std::max<size_t>(args.GetOption("threads", Core::GetDefaultThreadCount()), 1);
+
+		// Large synthetic master with every record compressed
+		FixtureOptions options;
+		options.RecordCount = std::max<size_t>(args.GetOption("records", size_t(200000)), 1);
+		options.RecordSize = args.GetOption("record-size", size_t(512));
+		options.CompressedEvery = std::max<size_t>(args.GetOption("compressed-every", size_t(1)), 1);
+
+		const std::vector<std::byte> content = GenerateModule(options);
+		Core::ModuleHeader header;
+		Core::ParseModuleHeader(content, header);
+		const std::vector<Core::RecordEntry> records = Core::FindCompressedRecords(content, header);
+
+		std::cout << "File: " << content.size() << " bytes, " << records.size() << " compressed records of " << options.RecordSize << " bytes\n";
+		if (records.empty())
+		{
+			return 1;
+		}
+
+		auto Print = [&](std::string_view name, const BenchResult& result)
+		{
+			std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+				<< std::setw(10) << std::setprecision(1) << result.Seconds * 1e9 / records.size() << " ns/record"
+				<< std::setw(10) << std::setprecision(0) << result.BytesRead / result.Seconds / (1024.0 * 1024.0) << " MiB/sec"
+				<< "  (checksum " << result.Checksum << ")\n";
+		};
+		auto GetChecksum = [](std::span<const std::byte> data)
+		{
+			return data.size() + static_cast<size_t>(data.back());
+		};
+
+		Print("unpooled", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			for (const Core::RecordEntry& record: records)
+			{
+				std::vector<std::byte> data;
+				if (Core::InflateRecordUnpooled(std::span(content).subspan(record.DataOffset, record.DataSize), data) == Core::ParseStatus::Success)
+				{
+					result.BytesRead += data.size();
+					result.Checksum += GetChecksum(data);
+				}
+			}
+		}));
+		Print("pooled", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			Core::RecordInflater& inflater = Core::GetThreadInflater();
+			for (const Core::RecordEntry& record: records)
+			{
+				std::span<const std::byte> data;
+				if (inflater.Inflate(std::span(content).subspan(record.DataOffset, record.DataSize), data) == Core::ParseStatus::Success)
+				{
+					result.BytesRead += data.size();
+					result.Checksum += GetChecksum(data);
+				}
+			}
+		}));
+
+		Core::InflateStats stats;
+		Print("pooled-parallel", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			std::atomic<size_t> checksum = 0;
+			stats = Core::InflateRecords(content, records, threadCount, [&](size_t, std::span<const std::byte> data)
+			{
+				checksum += GetChecksum(data);
+			});
+			result.BytesRead = stats.UncompressedBytes;
+			result.Checksum = checksum;
+		}));
+
+		std::cout << std::setprecision(2) << "records: " << stats.Records << ", failed: " << stats.Failed << ", compressed: " << stats.CompressedBytes
+			<< " bytes, uncompressed: " << stats.UncompressedBytes << " bytes (ratio " << stats.GetRatio() << ") on " << threadCount << " thread(s)\n";
+		return stats.Failed == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,217 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/ModuleInfoCache.h"
+#include "Core/PackedModuleInfo.h"
+#include "Core/Parallel.h"
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	Core::PackedModuleInfo MakeInfo(const std::vector<std::byte>& content)
+	{
+		Core::ModuleHeader header;
+		Core::ParseModuleHeader(content, header);
+		return Core::PackedModuleInfo::FromHeader(content, header);
+	}
+	Core::PackedModuleInfo MakeInfo(std::string author)
+	{
+		Tool::FixtureOptions options;
+		options.Author = std::move(author);
+		return MakeInfo(Tool::GenerateModule(options));
+	}
+
+	// Replacing a changed file: the old version is gone, the new one is found and views taken before stay readable
+	size_t CheckReplace()
+	{
+		size_t mismatches = 0;
+		const Core::PackedModuleInfo first = MakeInfo("First");
+		const Core::PackedModuleInfo second = MakeInfo("Second");
+
+		const Core::CacheKey key = {"Skyrim.esm", 1000, 1};
+		Core::CacheKey changedTime = key;
+		changedTime.LastWriteTime++;
+		Core::CacheKey changedSize = key;
+		changedSize.FileSize++;
+
+		Core::ModuleInfoCache cache;
+		if (cache.Find(key))
+		{
+			mismatches++;
+		}
+		cache.Put(key, first);
+
+		const Core::PackedModuleInfo firstView = cache.Find(key);
+		if (firstView.GetAuthor() != "First")
+		{
+			mismatches++;
+		}
+		if (cache.Find(changedTime) || cache.Find(changedSize))
+		{
+			mismatches++;
+		}
+
+		cache.Put(changedTime, second);
+		if (cache.Find(key) || cache.Find(changedTime).GetAuthor() != "Second")
+		{
+			mismatches++;
+		}
+		cache.Put(changedSize, first);
+		if (cache.Find(changedTime) || cache.Find(changedSize).GetAuthor() != "First")
+		{
+			mismatches++;
+		}
+		if (firstView.GetAuthor() != "First")
+		{
+			mismatches++;
+		}
+
+		// 3 hits and 5 misses above, and only the latest version takes memory
+		const Core::ModuleInfoCacheStats stats = cache.GetStats();
+		if (stats.Hits != 3 || stats.Misses != 5 || stats.Entries != 1 || stats.Evictions != 0 || stats.MemoryUsage != Core::ModuleInfoCache::EstimateMemoryUsage(key.Name, first))
+		{
+			mismatches++;
+		}
+		return mismatches;
+	}
+
+	// Many more files than fit: memory stays under the limit, also when the limit is lowered later
+	size_t CheckEviction(const Core::PackedModuleInfo& info)
+	{
+		size_t mismatches = 0;
+		const size_t entrySize = Core::ModuleInfoCache::EstimateMemoryUsage("plugin0000.esp", info);
+		Core::ModuleInfoCache cache(Core::ModuleInfoCache::ShardCount * 4 * entrySize);
+
+		constexpr size_t count = 1000;
+		for (size_t i = 0; i < count; i++)
+		{
+			Core::CacheKey key;
+			key.Name = "plugin" + std::to_string(1000 + i) + ".esp";
+			cache.Put(key, info);
+
+			if (cache.GetStats().MemoryUsage > cache.GetMemoryLimit() || !cache.Find(key))
+			{
+				mismatches++;
+			}
+		}
+
+		Core::ModuleInfoCacheStats stats = cache.GetStats();
+		if (stats.Evictions == 0 || stats.Entries + stats.Evictions != count)
+		{
+			mismatches++;
+		}
+
+		cache.SetMemoryLimit(cache.GetMemoryLimit() / 2);
+		stats = cache.GetStats();
+		if (stats.MemoryUsage > cache.GetMemoryLimit() || stats.Entries + stats.Evictions != count)
+		{
+			mismatches++;
+		}
+		return mismatches;
+	}
+
+	// Several threads replacing and looking up the same file: every hit is one of the versions put and nothing
+	// is counted twice or lost
+	size_t CheckConcurrentKey(size_t threadCount)
+	{
+		const Core::PackedModuleInfo versions[] = {MakeInfo("Even"), MakeInfo("Odd")};
+
+		constexpr size_t iterations = 20000;
+		Core::ModuleInfoCache cache;
+		std::atomic<size_t> mismatches = 0;
+		Core::ParallelFor(threadCount, threadCount, [&](size_t thread)
+		{
+			Core::CacheKey key = {"Skyrim.esm", 1000, 0};
+			for (size_t i = 0; i < iterations; i++)
+			{
+				key.LastWriteTime = static_cast<int64_t>((i + thread) % 2);
+				if (const Core::PackedModuleInfo value = cache.Find(key))
+				{
+					if (value.GetAuthor() != versions[key.LastWriteTime].GetAuthor())
+					{
+						mismatches++;
+					}
+				}
+				else if (cache.Put(key, versions[key.LastWriteTime]).GetAuthor() != versions[key.LastWriteTime].GetAuthor())
+				{
+					mismatches++;
+				}
+			}
+		});
+
+		const Core::ModuleInfoCacheStats stats = cache.GetStats();
+		if (stats.Hits + stats.Misses != threadCount * iterations || stats.Entries != 1)
+		{
+			mismatches++;
+		}
+		return mismatches;
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int BenchLRU(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(5000)), 1);
+		const size_t lookups = args.GetOption("lookups", size_t(1000000));
+		const size_t threadCount = std::max<size_t>(args.GetOption("threads", Core::GetDefaultThreadCount()), 1);
+
+		FixtureOptions options;
+		options.MasterCount = args.GetOption("masters", size_t(8));
+
+		// Parse one generated header and cache it under many different names
+		const std::vector<std::byte> content = GenerateModule(options);
+		const Core::PackedModuleInfo info = MakeInfo(content);
+
+		std::vector<Core::CacheKey> keys(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			keys[i].Name = "plugin" + std::to_string(i) + ".esp";
+			keys[i].FileSize = content.size();
+		}
+
+		Core::ModuleInfoCache cache(args.GetOption("memory", Core::ModuleInfoCache::DefaultMemoryLimit));
+		const size_t lookupsPerThread = lookups / threadCount;
+		const auto startTime = std::chrono::steady_clock::now();
+		Core::ParallelFor(threadCount, threadCount, [&](size_t thread)
+		{
+			// Skewed access pattern: most lookups go to a small set of files, like Explorer refreshing one folder
+			uint32_t state = static_cast<uint32_t>(thread) * 2654435761u + 1;
+			for (size_t i = 0; i < lookupsPerThread; i++)
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+
+				const size_t index = (state >> 30) != 0 ? state % std::min<size_t>(count, 64) : state % count;
+				if (!cache.Find(keys[index]))
+				{
+					cache.Put(keys[index], info);
+				}
+			}
+		});
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		const Core::ModuleInfoCacheStats stats = cache.GetStats();
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Lookups: " << lookups << " over " << count << " files on " << threadCount << " thread(s)\n";
+		std::cout << "time: " << seconds * 1e9 / std::max<size_t>(lookups, 1) << " ns/lookup\n";
+		std::cout << "hits: " << stats.Hits << ", misses: " << stats.Misses << ", evictions: " << stats.Evictions << '\n';
+		std::cout << "entries: " << stats.Entries << ", memory: " << stats.MemoryUsage << " of " << cache.GetMemoryLimit() << " bytes\n";
+
+		size_t mismatches = 0;
+		if (stats.Hits + stats.Misses != lookupsPerThread * threadCount || stats.MemoryUsage > cache.GetMemoryLimit())
+		{
+			mismatches++;
+		}
+		mismatches += CheckReplace();
+		mismatches += CheckEviction(info);
+		mismatches += CheckConcurrentKey(std::max<size_t>(threadCount, 4));
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
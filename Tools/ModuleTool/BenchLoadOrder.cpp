@@ -0,0 +1,115 @@
+#include "Bench.h"
+#include "Core/LoadOrder.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+namespace BethesdaModule::Tool
+{
+	int BenchLoadOrder(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(5000)), 8);
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+
+		// Synthetic load order: a few base game masters, then plugins requiring up to 6 earlier ones. Every third
+		// plugin is light, like a modern Skyrim SE setup.
+		std::vector<std::string> names;
+		std::vector<Core::ModuleInfo> infos(count);
+		uint32_t state = 1;
+		for (size_t i = 0; i < count; i++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			Core::ModuleInfo& info = infos[i];
+			info.FormatLevel = Core::FormatLevel::Skyrim;
+			info.FormVersion = 44;
+			if (i < 5)
+			{
+				names.push_back("Base" + std::to_string(i) + ".esm");
+				info.Flags = Core::HeaderFlags::Master;
+			}
+			else
+			{
+				names.push_back("Plugin" + std::to_string(i) + (i % 3 == 0 ? ".esl" : ".esp"));
+				info.Masters.push_back("BASE0.ESM");
+				for (size_t j = 0; j < state % 6; j++)
+				{
+					info.Masters.push_back(names[(state >> (j * 4)) % i]);
+				}
+			}
+		}
+
+		Core::LoadOrderGraph graph;
+		graph.SetRequestedOrder(names);
+		const BenchResult build = MeasureBest(iterations, [&](BenchResult&)
+		{
+			graph.Clear();
+			graph.SetRequestedOrder(names);
+			for (size_t i = 0; i < count; i++)
+			{
+				graph.Update(names[i], infos[i]);
+			}
+		});
+
+		Core::LoadOrderResult result;
+		const BenchResult resolve = MeasureBest(iterations, [&](BenchResult&)
+		{
+			result = graph.Resolve();
+		});
+
+		// One file changed: replace its node and resolve again
+		const BenchResult update = MeasureBest(iterations, [&](BenchResult&)
+		{
+			infos[count / 2].Masters.push_back(names[count / 3]);
+			graph.Update(names[count / 2], infos[count / 2]);
+			result = graph.Resolve();
+		});
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "Plugins: " << count << ", full slots: " << result.FullSlots << ", light slots: " << result.LightSlots << ", issues: " << result.Issues.size() << '\n';
+		std::cout << "build: " << build.Seconds * 1000.0 << " ms\n";
+		std::cout << "resolve: " << resolve.Seconds * 1000.0 << " ms\n";
+		std::cout << "update one and resolve: " << update.Seconds * 1000.0 << " ms\n";
+
+		// Every plugin must load after its masters
+		std::unordered_map<std::string_view, size_t> positions;
+		for (size_t i = 0; i < result.Order.size(); i++)
+		{
+			positions.emplace(result.Order[i].Name, i);
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			for (const std::string& master: infos[i].Masters)
+			{
+				if (auto it = positions.find(master); it != positions.end() && it->second > positions[names[i]])
+				{
+					std::cerr << "bench: " << names[i] << " loads before its master " << master << '\n';
+					return 1;
+				}
+			}
+		}
+
+		// A cycle must be detected and must not lose plugins
+		Core::ModuleInfo cycle;
+		cycle.Masters = {"CycleB.esp"};
+		graph.Update("CycleA.esp", cycle);
+		cycle.Masters = {"CycleA.esp"};
+		graph.Update("CycleB.esp", cycle);
+		graph.SetRequestedOrder({});
+
+		result = graph.Resolve();
+		const bool hasCycle = std::any_of(result.Issues.begin(), result.Issues.end(), [](const Core::LoadOrderIssue& issue)
+		{
+			return issue.Type == Core::LoadOrderIssueType::Cycle;
+		});
+		if (!hasCycle || result.Order.size() != count + 2)
+		{
+			std::cerr << "bench: cycle wasn't reported\n";
+			return 1;
+		}
+		return 0;
+	}
+}
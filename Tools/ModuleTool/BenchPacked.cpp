@@ -0,0 +1,107 @@
+#include "Bench.h"
+#include "AllocationCounter.h"
+#include "ModuleFixture.h"
+#include "Core/PackedModuleInfo.h"
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchPacked(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(10000)), 1);
+
+		// Every game format with master lists from none to a dozen, long enough names to defeat the small string optimization
+		std::vector<std::vector<std::byte>> headers;
+		headers.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const FixtureProfile& profile = FixtureProfiles[i % std::size(FixtureProfiles)];
+
+			FixtureOptions options;
+			options.Seed = static_cast<uint32_t>(i);
+			options.FormatLevel = profile.FormatLevel;
+			options.FormVersion = profile.FormVersion;
+			options.MasterCount = i % 13;
+			options.AuthorLength = 8 + i % 32;
+			options.DescriptionLength = i % 3 == 0 ? 0 : 32 + i % 256;
+			headers.emplace_back(GenerateModule(options));
+		}
+
+		auto Measure = [&](auto&& func)
+		{
+			const size_t allocationsBefore = GetAllocationCount();
+			const auto startTime = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < count; i++)
+			{
+				Core::ModuleHeader header;
+				Core::ParseModuleHeader(headers[i], header);
+				func(i, header);
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			return std::make_pair(seconds, GetAllocationCount() - allocationsBefore);
+		};
+		auto Print = [&](std::string_view name, std::pair<double, size_t> measurement, size_t memory)
+		{
+			std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+				<< std::setw(10) << std::setprecision(1) << measurement.first * 1e9 / count << " ns/file"
+				<< std::setw(8) << std::setprecision(2) << static_cast<double>(measurement.second) / count << " allocs/file"
+				<< std::setw(8) << memory / count << " bytes/file\n";
+		};
+
+		// Separate strings, the way 'ModuleInfo' stores them
+		std::vector<Core::ModuleInfo> infos(count);
+		const auto infoTime = Measure([&](size_t i, const Core::ModuleHeader& header)
+		{
+			infos[i] = Core::ModuleInfo::FromHeader(headers[i], header);
+		});
+		size_t infoMemory = 0;
+		for (const Core::ModuleInfo& info: infos)
+		{
+			auto GetHeapSize = [](const std::string& value)
+			{
+				return value.capacity() > std::string().capacity() ? value.capacity() + 1 : 0;
+			};
+			infoMemory += sizeof(info) + GetHeapSize(info.Author) + GetHeapSize(info.Description) + info.Masters.capacity() * sizeof(std::string);
+			for (const std::string& master: info.Masters)
+			{
+				infoMemory += GetHeapSize(master);
+			}
+		}
+		Print("separate", infoTime, infoMemory);
+
+		// One block per file
+		std::vector<Core::PackedModuleInfo> packedInfos(count);
+		const auto packedTime = Measure([&](size_t i, const Core::ModuleHeader& header)
+		{
+			packedInfos[i] = Core::PackedModuleInfo::FromHeader(headers[i], header);
+		});
+		size_t packedMemory = 0;
+		for (const Core::PackedModuleInfo& info: packedInfos)
+		{
+			packedMemory += sizeof(info) + info.GetMemoryUsage();
+		}
+		Print("packed", packedTime, packedMemory);
+
+		// Both forms must hold the same data and packing must allocate exactly once per file
+		size_t mismatches = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const Core::ModuleInfo& info = infos[i];
+			const Core::ModuleInfo unpacked = packedInfos[i].ToModuleInfo();
+			if (unpacked.Signature != info.Signature || unpacked.Flags != info.Flags || unpacked.FormVersion != info.FormVersion || unpacked.FormatLevel != info.FormatLevel ||
+				unpacked.Author != info.Author || unpacked.Description != info.Description || unpacked.Masters != info.Masters)
+			{
+				mismatches++;
+			}
+		}
+		std::cout << "mismatches: " << mismatches << '\n';
+
+		if (packedTime.second != count)
+		{
+			std::cerr << "bench packed: " << packedTime.second << " allocation(s) for " << count << " file(s), expected one per file\n";
+			return 1;
+		}
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,400 @@
+#include "Bench.h"
+#include "AllocationCounter.h"
+#include "ModuleFixture.h"
+#include "Core/PackedModuleInfo.h"
+#include "Core/TextDecoder.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	// The properties of the shell handler, in its 'PropertyIndex' order
+	enum class PropertyIndex: size_t
+	{
+		Author,
+		Comment,
+		FileVersion,
+		ContentType,
+		DataObjectFormat,
+		Keywords,
+
+		Count
+	};
+	constexpr size_t PropertyCount = static_cast<size_t>(PropertyIndex::Count);
+
+	// What 'GetValue' hands out: a number or a string allocated for the caller, the way 'VariantProperty' and
+	// 'PropVariantCopy' allocate one with 'CoTaskMemAlloc'
+	struct PropertyValue final
+	{
+		uint32_t Number = 0;
+		std::unique_ptr<char16_t[]> Text;
+		size_t Length = 0;
+
+		static PropertyValue FromText(std::u16string_view text)
+		{
+			PropertyValue value;
+			value.Text = std::make_unique_for_overwrite<char16_t[]>(text.size() + 1);
+			value.Length = text.size();
+			std::copy(text.begin(), text.end(), value.Text.get());
+			value.Text[text.size()] = 0;
+			return value;
+		}
+		PropertyValue Copy() const
+		{
+			if (Text)
+			{
+				return FromText({Text.get(), Length});
+			}
+
+			PropertyValue value;
+			value.Number = Number;
+			return value;
+		}
+		bool IsSame(const PropertyValue& other) const noexcept
+		{
+			return Number == other.Number && std::u16string_view(Text.get(), Text ? Length : 0) == std::u16string_view(other.Text.get(), other.Text ? other.Length : 0);
+		}
+	};
+
+	std::u16string DecodeText(std::string_view text)
+	{
+		Core::TextDecodeOptions options;
+		options.DetectUTF8 = true;
+
+		std::u16string result(text.size(), u'\0');
+		result.resize(Core::DecodeToUTF16(text, result.data(), options));
+		return result;
+	}
+	std::u16string Widen(std::string_view text)
+	{
+		return std::u16string(text.begin(), text.end());
+	}
+	std::u16string StringOrNone(std::u16string value)
+	{
+		return !value.empty() ? std::move(value) : u"<None>";
+	}
+
+	// Same steps as 'MetadataHandler::CreateValue' with the Windows and KxFramework parts replaced
+	PropertyValue CreateValue(const Core::PackedModuleInfo& info, PropertyIndex index)
+	{
+		switch (index)
+		{
+			case PropertyIndex::Author:
+			{
+				return PropertyValue::FromText(StringOrNone(DecodeText(info.GetAuthor())));
+			}
+			case PropertyIndex::Comment:
+			{
+				return PropertyValue::FromText(StringOrNone(DecodeText(info.GetDescription())));
+			}
+			case PropertyIndex::FileVersion:
+			{
+				if (info.GetFormVersion() != 0)
+				{
+					PropertyValue value;
+					value.Number = info.GetFormVersion();
+					return value;
+				}
+				return PropertyValue::FromText(u"<Unknown>");
+			}
+			case PropertyIndex::ContentType:
+			{
+				constexpr std::pair<Core::HeaderFlags, std::u16string_view> flagNames[] =
+				{
+					{Core::HeaderFlags::Master, u"Master"},
+					{Core::HeaderFlags::Localized, u"Localized"},
+					{Core::HeaderFlags::Light, u"Light"},
+					{Core::HeaderFlags::Ignored, u"Ignored"},
+				};
+
+				std::u16string content;
+				for (const auto& [flag, name]: flagNames)
+				{
+					if (Core::TestFlag(info.GetFlags(), flag))
+					{
+						if (!content.empty())
+						{
+							content += u'|';
+						}
+						content += name;
+					}
+				}
+				return PropertyValue::FromText(!content.empty() ? content : u"Normal");
+			}
+			case PropertyIndex::DataObjectFormat:
+			{
+				return PropertyValue::FromText(Widen(Core::GetFormatLevelName(info.GetFormatLevel())));
+			}
+			case PropertyIndex::Keywords:
+			{
+				std::u16string requiredFiles;
+				info.ForEachMaster([&](std::string_view name)
+				{
+					if (!requiredFiles.empty())
+					{
+						requiredFiles += u"; ";
+					}
+					requiredFiles += DecodeText(name);
+				});
+				return PropertyValue::FromText(StringOrNone(std::move(requiredFiles)));
+			}
+		};
+		return {};
+	}
+
+	// 'PROPERTYKEY' with the values of the keys in 'propkey.h'
+	struct PropertyKey final
+	{
+		uint32_t Data1 = 0;
+		uint16_t Data2 = 0;
+		uint16_t Data3 = 0;
+		uint8_t Data4[8] = {};
+		uint32_t pid = 0;
+
+		// 'IsEqualPropertyKey': the format ID is compared with 'memcmp' first
+		bool operator==(const PropertyKey& other) const noexcept
+		{
+			return std::memcmp(&Data1, &other.Data1, 16) == 0 && pid == other.pid;
+		}
+		bool IsSameFormat(const PropertyKey& other) const noexcept
+		{
+			return std::memcmp(&Data1, &other.Data1, 16) == 0;
+		}
+	};
+	constexpr PropertyKey g_PKEY_Author = {0xF29F85E0, 0x4FF9, 0x1068, {0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9}, 4};
+	constexpr PropertyKey g_PKEY_Comment = {0xF29F85E0, 0x4FF9, 0x1068, {0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9}, 6};
+	constexpr PropertyKey g_PKEY_FileVersion = {0x0CEF7D53, 0xFA64, 0x11D1, {0xA2, 0x03, 0x00, 0x00, 0xF8, 0x1F, 0xED, 0xEE}, 4};
+	constexpr PropertyKey g_PKEY_ContentType = {0xD5CDD502, 0x2E9C, 0x101B, {0x93, 0x97, 0x08, 0x00, 0x2B, 0x2C, 0xF9, 0xAE}, 26};
+	constexpr PropertyKey g_PKEY_DataObjectFormat = {0x1E81A3F8, 0xA30F, 0x4247, {0xB9, 0xEE, 0x1D, 0x03, 0x68, 0xA9, 0x42, 0x5C}, 2};
+	constexpr PropertyKey g_PKEY_Keywords = {0xF29F85E0, 0x4FF9, 0x1068, {0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9}, 5};
+
+	// Same order as 'PropertyIndex', like the handler's 'g_PropertyKeys'
+	constexpr const PropertyKey* g_PropertyKeys[] =
+	{
+		&g_PKEY_Author,
+		&g_PKEY_Comment,
+		&g_PKEY_FileVersion,
+		&g_PKEY_ContentType,
+		&g_PKEY_DataObjectFormat,
+		&g_PKEY_Keywords,
+	};
+	static_assert(std::size(g_PropertyKeys) == PropertyCount);
+
+	// Keys Explorer asks every handler for while it lists a folder, none of them are ours. 'System.Title' shares the
+	// format ID of 'System.Author'.
+	constexpr PropertyKey g_OtherKeys[] =
+	{
+		{0xB725F130, 0x47EF, 0x101A, {0xA5, 0xF1, 0x02, 0x60, 0x8C, 0x9E, 0xEB, 0xAC}, 10},
+		{0xB725F130, 0x47EF, 0x101A, {0xA5, 0xF1, 0x02, 0x60, 0x8C, 0x9E, 0xEB, 0xAC}, 12},
+		{0xB725F130, 0x47EF, 0x101A, {0xA5, 0xF1, 0x02, 0x60, 0x8C, 0x9E, 0xEB, 0xAC}, 14},
+		{0xF29F85E0, 0x4FF9, 0x1068, {0xAB, 0x91, 0x08, 0x00, 0x2B, 0x27, 0xB3, 0xD9}, 2},
+	};
+
+	// 'GetValue' before the key table: one full key compare after another
+	std::optional<PropertyIndex> FindPropertyChain(const PropertyKey& key) noexcept
+	{
+		if (key == g_PKEY_Author)
+		{
+			return PropertyIndex::Author;
+		}
+		if (key == g_PKEY_Comment)
+		{
+			return PropertyIndex::Comment;
+		}
+		if (key == g_PKEY_FileVersion)
+		{
+			return PropertyIndex::FileVersion;
+		}
+		if (key == g_PKEY_ContentType)
+		{
+			return PropertyIndex::ContentType;
+		}
+		if (key == g_PKEY_DataObjectFormat)
+		{
+			return PropertyIndex::DataObjectFormat;
+		}
+		if (key == g_PKEY_Keywords)
+		{
+			return PropertyIndex::Keywords;
+		}
+		return {};
+	}
+
+	// 'MetadataHandler::FindProperty': the table, property ID first
+	std::optional<PropertyIndex> FindPropertyTable(const PropertyKey& key) noexcept
+	{
+		for (size_t i = 0; i < std::size(g_PropertyKeys); i++)
+		{
+			if (g_PropertyKeys[i]->pid == key.pid && g_PropertyKeys[i]->IsSameFormat(key))
+			{
+				return static_cast<PropertyIndex>(i);
+			}
+		}
+		return {};
+	}
+
+	// Values built on the first request and copied out afterwards, like 'MetadataHandler::GetPropertyValue'
+	class PropertyValues final
+	{
+		private:
+			std::mutex m_Mutex;
+			std::array<PropertyValue, PropertyCount> m_Values;
+			std::array<std::atomic<bool>, PropertyCount> m_Ready = {};
+
+		public:
+			const PropertyValue& Get(const Core::PackedModuleInfo& info, PropertyIndex index)
+			{
+				const size_t i = static_cast<size_t>(index);
+				if (!m_Ready[i].load(std::memory_order_acquire))
+				{
+					std::lock_guard lock(m_Mutex);
+					if (!m_Ready[i].load(std::memory_order_relaxed))
+					{
+						m_Values[i] = CreateValue(info, index);
+						m_Ready[i].store(true, std::memory_order_release);
+					}
+				}
+				return m_Values[i];
+			}
+	};
+}
+
+namespace BethesdaModule::Tool
+{
+	// 'GetValue' calls on one handler, the shell asks for the same few properties over and over while it draws
+	// columns and the details pane. Each value either built on every call or built once and copied out.
+	// Then finding a key, and copying the whole store the way 'CopyPropertyStores' does.
+	int BenchProperties(const CommandLine& args)
+	{
+		const size_t calls = std::max<size_t>(args.GetOption("calls", size_t(1000000)), PropertyCount);
+		const size_t stores = std::max<size_t>(args.GetOption("stores", size_t(100000)), 1);
+
+		FixtureOptions options;
+		options.Flags = static_cast<Core::HeaderFlags>(static_cast<uint32_t>(Core::HeaderFlags::Master)|static_cast<uint32_t>(Core::HeaderFlags::Localized));
+		options.MasterCount = args.GetOption("masters", size_t(8));
+		options.Text = FixtureText::Windows1252;
+
+		const std::vector<std::byte> content = GenerateModule(options);
+		Core::ModuleHeader header;
+		Core::ParseModuleHeader(content, header);
+		const Core::PackedModuleInfo info = Core::PackedModuleInfo::FromHeader(content, header);
+
+		auto Measure = [&](std::string_view name, auto&& getValue)
+		{
+			size_t checksum = 0;
+			const size_t allocationsBefore = GetAllocationCount();
+			const auto startTime = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < calls; i++)
+			{
+				const PropertyValue value = getValue(static_cast<PropertyIndex>(i % PropertyCount));
+				checksum += value.Number + value.Length;
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const size_t allocations = GetAllocationCount() - allocationsBefore;
+
+			std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+				<< std::setw(10) << std::setprecision(1) << seconds * 1e9 / calls << " ns/call"
+				<< std::setw(8) << std::setprecision(2) << static_cast<double>(allocations) / calls << " allocs/call\n";
+			return checksum;
+		};
+
+		std::cout << "Calls: " << calls << " over " << PropertyCount << " properties, " << info.GetMasterCount() << " master(s)\n";
+		const size_t rebuilt = Measure("rebuilt", [&](PropertyIndex index)
+		{
+			return CreateValue(info, index);
+		});
+
+		PropertyValues values;
+		const size_t cached = Measure("cached", [&](PropertyIndex index)
+		{
+			return values.Get(info, index).Copy();
+		});
+
+		// Cached values are the same as freshly built ones
+		size_t mismatches = rebuilt != cached;
+		for (size_t i = 0; i < PropertyCount; i++)
+		{
+			const PropertyIndex index = static_cast<PropertyIndex>(i);
+			mismatches += !values.Get(info, index).IsSame(CreateValue(info, index));
+		}
+
+		// Our keys and the ones we don't have, asked for equally often
+		std::vector<PropertyKey> keys;
+		for (const PropertyKey* key: g_PropertyKeys)
+		{
+			keys.push_back(*key);
+		}
+		keys.insert(keys.end(), std::begin(g_OtherKeys), std::end(g_OtherKeys));
+
+		for (const PropertyKey& key: keys)
+		{
+			mismatches += FindPropertyChain(key) != FindPropertyTable(key);
+		}
+
+		auto MeasureLookup = [&](std::string_view name, auto&& findProperty)
+		{
+			size_t found = 0;
+			const auto startTime = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < calls; i++)
+			{
+				if (auto index = findProperty(keys[i % keys.size()]))
+				{
+					found += static_cast<size_t>(*index) + 1;
+				}
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			std::cout << std::left << std::setw(10) << name << std::right << std::setw(10) << std::setprecision(2) << seconds * 1e9 / calls << " ns/lookup\n";
+			return found;
+		};
+		std::cout << "Lookups: " << calls << " over " << keys.size() << " keys, " << std::size(g_OtherKeys) << " of them not provided\n";
+		mismatches += MeasureLookup("chain", FindPropertyChain) != MeasureLookup("table", FindPropertyTable);
+
+		// A new handler per store, enumerated through 'GetAt' until it fails. Before the key table 'GetCount' was 0
+		// and nothing was copied.
+		{
+			size_t copied = 0;
+			const size_t allocationsBefore = GetAllocationCount();
+			const auto startTime = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < stores; i++)
+			{
+				PropertyValues handlerValues;
+				std::vector<std::pair<PropertyKey, PropertyValue>> memoryStore;
+				memoryStore.reserve(PropertyCount);
+				for (size_t j = 0; j < std::size(g_PropertyKeys); j++)
+				{
+					const PropertyKey& key = *g_PropertyKeys[j];
+					if (auto index = FindPropertyTable(key))
+					{
+						memoryStore.emplace_back(key, handlerValues.Get(info, *index).Copy());
+					}
+				}
+				copied += memoryStore.size();
+
+				if (i == 0)
+				{
+					for (const auto& [key, value]: memoryStore)
+					{
+						mismatches += !value.IsSame(CreateValue(info, *FindPropertyChain(key)));
+					}
+				}
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const size_t allocations = GetAllocationCount() - allocationsBefore;
+
+			std::cout << "clone: " << std::setprecision(1) << seconds * 1e9 / stores << " ns/store, " << std::setprecision(2)
+				<< static_cast<double>(allocations) / stores << " allocs/store, " << copied / stores << " of " << PropertyCount << " properties\n";
+			mismatches += copied != stores * PropertyCount;
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,206 @@
+#include "Bench.h"
+#include "Core/ModuleQuery.h"
+#include "Core/ModuleTable.h"
+#include "Core/Parallel.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	// Set operations of the bitmaps against sorted vectors, for sparse and dense containers and every mix of them
+	size_t CheckBitmaps()
+	{
+		size_t mismatches = 0;
+		uint32_t state = 12345;
+		auto Next = [&]()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		};
+		auto Generate = [&](uint32_t density)
+		{
+			// Four containers, the third one is left empty
+			std::vector<uint32_t> values;
+			for (uint32_t value = 0; value < 4 * 65536; value++)
+			{
+				if (value >> 16 != 2 && Next() % 1000 < density)
+				{
+					values.push_back(value);
+				}
+			}
+			return values;
+		};
+
+		constexpr uint32_t densities[] = {1, 30, 62, 500, 999};
+		for (uint32_t leftDensity: densities)
+		{
+			for (uint32_t rightDensity: densities)
+			{
+				const std::vector<uint32_t> left = Generate(leftDensity);
+				const std::vector<uint32_t> right = Generate(rightDensity);
+
+				// Added out of order to go through the inserting path as well
+				Core::RoaringBitmap leftBitmap;
+				Core::RoaringBitmap rightBitmap;
+				for (uint32_t value: left)
+				{
+					leftBitmap.Add(value);
+				}
+				for (auto it = right.rbegin(); it != right.rend(); ++it)
+				{
+					rightBitmap.Add(*it);
+				}
+				mismatches += leftBitmap.ToVector() != left || rightBitmap.ToVector() != right || rightBitmap.GetCardinality() != right.size();
+
+				auto Check = [&](const Core::RoaringBitmap& bitmap, auto&& operation)
+				{
+					std::vector<uint32_t> expected;
+					operation(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+					mismatches += bitmap.ToVector() != expected || bitmap.GetCardinality() != expected.size();
+				};
+				Check(Core::RoaringBitmap::And(leftBitmap, rightBitmap), [](auto... args)
+				{
+					std::set_intersection(args...);
+				});
+				Check(Core::RoaringBitmap::Or(leftBitmap, rightBitmap), [](auto... args)
+				{
+					std::set_union(args...);
+				});
+				Check(Core::RoaringBitmap::AndNot(leftBitmap, rightBitmap), [](auto... args)
+				{
+					std::set_difference(args...);
+				});
+
+				for (size_t i = 0; i < 1000; i++)
+				{
+					const uint32_t value = Next() % (4 * 65536);
+					mismatches += leftBitmap.Contains(value) != std::binary_search(left.begin(), left.end(), value);
+				}
+			}
+		}
+
+		const Core::RoaringBitmap range = Core::RoaringBitmap::FromRange(1000, 200000);
+		mismatches += range.GetCardinality() != 199000 || range.Contains(999) || !range.Contains(1000) || !range.Contains(199999) || range.Contains(200000);
+		return mismatches;
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int BenchQuery(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(50000)), 1);
+		const size_t iterations = args.GetOption("iterations", size_t(20));
+		const std::vector<Core::ScanResult> results = GenerateLibrary(count, args.GetOption("threads", Core::GetDefaultThreadCount()));
+
+		Core::ModuleTable table = Core::ModuleTable::Build(results);
+		Core::ModuleIndex index;
+		const BenchResult build = MeasureBest(iterations, [&](BenchResult&)
+		{
+			index = Core::ModuleIndex::Build(table);
+		});
+
+		size_t mismatches = CheckBitmaps();
+		std::cout << "Library: " << count << " plugins, " << index.GetFormVersionCount() << " form versions, " << table.GetNameCount() << " distinct names\n";
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "index: " << index.GetMemoryUsage() << " bytes, built in " << build.Seconds * 1e3 << " ms\n";
+		std::cout << std::left << std::setw(74) << "query" << std::right << std::setw(8) << "rows" << std::setw(14) << "structs us" << std::setw(14) << "columns us"
+			<< std::setw(14) << "bitmaps us" << std::setw(10) << "speedup" << '\n';
+
+		auto Run = [&](std::string_view expression, std::optional<Core::ModuleFilter> filter)
+		{
+			std::string error;
+			const auto query = Core::ModuleQuery::Parse(expression, &error);
+			if (!query)
+			{
+				std::cout << expression << ": " << error << '\n';
+				mismatches++;
+				return;
+			}
+
+			// Header by header, the way it's done without an index
+			std::vector<Core::ModuleTable::TRow> expected;
+			const BenchResult structTime = MeasureBest(iterations, [&](BenchResult&)
+			{
+				expected.clear();
+				for (size_t i = 0; i < count; i++)
+				{
+					if (query->Matches(results[i].Info))
+					{
+						expected.push_back(static_cast<Core::ModuleTable::TRow>(i));
+					}
+				}
+			});
+
+			// Filter over the columns, where it can express the query
+			BenchResult columnTime;
+			if (filter)
+			{
+				std::vector<Core::ModuleTable::TRow> rows;
+				columnTime = MeasureBest(iterations, [&](BenchResult&)
+				{
+					rows = table.Select(*filter);
+				});
+				mismatches += rows != expected;
+			}
+
+			Core::RoaringBitmap bitmap;
+			const BenchResult bitmapTime = MeasureBest(iterations, [&](BenchResult&)
+			{
+				bitmap = query->Evaluate(index);
+			});
+			mismatches += bitmap.ToVector() != expected;
+
+			std::cout << std::left << std::setw(74) << expression << std::right << std::setw(8) << expected.size() << std::setw(14) << structTime.Seconds * 1e6;
+			if (filter)
+			{
+				std::cout << std::setw(14) << columnTime.Seconds * 1e6;
+			}
+			else
+			{
+				std::cout << std::setw(14) << '-';
+			}
+			std::cout << std::setw(14) << bitmapTime.Seconds * 1e6 << std::setw(9) << structTime.Seconds / bitmapTime.Seconds << "x\n";
+		};
+
+		Core::ModuleFilter lightNotMaster;
+		lightNotMaster.RequiredFlags = Core::HeaderFlags::Light;
+		lightNotMaster.ExcludedFlags = Core::HeaderFlags::Master;
+		Run("esl & !esm", lightNotMaster);
+
+		Core::ModuleFilter dawnguard;
+		dawnguard.Master = table.FindName("Dawnguard.esm").value_or(std::numeric_limits<uint32_t>::max());
+		Run("requires:Dawnguard.esm", dawnguard);
+
+		Core::ModuleFilter olderVersion;
+		olderVersion.MaxFormVersion = 43;
+		Run("version<44", olderVersion);
+
+		Core::ModuleFilter lightSkyrimSE;
+		lightSkyrimSE.RequiredFlags = Core::HeaderFlags::Light;
+		lightSkyrimSE.FormatLevel = Core::FormatLevel::Skyrim;
+		lightSkyrimSE.MinFormVersion = 44;
+		lightSkyrimSE.MaxFormVersion = 44;
+		Run("esl & format:skyrim & version=44", lightSkyrimSE);
+
+		Run("(esm | esl) & !requires:Update.esm", {});
+		Run("localized & version>=44 & not format:morrowind", {});
+		Run("requires:Skyrim.esm & requires:Dawnguard.esm & !requires:Dragonborn.esm", {});
+		Run("requires:\"Unofficial Skyrim Special Edition Patch.esp\" | format=oblivion", {});
+
+		// Broken expressions have to be rejected
+		for (std::string_view expression: {"", "esm &", "(esl", "esl esm", "version<x", "format:fallout", "requires:", "esm:1", "requires:\"Skyrim.esm", "flag:32"})
+		{
+			mismatches += Core::ModuleQuery::Parse(expression).has_value();
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
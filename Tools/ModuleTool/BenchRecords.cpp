@@ -0,0 +1,88 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/RecordWalker.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchRecords(const CommandLine& args)
+	{
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+
+		FixtureOptions options;
+		options.RecordCount = std::max<size_t>(args.GetOption("records", size_t(1000000)), 1);
+		options.RecordSize = args.GetOption("record-size", size_t(64));
+		options.CompressedEvery = args.GetOption("compressed-every", size_t(8));
+		if (auto name = args.GetOption("profile"))
+		{
+			const FixtureProfile* profile = FindFixtureProfile(*name);
+			if (!profile)
+			{
+				std::cerr << "bench: unknown profile '" << *name << "'\n";
+				return 1;
+			}
+			options.FormatLevel = profile->FormatLevel;
+			options.FormVersion = profile->FormVersion;
+		}
+
+		const std::vector<std::byte> content = GenerateModule(options);
+		Core::ModuleHeader header;
+		Core::ParseModuleHeader(content, header);
+
+		const std::filesystem::path directory = GetCorpusDirectory(args);
+		const std::filesystem::path path = directory / "Records.esm";
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+
+			std::ofstream stream(path, std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+			if (!stream)
+			{
+				std::cerr << "bench: can't write the corpus\n";
+				return 1;
+			}
+		}
+		std::cout << "File: " << options.RecordCount << " records of " << options.RecordSize << " bytes, " << content.size() << " bytes total\n";
+
+		auto Walk = [&](auto& source, BenchResult& result)
+		{
+			const Core::RecordStats stats = Core::WalkRecords(source, header);
+			result.BytesRead += stats.BytesWalked;
+			result.Checksum += stats.Records;
+		};
+		auto Print = [&](std::string_view name, const BenchResult& result)
+		{
+			std::cout << std::left << std::setw(12) << name << std::right << std::fixed
+				<< std::setw(10) << std::setprecision(2) << result.BytesRead / result.Seconds / 1e9 << " GB/sec"
+				<< std::setw(12) << std::setprecision(1) << result.Seconds * 1e9 / options.RecordCount << " ns/record"
+				<< "  (" << result.Checksum << " records)\n";
+			return result.Checksum == options.RecordCount;
+		};
+
+		bool valid = Print("memory", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			Core::MemoryByteSource source(content);
+			Walk(source, result);
+		}));
+		valid &= Print("pread", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			Core::FileByteSource source(path);
+			Walk(source, result);
+		}));
+		valid &= Print("mmap", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			Core::MappedByteSource source(path);
+			Walk(source, result);
+		}));
+
+		if (!valid)
+		{
+			std::cerr << "bench: walked record count doesn't match the generated one\n";
+			return 1;
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,145 @@
+#include "Bench.h"
+#include "AllocationCounter.h"
+#include "ModuleFixture.h"
+#include "Core/FreeList.h"
+#include "Core/PackedModuleInfo.h"
+#include "Core/Parallel.h"
+#include "Core/ReadAheadBuffer.h"
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	// What a shell handler keeps per file: a buffered stream over the file, the header record and the parsed header
+	class BenchHandler final
+	{
+		private:
+			class Stream final
+			{
+				public:
+					std::span<const std::byte> Data;
+					uint64_t Position = 0;
+
+				public:
+					size_t Read(void* buffer, size_t size)
+					{
+						const size_t count = Core::MemoryByteSource(Data).ReadAt(Position, buffer, size);
+						Position += count;
+						return count;
+					}
+					std::optional<uint64_t> Seek(int64_t offset, Core::SeekOrigin origin)
+					{
+						Position = origin == Core::SeekOrigin::Start ? offset : origin == Core::SeekOrigin::End ? Data.size() + offset : Position + offset;
+						return Position;
+					}
+			};
+
+		private:
+			Stream m_Stream;
+			Core::ReadAheadBuffer m_ReadAhead;
+			std::vector<std::byte> m_HeaderData;
+			Core::PackedModuleInfo m_Info;
+
+		public:
+			bool Initialize(std::span<const std::byte> data)
+			{
+				m_Stream = {data, 0};
+				m_ReadAhead.Reset();
+
+				const std::span<const std::byte> header = Core::ReadModuleHeaderData(*this, m_HeaderData);
+				Core::ModuleHeader moduleHeader;
+				if (Core::ParseModuleHeader(header, moduleHeader) != Core::ParseStatus::UnknownFormat)
+				{
+					m_Info = Core::PackedModuleInfo::FromHeader(header, moduleHeader);
+					return true;
+				}
+				return false;
+			}
+			void Reset() noexcept
+			{
+				m_Stream = {};
+				m_Info = {};
+				m_HeaderData.clear();
+			}
+
+			size_t ReadAt(uint64_t offset, void* buffer, size_t size)
+			{
+				m_ReadAhead.Seek(m_Stream, static_cast<int64_t>(offset), Core::SeekOrigin::Start);
+				return m_ReadAhead.Read(m_Stream, buffer, size);
+			}
+			size_t GetMasterCount() const noexcept
+			{
+				return m_Info.GetMasterCount();
+			}
+	};
+}
+
+namespace BethesdaModule::Tool
+{
+	int BenchRecycle(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(200000)), 1);
+		const size_t threadCount = std::max<size_t>(args.GetOption("threads", Core::GetDefaultThreadCount()), 1);
+
+		// A handful of distinct headers, handlers are created for each file in turn like Explorer does when browsing a folder
+		std::vector<std::vector<std::byte>> files;
+		for (size_t i = 0; i < 64; i++)
+		{
+			FixtureOptions options;
+			options.Seed = static_cast<uint32_t>(i);
+			options.MasterCount = i % 9;
+			options.BodySize = 4096;
+			files.emplace_back(GenerateModule(options));
+		}
+
+		auto Measure = [&](std::string_view name, auto&& acquire, auto&& release)
+		{
+			std::atomic<size_t> masters = 0;
+			const size_t allocationsBefore = GetAllocationCount();
+			const auto startTime = std::chrono::steady_clock::now();
+			Core::ParallelFor(count, threadCount, [&](size_t i)
+			{
+				std::unique_ptr<BenchHandler> handler = acquire();
+				if (handler->Initialize(files[i % files.size()]))
+				{
+					masters.fetch_add(handler->GetMasterCount(), std::memory_order_relaxed);
+				}
+				release(std::move(handler));
+			});
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const size_t allocations = GetAllocationCount() - allocationsBefore;
+
+			std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+				<< std::setw(10) << std::setprecision(1) << seconds * 1e9 / count << " ns/file"
+				<< std::setw(8) << std::setprecision(2) << static_cast<double>(allocations) / count << " allocs/file\n";
+			return std::make_pair(static_cast<double>(allocations) / count, masters.load());
+		};
+
+		// A new handler for every file
+		const auto created = Measure("new", []()
+		{
+			return std::make_unique<BenchHandler>();
+		}, [](std::unique_ptr<BenchHandler>)
+		{
+		});
+
+		// Released handlers are reset and reused
+		Core::BoundedFreeList<BenchHandler> pool;
+		const auto recycled = Measure("recycled", [&]()
+		{
+			std::unique_ptr<BenchHandler> handler = pool.Pop();
+			return handler ? std::move(handler) : std::make_unique<BenchHandler>();
+		}, [&](std::unique_ptr<BenchHandler> handler)
+		{
+			handler->Reset();
+			pool.Push(std::move(handler));
+		});
+
+		const Core::FreeListStats stats = pool.GetStats();
+		std::cout << std::setprecision(2) << "saved: " << created.first - recycled.first << " allocs/file, reused: " << stats.Reused << ", overflows: " << stats.Overflows << '\n';
+		return created.second == recycled.second ? 0 : 1;
+	}
+}
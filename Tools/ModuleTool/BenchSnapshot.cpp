@@ -0,0 +1,138 @@
+#include "Bench.h"
+#include "Core/ModuleSnapshot.h"
+#include "Core/Parallel.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	// Snapshot export of a synthetic library, opened again through the mapping
+	int BenchSnapshot(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(50000)), 1);
+		const size_t iterations = std::max<size_t>(args.GetOption("iterations", size_t(20)), 1);
+		const std::vector<Core::ScanResult> results = GenerateLibrary(count, args.GetOption("threads", Core::GetDefaultThreadCount()));
+
+		// Spread over a year, the fixtures have no files to take them from
+		std::vector<int64_t> times(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			times[i] = 1'700'000'000'000'000 + static_cast<int64_t>(i) * 631'000'007;
+		}
+
+		const std::filesystem::path directory = GetCorpusDirectory(args);
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+		}
+		const std::filesystem::path path = directory / "Snapshot.arrow";
+
+		bool written = true;
+		const BenchResult write = MeasureBest(std::max<size_t>(iterations / 4, 1), [&](BenchResult&)
+		{
+			written = written && Core::ModuleSnapshot::Write(path, results, times);
+		});
+		if (!written)
+		{
+			std::cerr << "bench snapshot: can't write '" << path.string() << "'\n";
+			return 1;
+		}
+
+		Core::ModuleSnapshot snapshot;
+		const BenchResult open = MeasureBest(iterations, [&](BenchResult&)
+		{
+			written = snapshot.Open(path);
+		});
+		if (!written || snapshot.GetCount() != count)
+		{
+			std::cerr << "bench snapshot: can't open '" << path.string() << "'\n";
+			return 1;
+		}
+
+		// What a query over the columns touches: every value of the fixed width ones and every path
+		const BenchResult scan = MeasureBest(iterations, [&](BenchResult& result)
+		{
+			size_t checksum = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				checksum += snapshot.GetSignatures()[i] ^ snapshot.GetFlags()[i] ^ snapshot.GetFormVersions()[i];
+				checksum += static_cast<size_t>(snapshot.GetFileSizes()[i] + static_cast<uint64_t>(snapshot.GetLastWriteTimes()[i]));
+				checksum += snapshot.GetPath(i).size() + static_cast<size_t>(snapshot.GetStatus(i)) + snapshot.GetMasterCount(i);
+			}
+			result.Checksum = checksum;
+		});
+
+		// Every row has to come back out as it went in
+		size_t mismatches = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const Core::ScanResult result = snapshot.GetResult(i);
+			const Core::ScanResult& expected = results[i];
+			mismatches += result.Path != expected.Path || result.FileSize != expected.FileSize || result.Status != expected.Status || result.Info.Signature != expected.Info.Signature
+				|| result.Info.Flags != expected.Info.Flags || result.Info.FormVersion != expected.Info.FormVersion || result.Info.FormatLevel != expected.Info.FormatLevel
+				|| result.Info.Author != expected.Info.Author || result.Info.Description != expected.Info.Description || result.Info.Masters != expected.Info.Masters
+				|| snapshot.GetLastWriteTimes()[i] != times[i];
+		}
+		const size_t fileSize = snapshot.GetMappedSize();
+		snapshot.Close();
+
+		std::vector<std::byte> data(fileSize);
+		{
+			std::ifstream stream(path, std::ios::binary);
+			stream.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		}
+		const std::filesystem::path damagedPath = directory / "Snapshot - Damaged.arrow";
+		auto OpenDamaged = [&](std::span<const std::byte> damaged)
+		{
+			{
+				std::ofstream stream(damagedPath, std::ios::binary|std::ios::trunc);
+				stream.write(reinterpret_cast<const char*>(damaged.data()), static_cast<std::streamsize>(damaged.size()));
+			}
+			return snapshot.Open(damagedPath);
+		};
+
+		// Truncated files have to be rejected, wherever they end
+		size_t truncations = 0;
+		for (size_t size: {size_t(0), size_t(6), size_t(64), fileSize / 2, fileSize - 10, fileSize - 1})
+		{
+			mismatches += OpenDamaged(std::span(data).first(size));
+			truncations++;
+		}
+
+		// Damaged metadata either fails to open or still gives rows that can be read in full
+		size_t damages = 0;
+		size_t accepted = 0;
+		uint32_t seed = 0x9E3779B9;
+		for (size_t i = 0; i < 200; i++)
+		{
+			std::vector<std::byte> damaged = data;
+			seed = seed * 1664525 + 1013904223;
+			const size_t metadataSize = std::min<size_t>(fileSize, 1024);
+			const size_t offset = (i % 2 == 0) ? seed % metadataSize : fileSize - 1 - seed % metadataSize;
+			damaged[offset] ^= static_cast<std::byte>(1 + (seed >> 24) % 255);
+			if (OpenDamaged(damaged))
+			{
+				for (size_t row = 0; row < snapshot.GetCount(); row++)
+				{
+					accepted += !snapshot.GetResult(row).Path.empty();
+				}
+			}
+			damages++;
+		}
+		snapshot.Close();
+		{
+			std::error_code error;
+			std::filesystem::remove(damagedPath, error);
+		}
+
+		std::cout << "Library: " << count << " plugins, snapshot '" << path.string() << "' of " << fileSize << " bytes (" << fileSize / count << " per row)\n";
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "write: " << write.Seconds * 1e3 << " ms\n";
+		std::cout << "open:  " << open.Seconds * 1e3 << " ms\n";
+		std::cout << "scan:  " << scan.Seconds * 1e3 << " ms (" << scan.Seconds * 1e9 / count << " ns/row, checksum " << scan.Checksum << ")\n";
+		std::cout << "damaged: " << truncations << " truncations rejected, " << damages << " byte flips, " << accepted << " rows read from the accepted ones\n";
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
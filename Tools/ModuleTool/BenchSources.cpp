@@ -0,0 +1,130 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	template<Core::ByteSource TSource>
+	void ParseSource(TSource& source, std::vector<std::byte>& buffer, Tool::BenchResult& result)
+	{
+		const auto data = Core::ReadModuleHeaderData(source, buffer, &result.BytesRead);
+
+		Core::ModuleHeader header;
+		Core::ParseModuleHeader(data, header);
+		result.Checksum += header.MasterCount + header.Author.Length;
+	}
+
+	void PrintResult(std::string_view name, const Tool::BenchResult& result, size_t files)
+	{
+		std::cout << std::left << std::setw(12) << name << std::right << std::fixed
+			<< std::setw(12) << std::setprecision(1) << result.Seconds * 1e9 / files << " ns/file"
+			<< std::setw(12) << std::setprecision(0) << files / result.Seconds << " files/sec"
+			<< std::setw(10) << result.BytesRead / files << " bytes/file"
+			<< "  (checksum " << result.Checksum << ")\n";
+	}
+
+	bool IsSameInfo(const Core::ModuleInfo& info, const Core::ModuleInfo& expected) noexcept
+	{
+		return info.Signature == expected.Signature && info.Flags == expected.Flags && info.FormVersion == expected.FormVersion && info.FormatLevel == expected.FormatLevel
+			&& info.Author == expected.Author && info.Description == expected.Description && info.Masters == expected.Masters;
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int BenchSources(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(5000)), 1);
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+
+		FixtureOptions options;
+		options.MasterCount = args.GetOption("masters", size_t(8));
+		options.BodySize = args.GetOption("body", size_t(64 * 1024));
+
+		const auto files = GenerateModuleCorpus(GetCorpusDirectory(args), count, options);
+		if (files.size() != count)
+		{
+			std::cerr << "bench: can't write the corpus\n";
+			return 1;
+		}
+
+		// Memory backend gets whole files preloaded, so it measures pure parsing
+		std::vector<std::vector<std::byte>> contents;
+		for (const auto& path: files)
+		{
+			std::ifstream stream(path, std::ios::binary);
+			contents.emplace_back(std::filesystem::file_size(path));
+			stream.read(reinterpret_cast<char*>(contents.back().data()), static_cast<std::streamsize>(contents.back().size()));
+		}
+
+		std::cout << "Corpus: " << count << " files, " << options.MasterCount << " masters, " << options.BodySize << " bytes of body each\n";
+		std::vector<std::byte> buffer;
+
+		const BenchResult memory = MeasureBest(iterations, [&](BenchResult& result)
+		{
+			for (const auto& content: contents)
+			{
+				Core::MemoryByteSource source(content);
+				ParseSource(source, buffer, result);
+			}
+		});
+		PrintResult("memory", memory, count);
+		const BenchResult pread = MeasureBest(iterations, [&](BenchResult& result)
+		{
+			for (const auto& path: files)
+			{
+				Core::FileByteSource source(path);
+				ParseSource(source, buffer, result);
+			}
+		});
+		PrintResult("pread", pread, count);
+		const BenchResult mmap = MeasureBest(iterations, [&](BenchResult& result)
+		{
+			for (const auto& path: files)
+			{
+				Core::MappedByteSource source(path);
+				ParseSource(source, buffer, result);
+			}
+		});
+		PrintResult("mmap", mmap, count);
+
+		// Every source has to give the same header, for the corpus above and for each game with no, some and the most masters
+		size_t mismatches = memory.Checksum != pread.Checksum || memory.Checksum != mmap.Checksum;
+		const std::filesystem::path directory = GetCorpusDirectory(args);
+		for (const FixtureProfile& profile: FixtureProfiles)
+		{
+			for (size_t masterCount: {size_t(0), size_t(8), size_t(254)})
+			{
+				FixtureOptions profileOptions = options;
+				profileOptions.FormatLevel = profile.FormatLevel;
+				profileOptions.FormVersion = profile.FormVersion;
+				profileOptions.MasterCount = masterCount;
+				const std::vector<std::byte> content = GenerateModule(profileOptions);
+
+				const std::filesystem::path path = directory / (std::string(profile.Name) + '-' + std::to_string(masterCount) + ".esp");
+				std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+
+				Core::ModuleInfo expected;
+				Core::MemoryByteSource memorySource(content);
+				if (Core::ReadModuleInfo(memorySource, buffer, expected) != Core::ParseStatus::Success || expected.FormatLevel != profile.FormatLevel || expected.Masters.size() != masterCount)
+				{
+					mismatches++;
+				}
+
+				Core::ModuleInfo info;
+				Core::FileByteSource fileSource(path);
+				mismatches += Core::ReadModuleInfo(fileSource, buffer, info) != Core::ParseStatus::Success || !IsSameInfo(info, expected);
+
+				Core::MappedByteSource mappedSource(path);
+				mismatches += Core::ReadModuleInfo(mappedSource, buffer, info) != Core::ParseStatus::Success || !IsSameInfo(info, expected);
+			}
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,51 @@
+#include "Bench.h"
+#include "CountingStream.h"
+#include "ModuleFixture.h"
+#include "Core/ReadAheadBuffer.h"
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	// Stream calls of a header read, as 'IStreamByteSource' counts them. A header that fits into the
+	// read-ahead block takes one seek to find out the position and one read.
+	int BenchStream(const CommandLine& args)
+	{
+		size_t mismatches = 0;
+		std::vector<std::byte> buffer;
+
+		std::cout << std::left << std::setw(12) << "profile" << std::right << std::setw(8) << "masters" << std::setw(8) << "reads" << std::setw(8) << "seeks" << '\n';
+		for (const FixtureProfile& profile: FixtureProfiles)
+		{
+			for (size_t masterCount: {size_t(0), size_t(8), size_t(254)})
+			{
+				FixtureOptions options;
+				options.FormatLevel = profile.FormatLevel;
+				options.FormVersion = profile.FormVersion;
+				options.MasterCount = masterCount;
+				const std::vector<std::byte> content = GenerateModule(options);
+
+				Core::MemoryByteSource memory(content);
+				Core::ModuleInfo expected;
+				Core::ReadModuleInfo(memory, buffer, expected);
+
+				CountingStream stream(content);
+				StreamByteSource source(stream);
+				Core::ModuleInfo info;
+				Core::ReadModuleInfo(source, buffer, info);
+
+				// The counters have to agree with the calls the stream got, and the header with the one read from memory
+				const Core::ReadAheadStats& stats = source.GetStats();
+				mismatches += stats.ReadCalls != stream.GetReadCalls() || stats.SeekCalls != stream.GetSeekCalls() || stats.GetStreamCalls() > 2;
+				mismatches += info.Signature != expected.Signature || info.Flags != expected.Flags || info.FormVersion != expected.FormVersion
+					|| info.Author != expected.Author || info.Description != expected.Description || info.Masters != expected.Masters;
+
+				std::cout << std::left << std::setw(12) << profile.Name << std::right << std::setw(8) << masterCount << std::setw(8) << stream.GetReadCalls()
+					<< std::setw(8) << stream.GetSeekCalls() << '\n';
+			}
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,201 @@
+#include "Bench.h"
+#include "AllocationCounter.h"
+#include "ModuleFixture.h"
+#include "Core/BinaryIO.h"
+#include "Core/StringTable.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+namespace BethesdaModule::Tool
+{
+	int BenchStringTables(const CommandLine& args)
+	{
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+		const size_t lookups = std::max<size_t>(args.GetOption("lookups", size_t(1000000)), 1);
+		const std::string_view textName = args.GetOption("text", "ascii");
+		const auto textType = ParseFixtureText(textName);
+		if (!textType)
+		{
+			std::cerr << "bench stringtables: unknown text type '" << textName << "'\n";
+			return 1;
+		}
+
+		// One table of each type for 'Fixture.esp', laid out the way the games look for them
+		const std::filesystem::path directory = GetCorpusDirectory(args);
+		const std::filesystem::path pluginPath = directory / "Fixture.esp";
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory / "Strings", error);
+		}
+
+		StringTableFixtureOptions fixtureOptions;
+		fixtureOptions.Count = std::max<size_t>(args.GetOption("entries", size_t(200000)), 1);
+		fixtureOptions.Length = args.GetOption("length", size_t(32));
+		fixtureOptions.Text = *textType;
+		fixtureOptions.Sorted = !args.HasOption("unsorted");
+		for (Core::StringTableType type: Core::StringTableTypes)
+		{
+			fixtureOptions.Type = type;
+			const std::vector<std::byte> data = GenerateStringTable(fixtureOptions);
+
+			std::ofstream stream(Core::StringTableCache::GetTablePath(pluginPath, "english", type), std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (!stream)
+			{
+				std::cerr << "bench stringtables: can't write the tables\n";
+				return 1;
+			}
+		}
+
+		std::cout << "Lookups: " << lookups << " per table of " << fixtureOptions.Count << " strings, " << textName << " text, " << (fixtureOptions.Sorted ? "sorted" : "unsorted") << " directories\n";
+		std::cout << std::left << std::setw(10) << "table" << std::setw(8) << "reader" << std::right
+			<< std::setw(12) << "open ms" << std::setw(12) << "ns/lookup" << std::setw(14) << "heap bytes" << std::setw(14) << "mapped bytes" << std::setw(8) << "allocs" << '\n';
+
+		Core::StringTableCache cache;
+		size_t mismatches = 0;
+		for (Core::StringTableType type: Core::StringTableTypes)
+		{
+			const std::filesystem::path path = Core::StringTableCache::GetTablePath(pluginPath, "english", type);
+
+			// Mapped table
+			size_t allocations = GetAllocationCount();
+			auto startTime = std::chrono::steady_clock::now();
+			Core::StringTable table;
+			if (!table.Open(path))
+			{
+				std::cerr << "bench stringtables: can't open '" << path.string() << "'\n";
+				return 1;
+			}
+			const double mappedOpen = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const size_t mappedAllocations = GetAllocationCount() - allocations;
+
+			// Baseline: the whole file read and copied into a hash map
+			allocations = GetAllocationCount();
+			startTime = std::chrono::steady_clock::now();
+			std::vector<std::byte> content(std::filesystem::file_size(path));
+			{
+				std::ifstream stream(path, std::ios::binary);
+				stream.read(reinterpret_cast<char*>(content.data()), static_cast<std::streamsize>(content.size()));
+			}
+			std::unordered_map<uint32_t, std::string> strings;
+			{
+				Core::BinaryReader reader(content);
+				const uint32_t count = reader.Read<uint32_t>();
+				const uint32_t dataSize = reader.Read<uint32_t>();
+				const size_t dataOffset = 2 * sizeof(uint32_t) + static_cast<size_t>(count) * 2 * sizeof(uint32_t);
+
+				strings.reserve(count);
+				for (uint32_t i = 0; i < count && reader.IsOk(); i++)
+				{
+					const uint32_t id = reader.Read<uint32_t>();
+					const uint32_t offset = reader.Read<uint32_t>();
+
+					Core::BinaryReader text(std::span<const std::byte>(content).subspan(dataOffset, dataSize));
+					text.Skip(offset + (type != Core::StringTableType::Strings ? sizeof(uint32_t) : 0));
+					std::string value;
+					while (text.IsOk() && !text.IsEnd())
+					{
+						const char c = text.Read<char>();
+						if (c == '\0')
+						{
+							break;
+						}
+						value += c;
+					}
+					strings.try_emplace(id, std::move(value));
+				}
+			}
+			const double readOpen = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			const size_t readAllocations = GetAllocationCount() - allocations;
+
+			size_t readMemory = content.capacity() + strings.bucket_count() * sizeof(void*);
+			for (const auto& [id, value]: strings)
+			{
+				// Node with its 'next' pointer and cached hash, plus the text if it doesn't fit inline
+				readMemory += sizeof(std::pair<const uint32_t, std::string>) + 2 * sizeof(void*) + (value.capacity() > 15 ? value.capacity() + 1 : 0);
+			}
+
+			// Random IDs over the whole range, some of them missing from the table
+			std::vector<uint32_t> ids(lookups);
+			uint32_t maxID = 0;
+			table.ForEach([&](uint32_t id, std::string_view)
+			{
+				maxID = std::max(maxID, id);
+			});
+			uint32_t state = 1;
+			for (uint32_t& id: ids)
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				id = 1 + state % maxID;
+			}
+
+			const BenchResult mapped = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				for (uint32_t id: ids)
+				{
+					if (auto text = table.Find(id))
+					{
+						result.Checksum += text->size();
+					}
+				}
+			});
+			const BenchResult read = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				for (uint32_t id: ids)
+				{
+					if (auto it = strings.find(id); it != strings.end())
+					{
+						result.Checksum += it->second.size();
+					}
+				}
+			});
+
+			// Through the cache, the way a caller that doesn't hold on to the table would look strings up
+			const BenchResult cached = MeasureBest(iterations, [&](BenchResult& result)
+			{
+				for (size_t i = 0; i < ids.size(); i += 16)
+				{
+					if (auto text = cache.Find(pluginPath, "english", type, ids[i]))
+					{
+						result.Checksum += text->size();
+					}
+				}
+			});
+
+			// Both readers must agree on every string and on the missing ones
+			for (uint32_t id = 0; id <= maxID + 1; id++)
+			{
+				const auto text = table.Find(id);
+				const auto it = strings.find(id);
+				if (text.has_value() != (it != strings.end()) || (text && *text != it->second))
+				{
+					mismatches++;
+				}
+			}
+			if (mapped.Checksum != read.Checksum)
+			{
+				mismatches++;
+			}
+
+			const Core::StringTableStats stats = table.GetStats();
+			auto Print = [&](std::string_view reader, double openSeconds, double lookupSeconds, size_t lookupCount, size_t heap, size_t mappedSize, size_t allocationCount)
+			{
+				std::cout << std::left << std::setw(10) << Core::GetStringTableExtension(type) << std::setw(8) << reader << std::right << std::fixed << std::setprecision(2)
+					<< std::setw(12) << openSeconds * 1000.0 << std::setprecision(1) << std::setw(12) << lookupSeconds * 1e9 / std::max<size_t>(lookupCount, 1)
+					<< std::setw(14) << heap << std::setw(14) << mappedSize << std::setw(8) << allocationCount << '\n';
+			};
+			Print("mapped", mappedOpen, mapped.Seconds, ids.size(), stats.IndexMemory, stats.MappedSize, mappedAllocations);
+			Print("cached", 0, cached.Seconds, (ids.size() + 15) / 16, 0, 0, 0);
+			Print("read", readOpen, read.Seconds, ids.size(), readMemory, 0, readAllocations);
+		}
+
+		const Core::StringTableCacheStats cacheStats = cache.GetStats();
+		std::cout << "cache: " << cacheStats.Tables << " table(s), " << cacheStats.Loads << " load(s), " << cacheStats.Hits << " hit(s), " << cacheStats.MappedSize << " bytes mapped\n";
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 && cacheStats.Loads == std::size(Core::StringTableTypes) ? 0 : 1;
+	}
+}
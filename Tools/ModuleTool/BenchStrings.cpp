@@ -0,0 +1,148 @@
+#include "Bench.h"
+#include "AllocationCounter.h"
+#include "ModuleFixture.h"
+#include "Core/LoadOrder.h"
+#include "Core/Parallel.h"
+#include "Core/StringPool.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchStrings(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(5000)), 1);
+		const size_t threadCount = std::max<size_t>(args.GetOption("threads", Core::GetDefaultThreadCount()), 1);
+
+		// Synthetic library: plugins require a few of the same base game and popular masters, spelled in different
+		// case now and then, and come from a limited set of authors
+		constexpr std::string_view commonMasters[] =
+		{
+			"Skyrim.esm", "Update.esm", "Dawnguard.esm", "HearthFires.esm", "Dragonborn.esm",
+			"Unofficial Skyrim Special Edition Patch.esp", "SkyUI_SE.esp", "RaceMenu.esp", "SMIM-SE-Merged-All.esp", "Immersive Weapons.esp",
+		};
+		std::vector<std::vector<std::byte>> headers;
+		uint32_t state = 1;
+		for (size_t i = 0; i < count; i++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			FixtureOptions options;
+			options.Seed = static_cast<uint32_t>(i);
+			options.Author = "Author" + std::to_string(state % 200);
+			options.MasterNames.assign(std::begin(commonMasters), std::begin(commonMasters) + 1 + state % 7);
+			if (state % 5 == 0)
+			{
+				std::transform(options.MasterNames[0].begin(), options.MasterNames[0].end(), options.MasterNames[0].begin(), [](char c)
+				{
+					return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+				});
+			}
+			headers.emplace_back(GenerateModule(options));
+		}
+
+		auto Measure = [](auto&& func)
+		{
+			const size_t allocationsBefore = GetAllocationCount();
+			const auto startTime = std::chrono::steady_clock::now();
+			func();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			return std::make_pair(seconds, GetAllocationCount() - allocationsBefore);
+		};
+		auto Print = [&](std::string_view name, std::pair<double, size_t> measurement, size_t memory)
+		{
+			std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+				<< std::setw(10) << std::setprecision(1) << measurement.first * 1e9 / count << " ns/plugin"
+				<< std::setw(8) << std::setprecision(2) << static_cast<double>(measurement.second) / count << " allocs/plugin"
+				<< std::setw(12) << memory << " bytes of author and master names\n";
+		};
+
+		// Strings per plugin, the way 'ModuleInfo' stores them
+		std::vector<Core::ModuleInfo> infos(count);
+		const auto stringsTime = Measure([&]()
+		{
+			Core::ParallelFor(count, threadCount, [&](size_t i)
+			{
+				Core::ModuleHeader header;
+				Core::ParseModuleHeader(headers[i], header);
+				infos[i] = Core::ModuleInfo::FromHeader(headers[i], header);
+			});
+		});
+		size_t stringsMemory = 0;
+		for (const Core::ModuleInfo& info: infos)
+		{
+			// Short strings live inside the object, only longer ones allocate
+			auto GetHeapSize = [](const std::string& value)
+			{
+				return value.capacity() > std::string().capacity() ? value.capacity() + 1 : 0;
+			};
+			stringsMemory += sizeof(std::string) + GetHeapSize(info.Author) + info.Masters.capacity() * sizeof(std::string);
+			for (const std::string& master: info.Masters)
+			{
+				stringsMemory += GetHeapSize(master);
+			}
+		}
+		Print("strings", stringsTime, stringsMemory);
+
+		// Handles into a shared pool
+		Core::StringPool pool;
+		std::vector<Core::PooledModuleInfo> pooledInfos(count);
+		const auto pooledTime = Measure([&]()
+		{
+			Core::ParallelFor(count, threadCount, [&](size_t i)
+			{
+				Core::ModuleHeader header;
+				Core::ParseModuleHeader(headers[i], header);
+				pooledInfos[i] = Core::PooledModuleInfo::FromHeader(headers[i], header, pool);
+			});
+		});
+		const Core::StringPoolStats poolStats = pool.GetStats();
+		size_t pooledMemory = poolStats.MemoryUsage;
+		for (const Core::PooledModuleInfo& info: pooledInfos)
+		{
+			pooledMemory += sizeof(info.Author) + info.Masters.capacity() * sizeof(Core::StringPool::THandle);
+		}
+		Print("pooled", pooledTime, pooledMemory);
+		std::cout << "pool: " << poolStats.Strings << " distinct strings, " << poolStats.BytesStored << " bytes of text, " << poolStats.Lookups << " lookups\n";
+
+		// Who requires 'Skyrim.esm': string comparisons against handle comparisons
+		size_t stringMatches = 0;
+		const auto stringCompareTime = Measure([&]()
+		{
+			for (const Core::ModuleInfo& info: infos)
+			{
+				stringMatches += std::count_if(info.Masters.begin(), info.Masters.end(), [](const std::string& name)
+				{
+					return Core::StringPool::Equals(name, "Skyrim.esm");
+				});
+			}
+		});
+		size_t handleMatches = 0;
+		const auto handleCompareTime = Measure([&]()
+		{
+			const Core::StringPool::THandle skyrim = pool.Intern("Skyrim.esm");
+			for (const Core::PooledModuleInfo& info: pooledInfos)
+			{
+				handleMatches += std::count(info.Masters.begin(), info.Masters.end(), skyrim);
+			}
+		});
+		std::cout << std::setprecision(1) << "dependents of Skyrim.esm: " << stringMatches << " by name in " << stringCompareTime.first * 1e6 << " us, "
+			<< handleMatches << " by handle in " << handleCompareTime.first * 1e6 << " us\n";
+
+		// Load order graph links masters by handle
+		Core::LoadOrderGraph graph;
+		const auto graphTime = Measure([&]()
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				graph.Update("Plugin" + std::to_string(i) + ".esp", infos[i]);
+			}
+			graph.Resolve();
+		});
+		std::cout << std::setprecision(3) << "load order graph: " << graphTime.first * 1000.0 << " ms\n";
+		return stringMatches == handleMatches ? 0 : 1;
+	}
+}
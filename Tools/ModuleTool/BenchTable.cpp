@@ -0,0 +1,179 @@
+#include "Bench.h"
+#include "Core/ModuleTable.h"
+#include "Core/Parallel.h"
+#include "Core/StringPool.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace BethesdaModule::Tool
+{
+	int BenchTable(const CommandLine& args)
+	{
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(50000)), 1);
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+		const std::vector<Core::ScanResult> results = GenerateLibrary(count, args.GetOption("threads", Core::GetDefaultThreadCount()));
+
+		// Row per struct with its own strings, the way handlers and scans keep them
+		auto GetHeapSize = [](const auto& value)
+		{
+			return value.capacity() > std::string().capacity() ? (value.capacity() + 1) * sizeof(value[0]) : 0;
+		};
+		size_t structMemory = results.capacity() * sizeof(Core::ScanResult);
+		for (const Core::ScanResult& result: results)
+		{
+			structMemory += GetHeapSize(result.Path.native()) + GetHeapSize(result.Info.Author) + GetHeapSize(result.Info.Description) + result.Info.Masters.capacity() * sizeof(std::string);
+			for (const std::string& master: result.Info.Masters)
+			{
+				structMemory += GetHeapSize(master);
+			}
+		}
+
+		Core::ModuleTable table;
+		const BenchResult build = MeasureBest(iterations, [&](BenchResult&)
+		{
+			table = Core::ModuleTable::Build(results);
+		});
+
+		std::cout << "Library: " << count << " plugins, " << table.GetNameCount() << " distinct file and master names\n";
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "memory: " << structMemory << " bytes as structs, " << table.GetMemoryUsage() << " bytes as columns; build " << build.Seconds * 1e9 / count << " ns/plugin\n";
+		std::cout << std::left << std::setw(22) << "query" << std::right << std::setw(10) << "rows" << std::setw(16) << "structs ns/row" << std::setw(16) << "columns ns/row" << std::setw(10) << "speedup" << '\n';
+
+		size_t mismatches = 0;
+		auto Compare = [&](std::string_view name, auto&& structs, auto&& columns)
+		{
+			std::vector<Core::ModuleTable::TRow> expected;
+			std::vector<Core::ModuleTable::TRow> rows;
+			const BenchResult structTime = MeasureBest(iterations, [&](BenchResult&)
+			{
+				expected = structs();
+			});
+			const BenchResult columnTime = MeasureBest(iterations, [&](BenchResult&)
+			{
+				rows = columns();
+			});
+			mismatches += rows != expected;
+
+			std::cout << std::left << std::setw(22) << name << std::right << std::setw(10) << rows.size() << std::setw(16) << structTime.Seconds * 1e9 / count
+				<< std::setw(16) << columnTime.Seconds * 1e9 / count << std::setw(9) << structTime.Seconds / columnTime.Seconds << "x\n";
+		};
+		auto AllRows = [&]()
+		{
+			std::vector<Core::ModuleTable::TRow> rows(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				rows[i] = static_cast<Core::ModuleTable::TRow>(i);
+			}
+			return rows;
+		};
+
+		// Light plugins of Skyrim Special Edition
+		Compare("esl skyrimse", [&]()
+		{
+			std::vector<Core::ModuleTable::TRow> rows;
+			for (size_t i = 0; i < count; i++)
+			{
+				const Core::ModuleInfo& info = results[i].Info;
+				if (Core::TestFlag(info.Flags, Core::HeaderFlags::Light) && info.FormatLevel == Core::FormatLevel::Skyrim && info.FormVersion == 44)
+				{
+					rows.push_back(static_cast<Core::ModuleTable::TRow>(i));
+				}
+			}
+			return rows;
+		}, [&]()
+		{
+			Core::ModuleFilter filter;
+			filter.RequiredFlags = Core::HeaderFlags::Light;
+			filter.FormatLevel = Core::FormatLevel::Skyrim;
+			filter.MinFormVersion = 44;
+			filter.MaxFormVersion = 44;
+			return table.Select(filter);
+		});
+
+		// Light but not master, older than Skyrim Special Edition
+		Compare("esl !esm version<44", [&]()
+		{
+			std::vector<Core::ModuleTable::TRow> rows;
+			for (size_t i = 0; i < count; i++)
+			{
+				const Core::ModuleInfo& info = results[i].Info;
+				if (Core::TestFlag(info.Flags, Core::HeaderFlags::Light) && !Core::TestFlag(info.Flags, Core::HeaderFlags::Master) && info.FormVersion < 44)
+				{
+					rows.push_back(static_cast<Core::ModuleTable::TRow>(i));
+				}
+			}
+			return rows;
+		}, [&]()
+		{
+			Core::ModuleFilter filter;
+			filter.RequiredFlags = Core::HeaderFlags::Light;
+			filter.ExcludedFlags = Core::HeaderFlags::Master;
+			filter.MaxFormVersion = 43;
+			return table.Select(filter);
+		});
+
+		// Everything that requires 'Dawnguard.esm', in any case
+		Compare("requires dawnguard", [&]()
+		{
+			std::vector<Core::ModuleTable::TRow> rows;
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto& masters = results[i].Info.Masters;
+				if (std::any_of(masters.begin(), masters.end(), [](const std::string& master)
+				{
+					return Core::StringPool::Equals(master, "dawnguard.esm");
+				}))
+				{
+					rows.push_back(static_cast<Core::ModuleTable::TRow>(i));
+				}
+			}
+			return rows;
+		}, [&]()
+		{
+			Core::ModuleFilter filter;
+			filter.Master = table.FindName("dawnguard.esm").value_or(std::numeric_limits<uint32_t>::max());
+			return table.Select(filter);
+		});
+
+		// Sorts of row indices, structs are read through the index just like columns are
+		Compare("sort form version", [&]()
+		{
+			auto rows = AllRows();
+			std::stable_sort(rows.begin(), rows.end(), [&](Core::ModuleTable::TRow left, Core::ModuleTable::TRow right)
+			{
+				return results[left].Info.FormVersion > results[right].Info.FormVersion;
+			});
+			return rows;
+		}, [&]()
+		{
+			return table.Sort(Core::ModuleColumn::FormVersion, true);
+		});
+		Compare("sort file size", [&]()
+		{
+			auto rows = AllRows();
+			std::stable_sort(rows.begin(), rows.end(), [&](Core::ModuleTable::TRow left, Core::ModuleTable::TRow right)
+			{
+				return results[left].FileSize < results[right].FileSize;
+			});
+			return rows;
+		}, [&]()
+		{
+			return table.Sort(Core::ModuleColumn::FileSize);
+		});
+
+		// Every row has to come back out as it went in
+		for (size_t i = 0; i < count; i++)
+		{
+			const Core::ScanResult result = table.GetResult(static_cast<Core::ModuleTable::TRow>(i));
+			const Core::ScanResult& expected = results[i];
+			mismatches += result.Path != expected.Path || result.FileSize != expected.FileSize || result.Status != expected.Status || result.Info.Signature != expected.Info.Signature
+				|| result.Info.Flags != expected.Info.Flags || result.Info.FormVersion != expected.Info.FormVersion || result.Info.FormatLevel != expected.Info.FormatLevel
+				|| result.Info.Author != expected.Info.Author || result.Info.Description != expected.Info.Description || result.Info.Masters != expected.Info.Masters;
+		}
+
+		std::cout << "mismatches: " << mismatches << '\n';
+		return mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,149 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/TextDecoder.h"
+#include <iomanip>
+#include <iostream>
+
+namespace BethesdaModule::Tool
+{
+	int BenchText(const CommandLine& args)
+	{
+		const size_t iterations = args.GetOption("iterations", size_t(5));
+		const size_t count = std::max<size_t>(args.GetOption("files", size_t(20000)), 1);
+		const std::string_view textName = args.GetOption("text", "ascii");
+		const auto textType = ParseFixtureText(textName);
+		if (!textType)
+		{
+			std::cerr << "bench text: unknown text type '" << textName << "'\n";
+			return 1;
+		}
+
+		// Author, description and master names of generated headers, decoded the way the text type was written
+		Core::TextDecodeOptions options;
+		options.Encoding = *textType == FixtureText::Windows1251 ? Core::TextEncoding::Windows1251 : Core::TextEncoding::Windows1252;
+		options.DetectUTF8 = args.HasOption("detect") || *textType == FixtureText::UTF8;
+
+		std::vector<std::string> strings;
+		size_t totalSize = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			FixtureOptions fixtureOptions;
+			fixtureOptions.Seed = static_cast<uint32_t>(i);
+			fixtureOptions.Text = *textType;
+			fixtureOptions.AuthorLength = args.GetOption("author", size_t(16));
+			fixtureOptions.DescriptionLength = args.GetOption("description", size_t(64));
+			fixtureOptions.MasterCount = i % 4;
+
+			const std::vector<std::byte> content = GenerateModule(fixtureOptions);
+			Core::ModuleHeader header;
+			Core::ParseModuleHeader(content, header);
+			Core::ModuleInfo info = Core::ModuleInfo::FromHeader(content, header);
+
+			totalSize += info.Author.size() + info.Description.size();
+			strings.emplace_back(std::move(info.Author));
+			strings.emplace_back(std::move(info.Description));
+			for (std::string& master: info.Masters)
+			{
+				totalSize += master.size();
+				strings.emplace_back(std::move(master));
+			}
+		}
+
+		size_t maxSize = 256;
+		for (const std::string& text: strings)
+		{
+			maxSize = std::max(maxSize, text.size());
+		}
+
+		std::vector<char16_t> buffer(maxSize);
+		auto Decode = [&](auto&& func)
+		{
+			return MeasureBest(iterations, [&](BenchResult& result)
+			{
+				for (const std::string& text: strings)
+				{
+					result.Checksum += func(text, buffer.data());
+					result.BytesRead += text.size();
+				}
+			});
+		};
+		auto Print = [&](std::string_view name, const BenchResult& result)
+		{
+			std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << result.Seconds * 1e9 / strings.size() << " ns/string"
+				<< std::setw(10) << result.BytesRead / std::max(result.Seconds, 1e-9) / (1024.0 * 1024.0) << " MB/sec\n";
+		};
+
+		std::cout << strings.size() << " strings, " << totalSize << " bytes, " << textName << " text decoded as " << Core::GetTextEncodingName(options.Encoding) << (options.DetectUTF8 ? " with UTF-8 detection\n" : "\n");
+		const BenchResult scalar = Decode([&](const std::string& text, char16_t* out)
+		{
+			return Core::DecodeToUTF16Scalar(text, out, options);
+		});
+		Print("scalar", scalar);
+		const BenchResult vector = Decode([&](const std::string& text, char16_t* out)
+		{
+			return Core::DecodeToUTF16(text, out, options);
+		});
+		Print("vector", vector);
+
+		std::string utf8;
+		Print("utf8", MeasureBest(iterations, [&](BenchResult& result)
+		{
+			for (const std::string& text: strings)
+			{
+				Core::DecodeToUTF8(text, utf8, options);
+				result.Checksum += utf8.size();
+				result.BytesRead += text.size();
+			}
+		}));
+
+		// Both paths must agree on the generated text, on every byte value and on randomly broken text in every encoding
+		size_t mismatches = 0;
+		std::vector<char16_t> reference(maxSize);
+		auto Compare = [&](std::string_view text, const Core::TextDecodeOptions& compareOptions)
+		{
+			const size_t size = Core::DecodeToUTF16(text, buffer.data(), compareOptions);
+			if (size != Core::DecodeToUTF16Scalar(text, reference.data(), compareOptions) || !std::equal(buffer.begin(), buffer.begin() + size, reference.begin()))
+			{
+				mismatches++;
+			}
+		};
+		for (const std::string& text: strings)
+		{
+			Compare(text, options);
+		}
+
+		uint32_t state = 1;
+		for (Core::TextEncoding encoding: {Core::TextEncoding::Windows1250, Core::TextEncoding::Windows1251, Core::TextEncoding::Windows1252, Core::TextEncoding::UTF8})
+		{
+			Core::TextDecodeOptions compareOptions;
+			compareOptions.Encoding = encoding;
+			compareOptions.DetectUTF8 = true;
+
+			std::string allBytes(256, '\0');
+			for (size_t i = 0; i < allBytes.size(); i++)
+			{
+				allBytes[i] = static_cast<char>(i);
+			}
+			Compare(allBytes, compareOptions);
+
+			for (size_t i = 0; i < 10000; i++)
+			{
+				std::string text = strings[i % strings.size()];
+				for (char& c: text)
+				{
+					state ^= state << 13;
+					state ^= state >> 17;
+					state ^= state << 5;
+					if (state % 16 == 0)
+					{
+						c = static_cast<char>(state >> 24);
+					}
+				}
+				Compare(text, compareOptions);
+			}
+		}
+		std::cout << "mismatches: " << mismatches << '\n';
+		return scalar.Checksum == vector.Checksum && mismatches == 0 ? 0 : 1;
+	}
+}
@@ -0,0 +1,273 @@
+#include "Bench.h"
+#include "ModuleFixture.h"
+#include "Core/ModuleWatcher.h"
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace BethesdaModule::Tool
+{
+	int BenchWatch(const CommandLine& args)
+	{
+		if (!Core::ModuleWatcher::IsSupported())
+		{
+			std::cerr << "bench watch: not supported on this platform\n";
+			return 1;
+		}
+
+		const size_t count = std::max<size_t>(args.GetOption("plugins", size_t(2000)), 1);
+		const size_t burst = std::max<size_t>(args.GetOption("files", size_t(200)), 1);
+		const size_t iterations = std::max<size_t>(args.GetOption("iterations", size_t(5)), 1);
+		const auto idleTime = std::chrono::milliseconds(args.GetOption("idle-ms", size_t(1000)));
+
+		// A fresh folder every run, so the watcher starts from a known state
+		const std::filesystem::path directory = GetCorpusDirectory(args) / "Watch";
+		{
+			std::error_code error;
+			std::filesystem::remove_all(directory, error);
+		}
+		FixtureOptions fixtureOptions;
+		fixtureOptions.MasterCount = args.GetOption("masters", size_t(8));
+		fixtureOptions.BodySize = args.GetOption("body", size_t(4 * 1024));
+		if (GenerateModuleCorpus(directory, count, fixtureOptions).size() != count)
+		{
+			std::cerr << "bench watch: can't write the corpus\n";
+			return 1;
+		}
+
+		auto WriteModule = [&](const std::filesystem::path& path, std::string author)
+		{
+			fixtureOptions.Author = std::move(author);
+			const std::vector<std::byte> data = GenerateModule(fixtureOptions);
+
+			std::ofstream stream(path, std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			return static_cast<bool>(stream);
+		};
+
+		// What the watcher replaces: listing and parsing the whole folder again
+		Core::ModuleScanner scanner(args.GetOption("threads", size_t(0)));
+		const BenchResult rescan = MeasureBest(iterations, [&](BenchResult& result)
+		{
+			result.BytesRead += scanner.Scan(directory, [](const Core::ScanResult&)
+			{
+			}).BytesRead;
+		});
+
+		Core::ModuleWatcherOptions options;
+		options.ThreadCount = args.GetOption("threads", size_t(0));
+		options.QuietPeriod = std::chrono::milliseconds(args.GetOption("quiet-ms", size_t(20)));
+		options.MaxDelay = std::chrono::milliseconds(args.GetOption("max-delay-ms", size_t(250)));
+
+		Core::ModuleWatcher watcher;
+		auto startTime = std::chrono::steady_clock::now();
+		if (!watcher.Open(directory, options))
+		{
+			std::cerr << "bench watch: can't watch '" << directory.string() << "'\n";
+			return 1;
+		}
+		const double openTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		// Updates are applied on their own thread, the bench waits until the expected number of them arrives
+		std::mutex mutex;
+		std::condition_variable updated;
+		size_t updateCount = 0;
+		std::chrono::steady_clock::time_point updateTime;
+		std::thread thread([&]()
+		{
+			watcher.Run([&](const Core::ModuleUpdate&)
+			{
+				std::lock_guard lock(mutex);
+				updateCount++;
+				updateTime = std::chrono::steady_clock::now();
+				updated.notify_all();
+			});
+		});
+		auto WaitForUpdates = [&](size_t expected) -> std::optional<std::chrono::steady_clock::time_point>
+		{
+			std::unique_lock lock(mutex);
+			if (!updated.wait_for(lock, std::chrono::seconds(30), [&]()
+			{
+				return updateCount >= expected;
+			}))
+			{
+				return {};
+			}
+			return updateTime;
+		};
+
+		std::cout << "Folder: " << count << " modules, bursts of " << burst << " files, " << options.QuietPeriod.count() << " ms quiet period, " << options.MaxDelay.count() << " ms max delay\n";
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "open and index: " << openTime * 1000.0 << " ms, full rescan: " << rescan.Seconds * 1000.0 << " ms (" << rescan.BytesRead << " bytes read)\n";
+		std::cout << std::left << std::setw(12) << "change" << std::right << std::setw(8) << "files" << std::setw(14) << "latency ms" << std::setw(10) << "events"
+			<< std::setw(10) << "batches" << std::setw(10) << "parsed" << '\n';
+
+		size_t mismatches = 0;
+		bool isTimedOut = false;
+		auto Measure = [&](std::string_view name, size_t files, auto&& change, auto&& verify)
+		{
+			// Best of N, each run waits for the index to catch up before the next one starts
+			double best = 0;
+			const Core::ModuleWatcherStats before = watcher.GetStats();
+			for (size_t i = 0; i < iterations && !isTimedOut; i++)
+			{
+				// Let the previous batch settle, so its stragglers aren't counted for this one
+				std::this_thread::sleep_for(options.QuietPeriod * 2);
+
+				size_t expected = 0;
+				{
+					std::lock_guard lock(mutex);
+					expected = updateCount + files;
+				}
+				if (!change(i))
+				{
+					std::cerr << "bench watch: can't change the folder\n";
+					isTimedOut = true;
+					break;
+				}
+				const auto changeTime = std::chrono::steady_clock::now();
+
+				auto time = WaitForUpdates(expected);
+				if (!time)
+				{
+					std::cerr << "bench watch: no update after '" << name << "'\n";
+					isTimedOut = true;
+					break;
+				}
+				const double latency = std::chrono::duration<double>(*time - changeTime).count();
+				best = i == 0 ? latency : std::min(best, latency);
+				mismatches += verify(i);
+			}
+
+			const Core::ModuleWatcherStats after = watcher.GetStats();
+			std::cout << std::left << std::setw(12) << name << std::right << std::setw(8) << files << std::setw(14) << best * 1000.0
+				<< std::setw(10) << (after.Events - before.Events) / iterations << std::setw(10) << static_cast<double>(after.Batches - before.Batches) / iterations
+				<< std::setw(10) << (after.Parsed - before.Parsed) / iterations << '\n';
+		};
+
+		auto GetBurstPath = [&](size_t index, std::string_view prefix)
+		{
+			return directory / (std::string(prefix) + std::to_string(index) + ".esp");
+		};
+		auto VerifyAuthor = [&](const std::filesystem::path& path, std::string_view author) -> size_t
+		{
+			auto result = watcher.Find(path);
+			return !result || result->Info.Author != author;
+		};
+
+		// One plugin saved by an editor
+		Measure("modify", 1, [&](size_t i)
+		{
+			return WriteModule(directory / "Fixture0.esp", "Modified" + std::to_string(i));
+		}, [&](size_t i)
+		{
+			return VerifyAuthor(directory / "Fixture0.esp", "Modified" + std::to_string(i));
+		});
+
+		// A mod manager deploying, renaming and removing a batch of plugins
+		Measure("create", burst, [&](size_t i)
+		{
+			for (size_t j = 0; j < burst; j++)
+			{
+				if (!WriteModule(GetBurstPath(j, "Burst"), "Burst" + std::to_string(i) + '.' + std::to_string(j)))
+				{
+					return false;
+				}
+			}
+			return true;
+		}, [&](size_t i)
+		{
+			size_t result = 0;
+			for (size_t j = 0; j < burst; j++)
+			{
+				result += VerifyAuthor(GetBurstPath(j, "Burst"), "Burst" + std::to_string(i) + '.' + std::to_string(j));
+			}
+			return result;
+		});
+		Measure("rename", burst, [&](size_t i)
+		{
+			std::error_code error;
+			for (size_t j = 0; j < burst && !error; j++)
+			{
+				std::filesystem::rename(GetBurstPath(j, i % 2 ? "Renamed" : "Burst"), GetBurstPath(j, i % 2 ? "Burst" : "Renamed"), error);
+			}
+			return !error;
+		}, [&](size_t i)
+		{
+			size_t result = 0;
+			for (size_t j = 0; j < burst; j++)
+			{
+				result += VerifyAuthor(GetBurstPath(j, i % 2 ? "Burst" : "Renamed"), "Burst" + std::to_string(iterations - 1) + '.' + std::to_string(j));
+				result += watcher.Find(GetBurstPath(j, i % 2 ? "Renamed" : "Burst")) != nullptr;
+			}
+			return result;
+		});
+		Measure("remove", burst, [&](size_t i)
+		{
+			// Every other run puts the files back, so there's something to remove
+			std::error_code error;
+			const std::string_view prefix = iterations % 2 ? "Renamed" : "Burst";
+			for (size_t j = 0; j < burst && !error; j++)
+			{
+				if (i % 2)
+				{
+					WriteModule(GetBurstPath(j, prefix), "Restored");
+				}
+				else
+				{
+					std::filesystem::remove(GetBurstPath(j, prefix), error);
+				}
+			}
+			return !error;
+		}, [&](size_t i)
+		{
+			size_t result = 0;
+			const std::string_view prefix = iterations % 2 ? "Renamed" : "Burst";
+			for (size_t j = 0; j < burst; j++)
+			{
+				result += i % 2 ? VerifyAuthor(GetBurstPath(j, prefix), "Restored") : watcher.Find(GetBurstPath(j, prefix)) != nullptr;
+			}
+			return result;
+		});
+
+		// Nothing happens: the watcher thread should stay blocked and not use any CPU
+		auto GetCPUTime = []()
+		{
+			#if defined(__linux__)
+			rusage usage = {};
+			::getrusage(RUSAGE_SELF, &usage);
+			return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+			#else
+			return 0.0;
+			#endif
+		};
+		const size_t idleWakeups = watcher.GetStats().Wakeups;
+		const double idleCPU = GetCPUTime();
+		std::this_thread::sleep_for(idleTime);
+		std::cout << "idle " << idleTime.count() << " ms: " << (GetCPUTime() - idleCPU) * 1000.0 << " ms of CPU, " << watcher.GetStats().Wakeups - idleWakeups << " wakeup(s)\n";
+
+		watcher.Stop();
+		thread.join();
+
+		// The index has to match a scan of the folder done from scratch
+		size_t scanned = 0;
+		scanner.Scan(directory, [&](const Core::ScanResult& result)
+		{
+			auto indexed = watcher.Find(result.Path);
+			mismatches += !indexed || indexed->Info.Author != result.Info.Author || indexed->FileSize != result.FileSize;
+			scanned++;
+		});
+		mismatches += scanned != watcher.GetCount();
+
+		const Core::ModuleWatcherStats stats = watcher.GetStats();
+		std::cout << "indexed: " << stats.Modules << " modules in " << stats.Directories << " folder(s), " << stats.Overflows << " overflow(s)\nmismatches: " << mismatches << '\n';
+		return mismatches == 0 && !isTimedOut ? 0 : 1;
+	}
+}
@@ -0,0 +1,73 @@
+#include "Commands.h"
+#include "Core/MetadataCache.h"
+#include <iostream>
+#include <chrono>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	void PrintStats(const Core::CacheStats& stats)
+	{
+		std::cout << "entries: " << stats.Entries << '\n';
+		std::cout << "dead records: " << stats.DeadRecords << '\n';
+		std::cout << "file size: " << stats.FileSize << '\n';
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunCache(const CommandLine& args)
+	{
+		auto action = args.GetPositional(0);
+		auto cachePath = args.GetPositional(1);
+		if (!action || !cachePath)
+		{
+			std::cerr << "cache: action and cache file are required\n";
+			return 1;
+		}
+
+		Core::MetadataCache cache;
+		if (!cache.Open(std::filesystem::path(*cachePath)))
+		{
+			std::cerr << "cache: can't open '" << *cachePath << "'\n";
+			return 1;
+		}
+
+		if (*action == "warm")
+		{
+			auto directory = args.GetPositional(2);
+			if (!directory)
+			{
+				std::cerr << "cache: directory is required\n";
+				return 1;
+			}
+
+			const auto startTime = std::chrono::steady_clock::now();
+			const size_t added = cache.Warm(std::filesystem::path(*directory), args.GetOption("threads", size_t(0)), !args.HasOption("no-recurse"));
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			const Core::CacheStats stats = cache.GetStats();
+			std::cerr << "warmed " << added << " new file(s), " << stats.Hits << " already cached, in " << seconds * 1000.0 << " ms\n";
+			return 0;
+		}
+		else if (*action == "stats")
+		{
+			PrintStats(cache.GetStats());
+			return 0;
+		}
+		else if (*action == "compact")
+		{
+			if (!cache.Compact())
+			{
+				std::cerr << "cache: compaction failed\n";
+				return 1;
+			}
+			PrintStats(cache.GetStats());
+			return 0;
+		}
+
+		std::cerr << "cache: unknown action '" << *action << "', use 'warm', 'stats' or 'compact'\n";
+		return 1;
+	}
+}
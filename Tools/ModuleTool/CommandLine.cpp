@@ -0,0 +1,63 @@
+#include "CommandLine.h"
+#include <charconv>
+
+namespace BethesdaModule::Tool
+{
+	CommandLine::CommandLine(int argc, char** argv, int first)
+	{
+		for (int i = first; i < argc; i++)
+		{
+			std::string_view arg = argv[i];
+			if (arg.size() > 2 && arg.substr(0, 2) == "--")
+			{
+				arg.remove_prefix(2);
+
+				// Both '--name=value' and '--name value' are accepted, an option without value is a flag
+				if (size_t pos = arg.find('='); pos != arg.npos)
+				{
+					m_Options.emplace_back(arg.substr(0, pos), arg.substr(pos + 1));
+				}
+				else if (i + 1 < argc && std::string_view(argv[i + 1]).substr(0, 2) != "--")
+				{
+					m_Options.emplace_back(arg, argv[++i]);
+				}
+				else
+				{
+					m_Options.emplace_back(arg, std::string());
+				}
+			}
+			else
+			{
+				m_Positional.emplace_back(arg);
+			}
+		}
+	}
+
+	bool CommandLine::HasOption(std::string_view name) const noexcept
+	{
+		return GetOption(name).has_value();
+	}
+	std::optional<std::string_view> CommandLine::GetOption(std::string_view name) const noexcept
+	{
+		for (const auto& [key, value]: m_Options)
+		{
+			if (key == name)
+			{
+				return value;
+			}
+		}
+		return {};
+	}
+	size_t CommandLine::GetOption(std::string_view name, size_t defaultValue) const noexcept
+	{
+		if (auto value = GetOption(name))
+		{
+			size_t result = 0;
+			if (std::from_chars(value->data(), value->data() + value->size(), result).ec == std::errc())
+			{
+				return result;
+			}
+		}
+		return defaultValue;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <utility>
+
+namespace BethesdaModule::Tool
+{
+	// Splits arguments into positional ones and '--name value' / '--flag' options
+	class CommandLine final
+	{
+		private:
+			std::vector<std::string> m_Positional;
+			std::vector<std::pair<std::string, std::string>> m_Options;
+
+		public:
+			CommandLine() = default;
+			CommandLine(int argc, char** argv, int first = 1);
+
+		public:
+			const std::vector<std::string>& GetPositional() const noexcept
+			{
+				return m_Positional;
+			}
+			std::optional<std::string_view> GetPositional(size_t index) const noexcept
+			{
+				if (index < m_Positional.size())
+				{
+					return m_Positional[index];
+				}
+				return {};
+			}
+
+			bool HasOption(std::string_view name) const noexcept;
+			std::optional<std::string_view> GetOption(std::string_view name) const noexcept;
+			std::string_view GetOption(std::string_view name, std::string_view defaultValue) const noexcept
+			{
+				return GetOption(name).value_or(defaultValue);
+			}
+			size_t GetOption(std::string_view name, size_t defaultValue) const noexcept;
+	};
+}
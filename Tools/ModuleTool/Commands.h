@@ -0,0 +1,38 @@
+#pragma once
+#include "CommandLine.h"
+#include <iosfwd>
+
+namespace BethesdaModule::Core
+{
+	struct LoadOrderResult;
+}
+
+namespace BethesdaModule::Tool
+{
+	struct Command final
+	{
+		using TFunc = int(*)(const CommandLine& args);
+
+		std::string_view Name;
+		std::string_view Usage;
+		TFunc Run = nullptr;
+	};
+
+	int RunScan(const CommandLine& args);
+	int RunBench(const CommandLine& args);
+	int RunCache(const CommandLine& args);
+	int RunRecords(const CommandLine& args);
+	int RunLoadOrder(const CommandLine& args);
+	int RunConflicts(const CommandLine& args);
+	int RunStringTable(const CommandLine& args);
+	int RunArchive(const CommandLine& args);
+	int RunWatch(const CommandLine& args);
+	int RunQuery(const CommandLine& args);
+	int RunSnapshot(const CommandLine& args);
+
+	// Prints a short summary line to stderr, shared by all commands that process a number of files
+	void PrintThroughput(std::string_view what, size_t files, uint64_t bytes, double seconds);
+
+	// Resolves the load order of the data folder given as the first positional argument, honoring '--plugins'
+	bool ResolveLoadOrder(const CommandLine& args, std::string_view command, Core::LoadOrderResult& result);
+}
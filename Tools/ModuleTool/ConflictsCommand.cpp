@@ -0,0 +1,145 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/FormIDIndex.h"
+#include "Core/LoadOrder.h"
+#include "Core/Parallel.h"
+#include <iostream>
+#include <iomanip>
+#include <charconv>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	// 'Skyrim.esm:012E49', the object ID is relative to the plugin that introduced the form
+	std::string FormatFormID(const Core::FormIDIndex& index, Core::GlobalFormID formID)
+	{
+		char objectID[16] = {};
+		auto end = std::to_chars(std::begin(objectID), std::end(objectID), Core::GetFormIDObject(formID), 16).ptr;
+
+		std::string result = index.GetPlugins()[Core::GetFormIDPlugin(formID)].Name;
+		result += ':';
+		result.append(6 - std::min<size_t>(end - objectID, 6), '0');
+		result.append(objectID, end);
+		return result;
+	}
+	std::optional<Core::GlobalFormID> ParseFormID(const Core::FormIDIndex& index, std::string_view value)
+	{
+		const size_t separator = value.rfind(':');
+		if (separator == std::string_view::npos)
+		{
+			return {};
+		}
+
+		uint32_t objectID = 0;
+		const std::string_view number = value.substr(separator + 1);
+		if (std::from_chars(number.data(), number.data() + number.size(), objectID, 16).ec != std::errc())
+		{
+			return {};
+		}
+		if (auto plugin = index.FindPlugin(value.substr(0, separator)))
+		{
+			return Core::MakeGlobalFormID(*plugin, objectID);
+		}
+		return {};
+	}
+
+	void WriteForm(std::string& buffer, const Core::FormIDIndex& index, Core::GlobalFormID formID)
+	{
+		const std::vector<uint32_t> plugins = index.FindDefinitions(formID);
+
+		buffer += "{\"form\":";
+		Tool::AppendJSONString(buffer, FormatFormID(index, formID));
+		buffer += ",\"plugins\":[";
+		for (size_t i = 0; i < plugins.size(); i++)
+		{
+			if (i != 0)
+			{
+				buffer += ',';
+			}
+			Tool::AppendJSONString(buffer, index.GetPlugins()[plugins[i]].Name);
+		}
+		buffer += "],\"winner\":";
+		Tool::AppendJSONString(buffer, !plugins.empty() ? std::string_view(index.GetPlugins()[plugins.back()].Name) : std::string_view());
+		buffer += "}\n";
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunConflicts(const CommandLine& args)
+	{
+		Core::LoadOrderResult loadOrder;
+		if (!ResolveLoadOrder(args, "conflicts", loadOrder))
+		{
+			return 1;
+		}
+
+		std::vector<std::filesystem::path> files;
+		for (const Core::LoadOrderEntry& entry: loadOrder.Order)
+		{
+			files.push_back(std::filesystem::path(*args.GetPositional(0)) / std::u8string(entry.Name.begin(), entry.Name.end()));
+		}
+
+		Core::FormIDIndex index;
+		const auto startTime = std::chrono::steady_clock::now();
+		index.Build(files, args.GetOption("threads", Core::GetDefaultThreadCount()));
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		const Core::FormIDIndexStats stats = index.GetStats();
+		std::cerr << std::fixed << std::setprecision(3) << "indexed " << stats.Records << " record(s) of " << stats.Plugins << " plugin(s) in " << seconds * 1000.0 << " ms: "
+			<< stats.Forms << " forms, " << stats.Overrides << " overrides, " << stats.Orphans << " orphaned, " << stats.MemoryUsage << " bytes\n";
+
+		std::string buffer;
+		if (auto value = args.GetOption("form"))
+		{
+			// Who defines and overrides the form
+			auto formID = ParseFormID(index, *value);
+			if (!formID)
+			{
+				std::cerr << "conflicts: '" << *value << "' isn't a form of a known plugin, use 'Plugin.esm:012345'\n";
+				return 1;
+			}
+			WriteForm(buffer, index, *formID);
+		}
+		else if (auto name = args.GetOption("plugin"))
+		{
+			// What the plugin overrides
+			auto plugin = index.FindPlugin(*name);
+			if (!plugin)
+			{
+				std::cerr << "conflicts: plugin '" << *name << "' isn't in the load order\n";
+				return 1;
+			}
+			for (Core::GlobalFormID formID: index.GetOverrides(*plugin))
+			{
+				WriteForm(buffer, index, formID);
+			}
+		}
+		else
+		{
+			// Summary per plugin
+			const auto& plugins = index.GetPlugins();
+			for (uint32_t i = 0; i < plugins.size(); i++)
+			{
+				const auto& overrides = index.GetOverrides(i);
+				const size_t winning = std::count_if(overrides.begin(), overrides.end(), [&](Core::GlobalFormID formID)
+				{
+					return index.FindWinner(formID) == i;
+				});
+
+				buffer += "{\"plugin\":";
+				AppendJSONString(buffer, plugins[i].Name);
+				buffer += ",\"status\":";
+				AppendJSONString(buffer, Core::GetParseStatusName(plugins[i].Status));
+				buffer += ",\"records\":" + std::to_string(plugins[i].Records);
+				buffer += ",\"overrides\":" + std::to_string(overrides.size());
+				buffer += ",\"winning\":" + std::to_string(winning);
+				buffer += "}\n";
+			}
+		}
+		std::cout << buffer;
+		std::cout.flush();
+		return 0;
+	}
+}
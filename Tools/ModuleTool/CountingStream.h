@@ -0,0 +1,82 @@
+#pragma once
+#include "Core/ByteSource.h"
+#include "Core/ReadAheadBuffer.h"
+#include <span>
+
+namespace BethesdaModule::Tool
+{
+	// Stands in for 'IStream' over a file: data comes from memory and every call is counted, so the counters
+	// 'Core::ReadAheadBuffer' keeps can be checked against what actually reached the stream
+	class CountingStream final
+	{
+		private:
+			std::span<const std::byte> m_Data;
+			uint64_t m_Position = 0;
+
+			size_t m_ReadCalls = 0;
+			size_t m_SeekCalls = 0;
+
+		public:
+			CountingStream(std::span<const std::byte> data) noexcept
+				:m_Data(data)
+			{
+			}
+
+		public:
+			size_t GetReadCalls() const noexcept
+			{
+				return m_ReadCalls;
+			}
+			size_t GetSeekCalls() const noexcept
+			{
+				return m_SeekCalls;
+			}
+
+			size_t Read(void* buffer, size_t size)
+			{
+				m_ReadCalls++;
+				const size_t read = Core::MemoryByteSource(m_Data).ReadAt(m_Position, buffer, size);
+				m_Position += read;
+				return read;
+			}
+			std::optional<uint64_t> Seek(int64_t offset, Core::SeekOrigin origin)
+			{
+				m_SeekCalls++;
+				const int64_t base = origin == Core::SeekOrigin::Start ? 0 : (origin == Core::SeekOrigin::End ? static_cast<int64_t>(m_Data.size()) : static_cast<int64_t>(m_Position));
+				if (base + offset < 0)
+				{
+					return {};
+				}
+				m_Position = static_cast<uint64_t>(base + offset);
+				return m_Position;
+			}
+	};
+
+	// Same read path as 'ShellView::IStreamByteSource': absolute seek and read through the read-ahead buffer
+	class StreamByteSource final
+	{
+		private:
+			CountingStream& m_Stream;
+			Core::ReadAheadBuffer m_ReadAhead;
+
+		public:
+			StreamByteSource(CountingStream& stream) noexcept
+				:m_Stream(stream)
+			{
+			}
+
+		public:
+			const Core::ReadAheadStats& GetStats() const noexcept
+			{
+				return m_ReadAhead.GetStats();
+			}
+			size_t ReadAt(uint64_t offset, void* buffer, size_t size)
+			{
+				if (m_ReadAhead.Seek(m_Stream, static_cast<int64_t>(offset), Core::SeekOrigin::Start))
+				{
+					return m_ReadAhead.Read(m_Stream, buffer, size);
+				}
+				return 0;
+			}
+	};
+}
@@ -0,0 +1,92 @@
+#include "Commands.h"
+#include "Core/LoadOrder.h"
+#include "Core/ModuleScanner.h"
+#include <iostream>
+#include <iomanip>
+
+namespace BethesdaModule::Tool
+{
+	bool ResolveLoadOrder(const CommandLine& args, std::string_view command, Core::LoadOrderResult& result)
+	{
+		auto directory = args.GetPositional(0);
+		if (!directory)
+		{
+			std::cerr << command << ": directory is required\n";
+			return false;
+		}
+
+		Core::LoadOrderGraph graph;
+		if (auto path = args.GetOption("plugins"))
+		{
+			auto names = Core::ReadPluginList(std::filesystem::path(*path));
+			if (!names)
+			{
+				std::cerr << command << ": can't read '" << *path << "'\n";
+				return false;
+			}
+			graph.SetRequestedOrder(std::move(*names));
+		}
+
+		// Plugins are only ever loaded from the top level of the data folder
+		Core::ModuleScanner scanner(args.GetOption("threads", size_t(0)), false);
+		const Core::ScanStats stats = scanner.Scan(std::filesystem::path(*directory), [&](const Core::ScanResult& result)
+		{
+			if (result.Error.empty() && result.Status != Core::ParseStatus::UnknownFormat)
+			{
+				const std::u8string name = result.Path.filename().u8string();
+				graph.Update({reinterpret_cast<const char*>(name.data()), name.size()}, result.Info);
+			}
+		});
+		PrintThroughput("scanned", stats.Files, stats.BytesRead, std::chrono::duration<double>(stats.Elapsed).count());
+
+		const auto startTime = std::chrono::steady_clock::now();
+		result = graph.Resolve();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::cerr << std::fixed << std::setprecision(3) << "resolved " << result.Order.size() << " plugin(s) in " << seconds * 1000.0 << " ms: "
+			<< result.FullSlots << " of " << Core::LoadOrderGraph::MaxFullPlugins << " full slots, "
+			<< result.LightSlots << " of " << Core::LoadOrderGraph::MaxLightPlugins << " light slots, " << result.Issues.size() << " issue(s)\n";
+		return true;
+	}
+
+	int RunLoadOrder(const CommandLine& args)
+	{
+		Core::LoadOrderResult result;
+		if (!ResolveLoadOrder(args, "loadorder", result))
+		{
+			return 1;
+		}
+
+		// Same notation as the game console and xEdit: '0A' for full plugins and 'FE:01F' for light ones
+		std::cout << std::uppercase << std::hex << std::setfill('0');
+		for (const Core::LoadOrderEntry& entry: result.Order)
+		{
+			if (!entry.Slot)
+			{
+				std::cout << "--     ";
+			}
+			else if (entry.IsLight)
+			{
+				std::cout << "FE:" << std::setw(3) << *entry.Slot << ' ';
+			}
+			else
+			{
+				std::cout << std::setw(2) << *entry.Slot << "     ";
+			}
+			std::cout << entry.Name << '\n';
+		}
+		std::cout << std::dec;
+
+		for (const Core::LoadOrderIssue& issue: result.Issues)
+		{
+			std::cout << Core::GetLoadOrderIssueName(issue.Type) << ": " << issue.Plugin;
+			for (size_t i = 0; i < issue.Related.size(); i++)
+			{
+				std::cout << (i == 0 ? " -> " : ", ") << issue.Related[i];
+			}
+			std::cout << '\n';
+		}
+		std::cout.flush();
+		return result.Issues.empty() ? 0 : 2;
+	}
+}
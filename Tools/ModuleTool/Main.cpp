@@ -0,0 +1,65 @@
+#include "Commands.h"
+#include <iostream>
+#include <iomanip>
+
+namespace
+{
+	using namespace BethesdaModule::Tool;
+
+	constexpr Command g_Commands[] =
+	{
+		{"scan", "scan <directory> [--format ndjson|csv|arrow] [--source file|mmap] [--threads N] [--output file] [--no-recurse]", RunScan},
+		{"bench", "bench sources|formats|stream|fuzz|lru|cache|records|inflate|loadorder|formids|strings|packed|recycle|properties|text|stringtables|archives|watch|batch|table|query|snapshot [--files N] [--plugins N] [--masters N[,N...]] [--body bytes] [--iterations N] [--dir path] [--profile name] [--author N] [--description N] [--text ascii|1252|1251|utf8] [--detect] [--entries N] [--length bytes] [--file-size bytes] [--unsorted] [--quiet-ms N] [--max-delay-ms N] [--idle-ms N] [--mutants N] [--budget bytes] [--max-us N] [--lookups N] [--calls N] [--stores N] [--memory bytes] [--records N] [--record-size bytes] [--compressed-every N] [--override-every N] [--threads N]", RunBench},
+		{"cache", "cache warm|stats|compact <cache file> [directory] [--threads N] [--no-recurse]", RunCache},
+		{"loadorder", "loadorder <directory> [--plugins plugins.txt|loadorder.txt] [--threads N]", RunLoadOrder},
+		{"conflicts", "conflicts <directory> [--plugins plugins.txt|loadorder.txt] [--form Plugin.esm:012345] [--plugin name] [--threads N]", RunConflicts},
+		{"records", "records <file|directory> [--source file|mmap] [--threads N] [--no-recurse]", RunRecords},
+		{"stringtable", "stringtable <plugin|.STRINGS|.DLSTRINGS|.ILSTRINGS file> [--language english] [--id N] [--encoding 1250|1251|1252|utf8] [--archive file]", RunStringTable},
+		{"archive", "archive <.bsa|.ba2 file> [--find path] [--extract path --output file]", RunArchive},
+		{"watch", "watch <directory> [--source file|mmap] [--threads N] [--no-recurse] [--no-initial] [--quiet-ms N] [--max-delay-ms N] [--updates N]", RunWatch},
+		{"query", "query <directory> <expression> [--count] [--format ndjson|csv] [--source file|mmap] [--threads N] [--output file] [--no-recurse]", RunQuery},
+		{"snapshot", "snapshot <.arrow file> [--count] [--format ndjson|csv] [--output file]", RunSnapshot},
+	};
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage: BethesdaModuleTool <command> [arguments]\n\nCommands:\n";
+		for (const Command& command: g_Commands)
+		{
+			std::cerr << "  " << command.Usage << '\n';
+		}
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	void PrintThroughput(std::string_view what, size_t files, uint64_t bytes, double seconds)
+	{
+		std::cerr << std::fixed << std::setprecision(3);
+		std::cerr << what << ' ' << files << " file(s), " << bytes << " bytes read in " << seconds * 1000.0 << " ms";
+		if (seconds > 0)
+		{
+			std::cerr << " (" << std::setprecision(0) << files / seconds << " files/sec, " << std::setprecision(1) << bytes / seconds / (1024.0 * 1024.0) << " MiB/sec)";
+		}
+		std::cerr << '\n';
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2)
+	{
+		const std::string_view name = argv[1];
+		for (const Command& command: g_Commands)
+		{
+			if (command.Name == name)
+			{
+				return command.Run(CommandLine(argc, argv, 2));
+			}
+		}
+		std::cerr << "Unknown command '" << name << "'\n\n";
+	}
+
+	PrintUsage();
+	return 1;
+}
@@ -0,0 +1,753 @@
+#include "ModuleFixture.h"
+#include "Core/BinaryIO.h"
+#include "Core/RecordWalker.h"
+#include "Core/LZ4.h"
+#include <algorithm>
+#include <map>
+#include <fstream>
+#include <zlib.h>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	using namespace BethesdaModule::Core;
+	using namespace BethesdaModule::Tool;
+
+	uint32_t NextRandom(uint32_t& state) noexcept
+	{
+		// Deterministic pseudo-random numbers, xorshift is more than enough here
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	std::string MakeText(uint32_t& state, size_t length, FixtureText textType, std::string_view prefix = {})
+	{
+		std::string text(prefix.substr(0, length));
+		while (text.size() < length)
+		{
+			const uint32_t value = NextRandom(state);
+			switch (textType)
+			{
+				case FixtureText::Windows1252:
+				{
+					// Mix 'à'..'ÿ' with ASCII, like real French or German text
+					text += static_cast<char>(value % 3 == 0 ? 0xE0 + (value >> 8) % 32 : 'a' + (value >> 8) % 26);
+					break;
+				}
+				case FixtureText::Windows1251:
+				{
+					// 'а'..'я'
+					text += static_cast<char>(0xE0 + (value >> 8) % 32);
+					break;
+				}
+				case FixtureText::UTF8:
+				{
+					// U+0430..U+044F as two byte sequences, never split at the end
+					if (text.size() + 2 <= length)
+					{
+						const uint32_t codePoint = 0x430 + (value >> 8) % 32;
+						text += static_cast<char>(0xC0|(codePoint >> 6));
+						text += static_cast<char>(0x80|(codePoint & 0x3F));
+					}
+					else
+					{
+						text += 'a';
+					}
+					break;
+				}
+				default:
+				{
+					text += static_cast<char>('a' + value % 26);
+					break;
+				}
+			};
+		}
+		return text;
+	}
+
+	void WriteSubrecord(BinaryWriter& writer, FormatLevel formatLevel, uint32_t type, const void* data, size_t size)
+	{
+		if (formatLevel == FormatLevel::Morrowind)
+		{
+			writer.Write(type);
+			writer.Write(static_cast<uint32_t>(size));
+		}
+		else if (size > std::numeric_limits<uint16_t>::max())
+		{
+			// Real size goes into preceding 'XXXX' subrecord, the size field of the subrecord itself is zero
+			writer.Write(FourCC::XXXX);
+			writer.Write<uint16_t>(sizeof(uint32_t));
+			writer.Write(static_cast<uint32_t>(size));
+
+			writer.Write(type);
+			writer.Write<uint16_t>(0);
+		}
+		else
+		{
+			writer.Write(type);
+			writer.Write(static_cast<uint16_t>(size));
+		}
+		writer.Write(data, size);
+	}
+	void WriteZString(BinaryWriter& writer, FormatLevel formatLevel, uint32_t type, const std::string& text)
+	{
+		// Size includes the null terminator
+		WriteSubrecord(writer, formatLevel, type, text.c_str(), text.size() + 1);
+	}
+
+	void WriteRecords(BinaryWriter& writer, const FixtureOptions& options, uint32_t& state)
+	{
+		constexpr uint32_t recordTypes[] = {MakeFourCC("NPC_"), MakeFourCC("WEAP"), MakeFourCC("ARMO"), MakeFourCC("CELL")};
+		constexpr size_t cellBlockSize = 16;
+
+		const bool isMorrowind = options.FormatLevel == FormatLevel::Morrowind;
+		const bool isOblivion = options.FormatLevel == FormatLevel::Oblivion;
+		const size_t headerTail = isMorrowind ? 0 : (isOblivion ? 4 : 8);
+
+		// New forms use the plugin's own mod index (the one past its masters), overrides refer to a form of a master
+		const size_t masterCount = !options.MasterNames.empty() ? options.MasterNames.size() : options.MasterCount;
+		auto MakeFormID = [&](size_t recordIndex)
+		{
+			if (masterCount != 0 && options.OverrideEvery != 0 && recordIndex % options.OverrideEvery == 0)
+			{
+				const uint32_t master = NextRandom(state) % std::min<size_t>(masterCount, 0xFF);
+				return master << 24|static_cast<uint32_t>(0x800 + NextRandom(state) % std::max<size_t>(options.RecordCount, 1));
+			}
+			return static_cast<uint32_t>(std::min<size_t>(masterCount, 0xFF)) << 24|static_cast<uint32_t>(0x800 + recordIndex);
+		};
+
+		size_t recordIndex = 0;
+		std::vector<std::byte> payload(options.RecordSize);
+		std::vector<std::byte> compressedPayload;
+		auto WriteRecord = [&](uint32_t type)
+		{
+			// Lowercase letters only, so the payload compresses about as well as real record data does
+			for (std::byte& value: payload)
+			{
+				value = static_cast<std::byte>('a' + NextRandom(state) % 16);
+			}
+
+			std::span<const std::byte> data = payload;
+			const bool compressed = !isMorrowind && options.CompressedEvery != 0 && recordIndex % options.CompressedEvery == 0;
+			if (compressed)
+			{
+				uLongf compressedSize = ::compressBound(static_cast<uLong>(payload.size()));
+				compressedPayload.resize(sizeof(uint32_t) + compressedSize);
+				::compress2(reinterpret_cast<Bytef*>(compressedPayload.data() + sizeof(uint32_t)), &compressedSize, reinterpret_cast<const Bytef*>(payload.data()), static_cast<uLong>(payload.size()), Z_DEFAULT_COMPRESSION);
+
+				compressedPayload.resize(sizeof(uint32_t) + compressedSize);
+				BinaryWriter(compressedPayload).Patch(0, static_cast<uint32_t>(payload.size()));
+				data = compressedPayload;
+			}
+			const uint32_t flags = compressed ? CompressedRecordFlag : 0;
+
+			writer.Write(type);
+			writer.Write(static_cast<uint32_t>(data.size()));
+			if (isMorrowind)
+			{
+				writer.Write<uint32_t>(0);
+				writer.Write(flags);
+			}
+			else
+			{
+				writer.Write(flags);
+				writer.Write(MakeFormID(recordIndex));
+				writer.WriteZeros(headerTail);
+			}
+			writer.Write(data.data(), data.size());
+			recordIndex++;
+		};
+		auto BeginGroup = [&](uint32_t label, int32_t groupType)
+		{
+			const size_t offset = writer.GetOffset();
+			writer.Write(FourCC::GRUP);
+			writer.Write<uint32_t>(0);
+			writer.Write(label);
+			writer.Write(groupType);
+			writer.WriteZeros(headerTail);
+			return offset;
+		};
+		auto EndGroup = [&](size_t offset)
+		{
+			writer.Patch(offset + 4, static_cast<uint32_t>(writer.GetOffset() - offset));
+		};
+
+		// Spread records evenly between types
+		for (size_t t = 0; t < std::size(recordTypes); t++)
+		{
+			const size_t count = options.RecordCount / std::size(recordTypes) + (t < options.RecordCount % std::size(recordTypes) ? 1 : 0);
+			if (count == 0)
+			{
+				continue;
+			}
+
+			const size_t group = isMorrowind ? 0 : BeginGroup(recordTypes[t], 0);
+			if (!isMorrowind && recordTypes[t] == MakeFourCC("CELL"))
+			{
+				for (size_t i = 0; i < count; i += cellBlockSize)
+				{
+					const size_t block = BeginGroup(static_cast<uint32_t>(i / cellBlockSize), 2);
+					for (size_t j = i; j < std::min(count, i + cellBlockSize); j++)
+					{
+						WriteRecord(recordTypes[t]);
+					}
+					EndGroup(block);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					WriteRecord(recordTypes[t]);
+				}
+			}
+			if (!isMorrowind)
+			{
+				EndGroup(group);
+			}
+		}
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	const FixtureProfile* FindFixtureProfile(std::string_view name) noexcept
+	{
+		for (const FixtureProfile& profile: FixtureProfiles)
+		{
+			if (profile.Name == name)
+			{
+				return &profile;
+			}
+		}
+		return nullptr;
+	}
+	std::optional<FixtureText> ParseFixtureText(std::string_view name) noexcept
+	{
+		if (name == "ascii")
+		{
+			return FixtureText::ASCII;
+		}
+		if (name == "1252")
+		{
+			return FixtureText::Windows1252;
+		}
+		if (name == "1251")
+		{
+			return FixtureText::Windows1251;
+		}
+		if (name == "utf8")
+		{
+			return FixtureText::UTF8;
+		}
+		return {};
+	}
+
+	std::vector<std::byte> GenerateModule(const FixtureOptions& options)
+	{
+		std::vector<std::byte> buffer;
+		BinaryWriter writer(buffer);
+
+		uint32_t state = options.Seed * 2654435761u + 1;
+		const std::string generatedAuthor = MakeText(state, options.AuthorLength, options.Text);
+		const std::string& author = !options.Author.empty() ? options.Author : generatedAuthor;
+		const std::string description = MakeText(state, options.DescriptionLength, options.Text);
+
+		if (options.FormatLevel == FormatLevel::Morrowind)
+		{
+			writer.Write(FourCC::TES3);
+			writer.Write<uint32_t>(0);
+			writer.Write<uint32_t>(0);
+			writer.Write<uint32_t>(0);
+
+			// HEDR: version, file type, fixed length author and description, record count
+			char hedr[300] = {};
+			const float version = 1.3f;
+			std::memcpy(hedr, &version, sizeof(version));
+			std::memcpy(hedr + 8, author.data(), std::min<size_t>(author.size(), 31));
+			std::memcpy(hedr + 40, description.data(), std::min<size_t>(description.size(), 255));
+			WriteSubrecord(writer, options.FormatLevel, FourCC::HEDR, hedr, sizeof(hedr));
+		}
+		else
+		{
+			writer.Write(FourCC::TES4);
+			writer.Write<uint32_t>(0);
+			writer.Write(static_cast<uint32_t>(options.Flags));
+			writer.Write<uint32_t>(0);
+			writer.Write<uint32_t>(0);
+			if (options.FormatLevel == FormatLevel::Skyrim)
+			{
+				writer.Write<uint16_t>(options.FormVersion);
+				writer.Write<uint16_t>(0);
+			}
+
+			// HEDR: version, record count, next object ID
+			float version = 1.0f;
+			if (options.FormatLevel == FormatLevel::Skyrim)
+			{
+				version = options.FormVersion >= 131 ? 0.95f : 1.7f;
+			}
+			char hedr[12] = {};
+			std::memcpy(hedr, &version, sizeof(version));
+			WriteSubrecord(writer, options.FormatLevel, FourCC::HEDR, hedr, sizeof(hedr));
+
+			if (!author.empty())
+			{
+				WriteZString(writer, options.FormatLevel, FourCC::CNAM, author);
+			}
+			if (!description.empty())
+			{
+				WriteZString(writer, options.FormatLevel, FourCC::SNAM, description);
+			}
+		}
+
+		const uint64_t masterSize = 0;
+		for (const std::string& name: options.MasterNames)
+		{
+			WriteZString(writer, options.FormatLevel, FourCC::MAST, name);
+			WriteSubrecord(writer, options.FormatLevel, FourCC::DATA, &masterSize, sizeof(masterSize));
+		}
+		for (size_t i = 0; i < options.MasterCount && options.MasterNames.empty(); i++)
+		{
+			WriteZString(writer, options.FormatLevel, FourCC::MAST, MakeText(state, 8 + state % 24, options.Text, i == 0 ? "Master" : "") + ".esm");
+			WriteSubrecord(writer, options.FormatLevel, FourCC::DATA, &masterSize, sizeof(masterSize));
+		}
+
+		// Patch record data size now that we know it
+		const size_t recordHeaderSize = options.FormatLevel == FormatLevel::Morrowind ? 16 : (options.FormatLevel == FormatLevel::Oblivion ? 20 : 24);
+		writer.Patch(4, static_cast<uint32_t>(writer.GetOffset() - recordHeaderSize));
+
+		if (options.RecordCount != 0)
+		{
+			WriteRecords(writer, options, state);
+		}
+		else
+		{
+			writer.WriteZeros(options.BodySize);
+		}
+		return buffer;
+	}
+
+	std::vector<FixtureCase> GenerateHostileCorpus()
+	{
+		std::vector<FixtureCase> corpus;
+		auto Add = [&](std::string name, std::vector<std::byte> data)
+		{
+			corpus.push_back({std::move(name), std::move(data)});
+		};
+
+		for (const FixtureProfile& profile: FixtureProfiles)
+		{
+			const std::string prefix = std::string(profile.Name) + '/';
+
+			FixtureOptions options;
+			options.FormatLevel = profile.FormatLevel;
+			options.FormVersion = profile.FormVersion;
+
+			// Far more masters than any game can load
+			options.MasterCount = 20000;
+			Add(prefix + "master-flood", GenerateModule(options));
+			options.MasterCount = 2;
+
+			// Record claims to be 4 GiB while the file is tiny
+			std::vector<std::byte> data = GenerateModule(options);
+			BinaryWriter(data).Patch<uint32_t>(4, std::numeric_limits<uint32_t>::max());
+			Add(prefix + "huge-declared-size", data);
+
+			// Same, but the file really continues with junk past the read budget
+			data.resize(4 * 1024 * 1024, std::byte{0x41});
+			Add(prefix + "huge-record", std::move(data));
+
+			// Record ends in the middle of the last subrecord
+			data = GenerateModule(options);
+			BinaryWriter(data).Patch<uint32_t>(4, static_cast<uint32_t>(data.size() - (profile.FormatLevel == FormatLevel::Morrowind ? 16 : 24) - 3));
+			Add(prefix + "record-cuts-subrecord", std::move(data));
+
+			// Description way over any sane length
+			options.DescriptionLength = 200 * 1024;
+			Add(prefix + "giant-description", GenerateModule(options));
+			options.DescriptionLength = 64;
+
+			// Cut at every interesting offset of the header
+			const std::vector<std::byte> full = GenerateModule(options);
+			for (size_t size: {size_t(0), size_t(3), size_t(4), size_t(16), size_t(23), size_t(24), size_t(30), full.size() / 2, full.size() - 1})
+			{
+				Add(prefix + "truncated-" + std::to_string(size), std::vector<std::byte>(full.begin(), full.begin() + std::min(size, full.size())));
+			}
+		}
+
+		// Thousands of empty subrecords, bounded only by the subrecord count limit
+		{
+			std::vector<std::byte> data;
+			BinaryWriter writer(data);
+			writer.Write(FourCC::TES4);
+			writer.Write<uint32_t>(0);
+			writer.WriteZeros(12);
+			writer.Write<uint16_t>(44);
+			writer.Write<uint16_t>(0);
+			for (size_t i = 0; i < 100000; i++)
+			{
+				writer.Write(MakeFourCC("ZERO"));
+				writer.Write<uint16_t>(0);
+			}
+			writer.Patch<uint32_t>(4, static_cast<uint32_t>(data.size() - 24));
+			Add("skyrim/empty-subrecords", std::move(data));
+		}
+
+		// 'XXXX' pointing far past the end of the record
+		{
+			std::vector<std::byte> data;
+			BinaryWriter writer(data);
+			writer.Write(FourCC::TES4);
+			writer.Write<uint32_t>(0);
+			writer.WriteZeros(12);
+			writer.Write<uint16_t>(44);
+			writer.Write<uint16_t>(0);
+			writer.Write(FourCC::XXXX);
+			writer.Write<uint16_t>(4);
+			writer.Write(std::numeric_limits<uint32_t>::max());
+			writer.Write(FourCC::SNAM);
+			writer.Write<uint16_t>(0);
+			writer.WriteZeros(64);
+			writer.Patch<uint32_t>(4, static_cast<uint32_t>(data.size() - 24));
+			Add("skyrim/xxxx-overflow", std::move(data));
+		}
+		return corpus;
+	}
+	std::vector<std::byte> MutateModule(std::vector<std::byte> data, uint32_t seed)
+	{
+		if (data.empty())
+		{
+			return data;
+		}
+
+		uint32_t state = seed * 2654435761u + 1;
+		const size_t mutations = 1 + NextRandom(state) % 8;
+		for (size_t i = 0; i < mutations; i++)
+		{
+			const size_t offset = NextRandom(state) % data.size();
+			switch (NextRandom(state) % 4)
+			{
+				case 0:
+				{
+					// Flip a bit
+					data[offset] ^= static_cast<std::byte>(1u << NextRandom(state) % 8);
+					break;
+				}
+				case 1:
+				{
+					// Large value in what might be a size field
+					const uint32_t value = NextRandom(state) % 2 ? std::numeric_limits<uint32_t>::max() : 0xFFFF;
+					std::memcpy(data.data() + offset, &value, std::min(sizeof(value), data.size() - offset));
+					break;
+				}
+				case 2:
+				{
+					// Zero out a size
+					data[offset] = std::byte{0};
+					break;
+				}
+				default:
+				{
+					// Truncate
+					data.resize(std::max<size_t>(offset, 1));
+					break;
+				}
+			};
+		}
+		return data;
+	}
+
+	std::vector<std::byte> GenerateStringTable(const StringTableFixtureOptions& options)
+	{
+		uint32_t state = options.Seed * 2654435761u + 1;
+
+		std::vector<std::pair<uint32_t, uint32_t>> directory;
+		directory.reserve(options.Count);
+
+		std::vector<std::byte> data;
+		BinaryWriter dataWriter(data);
+		uint32_t id = 0;
+		for (size_t i = 0; i < options.Count; i++)
+		{
+			id += 1 + NextRandom(state) % 4;
+			directory.emplace_back(id, static_cast<uint32_t>(data.size()));
+
+			const size_t length = options.Length / 2 + NextRandom(state) % (options.Length + 1);
+			const std::string text = MakeText(state, length, options.Text);
+			if (options.Type != StringTableType::Strings)
+			{
+				dataWriter.Write(static_cast<uint32_t>(text.size() + 1));
+			}
+			dataWriter.Write(text.data(), text.size());
+			dataWriter.Write<uint8_t>(0);
+		}
+
+		if (!options.Sorted)
+		{
+			for (size_t i = directory.size(); i > 1; i--)
+			{
+				std::swap(directory[i - 1], directory[NextRandom(state) % i]);
+			}
+		}
+
+		// Header and directory are patched in place, the data follows them
+		std::vector<std::byte> buffer((2 + 2 * directory.size()) * sizeof(uint32_t));
+		BinaryWriter writer(buffer);
+		writer.Patch(0, static_cast<uint32_t>(directory.size()));
+		writer.Patch(sizeof(uint32_t), static_cast<uint32_t>(data.size()));
+		for (size_t i = 0; i < directory.size(); i++)
+		{
+			writer.Patch((2 + 2 * i) * sizeof(uint32_t), directory[i].first);
+			writer.Patch((3 + 2 * i) * sizeof(uint32_t), directory[i].second);
+		}
+		writer.Write(data.data(), data.size());
+		return buffer;
+	}
+
+	std::vector<std::byte> GenerateArchive(const ArchiveFixtureOptions& options, const std::vector<ArchiveFixtureFile>& files)
+	{
+		auto Compress = [&](std::span<const std::byte> data)
+		{
+			const bool lz4 = options.Format == ArchiveFormat::BSA ? options.Version == 105 : options.Version == 3;
+			if (lz4)
+			{
+				return options.Format == ArchiveFormat::BSA ? EncodeLZ4Frame(data) : EncodeLZ4Block(data);
+			}
+
+			uLongf size = ::compressBound(static_cast<uLong>(data.size()));
+			std::vector<std::byte> result(size);
+			::compress2(reinterpret_cast<Bytef*>(result.data()), &size, reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION);
+			result.resize(size);
+			return result;
+		};
+		auto SplitPath = [](const std::string& path) -> std::pair<std::string, std::string>
+		{
+			const size_t separator = path.rfind('\\');
+			return separator != std::string::npos ? std::pair(path.substr(0, separator), path.substr(separator + 1)) : std::pair(std::string(), path);
+		};
+
+		std::vector<std::byte> buffer;
+		BinaryWriter writer(buffer);
+		if (options.Format == ArchiveFormat::BA2)
+		{
+			const size_t headerSize = options.Version == 3 ? 36 : (options.Version == 2 ? 32 : 24);
+			const size_t recordsSize = files.size() * 36;
+
+			// Data right after the records, names at the end
+			std::vector<std::byte> data;
+			std::vector<std::byte> records;
+			std::vector<std::byte> names;
+			BinaryWriter recordWriter(records);
+			BinaryWriter nameWriter(names);
+			for (const ArchiveFixtureFile& file: files)
+			{
+				const std::string path = Archive::NormalizePath(file.Path);
+				const auto [directory, name] = SplitPath(path);
+				const size_t dot = name.rfind('.');
+
+				char extension[4] = {};
+				if (dot != std::string::npos)
+				{
+					std::copy_n(name.begin() + dot + 1, std::min<size_t>(name.size() - dot - 1, 4), extension);
+				}
+
+				const uint64_t offset = headerSize + recordsSize + data.size();
+				uint32_t packedSize = 0;
+				if (options.Compressed)
+				{
+					const std::vector<std::byte> compressed = Compress(file.Data);
+					packedSize = static_cast<uint32_t>(compressed.size());
+					data.insert(data.end(), compressed.begin(), compressed.end());
+				}
+				else
+				{
+					data.insert(data.end(), file.Data.begin(), file.Data.end());
+				}
+
+				recordWriter.Write(Archive::HashBA2(name.substr(0, dot)));
+				recordWriter.Write(extension, sizeof(extension));
+				recordWriter.Write(Archive::HashBA2(directory));
+				recordWriter.Write<uint32_t>(0x00100100);
+				recordWriter.Write(offset);
+				recordWriter.Write(packedSize);
+				recordWriter.Write(static_cast<uint32_t>(file.Data.size()));
+				recordWriter.Write<uint32_t>(0xBAADF00D);
+
+				nameWriter.WriteString<uint16_t>(file.Path);
+			}
+
+			writer.Write<uint32_t>(0x58445442);
+			writer.Write(options.Version);
+			writer.Write("GNRL", 4);
+			writer.Write(static_cast<uint32_t>(files.size()));
+			writer.Write(static_cast<uint64_t>(headerSize + recordsSize + data.size()));
+			writer.WriteZeros(headerSize - 24);
+			if (options.Version == 3)
+			{
+				writer.Patch(32, uint32_t(3));
+			}
+			writer.Write(records.data(), records.size());
+			writer.Write(data.data(), data.size());
+			writer.Write(names.data(), names.size());
+			return buffer;
+		}
+
+		// Folders sorted by hash and files of each folder sorted by hash, the way the engine searches them
+		struct Folder final
+		{
+			std::string Name;
+			std::vector<std::pair<uint64_t, size_t>> Files;
+		};
+		std::map<uint64_t, Folder> folders;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			const auto [directory, name] = SplitPath(Archive::NormalizePath(files[i].Path));
+			Folder& folder = folders[Archive::HashBSAFolder(directory)];
+			folder.Name = directory;
+			folder.Files.emplace_back(Archive::HashBSAFile(name), i);
+		}
+
+		size_t folderNamesSize = 0;
+		size_t fileNamesSize = 0;
+		size_t blocksSize = 0;
+		for (auto& [hash, folder]: folders)
+		{
+			std::sort(folder.Files.begin(), folder.Files.end());
+			folderNamesSize += folder.Name.size() + 1;
+			blocksSize += 1 + folder.Name.size() + 1 + folder.Files.size() * 16;
+			for (const auto& [fileHash, index]: folder.Files)
+			{
+				fileNamesSize += SplitPath(Archive::NormalizePath(files[index].Path)).second.size() + 1;
+			}
+		}
+
+		const size_t folderRecordSize = options.Version == 105 ? 24 : 16;
+		const size_t blocksOffset = 36 + folders.size() * folderRecordSize;
+		const size_t dataOffset = blocksOffset + blocksSize + fileNamesSize;
+		const bool embedNames = options.EmbedNames && options.Version != 103;
+
+		writer.Write<uint32_t>(0x00415342);
+		writer.Write(options.Version);
+		writer.Write<uint32_t>(36);
+		writer.Write<uint32_t>(0x1|0x2|(options.Compressed ? 0x4 : 0)|(embedNames ? 0x100 : 0));
+		writer.Write(static_cast<uint32_t>(folders.size()));
+		writer.Write(static_cast<uint32_t>(files.size()));
+		writer.Write(static_cast<uint32_t>(folderNamesSize));
+		writer.Write(static_cast<uint32_t>(fileNamesSize));
+		writer.Write<uint32_t>(0);
+
+		size_t blockOffset = blocksOffset;
+		for (const auto& [hash, folder]: folders)
+		{
+			writer.Write(hash);
+			writer.Write(static_cast<uint32_t>(folder.Files.size()));
+			if (options.Version == 105)
+			{
+				writer.Write<uint32_t>(0);
+				writer.Write(static_cast<uint64_t>(blockOffset + fileNamesSize));
+			}
+			else
+			{
+				writer.Write(static_cast<uint32_t>(blockOffset + fileNamesSize));
+			}
+			blockOffset += 1 + folder.Name.size() + 1 + folder.Files.size() * 16;
+		}
+
+		// Data of every file is built first, records need its offset and size
+		std::vector<std::byte> data;
+		std::vector<std::byte> names;
+		size_t fileNumber = 0;
+		for (auto& [hash, folder]: folders)
+		{
+			writer.Write(static_cast<uint8_t>(folder.Name.size() + 1));
+			writer.Write(folder.Name.data(), folder.Name.size());
+			writer.Write<uint8_t>(0);
+
+			for (const auto& [fileHash, index]: folder.Files)
+			{
+				const ArchiveFixtureFile& file = files[index];
+				const bool inverted = options.InvertEvery != 0 && ++fileNumber % options.InvertEvery == 0;
+				const bool compressed = options.Compressed != inverted;
+
+				const size_t offset = dataOffset + data.size();
+				BinaryWriter dataWriter(data);
+				if (embedNames)
+				{
+					dataWriter.WriteString<uint8_t>(file.Path);
+				}
+				if (compressed)
+				{
+					const std::vector<std::byte> compressedData = Compress(file.Data);
+					dataWriter.Write(static_cast<uint32_t>(file.Data.size()));
+					dataWriter.Write(compressedData.data(), compressedData.size());
+				}
+				else
+				{
+					dataWriter.Write(file.Data.data(), file.Data.size());
+				}
+
+				writer.Write(fileHash);
+				writer.Write(static_cast<uint32_t>(data.size() - offset + dataOffset)|(inverted ? 0x40000000u : 0));
+				writer.Write(static_cast<uint32_t>(offset));
+
+				const std::string name = SplitPath(Archive::NormalizePath(file.Path)).second;
+				names.insert(names.end(), reinterpret_cast<const std::byte*>(name.data()), reinterpret_cast<const std::byte*>(name.data() + name.size() + 1));
+			}
+		}
+		writer.Write(names.data(), names.size());
+		writer.Write(data.data(), data.size());
+		return buffer;
+	}
+	std::vector<ArchiveFixtureFile> GenerateArchiveFiles(size_t count, size_t folderCount, size_t size, uint32_t seed)
+	{
+		// Words from a small vocabulary compress about as well as real text and scripts do
+		constexpr std::string_view words[] = {"the", "dragon", "sword", "of", "and", "guard", "whiterun", "quest", "stage", "armor", "iron", "to", "a", "jarl", "is", "steel"};
+		constexpr std::string_view extensions[] = {".txt", ".nif", ".dds", ".kf", ".wav", ".xml", ".pex"};
+
+		uint32_t state = seed * 2654435761u + 1;
+		std::vector<ArchiveFixtureFile> files(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			ArchiveFixtureFile& file = files[i];
+			file.Path = "Data" + std::to_string(i % std::max<size_t>(folderCount, 1)) + "/Sub/File" + std::to_string(i);
+			file.Path += extensions[i % std::size(extensions)];
+
+			const size_t length = size / 2 + NextRandom(state) % (size + 1);
+			std::string text;
+			while (text.size() < length)
+			{
+				text += words[NextRandom(state) % std::size(words)];
+				text += ' ';
+			}
+			text.resize(length);
+			file.Data.assign(reinterpret_cast<const std::byte*>(text.data()), reinterpret_cast<const std::byte*>(text.data() + text.size()));
+		}
+		return files;
+	}
+
+	std::vector<std::filesystem::path> GenerateModuleCorpus(const std::filesystem::path& directory, size_t count, FixtureOptions options)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+
+		std::vector<std::filesystem::path> files;
+		files.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			options.Seed = static_cast<uint32_t>(i);
+			const std::vector<std::byte> data = GenerateModule(options);
+
+			std::filesystem::path path = directory / ("Fixture" + std::to_string(i) + ".esp");
+			std::ofstream stream(path, std::ios::binary|std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (stream)
+			{
+				files.emplace_back(std::move(path));
+			}
+		}
+		return files;
+	}
+}
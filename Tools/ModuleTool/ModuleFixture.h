@@ -0,0 +1,136 @@
+#pragma once
+#include "Core/ModuleHeader.h"
+#include "Core/Archive.h"
+#include "Core/StringTable.h"
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Synthetic files for the benchmarks and their checks. Part of the tool only, nothing in the core depends on it.
+namespace BethesdaModule::Tool
+{
+	// Character set of generated author, description and master names
+	enum class FixtureText
+	{
+		// Plain ASCII letters
+		ASCII,
+
+		// Western European letters from the upper half of Windows-1252
+		Windows1252,
+
+		// Cyrillic letters from the upper half of Windows-1251, what Russian translations store
+		Windows1251,
+
+		// Multibyte UTF-8, as written by some newer tools
+		UTF8,
+	};
+
+	// Parameters of a synthetic module file used for benchmarking
+	struct FixtureOptions final
+	{
+		Core::FormatLevel FormatLevel = Core::FormatLevel::Skyrim;
+		Core::HeaderFlags Flags = Core::HeaderFlags::None;
+		uint16_t FormVersion = 44;
+
+		// Up to 254 for TES4 games. Text lengths are in bytes, descriptions longer than 64 KiB use 'XXXX' subrecord.
+		// 'MasterNames' and 'Author' replace generated text when they aren't empty.
+		size_t MasterCount = 2;
+		std::vector<std::string> MasterNames;
+		size_t AuthorLength = 16;
+		std::string Author;
+		size_t DescriptionLength = 64;
+		FixtureText Text = FixtureText::ASCII;
+
+		// Bytes of filler after the header record to make files look less like bare headers. Only used without records.
+		size_t BodySize = 0;
+
+		// Records after the header: TES4 files get a top level group per record type and 'CELL' records are
+		// additionally split into nested blocks. Every 'CompressedEvery'-th record is zlib-compressed
+		// the way games store them, 'RecordSize' is the uncompressed size then. Morrowind records are never compressed.
+		size_t RecordCount = 0;
+		size_t RecordSize = 64;
+		size_t CompressedEvery = 0;
+
+		// Every 'OverrideEvery'-th record overrides a form of a random master instead of defining a new one
+		size_t OverrideEvery = 0;
+
+		// Seeds generated text, so the same options always produce the same file
+		uint32_t Seed = 0;
+	};
+
+	// Header layouts of the supported games
+	struct FixtureProfile final
+	{
+		std::string_view Name;
+		Core::FormatLevel FormatLevel = Core::FormatLevel::Unknown;
+		uint16_t FormVersion = 0;
+	};
+	inline constexpr FixtureProfile FixtureProfiles[] =
+	{
+		{"morrowind", Core::FormatLevel::Morrowind, 0},
+		{"oblivion", Core::FormatLevel::Oblivion, 0},
+		{"skyrim40", Core::FormatLevel::Skyrim, 40},
+		{"skyrim43", Core::FormatLevel::Skyrim, 43},
+		{"skyrimse44", Core::FormatLevel::Skyrim, 44},
+		{"fallout4", Core::FormatLevel::Skyrim, 131},
+	};
+	const FixtureProfile* FindFixtureProfile(std::string_view name) noexcept;
+	std::optional<FixtureText> ParseFixtureText(std::string_view name) noexcept;
+
+	std::vector<std::byte> GenerateModule(const FixtureOptions& options);
+
+	// Broken and hostile headers: huge declared sizes, master floods, oversized and overlapping subrecords, truncation.
+	// Every one of them must be rejected or parsed partially in bounded time.
+	struct FixtureCase final
+	{
+		std::string Name;
+		std::vector<std::byte> Data;
+	};
+	std::vector<FixtureCase> GenerateHostileCorpus();
+
+	// Randomly corrupts bytes and sizes of a valid module, the same seed gives the same result
+	std::vector<std::byte> MutateModule(std::vector<std::byte> data, uint32_t seed);
+
+	// Parameters of a synthetic localized string table
+	struct StringTableFixtureOptions final
+	{
+		Core::StringTableType Type = Core::StringTableType::Strings;
+		size_t Count = 1000;
+
+		// Average text length in bytes, actual lengths vary between half and one and a half of it
+		size_t Length = 32;
+		FixtureText Text = FixtureText::ASCII;
+
+		// IDs grow with random gaps. The directory is shuffled unless it's sorted, like some tools write it.
+		bool Sorted = true;
+		uint32_t Seed = 0;
+	};
+	std::vector<std::byte> GenerateStringTable(const StringTableFixtureOptions& options);
+
+	// Parameters of a synthetic '.bsa' or general '.ba2' archive. Version 105 archives are compressed with LZ4
+	// frames, '.ba2' version 3 with LZ4 blocks and everything else with zlib.
+	struct ArchiveFixtureOptions final
+	{
+		Core::ArchiveFormat Format = Core::ArchiveFormat::BSA;
+		uint32_t Version = 105;
+
+		// Compression of the whole archive, every 'InvertEvery'-th file of a '.bsa' is stored the other way
+		bool Compressed = true;
+		size_t InvertEvery = 0;
+
+		// Full path written in front of each file's data, '.bsa' versions 104 and 105 only
+		bool EmbedNames = false;
+	};
+	struct ArchiveFixtureFile final
+	{
+		std::string Path;
+		std::vector<std::byte> Data;
+	};
+	std::vector<std::byte> GenerateArchive(const ArchiveFixtureOptions& options, const std::vector<ArchiveFixtureFile>& files);
+
+	// 'count' files of around 'size' bytes of compressible text spread over 'folderCount' folders
+	std::vector<ArchiveFixtureFile> GenerateArchiveFiles(size_t count, size_t folderCount, size_t size, uint32_t seed = 0);
+
+	// Writes 'count' modules named 'Fixture<N>.esp' into the directory varying the seed, returns their paths
+	std::vector<std::filesystem::path> GenerateModuleCorpus(const std::filesystem::path& directory, size_t count, FixtureOptions options);
+}
@@ -0,0 +1,85 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/ModuleQuery.h"
+#include <iostream>
+#include <fstream>
+
+namespace BethesdaModule::Tool
+{
+	int RunQuery(const CommandLine& args)
+	{
+		auto directory = args.GetPositional(0);
+		auto expression = args.GetPositional(1);
+		if (!directory || !expression)
+		{
+			std::cerr << "query: directory and expression are required\n";
+			return 1;
+		}
+
+		std::string error;
+		const auto query = Core::ModuleQuery::Parse(*expression, &error);
+		if (!query)
+		{
+			std::cerr << "query: " << error << '\n';
+			return 1;
+		}
+
+		std::ofstream file;
+		if (auto path = args.GetOption("output"))
+		{
+			file.open(std::string(*path), std::ios::binary);
+			if (!file)
+			{
+				std::cerr << "query: can't open '" << *path << "' for writing\n";
+				return 1;
+			}
+		}
+		std::ostream& stream = file.is_open() ? file : std::cout;
+
+		auto writer = ResultWriter::Create(args.GetOption("format", "ndjson"), stream);
+		if (!writer)
+		{
+			std::cerr << "query: unknown output format, use 'ndjson' or 'csv'\n";
+			return 1;
+		}
+
+		Core::ModuleScanner scanner(args.GetOption("threads", size_t(0)), !args.HasOption("no-recurse"));
+		if (args.GetOption("source", "file") == "mmap")
+		{
+			scanner.SetSourceType(Core::ByteSourceType::Mapped);
+		}
+
+		// Parsed in a batch so that rows are in the order of the files
+		Core::ScanStats stats;
+		const std::vector<std::filesystem::path> files = Core::FindModuleFiles(std::filesystem::path(*directory), !args.HasOption("no-recurse"));
+		const std::vector<Core::ScanResult> results = scanner.ScanBatch(files, &stats);
+		PrintThroughput("scanned", stats.Files, stats.BytesRead, std::chrono::duration<double>(stats.Elapsed).count());
+
+		auto startTime = std::chrono::steady_clock::now();
+		const Core::ModuleTable table = Core::ModuleTable::Build(results);
+		const Core::ModuleIndex index = Core::ModuleIndex::Build(table);
+		const double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		startTime = std::chrono::steady_clock::now();
+		const Core::RoaringBitmap rows = query->Evaluate(index);
+		const double queryTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+
+		if (args.HasOption("count"))
+		{
+			stream << rows.GetCardinality() << '\n';
+		}
+		else
+		{
+			writer->WriteHeader();
+			rows.ForEach([&](uint32_t row)
+			{
+				writer->Write(results[row]);
+			});
+		}
+		stream.flush();
+
+		std::cerr << rows.GetCardinality() << " of " << table.GetCount() << " module(s) match; index built in " << buildTime << " ms (" << index.GetMemoryUsage()
+			<< " bytes), query took " << queryTime << " us\n";
+		return 0;
+	}
+}
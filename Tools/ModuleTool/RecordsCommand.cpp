@@ -0,0 +1,161 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/ModuleScanner.h"
+#include "Core/RecordWalker.h"
+#include "Core/Parallel.h"
+#include <iostream>
+#include <charconv>
+#include <mutex>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	struct WalkResult final
+	{
+		Core::ModuleInfo Info;
+		Core::RecordStats Stats;
+		std::string Error;
+	};
+
+	template<Core::ByteSource TSource>
+	WalkResult WalkFile(TSource& source, std::vector<std::byte>& buffer)
+	{
+		WalkResult result;
+		if (!source.IsOpen())
+		{
+			result.Error = "can't open file";
+			return result;
+		}
+
+		const std::span<const std::byte> data = Core::ReadModuleHeaderData(source, buffer);
+		Core::ModuleHeader header;
+		if (Core::ParseModuleHeader(data, header) == Core::ParseStatus::UnknownFormat)
+		{
+			result.Error = "unknown format";
+			return result;
+		}
+
+		result.Info = Core::ModuleInfo::FromHeader(data, header);
+		result.Stats = Core::WalkRecords(source, header);
+		return result;
+	}
+
+	void AppendNumber(std::string& buffer, uint64_t value)
+	{
+		char temp[32] = {};
+		auto end = std::to_chars(std::begin(temp), std::end(temp), value).ptr;
+		buffer.append(temp, end);
+	}
+	void AppendResult(std::string& buffer, const std::filesystem::path& path, const WalkResult& result)
+	{
+		const std::u8string pathUTF8 = path.u8string();
+
+		buffer += "{\"path\":";
+		Tool::AppendJSONString(buffer, {reinterpret_cast<const char*>(pathUTF8.data()), pathUTF8.size()});
+		buffer += ",\"status\":";
+		Tool::AppendJSONString(buffer, !result.Error.empty() ? std::string_view("error") : Core::GetParseStatusName(result.Stats.Status));
+		if (!result.Error.empty())
+		{
+			buffer += ",\"error\":";
+			Tool::AppendJSONString(buffer, result.Error);
+		}
+		else
+		{
+			buffer += ",\"records\":";
+			AppendNumber(buffer, result.Stats.Records);
+			buffer += ",\"groups\":";
+			AppendNumber(buffer, result.Stats.Groups);
+			buffer += ",\"compressed\":";
+			AppendNumber(buffer, result.Stats.CompressedRecords);
+			buffer += ",\"uncompressed\":";
+			AppendNumber(buffer, result.Stats.GetUncompressedRecords());
+			buffer += ",\"types\":{";
+			for (const Core::RecordTypeCount& item: result.Stats.RecordTypes)
+			{
+				if (buffer.back() != '{')
+				{
+					buffer += ',';
+				}
+				Tool::AppendJSONString(buffer, {reinterpret_cast<const char*>(&item.Type), sizeof(item.Type)});
+				buffer += ':';
+				AppendNumber(buffer, item.Count);
+			}
+			buffer += '}';
+		}
+		buffer += "}\n";
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunRecords(const CommandLine& args)
+	{
+		auto target = args.GetPositional(0);
+		if (!target)
+		{
+			std::cerr << "records: file or directory is required\n";
+			return 1;
+		}
+
+		std::vector<std::filesystem::path> files;
+		const std::filesystem::path targetPath(*target);
+		if (std::filesystem::is_directory(targetPath))
+		{
+			files = Core::FindModuleFiles(targetPath, !args.HasOption("no-recurse"));
+		}
+		else
+		{
+			files.push_back(targetPath);
+		}
+		const bool useMapping = args.GetOption("source", "file") == "mmap";
+
+		std::mutex outputMutex;
+		std::atomic<uint64_t> totalBytes = 0;
+		std::atomic<size_t> failed = 0;
+
+		const auto startTime = std::chrono::steady_clock::now();
+		Core::ParallelFor(files.size(), args.GetOption("threads", Core::GetDefaultThreadCount()), [&](size_t index)
+		{
+			thread_local std::vector<std::byte> buffer;
+
+			WalkResult result;
+			if (useMapping)
+			{
+				Core::MappedByteSource source(files[index]);
+				result = WalkFile(source, buffer);
+			}
+			else
+			{
+				Core::FileByteSource source(files[index]);
+				result = WalkFile(source, buffer);
+			}
+
+			if (!result.Error.empty())
+			{
+				failed++;
+			}
+			totalBytes += result.Stats.BytesWalked;
+
+			std::string line;
+			AppendResult(line, files[index], result);
+
+			std::lock_guard lock(outputMutex);
+			std::cout << line;
+		});
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		std::cout.flush();
+
+		// Walking touches only record headers, so the figure is bytes of file structure covered per second
+		PrintThroughput("walked", files.size(), totalBytes, seconds);
+		if (seconds > 0)
+		{
+			std::cerr << "structure throughput: " << totalBytes / seconds / 1e9 << " GB/sec\n";
+		}
+		if (failed != 0)
+		{
+			std::cerr << failed << " file(s) couldn't be parsed\n";
+		}
+		return 0;
+	}
+}
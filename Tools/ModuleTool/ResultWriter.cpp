@@ -0,0 +1,229 @@
+#include "ResultWriter.h"
+#include "Core/TextDecoder.h"
+#include <charconv>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	std::string_view GetStatusName(const Core::ScanResult& result) noexcept
+	{
+		if (!result.Error.empty())
+		{
+			return "error";
+		}
+		return Core::GetParseStatusName(result.Status);
+	}
+
+	std::string ToUTF8(const std::filesystem::path& path)
+	{
+		const std::u8string value = path.u8string();
+		return {reinterpret_cast<const char*>(value.data()), value.size()};
+	}
+
+	template<class T>
+	void AppendNumber(std::string& buffer, T value)
+	{
+		char temp[32] = {};
+		auto end = std::to_chars(std::begin(temp), std::end(temp), value).ptr;
+		buffer.append(temp, end);
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	std::unique_ptr<ResultWriter> ResultWriter::Create(std::string_view format, std::ostream& stream)
+	{
+		if (format == "ndjson" || format == "json")
+		{
+			return std::make_unique<NDJSONWriter>(stream);
+		}
+		else if (format == "csv")
+		{
+			return std::make_unique<CSVWriter>(stream);
+		}
+		return nullptr;
+	}
+
+	void NDJSONWriter::Write(const Core::ScanResult& result)
+	{
+		const Core::ModuleInfo& info = result.Info;
+
+		m_Buffer.clear();
+		m_Buffer += "{\"path\":";
+		AppendJSONString(m_Buffer, ToUTF8(result.Path));
+		m_Buffer += ",\"size\":";
+		AppendNumber(m_Buffer, result.FileSize);
+		m_Buffer += ",\"status\":";
+		AppendJSONString(m_Buffer, GetStatusName(result));
+		if (!result.Error.empty())
+		{
+			m_Buffer += ",\"error\":";
+			AppendJSONString(m_Buffer, result.Error);
+		}
+		else
+		{
+			m_Buffer += ",\"signature\":";
+			AppendJSONString(m_Buffer, Core::GetSignatureName(info.Signature));
+			m_Buffer += ",\"format\":";
+			AppendJSONString(m_Buffer, Core::GetFormatLevelName(info.FormatLevel));
+			m_Buffer += ",\"flags\":";
+			AppendNumber(m_Buffer, static_cast<uint32_t>(info.Flags));
+			m_Buffer += ",\"flagNames\":[";
+			bool first = true;
+			Core::ForEachHeaderFlagName(info.Flags, [&](std::string_view name)
+			{
+				if (!first)
+				{
+					m_Buffer += ',';
+				}
+				first = false;
+				AppendJSONString(m_Buffer, name);
+			});
+			m_Buffer += "],\"formVersion\":";
+			AppendNumber(m_Buffer, info.FormVersion);
+			m_Buffer += ",\"author\":";
+			AppendJSONString(m_Buffer, Core::DecodeToUTF8(info.Author));
+			m_Buffer += ",\"description\":";
+			AppendJSONString(m_Buffer, Core::DecodeToUTF8(info.Description));
+			m_Buffer += ",\"masters\":[";
+			for (size_t i = 0; i < info.Masters.size(); i++)
+			{
+				if (i != 0)
+				{
+					m_Buffer += ',';
+				}
+				AppendJSONString(m_Buffer, Core::DecodeToUTF8(info.Masters[i]));
+			}
+			m_Buffer += ']';
+		}
+		m_Buffer += "}\n";
+
+		m_Stream.write(m_Buffer.data(), m_Buffer.size());
+	}
+
+	void CSVWriter::WriteHeader()
+	{
+		m_Stream << "path,size,status,signature,format,flags,form_version,author,description,masters\n";
+	}
+	void CSVWriter::Write(const Core::ScanResult& result)
+	{
+		const Core::ModuleInfo& info = result.Info;
+
+		m_Buffer.clear();
+		AppendCSVField(m_Buffer, ToUTF8(result.Path));
+		m_Buffer += ',';
+		AppendNumber(m_Buffer, result.FileSize);
+		m_Buffer += ',';
+		AppendCSVField(m_Buffer, GetStatusName(result));
+		m_Buffer += ',';
+		AppendCSVField(m_Buffer, Core::GetSignatureName(info.Signature));
+		m_Buffer += ',';
+		AppendCSVField(m_Buffer, Core::GetFormatLevelName(info.FormatLevel));
+		m_Buffer += ',';
+
+		std::string flags;
+		Core::ForEachHeaderFlagName(info.Flags, [&](std::string_view name)
+		{
+			if (!flags.empty())
+			{
+				flags += '|';
+			}
+			flags += name;
+		});
+		AppendCSVField(m_Buffer, flags);
+		m_Buffer += ',';
+		AppendNumber(m_Buffer, info.FormVersion);
+		m_Buffer += ',';
+		AppendCSVField(m_Buffer, Core::DecodeToUTF8(info.Author));
+		m_Buffer += ',';
+		AppendCSVField(m_Buffer, Core::DecodeToUTF8(info.Description));
+		m_Buffer += ',';
+
+		std::string masters;
+		for (const std::string& master: info.Masters)
+		{
+			if (!masters.empty())
+			{
+				masters += ';';
+			}
+			masters += Core::DecodeToUTF8(master);
+		}
+		AppendCSVField(m_Buffer, masters);
+		m_Buffer += '\n';
+
+		m_Stream.write(m_Buffer.data(), m_Buffer.size());
+	}
+
+	void AppendJSONString(std::string& buffer, std::string_view utf8)
+	{
+		constexpr char hex[] = "0123456789abcdef";
+
+		buffer += '"';
+		for (char c: utf8)
+		{
+			switch (c)
+			{
+				case '"':
+				{
+					buffer += "\\\"";
+					break;
+				}
+				case '\\':
+				{
+					buffer += "\\\\";
+					break;
+				}
+				case '\n':
+				{
+					buffer += "\\n";
+					break;
+				}
+				case '\r':
+				{
+					buffer += "\\r";
+					break;
+				}
+				case '\t':
+				{
+					buffer += "\\t";
+					break;
+				}
+				default:
+				{
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						buffer += "\\u00";
+						buffer += hex[(c >> 4) & 0xF];
+						buffer += hex[c & 0xF];
+					}
+					else
+					{
+						buffer += c;
+					}
+					break;
+				}
+			};
+		}
+		buffer += '"';
+	}
+	void AppendCSVField(std::string& buffer, std::string_view utf8)
+	{
+		if (utf8.find_first_of(",\"\r\n") == utf8.npos)
+		{
+			buffer += utf8;
+			return;
+		}
+
+		buffer += '"';
+		for (char c: utf8)
+		{
+			if (c == '"')
+			{
+				buffer += '"';
+			}
+			buffer += c;
+		}
+		buffer += '"';
+	}
+}
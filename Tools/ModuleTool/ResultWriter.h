@@ -0,0 +1,54 @@
+#pragma once
+#include "Core/ModuleScanner.h"
+#include <ostream>
+#include <memory>
+
+namespace BethesdaModule::Tool
+{
+	class ResultWriter
+	{
+		public:
+			static std::unique_ptr<ResultWriter> Create(std::string_view format, std::ostream& stream);
+
+		protected:
+			std::ostream& m_Stream;
+			std::string m_Buffer;
+
+		public:
+			ResultWriter(std::ostream& stream) noexcept
+				:m_Stream(stream)
+			{
+			}
+			virtual ~ResultWriter() = default;
+
+		public:
+			virtual void WriteHeader()
+			{
+			}
+			virtual void Write(const Core::ScanResult& result) = 0;
+	};
+
+	// One JSON object per line
+	class NDJSONWriter final: public ResultWriter
+	{
+		public:
+			using ResultWriter::ResultWriter;
+
+		public:
+			void Write(const Core::ScanResult& result) override;
+	};
+
+	// RFC 4180 CSV with a header row, masters are joined with ';'
+	class CSVWriter final: public ResultWriter
+	{
+		public:
+			using ResultWriter::ResultWriter;
+
+		public:
+			void WriteHeader() override;
+			void Write(const Core::ScanResult& result) override;
+	};
+
+	void AppendJSONString(std::string& buffer, std::string_view utf8);
+	void AppendCSVField(std::string& buffer, std::string_view utf8);
+}
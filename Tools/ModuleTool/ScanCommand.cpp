@@ -0,0 +1,101 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/ModuleScanner.h"
+#include "Core/ModuleSnapshot.h"
+#include <iostream>
+#include <fstream>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	int WriteSnapshot(const Tool::CommandLine& args, std::string_view directory)
+	{
+		auto output = args.GetOption("output");
+		if (!output)
+		{
+			std::cerr << "scan: Arrow output needs '--output'\n";
+			return 1;
+		}
+
+		Core::ModuleScanner scanner(args.GetOption("threads", size_t(0)), !args.HasOption("no-recurse"));
+		if (args.GetOption("source", "file") == "mmap")
+		{
+			scanner.SetSourceType(Core::ByteSourceType::Mapped);
+		}
+
+		Core::ScanStats stats;
+		const std::vector<std::filesystem::path> files = Core::FindModuleFiles(std::filesystem::path(directory), !args.HasOption("no-recurse"));
+		const std::vector<Core::ScanResult> results = scanner.ScanBatch(files, &stats);
+		Tool::PrintThroughput("scanned", stats.Files, stats.BytesRead, std::chrono::duration<double>(stats.Elapsed).count());
+
+		if (!Core::ModuleSnapshot::Write(std::filesystem::path(*output), results))
+		{
+			std::cerr << "scan: can't write '" << *output << "'\n";
+			return 1;
+		}
+		if (stats.Failed != 0)
+		{
+			std::cerr << stats.Failed << " file(s) couldn't be parsed\n";
+		}
+		return 0;
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunScan(const CommandLine& args)
+	{
+		auto directory = args.GetPositional(0);
+		if (!directory)
+		{
+			std::cerr << "scan: directory is required\n";
+			return 1;
+		}
+
+		// Arrow snapshots are columnar, so they're written once everything has been parsed
+		if (args.GetOption("format", "ndjson") == "arrow")
+		{
+			return WriteSnapshot(args, *directory);
+		}
+
+		std::ofstream file;
+		if (auto path = args.GetOption("output"))
+		{
+			file.open(std::string(*path), std::ios::binary);
+			if (!file)
+			{
+				std::cerr << "scan: can't open '" << *path << "' for writing\n";
+				return 1;
+			}
+		}
+		std::ostream& stream = file.is_open() ? file : std::cout;
+
+		auto writer = ResultWriter::Create(args.GetOption("format", "ndjson"), stream);
+		if (!writer)
+		{
+			std::cerr << "scan: unknown output format, use 'ndjson', 'csv' or 'arrow'\n";
+			return 1;
+		}
+		writer->WriteHeader();
+
+		Core::ModuleScanner scanner(args.GetOption("threads", size_t(0)), !args.HasOption("no-recurse"));
+		if (args.GetOption("source", "file") == "mmap")
+		{
+			scanner.SetSourceType(Core::ByteSourceType::Mapped);
+		}
+
+		const Core::ScanStats stats = scanner.Scan(std::filesystem::path(*directory), [&](const Core::ScanResult& result)
+		{
+			writer->Write(result);
+		});
+		stream.flush();
+
+		PrintThroughput("scanned", stats.Files, stats.BytesRead, std::chrono::duration<double>(stats.Elapsed).count());
+		if (stats.Failed != 0)
+		{
+			std::cerr << stats.Failed << " file(s) couldn't be parsed\n";
+		}
+		return 0;
+	}
+}
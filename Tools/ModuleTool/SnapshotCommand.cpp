@@ -0,0 +1,59 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/ModuleSnapshot.h"
+#include <iostream>
+#include <fstream>
+
+namespace BethesdaModule::Tool
+{
+	int RunSnapshot(const CommandLine& args)
+	{
+		auto path = args.GetPositional(0);
+		if (!path)
+		{
+			std::cerr << "snapshot: file is required\n";
+			return 1;
+		}
+
+		const auto startTime = std::chrono::steady_clock::now();
+		Core::ModuleSnapshot snapshot;
+		if (!snapshot.Open(std::filesystem::path(*path)))
+		{
+			std::cerr << "snapshot: '" << *path << "' isn't a module snapshot\n";
+			return 1;
+		}
+		const double openTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::ofstream file;
+		if (auto output = args.GetOption("output"))
+		{
+			file.open(std::string(*output), std::ios::binary);
+			if (!file)
+			{
+				std::cerr << "snapshot: can't open '" << *output << "' for writing\n";
+				return 1;
+			}
+		}
+		std::ostream& stream = file.is_open() ? file : std::cout;
+
+		if (!args.HasOption("count"))
+		{
+			auto writer = ResultWriter::Create(args.GetOption("format", "ndjson"), stream);
+			if (!writer)
+			{
+				std::cerr << "snapshot: unknown output format, use 'ndjson' or 'csv'\n";
+				return 1;
+			}
+
+			writer->WriteHeader();
+			for (size_t i = 0; i < snapshot.GetCount(); i++)
+			{
+				writer->Write(snapshot.GetResult(i));
+			}
+			stream.flush();
+		}
+
+		std::cerr << snapshot.GetCount() << " module(s), " << snapshot.GetMappedSize() << " bytes mapped, opened in " << openTime << " ms\n";
+		return 0;
+	}
+}
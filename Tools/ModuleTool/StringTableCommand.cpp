@@ -0,0 +1,165 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/StringTable.h"
+#include "Core/TextDecoder.h"
+#include <iostream>
+#include <charconv>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	// Decimal or '0x' prefixed hexadecimal
+	std::optional<uint32_t> ParseID(std::string_view value)
+	{
+		int base = 10;
+		if (value.size() > 2 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X'))
+		{
+			value.remove_prefix(2);
+			base = 16;
+		}
+
+		uint32_t id = 0;
+		auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), id, base);
+		if (error != std::errc() || end != value.data() + value.size())
+		{
+			return {};
+		}
+		return id;
+	}
+
+	void AppendEntry(std::string& buffer, uint32_t id, std::string_view text, const Core::TextDecodeOptions& options)
+	{
+		buffer += "{\"id\":" + std::to_string(id);
+		buffer += ",\"text\":";
+		Tool::AppendJSONString(buffer, Core::DecodeToUTF8(text, options));
+		buffer += "}\n";
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunStringTable(const CommandLine& args)
+	{
+		auto pathValue = args.GetPositional(0);
+		if (!pathValue)
+		{
+			std::cerr << "stringtable: a plugin or a string table is required\n";
+			return 1;
+		}
+
+		std::optional<uint32_t> id;
+		if (auto value = args.GetOption("id"))
+		{
+			id = ParseID(*value);
+			if (!id)
+			{
+				std::cerr << "stringtable: '" << *value << "' isn't a string ID\n";
+				return 1;
+			}
+		}
+
+		// Tables are in the encoding of their language, English ones are Windows-1252
+		Core::TextDecodeOptions options;
+		options.DetectUTF8 = true;
+		if (auto value = args.GetOption("encoding"))
+		{
+			auto encoding = Core::ParseTextEncoding(*value);
+			if (!encoding)
+			{
+				std::cerr << "stringtable: unknown encoding '" << *value << "'\n";
+				return 1;
+			}
+			options.Encoding = *encoding;
+		}
+
+		std::string buffer;
+		const std::filesystem::path path(*pathValue);
+		if (Core::GetStringTableType(path))
+		{
+			// A single table: every entry or just the requested one
+			Core::StringTable table;
+			if (!table.Open(path))
+			{
+				std::cerr << "stringtable: can't open '" << *pathValue << "' or it's not a string table\n";
+				return 1;
+			}
+
+			if (id)
+			{
+				auto text = table.Find(*id);
+				if (!text)
+				{
+					std::cerr << "stringtable: no string " << *id << '\n';
+					return 2;
+				}
+				AppendEntry(buffer, *id, *text, options);
+			}
+			else
+			{
+				table.ForEach([&](uint32_t entryID, std::string_view text)
+				{
+					AppendEntry(buffer, entryID, text, options);
+				});
+			}
+		}
+		else
+		{
+			// Tables of a plugin: a summary of each of them or the string the ID resolves to
+			const std::string_view language = args.GetOption("language", "english");
+
+			Core::StringTableCache cache;
+			if (auto archivePath = args.GetOption("archive"))
+			{
+				auto archive = std::make_shared<Core::Archive>();
+				if (archive->Open(std::filesystem::path(*archivePath)) != Core::ParseStatus::Success)
+				{
+					std::cerr << "stringtable: can't open archive '" << *archivePath << "'\n";
+					return 1;
+				}
+				cache.AddArchive(std::move(archive));
+			}
+			for (Core::StringTableType type: Core::StringTableTypes)
+			{
+				auto table = cache.Get(path, language, type);
+				if (id)
+				{
+					if (auto text = table ? table->Find(*id) : std::nullopt)
+					{
+						AppendEntry(buffer, *id, *text, options);
+						break;
+					}
+					continue;
+				}
+
+				const std::u8string tablePath = Core::StringTableCache::GetTablePath(path, language, type).u8string();
+				buffer += "{\"table\":";
+				AppendJSONString(buffer, Core::GetStringTableExtension(type));
+				buffer += ",\"path\":";
+				AppendJSONString(buffer, {reinterpret_cast<const char*>(tablePath.data()), tablePath.size()});
+				if (table)
+				{
+					const Core::StringTableStats stats = table->GetStats();
+					buffer += ",\"strings\":" + std::to_string(stats.Count);
+					buffer += ",\"size\":" + std::to_string(stats.MappedSize + stats.ExtractedSize);
+					buffer += stats.ExtractedSize != 0 ? ",\"source\":\"archive\"" : ",\"source\":\"file\"";
+					buffer += stats.Sorted ? ",\"sorted\":true" : ",\"sorted\":false";
+				}
+				else
+				{
+					buffer += ",\"status\":\"missing\"";
+				}
+				buffer += "}\n";
+			}
+
+			if (id && buffer.empty())
+			{
+				std::cerr << "stringtable: no string " << *id << " in the " << language << " tables of '" << *pathValue << "'\n";
+				return 2;
+			}
+		}
+		std::cout << buffer;
+		std::cout.flush();
+		return 0;
+	}
+}
@@ -0,0 +1,120 @@
+#include "Commands.h"
+#include "ResultWriter.h"
+#include "Core/ModuleWatcher.h"
+#include <iostream>
+#include <sstream>
+#include <csignal>
+
+namespace
+{
+	using namespace BethesdaModule;
+
+	Core::ModuleWatcher* g_Watcher = nullptr;
+
+	void OnInterrupt(int)
+	{
+		// Only writes to an eventfd, which is safe in a signal handler
+		if (g_Watcher)
+		{
+			g_Watcher->Stop();
+		}
+	}
+
+	std::string ToUTF8(const std::filesystem::path& path)
+	{
+		const std::u8string value = path.u8string();
+		return {reinterpret_cast<const char*>(value.data()), value.size()};
+	}
+}
+
+namespace BethesdaModule::Tool
+{
+	int RunWatch(const CommandLine& args)
+	{
+		auto directory = args.GetPositional(0);
+		if (!directory)
+		{
+			std::cerr << "watch: directory is required\n";
+			return 1;
+		}
+		if (!Core::ModuleWatcher::IsSupported())
+		{
+			std::cerr << "watch: not supported on this platform\n";
+			return 1;
+		}
+
+		Core::ModuleWatcherOptions options;
+		options.Recursive = !args.HasOption("no-recurse");
+		options.ThreadCount = args.GetOption("threads", size_t(0));
+		options.QuietPeriod = std::chrono::milliseconds(args.GetOption("quiet-ms", size_t(20)));
+		options.MaxDelay = std::chrono::milliseconds(args.GetOption("max-delay-ms", size_t(250)));
+		if (args.GetOption("source", "file") == "mmap")
+		{
+			options.SourceType = Core::ByteSourceType::Mapped;
+		}
+
+		const auto startTime = std::chrono::steady_clock::now();
+		Core::ModuleWatcher watcher;
+		if (!watcher.Open(std::filesystem::path(*directory), options))
+		{
+			std::cerr << "watch: can't watch '" << *directory << "'\n";
+			return 1;
+		}
+		const Core::ModuleWatcherStats initialStats = watcher.GetStats();
+		PrintThroughput("indexed", initialStats.Modules, initialStats.BytesRead, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
+		// The initial index is printed the way 'scan' does it, changes are the same objects with what happened to the file
+		std::ostringstream record;
+		NDJSONWriter writer(record);
+		if (!args.HasOption("no-initial"))
+		{
+			watcher.ForEach([&](const Core::ScanResult& result)
+			{
+				writer.Write(result);
+			});
+			std::cout << record.str();
+			std::cout.flush();
+		}
+
+		const size_t maxUpdates = args.GetOption("updates", size_t(0));
+		size_t updates = 0;
+
+		g_Watcher = &watcher;
+		std::signal(SIGINT, OnInterrupt);
+		std::signal(SIGTERM, OnInterrupt);
+
+		std::string buffer;
+		watcher.Run([&](const Core::ModuleUpdate& update)
+		{
+			record.str({});
+			writer.Write(*update.Result);
+			const std::string object = record.str();
+
+			buffer = "{\"change\":";
+			AppendJSONString(buffer, Core::GetModuleChangeName(update.Change));
+			if (update.Change == Core::ModuleChange::Renamed)
+			{
+				buffer += ",\"from\":";
+				AppendJSONString(buffer, ToUTF8(update.PreviousPath));
+			}
+			buffer += ',' + object.substr(1);
+			std::cout << buffer;
+			std::cout.flush();
+
+			if (maxUpdates != 0 && ++updates >= maxUpdates)
+			{
+				watcher.Stop();
+			}
+		});
+
+		std::signal(SIGINT, SIG_DFL);
+		std::signal(SIGTERM, SIG_DFL);
+		g_Watcher = nullptr;
+
+		const Core::ModuleWatcherStats stats = watcher.GetStats();
+		std::cerr << "watched " << stats.Modules << " module(s) in " << stats.Directories << " folder(s): " << stats.Events << " event(s) in " << stats.Batches << " batch(es), "
+			<< stats.Parsed << " parsed, " << stats.Renamed << " renamed, " << stats.Removed << " removed, " << stats.Overflows << " overflow(s), max latency "
+			<< std::chrono::duration<double, std::milli>(stats.MaxLatency).count() << " ms\n";
+		return 0;
+	}
+}
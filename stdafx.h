@@ -2,6 +2,8 @@
 
 #define _CRT_SECURE_NO_WARNINGS 1
 #define _CRT_SECURE_NO_DEPRECATE 1
+
+#if defined(_WIN32)
 #define BMSV_API	__declspec(dllexport)
 
 // Windows
@@ -9,10 +11,13 @@
 #define WIN32_LEAN_AND_MEAN
 #include <SDKDDKVer.h>
 #include <windows.h>
+#endif
 
 // Std
 #include <memory>
 #include <atomic>
 #include <utility>
 
+#if defined(_WIN32)
 #pragma comment(lib, "Propsys.lib")
+#endif